@@ -976,7 +976,7 @@ class CHelpItems {
 				],
 				[
 					'key' => 'zabbix[proxy,<name>,<param>]',
-					'description' => _('Time of proxy last access. Name - proxy name. Param - lastaccess. Unix timestamp.')
+					'description' => _('Proxy information. Name - proxy name. Param - lastaccess (time of proxy last access, Unix timestamp) or latency (time in seconds passive proxy took to respond to the last request of proxy poller).')
 				],
 				[
 					'key' => 'zabbix[proxy_history]',
@@ -994,6 +994,10 @@ class CHelpItems {
 					'key' => 'zabbix[requiredperformance]',
 					'description' => _('Required performance of the Zabbix server, in new values per second expected.')
 				],
+				[
+					'key' => 'zabbix[ssh,<mode>]',
+					'description' => _('SSH session reuse statistics of all Zabbix server or proxy pollers. Mode - requests (number of ssh.run checks), reused (number of checks done over an already authenticated session), preused (reused checks in %), sessions (number of open sessions).')
+				],
 				[
 					'key' => 'zabbix[stats,<ip>,<port>]',
 					'description' => _('Returns a JSON object containing Zabbix server or proxy internal metrics.')
@@ -1002,6 +1006,10 @@ class CHelpItems {
 					'key' => 'zabbix[stats,<ip>,<port>,queue,<from>,<to>]',
 					'description' => _('Number of items in the queue which are delayed in Zabbix server or proxy by "from" till "to" seconds, inclusive.')
 				],
+				[
+					'key' => 'zabbix[tls,<mode>]',
+					'description' => _('TLS handshake statistics of all Zabbix server or proxy processes. Mode - handshakes (total number of handshakes), resumed (number of handshakes resuming a previous session), presumed (resumed handshakes in %).')
+				],
 				[
 					'key' => 'zabbix[trends]',
 					'description' => _('Number of values stored in table TRENDS.')
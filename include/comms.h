@@ -144,6 +144,10 @@ int	get_address_family(const char *addr, int *family, char *error, int max_error
 int	zbx_tcp_listen(zbx_socket_t *s, const char *listen_ip, unsigned short listen_port);
 
 int	zbx_tcp_accept(zbx_socket_t *s, unsigned int tls_accept);
+int	zbx_tcp_accept_check(zbx_socket_t *s, unsigned int tls_accept);
+#ifndef _WINDOWS
+int	zbx_tcp_accept_nowait(zbx_socket_t *s, zbx_socket_t *conn);
+#endif
 void	zbx_tcp_unaccept(zbx_socket_t *s);
 
 #define ZBX_TCP_READ_UNTIL_CLOSE 0x01
@@ -37,9 +37,10 @@
 #define	ZBX_POLLER_TYPE_JAVA		4
 #define	ZBX_POLLER_TYPE_COUNT		5	/* number of poller types */
 
-#define MAX_JAVA_ITEMS		32
+#define MAX_JAVA_ITEMS		32	/* per Java gateway request, Java pollers take up to MAX_POLLER_ITEMS */
 #define MAX_SNMP_ITEMS		128
-#define MAX_POLLER_ITEMS	128	/* MAX(MAX_JAVA_ITEMS, MAX_SNMP_ITEMS) */
+#define MAX_AGENT_ITEMS		64
+#define MAX_POLLER_ITEMS	128	/* MAX(MAX_JAVA_ITEMS, MAX_SNMP_ITEMS, MAX_AGENT_ITEMS) */
 #define MAX_PINGER_ITEMS	128
 
 #define ZBX_TRIGGER_DEPENDENCY_LEVELS_MAX	32
@@ -64,6 +65,7 @@ extern int	CONFIG_PINGER_FORKS;
 extern int	CONFIG_UNAVAILABLE_DELAY;
 extern int	CONFIG_UNREACHABLE_PERIOD;
 extern int	CONFIG_UNREACHABLE_DELAY;
+extern int	CONFIG_AGENT_BULK_REQUESTS;
 extern int	CONFIG_HISTSYNCER_FORKS;
 extern int	CONFIG_PROXYCONFIG_FREQUENCY;
 extern int	CONFIG_PROXYDATA_FREQUENCY;
@@ -646,6 +648,8 @@ int	DCget_host_by_hostid(DC_HOST *host, zbx_uint64_t hostid);
 void	DCconfig_get_hosts_by_itemids(DC_HOST *hosts, const zbx_uint64_t *itemids, int *errcodes, size_t num);
 void	DCconfig_get_items_by_keys(DC_ITEM *items, zbx_host_key_t *keys, int *errcodes, size_t num);
 void	DCconfig_get_items_by_itemids(DC_ITEM *items, const zbx_uint64_t *itemids, int *errcodes, size_t num);
+void	DCconfig_get_function_items_by_itemids(DC_ITEM *items, const zbx_uint64_t *itemids, int *errcodes,
+		size_t num);
 void	DCconfig_get_preprocessable_items(zbx_hashset_t *items, int *timestamp);
 void	DCconfig_get_functions_by_functionids(DC_FUNCTION *functions,
 		zbx_uint64_t *functionids, int *errcodes, size_t num);
@@ -705,13 +709,14 @@ int	DCget_host_inventory_value_by_hostid(zbx_uint64_t hostid, char **replace_to,
 void	*DCconfig_get_stats(int request);
 
 int	DCconfig_get_last_sync_time(void);
+int	DCconfig_get_host_revision(zbx_uint64_t hostid, zbx_uint64_t *revision);
 int	DCconfig_get_proxypoller_hosts(DC_PROXY *proxies, int max_hosts);
 int	DCconfig_get_proxypoller_nextcheck(void);
 
 #define ZBX_PROXY_CONFIG_NEXTCHECK	0x01
 #define ZBX_PROXY_DATA_NEXTCHECK	0x02
 #define ZBX_PROXY_TASKS_NEXTCHECK	0x04
-void	DCrequeue_proxy(zbx_uint64_t hostid, unsigned char update_nextcheck, int proxy_conn_err);
+void	DCrequeue_proxy(zbx_uint64_t hostid, unsigned char update_nextcheck, int proxy_conn_err, double latency);
 int	DCcheck_proxy_permissions(const char *host, const zbx_socket_t *sock, zbx_uint64_t *hostid, char **error);
 
 #if defined(HAVE_POLARSSL) || defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
@@ -784,6 +789,7 @@ void	zbx_dc_correlation_rules_free(zbx_correlation_rules_t *rules);
 void	zbx_dc_correlation_rules_get(zbx_correlation_rules_t *rules);
 
 void	zbx_dc_get_nested_hostgroupids(zbx_uint64_t *groupids, int groupids_num, zbx_vector_uint64_t *nested_groupids);
+int	zbx_dc_check_hosts_in_hostgroup(const zbx_vector_uint64_t *hostids, zbx_uint64_t groupid);
 void	zbx_dc_get_nested_hostgroupids_by_names(char **names, int names_num,
 		zbx_vector_uint64_t *nested_groupids);
 
@@ -825,6 +831,7 @@ void	zbx_free_tag(zbx_tag_t *tag);
 void	zbx_free_item_tag(zbx_item_tag_t *host_tag);
 
 int	zbx_dc_get_active_proxy_by_name(const char *name, DC_PROXY *proxy, char **error);
+int	zbx_dc_get_proxy_latency(const char *name, double *latency, char **error);
 void	zbx_dc_update_proxy_version(zbx_uint64_t hostid, int version);
 
 typedef struct
@@ -920,6 +927,7 @@ int	zbx_dc_update_maintenances(void);
 void	zbx_dc_get_host_maintenance_updates(const zbx_vector_uint64_t *maintenanceids, zbx_vector_ptr_t *updates);
 void	zbx_dc_flush_host_maintenance_updates(const zbx_vector_ptr_t *updates);
 int	zbx_dc_get_event_maintenances(zbx_vector_ptr_t *event_queries, const zbx_vector_uint64_t *maintenanceids);
+void	zbx_dc_get_event_query_functionids(zbx_vector_ptr_t *event_queries);
 int	zbx_dc_get_running_maintenanceids(zbx_vector_uint64_t *maintenanceids);
 
 void	zbx_dc_maintenance_set_update_flags(void);
@@ -30,22 +30,60 @@
 #define ZBX_MAX_HRECORDS	1000
 #define ZBX_MAX_HRECORDS_TOTAL	10000
 
+/* binary history data format version, advertised by server and written as the first byte of encoded data */
+#define ZBX_PROXY_HISTORY_BINARY_FORMAT	1
+
 #define ZBX_PROXY_DATA_DONE	0
 #define ZBX_PROXY_DATA_MORE	1
 
+/* proxy memory buffer modes */
+#define ZBX_PB_MODE_DATABASE	0
+#define ZBX_PB_MODE_MEMORY	1
+
+typedef struct
+{
+	zbx_uint64_t	id;
+	zbx_uint64_t	itemid;
+	zbx_uint64_t	lastlogsize;
+	size_t		source_offset;
+	size_t		value_offset;
+	int		clock;
+	int		ns;
+	int		timestamp;
+	int		severity;
+	int		logeventid;
+	int		mtime;
+	unsigned char	state;
+	unsigned char	flags;
+}
+zbx_history_data_t;
+
+typedef struct
+{
+	int		mode;
+	int		db_writers;
+	zbx_uint64_t	db_inserts;
+	zbx_uint64_t	id_offset;
+}
+zbx_pb_state_t;
+
+typedef struct zbx_pb_history zbx_pb_history_t;
+
 int	get_active_proxy_from_request(struct zbx_json_parse *jp, DC_PROXY *proxy, char **error);
 int	zbx_proxy_check_permissions(const DC_PROXY *proxy, const zbx_socket_t *sock, char **error);
 int	check_access_passive_proxy(zbx_socket_t *sock, int send_response, const char *req);
 
 void	update_proxy_lastaccess(const zbx_uint64_t hostid, time_t last_access);
 
-int	get_proxyconfig_data(zbx_uint64_t proxy_hostid, struct zbx_json *j, char **error);
+int	get_proxyconfig_data(zbx_uint64_t proxy_hostid, struct zbx_json *j, const struct zbx_json_parse *jp_digest,
+		char **error);
+void	get_proxyconfig_digest(struct zbx_json *j);
 void	process_proxyconfig(struct zbx_json_parse *jp_data);
 
 int	get_host_availability_data(struct zbx_json *j, int *ts);
 int	process_host_availability(struct zbx_json_parse *jp_data, char **error);
 
-int	proxy_get_hist_data(struct zbx_json *j, zbx_uint64_t *lastid, int *more);
+int	proxy_get_hist_data(struct zbx_json *j, int binary, zbx_uint64_t *lastid, int *more);
 int	proxy_get_dhis_data(struct zbx_json *j, zbx_uint64_t *lastid, int *more);
 int	proxy_get_areg_data(struct zbx_json *j, zbx_uint64_t *lastid, int *more);
 void	proxy_set_hist_lastid(const zbx_uint64_t lastid);
@@ -58,10 +96,22 @@ int	process_history_data(DC_ITEM *items, zbx_agent_value_t *values, int *errcode
 int	process_discovery_data(struct zbx_json_parse *jp, zbx_timespec_t *ts, char **error);
 int	process_auto_registration(struct zbx_json_parse *jp, zbx_uint64_t proxy_hostid, zbx_timespec_t *ts, char **error);
 
-int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, char **error);
 
 int	proxy_get_history_count(void);
 
+int	init_proxy_buffer(zbx_uint64_t size, char **error);
+void	free_proxy_buffer(void);
+int	zbx_pb_history_write_begin(void);
+zbx_uint64_t	zbx_pb_history_get_db_lastid(void);
+void	zbx_pb_history_write_end(int mode, const ZBX_DC_HISTORY *history, int history_num,
+		zbx_uint64_t db_lastid);
+void	zbx_pb_history_spill(void);
+void	zbx_pb_get_state(zbx_pb_state_t *state);
+void	zbx_pb_set_memory_mode(const zbx_pb_state_t *state, zbx_uint64_t lastid);
+int	zbx_pb_history_get(zbx_uint64_t lastid, zbx_history_data_t **data, size_t *data_alloc,
+		char **string_buffer, size_t *string_buffer_alloc, int *more);
+int	zbx_pb_history_ack(zbx_uint64_t lastid, zbx_uint64_t *db_lastid);
+
 int	zbx_get_protocol_version(struct zbx_json_parse *jp);
 void	zbx_update_proxy_data(DC_PROXY *proxy, int version, int lastaccess, int compress);
 
@@ -69,6 +119,9 @@ int	process_proxy_history_data(const DC_PROXY *proxy, struct zbx_json_parse *jp,
 int	process_agent_history_data(zbx_socket_t *sock, struct zbx_json_parse *jp, zbx_timespec_t *ts, char **info);
 int	process_sender_history_data(zbx_socket_t *sock, struct zbx_json_parse *jp, zbx_timespec_t *ts, char **info);
 int	process_proxy_data(const DC_PROXY *proxy, struct zbx_json_parse *jp, zbx_timespec_t *ts, char **error);
+int	zbx_proxy_hist_bin_records(const struct zbx_json_parse *jp, int *records_num);
+int	zbx_proxy_hist_bin_supported(const struct zbx_json_parse *jp);
+int	zbx_proxy_hist_bin_confirmed(const struct zbx_json_parse *jp, int records_num);
 int	zbx_check_protocol_version(DC_PROXY *proxy);
 
 #endif
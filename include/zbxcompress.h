@@ -22,6 +22,9 @@
 
 int	zbx_compress(const char *in, size_t size_in, char **out, size_t *size_out);
 int	zbx_uncompress(const char *in, size_t size_in, char *out, size_t *size_out);
+int	zbx_uncompress_begin(char *out, size_t size_out);
+int	zbx_uncompress_update(const char *in, size_t size_in);
+int	zbx_uncompress_end(size_t *size_out);
 const char	*zbx_compress_strerror(void);
 
 #endif
@@ -116,6 +116,13 @@
 #define ZBX_PROTO_TAG_SENDTO		"sendto"
 #define ZBX_PROTO_TAG_SUBJECT		"subject"
 #define ZBX_PROTO_TAG_MESSAGE		"message"
+#define ZBX_PROTO_TAG_TIMEOUT		"timeout"
+#define ZBX_PROTO_TAG_HISTORY_BINARY	"history binary"
+#define ZBX_PROTO_TAG_HISTORY_BINARY_FORMAT	"history binary format"
+#define ZBX_PROTO_TAG_HISTORY_BINARY_RECORDS	"history binary records"
+#define ZBX_PROTO_TAG_KEEPALIVE		"keepalive"
+#define ZBX_PROTO_TAG_CONFIG_REVISION	"config_revision"
+#define ZBX_PROTO_TAG_CONFIG_DIGEST	"config_digest"
 
 #define ZBX_PROTO_VALUE_FAILED		"failed"
 #define ZBX_PROTO_VALUE_SUCCESS		"success"
@@ -132,6 +139,7 @@
 #define ZBX_PROTO_VALUE_GET_STATUS		"status.get"
 #define ZBX_PROTO_VALUE_PROXY_DATA		"proxy data"
 #define ZBX_PROTO_VALUE_PROXY_TASKS		"proxy tasks"
+#define ZBX_PROTO_VALUE_PASSIVE_CHECKS		"passive checks"
 
 #define ZBX_PROTO_VALUE_GET_QUEUE_OVERVIEW	"overview"
 #define ZBX_PROTO_VALUE_GET_QUEUE_PROXY		"overview by proxy"
@@ -54,6 +54,9 @@ void	collect_selfmon_stats(void);
 void	get_selfmon_stats(unsigned char process_type, unsigned char aggr_func, int process_num,
 		unsigned char state, double *value);
 int	zbx_get_all_process_stats(zbx_process_info_t *stats);
+void	get_selfmon_tls_stats(zbx_uint64_t *handshakes, zbx_uint64_t *resumed);
+void	update_selfmon_ssh_stats(zbx_uint64_t requests, zbx_uint64_t reused, int sessions);
+void	get_selfmon_ssh_stats(zbx_uint64_t *requests, zbx_uint64_t *reused, zbx_uint64_t *sessions);
 void	zbx_sleep_loop(int sleeptime);
 void	zbx_sleep_forever(void);
 void	zbx_wakeup(void);
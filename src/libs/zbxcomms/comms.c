@@ -1302,8 +1302,6 @@ int	zbx_tcp_accept(zbx_socket_t *s, unsigned int tls_accept)
 	ZBX_SOCKET	accepted_socket;
 	ZBX_SOCKLEN_T	nlen;
 	int		i, n = 0, ret = FAIL;
-	ssize_t		res;
-	unsigned char	buf;	/* 1 byte buffer */
 
 	zbx_tcp_unaccept(s);
 
@@ -1348,9 +1346,117 @@ int	zbx_tcp_accept(zbx_socket_t *s, unsigned int tls_accept)
 	{
 		/* cannot get peer IP address */
 		zbx_tcp_unaccept(s);
-		goto out;
+		return ret;
+	}
+
+	return zbx_tcp_accept_check(s, tls_accept);
+}
+
+#ifndef _WINDOWS
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_tcp_accept_nowait                                            *
+ *                                                                            *
+ * Purpose: accepts a pending connection on one of the listening sockets      *
+ *          without waiting for it                                            *
+ *                                                                            *
+ * Parameters: s    - [IN] the listening socket                               *
+ *             conn - [OUT] the accepted connection                           *
+ *                                                                            *
+ * Return value: SUCCEED - a connection was accepted                          *
+ *               FAIL    - no connection was pending (socket error is set to  *
+ *                         EAGAIN) or an error occurred                       *
+ *                                                                            *
+ * Comments: Unlike zbx_tcp_accept() the accepted connection is returned in a *
+ *           separate socket structure, so the caller can keep several        *
+ *           connections open at the same time. The connection must be        *
+ *           checked with zbx_tcp_accept_check() when the first data arrives  *
+ *           and closed with zbx_tcp_close().                                 *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_tcp_accept_nowait(zbx_socket_t *s, zbx_socket_t *conn)
+{
+	ZBX_SOCKADDR	serv_addr;
+	ZBX_SOCKET	accepted_socket = ZBX_SOCKET_ERROR;
+	ZBX_SOCKLEN_T	nlen;
+	int		i, flags;
+
+	for (i = 0; i < s->num_socks; i++)
+	{
+		/* listening sockets can be shared with other processes, make sure accept() does not block */
+		/* if the pending connection has already been taken by another process                     */
+		if (-1 != (flags = fcntl(s->sockets[i], F_GETFL, 0)) && 0 == (flags & O_NONBLOCK))
+			fcntl(s->sockets[i], F_SETFL, flags | O_NONBLOCK);
+
+		nlen = sizeof(serv_addr);
+		if (ZBX_SOCKET_ERROR != (accepted_socket = (ZBX_SOCKET)accept(s->sockets[i],
+				(struct sockaddr *)&serv_addr, &nlen)))
+		{
+			break;
+		}
+
+		switch (zbx_socket_last_error())
+		{
+			case EAGAIN:
+#if EWOULDBLOCK != EAGAIN
+			case EWOULDBLOCK:
+#endif
+			case EINTR:
+			case ECONNABORTED:
+				continue;
+		}
+
+		zbx_set_socket_strerror("accept() failed: %s", strerror_from_system(zbx_socket_last_error()));
+		return FAIL;
 	}
 
+	if (ZBX_SOCKET_ERROR == accepted_socket)
+	{
+		errno = EAGAIN;
+		return FAIL;
+	}
+
+	/* on some systems accepted socket inherits non-blocking mode from the listening socket */
+	if (-1 != (flags = fcntl(accepted_socket, F_GETFL, 0)) && 0 != (flags & O_NONBLOCK))
+		fcntl(accepted_socket, F_SETFL, flags & ~O_NONBLOCK);
+
+	memset(conn, 0, sizeof(zbx_socket_t));
+	conn->buf_type = ZBX_BUF_TYPE_STAT;
+	conn->buffer = conn->buf_stat;
+	conn->socket = accepted_socket;
+	conn->socket_orig = ZBX_SOCKET_ERROR;
+	conn->accepted = 1;
+
+	if (SUCCEED != zbx_socket_peer_ip_save(conn))
+	{
+		zbx_tcp_unaccept(conn);
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_tcp_accept_check                                             *
+ *                                                                            *
+ * Purpose: checks the type of accepted connection and performs TLS handshake *
+ *          if necessary                                                      *
+ *                                                                            *
+ * Parameters: s          - [IN] the accepted connection                      *
+ *             tls_accept - [IN] the allowed connection types                 *
+ *                                                                            *
+ * Return value: SUCCEED - success                                            *
+ *               FAIL - an error occurred, the connection is closed           *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_tcp_accept_check(zbx_socket_t *s, unsigned int tls_accept)
+{
+	ssize_t		res;
+	unsigned char	buf;	/* 1 byte buffer */
+	int		ret = FAIL;
+
 	zbx_socket_timeout_set(s, CONFIG_TIMEOUT);
 
 	if (ZBX_SOCKET_ERROR == (res = recv(s->socket, &buf, 1, MSG_PEEK)))
@@ -1662,8 +1768,8 @@ ssize_t	zbx_tcp_recv_ext(zbx_socket_t *s, int timeout)
 	ssize_t		nbytes;
 	size_t		buf_dyn_bytes = 0, buf_stat_bytes = 0, offset = 0;
 	zbx_uint32_t	expected_len = 16 * ZBX_MEBIBYTE, reserved = 0;
-	unsigned char	expect = ZBX_TCP_EXPECT_HEADER;
-	int		protocol_version;
+	unsigned char	expect = ZBX_TCP_EXPECT_HEADER, uncompressing = 0;
+	int		protocol_version = 0;
 
 	if (0 != timeout)
 		zbx_socket_timeout_set(s, timeout);
@@ -1683,7 +1789,16 @@ ssize_t	zbx_tcp_recv_ext(zbx_socket_t *s, int timeout)
 		else
 		{
 			if (buf_dyn_bytes + nbytes <= expected_len)
-				memcpy(s->buffer + buf_dyn_bytes, s->buf_stat, nbytes);
+			{
+				if (0 == uncompressing)
+					memcpy(s->buffer + buf_dyn_bytes, s->buf_stat, nbytes);
+				else if (SUCCEED != zbx_uncompress_update(s->buf_stat, nbytes))
+				{
+					zbx_set_socket_strerror("cannot uncompress data: %s", zbx_compress_strerror());
+					nbytes = ZBX_PROTO_ERROR;
+					goto out;
+				}
+			}
 			buf_dyn_bytes += nbytes;
 		}
 
@@ -1770,6 +1885,23 @@ ssize_t	zbx_tcp_recv_ext(zbx_socket_t *s, int timeout)
 				buf_stat_bytes -= offset;
 				memmove(s->buf_stat, s->buf_stat + offset, buf_stat_bytes);
 			}
+			else if (0 != (protocol_version & ZBX_TCP_COMPRESS))
+			{
+				/* uncompress large messages as they arrive instead of buffering compressed data */
+				s->buf_type = ZBX_BUF_TYPE_DYN;
+				s->buffer = (char *)zbx_malloc(NULL, reserved + 1);
+				buf_dyn_bytes = buf_stat_bytes - offset;
+				buf_stat_bytes = 0;
+				uncompressing = 1;
+
+				if (SUCCEED != zbx_uncompress_begin(s->buffer, reserved + 1) ||
+						SUCCEED != zbx_uncompress_update(s->buf_stat + offset, buf_dyn_bytes))
+				{
+					zbx_set_socket_strerror("cannot uncompress data: %s", zbx_compress_strerror());
+					nbytes = ZBX_PROTO_ERROR;
+					goto out;
+				}
+			}
 			else
 			{
 				s->buf_type = ZBX_BUF_TYPE_DYN;
@@ -1790,10 +1922,35 @@ ssize_t	zbx_tcp_recv_ext(zbx_socket_t *s, int timeout)
 	{
 		if (buf_stat_bytes + buf_dyn_bytes == expected_len)
 		{
-			if (0 != (protocol_version & ZBX_TCP_COMPRESS))
+			if (0 != uncompressing)
+			{
+				size_t	out_size;
+
+				if (FAIL == zbx_uncompress_end(&out_size))
+				{
+					zbx_set_socket_strerror("cannot uncompress data: %s", zbx_compress_strerror());
+					nbytes = ZBX_PROTO_ERROR;
+					goto out;
+				}
+
+				if (out_size != reserved)
+				{
+					zbx_set_socket_strerror("size of uncompressed data is %s than expected",
+							out_size < reserved ? "less" : "more");
+					nbytes = ZBX_PROTO_ERROR;
+					goto out;
+				}
+
+				s->read_bytes = reserved;
+
+				zabbix_log(LOG_LEVEL_TRACE, "%s(): received " ZBX_FS_SIZE_T " bytes with"
+						" compression ratio %.1f", __func__,
+						(zbx_fs_size_t)buf_dyn_bytes, (double)reserved / buf_dyn_bytes);
+			}
+			else if (0 != (protocol_version & ZBX_TCP_COMPRESS))
 			{
 				char	*out;
-				size_t	out_size = reserved;
+				size_t	out_size = reserved + 1;
 
 				out = (char *)zbx_malloc(NULL, reserved + 1);
 				if (FAIL == zbx_uncompress(s->buffer, buf_stat_bytes + buf_dyn_bytes, out, &out_size))
@@ -1807,7 +1964,8 @@ ssize_t	zbx_tcp_recv_ext(zbx_socket_t *s, int timeout)
 				if (out_size != reserved)
 				{
 					zbx_free(out);
-					zbx_set_socket_strerror("size of uncompressed data is less than expected");
+					zbx_set_socket_strerror("size of uncompressed data is %s than expected",
+							out_size < reserved ? "less" : "more");
 					nbytes = ZBX_PROTO_ERROR;
 					goto out;
 				}
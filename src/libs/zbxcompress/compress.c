@@ -27,6 +27,7 @@
 #define ZBX_COMPRESS_STRERROR_LEN	512
 
 static int	zbx_zlib_errno = 0;
+static z_stream	*uncompress_stream = NULL;	/* the stream being uncompressed in parts */
 
 /******************************************************************************
  *                                                                            *
@@ -53,6 +54,9 @@ const char	*zbx_compress_strerror(void)
 		case Z_DATA_ERROR:
 			zbx_strlcpy(message, "corrupted input data", sizeof(message));
 			break;
+		case Z_STREAM_ERROR:
+			zbx_strlcpy(message, "invalid compression stream state", sizeof(message));
+			break;
 		default:
 			zbx_snprintf(message, sizeof(message), "unknown error (%d)", zbx_zlib_errno);
 			break;
@@ -61,6 +65,67 @@ const char	*zbx_compress_strerror(void)
 	return message;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: compress_stream_get                                              *
+ *                                                                            *
+ * Purpose: get deflate stream ready for compressing new data                 *
+ *                                                                            *
+ * Return value: the deflate stream or NULL if it cannot be initialized       *
+ *                                                                            *
+ * Comments: The stream is initialized once and reset for subsequent data,    *
+ *           so its state is not allocated and freed for every message.       *
+ *                                                                            *
+ ******************************************************************************/
+static z_stream	*compress_stream_get(void)
+{
+	static z_stream	stream;
+	static int	initialized = 0;
+
+	if (0 == initialized)
+	{
+		memset(&stream, 0, sizeof(stream));
+
+		if (Z_OK != (zbx_zlib_errno = deflateInit(&stream, Z_DEFAULT_COMPRESSION)))
+			return NULL;
+
+		initialized = 1;
+	}
+	else if (Z_OK != (zbx_zlib_errno = deflateReset(&stream)))
+		return NULL;
+
+	return &stream;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: uncompress_stream_get                                            *
+ *                                                                            *
+ * Purpose: get inflate stream ready for uncompressing new data               *
+ *                                                                            *
+ * Return value: the inflate stream or NULL if it cannot be initialized       *
+ *                                                                            *
+ ******************************************************************************/
+static z_stream	*uncompress_stream_get(void)
+{
+	static z_stream	stream;
+	static int	initialized = 0;
+
+	if (0 == initialized)
+	{
+		memset(&stream, 0, sizeof(stream));
+
+		if (Z_OK != (zbx_zlib_errno = inflateInit(&stream)))
+			return NULL;
+
+		initialized = 1;
+	}
+	else if (Z_OK != (zbx_zlib_errno = inflateReset(&stream)))
+		return NULL;
+
+	return &stream;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_compress                                                     *
@@ -77,26 +142,69 @@ const char	*zbx_compress_strerror(void)
  *                                                                            *
  * Comments: In the case of success the output buffer must be freed by the    *
  *           caller.                                                          *
+ *           Large data is compressed into buffer sized for the expected      *
+ *           compression ratio and grown only when necessary, instead of      *
+ *           allocating the worst case size.                                  *
  *                                                                            *
  ******************************************************************************/
 int	zbx_compress(const char *in, size_t size_in, char **out, size_t *size_out)
 {
-	Bytef	*buf;
-	uLongf	buf_size;
+#define ZBX_COMPRESS_GUESS_MIN	(64 * ZBX_KIBIBYTE)
+#define ZBX_COMPRESS_GUESS_RATIO	4
+
+	z_stream	*stream;
+	Bytef		*buf;
+	size_t		buf_size, bound;
+
+	if (NULL == (stream = compress_stream_get()))
+		return FAIL;
+
+	bound = deflateBound(stream, size_in);
+
+	if (ZBX_COMPRESS_GUESS_MIN < (buf_size = size_in / ZBX_COMPRESS_GUESS_RATIO))
+		buf_size = MIN(buf_size, bound);
+	else
+		buf_size = MIN(ZBX_COMPRESS_GUESS_MIN, bound);
 
-	buf_size = compressBound(size_in);
 	buf = (Bytef *)zbx_malloc(NULL, buf_size);
 
-	if (Z_OK != (zbx_zlib_errno = compress(buf, &buf_size, (const Bytef *)in, size_in)))
+	stream->next_in = (Bytef *)in;
+	stream->avail_in = size_in;
+	stream->next_out = buf;
+	stream->avail_out = buf_size;
+
+	while (Z_STREAM_END != (zbx_zlib_errno = deflate(stream, Z_FINISH)))
 	{
-		zbx_free(buf);
-		return FAIL;
+		if (Z_OK != zbx_zlib_errno && Z_BUF_ERROR != zbx_zlib_errno)
+		{
+			zbx_free(buf);
+			return FAIL;
+		}
+
+		/* must not happen as the bound is enough to compress any data */
+		if (bound == buf_size)
+		{
+			zbx_zlib_errno = Z_BUF_ERROR;
+			zbx_free(buf);
+			return FAIL;
+		}
+
+		buf_size = MIN(buf_size * 2, bound);
+		buf = (Bytef *)zbx_realloc(buf, buf_size);
+
+		stream->next_out = buf + stream->total_out;
+		stream->avail_out = buf_size - stream->total_out;
 	}
 
+	zbx_zlib_errno = Z_OK;
+
 	*out = (char *)buf;
-	*size_out = buf_size;
+	*size_out = stream->total_out;
 
 	return SUCCEED;
+
+#undef ZBX_COMPRESS_GUESS_MIN
+#undef ZBX_COMPRESS_GUESS_RATIO
 }
 
 /******************************************************************************
@@ -116,12 +224,120 @@ int	zbx_compress(const char *in, size_t size_in, char **out, size_t *size_out)
  ******************************************************************************/
 int	zbx_uncompress(const char *in, size_t size_in, char *out, size_t *size_out)
 {
-	uLongf	size_o = *size_out;
+	if (SUCCEED != zbx_uncompress_begin(out, *size_out))
+		return FAIL;
+
+	if (SUCCEED != zbx_uncompress_update(in, size_in))
+		return FAIL;
+
+	return zbx_uncompress_end(size_out);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_uncompress_begin                                             *
+ *                                                                            *
+ * Purpose: start uncompressing data received in parts                        *
+ *                                                                            *
+ * Parameters: out      - [OUT] the uncompressed data                         *
+ *             size_out - [IN] the output buffer size                         *
+ *                                                                            *
+ * Return value: SUCCEED - uncompressing was started successfully             *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Only one data stream can be uncompressed at a time. The input    *
+ *           is passed with zbx_uncompress_update() as it arrives and the     *
+ *           result is checked with zbx_uncompress_end().                     *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_uncompress_begin(char *out, size_t size_out)
+{
+	if (NULL == (uncompress_stream = uncompress_stream_get()))
+		return FAIL;
+
+	uncompress_stream->next_out = (Bytef *)out;
+	uncompress_stream->avail_out = size_out;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_uncompress_update                                            *
+ *                                                                            *
+ * Purpose: uncompress next part of data                                      *
+ *                                                                            *
+ * Parameters: in      - [IN] the data to uncompress                          *
+ *             size_in - [IN] the input data size                             *
+ *                                                                            *
+ * Return value: SUCCEED - the data was uncompressed successfully             *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_uncompress_update(const char *in, size_t size_in)
+{
+	if (NULL == uncompress_stream)
+	{
+		zbx_zlib_errno = Z_STREAM_ERROR;
+		return FAIL;
+	}
+
+	uncompress_stream->next_in = (Bytef *)in;
+	uncompress_stream->avail_in = size_in;
+
+	while (0 != uncompress_stream->avail_in)
+	{
+		switch (zbx_zlib_errno = inflate(uncompress_stream, Z_NO_FLUSH))
+		{
+			case Z_OK:
+				break;
+			case Z_STREAM_END:
+				/* data after the end of compressed stream is ignored */
+				return SUCCEED;
+			case Z_NEED_DICT:
+				zbx_zlib_errno = Z_DATA_ERROR;
+				return FAIL;
+			default:
+				return FAIL;
+		}
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_uncompress_end                                               *
+ *                                                                            *
+ * Purpose: finish uncompressing data received in parts                       *
+ *                                                                            *
+ * Parameters: size_out - [OUT] the uncompressed data size                    *
+ *                                                                            *
+ * Return value: SUCCEED - the whole compressed stream was uncompressed       *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_uncompress_end(size_t *size_out)
+{
+	z_stream	*stream = uncompress_stream;
 
-	if (Z_OK != (zbx_zlib_errno = uncompress((Bytef *)out, &size_o, (const Bytef *)in, size_in)))
+	uncompress_stream = NULL;
+
+	if (NULL == stream)
+	{
+		zbx_zlib_errno = Z_STREAM_ERROR;
 		return FAIL;
+	}
 
-	*size_out = size_o;
+	if (Z_STREAM_END != zbx_zlib_errno)
+	{
+		/* input ended before the end of compressed stream or output buffer is too small */
+		zbx_zlib_errno = (0 == stream->avail_out ? Z_BUF_ERROR : Z_DATA_ERROR);
+		return FAIL;
+	}
+
+	zbx_zlib_errno = Z_OK;
+	*size_out = stream->total_out;
 
 	return SUCCEED;
 }
@@ -146,6 +362,26 @@ int zbx_uncompress(const char *in, size_t size_in, char *out, size_t *size_out)
 	return FAIL;
 }
 
+int	zbx_uncompress_begin(char *out, size_t size_out)
+{
+	ZBX_UNUSED(out);
+	ZBX_UNUSED(size_out);
+	return FAIL;
+}
+
+int	zbx_uncompress_update(const char *in, size_t size_in)
+{
+	ZBX_UNUSED(in);
+	ZBX_UNUSED(size_in);
+	return FAIL;
+}
+
+int	zbx_uncompress_end(size_t *size_out)
+{
+	ZBX_UNUSED(size_out);
+	return FAIL;
+}
+
 const char	*zbx_compress_strerror(void)
 {
 	return "";
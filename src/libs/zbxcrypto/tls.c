@@ -180,11 +180,23 @@ struct zbx_tls_context
 	gnutls_session_t		ctx;
 	gnutls_psk_client_credentials_t	psk_client_creds;
 	gnutls_psk_server_credentials_t	psk_server_creds;
+	char				*session_peer;	/* key for caching the session of outgoing */
+							/* connection on close, NULL if not cached */
 #elif defined(HAVE_OPENSSL)
 	SSL				*ctx;
+	char				*session_peer;	/* key for caching the session of outgoing */
+							/* connection on close, NULL if not cached */
 #endif
 };
 
+/* Session resumption is supported for certificate-based connections with GnuTLS and with OpenSSL 1.1.1 or newer */
+/* (session ticket callbacks are required to refuse resumption of PSK-based sessions). Client keeps sessions in  */
+/* a per-process cache, server issues session tickets encrypted with a key shared by all processes.             */
+#if defined(HAVE_GNUTLS) || (defined(HAVE_OPENSSL) && OPENSSL_VERSION_NUMBER >= 0x1010100fL && \
+		!defined(LIBRESSL_VERSION_NUMBER))
+#	define ZBX_TLS_SESSION_CACHE
+#endif
+
 extern unsigned int			configured_tls_connect_mode;
 extern unsigned int			configured_tls_accept_modes;
 
@@ -203,6 +215,8 @@ extern char				*CONFIG_TLS_CERT_FILE;
 extern char				*CONFIG_TLS_KEY_FILE;
 extern char				*CONFIG_TLS_PSK_IDENTITY;
 extern char				*CONFIG_TLS_PSK_FILE;
+extern int				CONFIG_TLS_SESSION_CACHE_SIZE;
+extern int				CONFIG_TLS_SESSION_LIFETIME;
 
 ZBX_THREAD_LOCAL static char		*my_psk_identity	= NULL;
 ZBX_THREAD_LOCAL static size_t		my_psk_identity_len	= 0;
@@ -255,6 +269,34 @@ ZBX_THREAD_LOCAL static char			incoming_connection_psk_id[PSK_MAX_IDENTITY_LEN +
 ZBX_THREAD_LOCAL char				info_buf[256];
 #endif
 
+ZBX_THREAD_LOCAL static zbx_tls_stats_t		tls_stats;
+
+#if defined(ZBX_TLS_SESSION_CACHE)
+/* session of outgoing connection kept for resumption on the next connection to the same peer */
+typedef struct
+{
+	char		*peer;		/* peer address and port, expected certificate issuer and subject */
+#if defined(HAVE_GNUTLS)
+	gnutls_datum_t	data;
+#elif defined(HAVE_OPENSSL)
+	SSL_SESSION	*session;
+#endif
+	time_t		expires;
+}
+zbx_tls_session_t;
+
+ZBX_THREAD_LOCAL static zbx_tls_session_t	*tls_sessions		= NULL;
+ZBX_THREAD_LOCAL static int			tls_sessions_num	= 0;
+
+/* session ticket key is generated in parent process so that any child process can resume a session */
+#if defined(HAVE_GNUTLS)
+static gnutls_datum_t				ticket_key		= {NULL, 0};
+#elif defined(HAVE_OPENSSL)
+static unsigned char				ticket_keys[80];	/* name, HMAC and AES keys */
+static int					ticket_keys_set		= 0;
+#endif
+#endif
+
 #if defined(HAVE_POLARSSL)
 /**********************************************************************************
  *                                                                                *
@@ -2610,6 +2652,240 @@ int	zbx_check_server_issuer_subject(zbx_socket_t *sock, char **error)
 	return SUCCEED;
 }
 
+#if defined(ZBX_TLS_SESSION_CACHE)
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_tls_session_peer                                             *
+ *                                                                            *
+ * Purpose: make a session cache key for an outgoing connection               *
+ *                                                                            *
+ * Parameters:                                                                *
+ *     s       - [IN] socket with established TCP connection                  *
+ *     issuer  - [IN] required issuer of peer certificate, can be NULL        *
+ *     subject - [IN] required subject of peer certificate, can be NULL       *
+ *                                                                            *
+ * Return value: dynamically allocated key or NULL if session caching is      *
+ *               disabled or peer address cannot be obtained                  *
+ *                                                                            *
+ ******************************************************************************/
+static char	*zbx_tls_session_peer(const zbx_socket_t *s, const char *issuer, const char *subject)
+{
+	ZBX_SOCKADDR	sa;
+	ZBX_SOCKLEN_T	sz = sizeof(sa);
+#ifdef HAVE_IPV6
+	char		host[MAX_ZBX_DNSNAME_LEN + 1], serv[8];
+#endif
+	if (0 == CONFIG_TLS_SESSION_CACHE_SIZE || 0 == CONFIG_TLS_SESSION_LIFETIME)
+		return NULL;
+
+	if (ZBX_PROTO_ERROR == getpeername(s->socket, (struct sockaddr *)&sa, &sz))
+		return NULL;
+#ifdef HAVE_IPV6
+	if (0 != zbx_getnameinfo((struct sockaddr *)&sa, host, sizeof(host), serv, sizeof(serv),
+			NI_NUMERICHOST | NI_NUMERICSERV))
+	{
+		return NULL;
+	}
+
+	return zbx_dsprintf(NULL, "[%s]:%s\n%s\n%s", host, serv, ZBX_NULL2EMPTY_STR(issuer),
+			ZBX_NULL2EMPTY_STR(subject));
+#else
+	return zbx_dsprintf(NULL, "[%s]:%hu\n%s\n%s", inet_ntoa(sa.sin_addr), ntohs(sa.sin_port),
+			ZBX_NULL2EMPTY_STR(issuer), ZBX_NULL2EMPTY_STR(subject));
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_tls_session_clean                                            *
+ *                                                                            *
+ * Purpose: release resources of a cached session                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_tls_session_clean(zbx_tls_session_t *session)
+{
+	zbx_free(session->peer);
+#if defined(HAVE_GNUTLS)
+	gnutls_free(session->data.data);
+#elif defined(HAVE_OPENSSL)
+	SSL_SESSION_free(session->session);
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_tls_session_remove                                           *
+ *                                                                            *
+ * Purpose: remove session from the cache                                     *
+ *                                                                            *
+ * Parameters: index - [IN] index of the session in cache                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_tls_session_remove(int index)
+{
+	zbx_tls_session_clean(&tls_sessions[index]);
+
+	if (index != --tls_sessions_num)
+		tls_sessions[index] = tls_sessions[tls_sessions_num];
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_tls_session_find                                             *
+ *                                                                            *
+ * Purpose: find cached session for the specified peer                        *
+ *                                                                            *
+ * Parameters: peer - [IN] session cache key                                  *
+ *                                                                            *
+ * Return value: index of the session in cache or FAIL if not found           *
+ *                                                                            *
+ * Comments: expired session is removed from the cache and not returned       *
+ *                                                                            *
+ ******************************************************************************/
+static int	zbx_tls_session_find(const char *peer)
+{
+	int	i;
+
+	for (i = 0; i < tls_sessions_num; i++)
+	{
+		if (0 != strcmp(tls_sessions[i].peer, peer))
+			continue;
+
+		if (tls_sessions[i].expires > time(NULL))
+			return i;
+
+		zbx_tls_session_remove(i);
+		break;
+	}
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_tls_session_forget                                           *
+ *                                                                            *
+ * Purpose: remove session of the specified peer from the cache, if any       *
+ *                                                                            *
+ * Parameters: peer - [IN] session cache key, can be NULL                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_tls_session_forget(const char *peer)
+{
+	int	index;
+
+	if (NULL != peer && FAIL != (index = zbx_tls_session_find(peer)))
+		zbx_tls_session_remove(index);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_tls_session_store                                            *
+ *                                                                            *
+ * Purpose: store session of an outgoing connection in the cache              *
+ *                                                                            *
+ * Parameters: peer    - [IN] session cache key                               *
+ *             session - [IN] session to store, the cache takes ownership     *
+ *                                                                            *
+ * Comments: if the cache is full the session that expires first is evicted  *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_tls_session_store(const char *peer, zbx_tls_session_t *session)
+{
+	int	index;
+
+	if (NULL == tls_sessions)
+	{
+		tls_sessions = (zbx_tls_session_t *)zbx_malloc(NULL, sizeof(zbx_tls_session_t) *
+				(size_t)CONFIG_TLS_SESSION_CACHE_SIZE);
+	}
+
+	if (FAIL != (index = zbx_tls_session_find(peer)))
+	{
+		zbx_tls_session_clean(&tls_sessions[index]);
+	}
+	else if (tls_sessions_num < CONFIG_TLS_SESSION_CACHE_SIZE)
+	{
+		index = tls_sessions_num++;
+	}
+	else
+	{
+		int	i;
+
+		for (index = 0, i = 1; i < tls_sessions_num; i++)
+		{
+			if (tls_sessions[i].expires < tls_sessions[index].expires)
+				index = i;
+		}
+
+		zbx_tls_session_clean(&tls_sessions[index]);
+	}
+
+	tls_sessions[index] = *session;
+	tls_sessions[index].peer = zbx_strdup(NULL, peer);
+	tls_sessions[index].expires = time(NULL) + CONFIG_TLS_SESSION_LIFETIME;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_tls_sessions_free                                            *
+ *                                                                            *
+ * Purpose: release all cached sessions                                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_tls_sessions_free(void)
+{
+	while (0 < tls_sessions_num)
+		zbx_tls_session_clean(&tls_sessions[--tls_sessions_num]);
+
+	zbx_free(tls_sessions);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_tls_ticket_key_generate                                      *
+ *                                                                            *
+ * Purpose: generate session ticket key to be shared by child processes       *
+ *                                                                            *
+ * Comments: if the key cannot be generated each process will use its own     *
+ *           random key and tickets will be accepted only by the process      *
+ *           which issued them                                                *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_tls_ticket_key_generate(void)
+{
+#if defined(HAVE_GNUTLS)
+	int	res;
+
+	if (GNUTLS_E_SUCCESS != (res = gnutls_session_ticket_key_generate(&ticket_key)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot generate TLS session ticket key: %d %s", res,
+				gnutls_strerror(res));
+		ticket_key.data = NULL;
+	}
+#elif defined(HAVE_OPENSSL)
+	if (1 == RAND_bytes(ticket_keys, sizeof(ticket_keys)))
+		ticket_keys_set = 1;
+	else
+		zabbix_log(LOG_LEVEL_WARNING, "cannot generate TLS session ticket keys");
+#endif
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_tls_get_stats                                                *
+ *                                                                            *
+ * Purpose: get TLS handshake statistics of the current process               *
+ *                                                                            *
+ * Parameters: stats - [OUT] handshake statistics                             *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_tls_get_stats(zbx_tls_stats_t *stats)
+{
+	*stats = tls_stats;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_tls_library_init                                             *
@@ -2683,12 +2959,22 @@ void	zbx_tls_library_deinit(void)
  *                                                                            *
  * Purpose: initialize TLS library in a parent process                        *
  *                                                                            *
+ * Comments: session ticket key is generated here to be shared by all child   *
+ *           processes                                                        *
+ *                                                                            *
  ******************************************************************************/
 void	zbx_tls_init_parent(void)
 {
 #if defined(_WINDOWS)
 	zbx_tls_library_init();		/* on MS Windows initialize crypto libraries in parent thread */
 #endif
+#if defined(ZBX_TLS_SESSION_CACHE)
+	if (0 != CONFIG_TLS_SESSION_LIFETIME && 0 != (program_type & (ZBX_PROGRAM_TYPE_SERVER |
+			ZBX_PROGRAM_TYPE_PROXY | ZBX_PROGRAM_TYPE_AGENTD)))
+	{
+		zbx_tls_ticket_key_generate();
+	}
+#endif
 }
 
 /******************************************************************************
@@ -3160,6 +3446,68 @@ static int	zbx_set_ecdhe_parameters(SSL_CTX *ctx)
 	return ret;
 }
 
+#if defined(ZBX_TLS_SESSION_CACHE)
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_openssl_ticket_decrypt_cb                                    *
+ *                                                                            *
+ * Purpose: decide whether a session can be resumed from decrypted ticket     *
+ *                                                                            *
+ * Comments: only certificate-based sessions are resumed. PSK-based session   *
+ *           would bypass zbx_psk_server_cb() which identifies PSK of the     *
+ *           incoming connection, therefore it requires a full handshake.     *
+ *                                                                            *
+ ******************************************************************************/
+static SSL_TICKET_RETURN	zbx_openssl_ticket_decrypt_cb(SSL *ssl, SSL_SESSION *session,
+		const unsigned char *keyname, size_t keyname_len, SSL_TICKET_STATUS status, void *arg)
+{
+	switch (status)
+	{
+		case SSL_TICKET_SUCCESS:
+		case SSL_TICKET_SUCCESS_RENEW:
+			if (NULL == SSL_SESSION_get0_peer(session))
+				return SSL_TICKET_RETURN_IGNORE_RENEW;
+
+			return SSL_TICKET_SUCCESS == status ? SSL_TICKET_RETURN_USE : SSL_TICKET_RETURN_USE_RENEW;
+		case SSL_TICKET_FATAL_ERR_MALLOC:
+		case SSL_TICKET_FATAL_ERR_OTHER:
+			return SSL_TICKET_RETURN_ABORT;
+		default:
+			return SSL_TICKET_RETURN_IGNORE_RENEW;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_openssl_set_session_tickets                                  *
+ *                                                                            *
+ * Purpose: enable session tickets for certificate-based connections          *
+ *                                                                            *
+ * Parameters: ctx - [IN] context for certificate-based connections           *
+ *                                                                            *
+ * Return value: SUCCEED - session tickets enabled                            *
+ *               FAIL - an error occurred                                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	zbx_openssl_set_session_tickets(SSL_CTX *ctx)
+{
+	SSL_CTX_clear_options(ctx, SSL_OP_NO_TICKET);
+	SSL_CTX_set_timeout(ctx, (long)CONFIG_TLS_SESSION_LIFETIME);
+
+	/* one ticket is enough as only the last session is kept by client */
+	if (1 != SSL_CTX_set_num_tickets(ctx, 1))
+		return FAIL;
+
+	if (1 == ticket_keys_set && 1 != SSL_CTX_set_tlsext_ticket_keys(ctx, ticket_keys, sizeof(ticket_keys)))
+		return FAIL;
+
+	if (1 != SSL_CTX_set_session_ticket_cb(ctx, NULL, zbx_openssl_ticket_decrypt_cb, NULL))
+		return FAIL;
+
+	return SUCCEED;
+}
+#endif
+
 void	zbx_tls_init_child(void)
 {
 #define ZBX_CIPHERS_CERT_ECDHE		"EECDH+aRSA+AES128:"
@@ -3440,6 +3788,15 @@ void	zbx_tls_init_child(void)
 
 		/* disable session caching */
 		SSL_CTX_set_session_cache_mode(ctx_cert, SSL_SESS_CACHE_OFF);
+#if defined(ZBX_TLS_SESSION_CACHE)
+		/* resume sessions with tickets instead, tickets are not kept in library session cache */
+		if (0 != CONFIG_TLS_SESSION_LIFETIME && SUCCEED != zbx_openssl_set_session_tickets(ctx_cert))
+		{
+			zbx_snprintf_alloc(&error, &error_alloc, &error_offset, "cannot set up session tickets for"
+					" certificate context:");
+			goto out;
+		}
+#endif
 
 		/* try to enable ECDH ciphersuites */
 		if (SUCCEED == zbx_set_ecdhe_parameters(ctx_cert))
@@ -3513,6 +3870,14 @@ void	zbx_tls_init_child(void)
 		SSL_CTX_set_options(ctx_all, SSL_OP_CIPHER_SERVER_PREFERENCE | SSL_OP_NO_TICKET);
 		SSL_CTX_clear_options(ctx_all, SSL_OP_LEGACY_SERVER_CONNECT);
 		SSL_CTX_set_session_cache_mode(ctx_all, SSL_SESS_CACHE_OFF);
+#if defined(ZBX_TLS_SESSION_CACHE)
+		if (0 != CONFIG_TLS_SESSION_LIFETIME && SUCCEED != zbx_openssl_set_session_tickets(ctx_all))
+		{
+			zbx_snprintf_alloc(&error, &error_alloc, &error_offset, "cannot set up session tickets for"
+					" certificate and PSK context:");
+			goto out;
+		}
+#endif
 
 		if (SUCCEED == zbx_set_ecdhe_parameters(ctx_all))
 			ciphers = ZBX_CIPHERS_CERT_ECDHE ZBX_CIPHERS_CERT ":" ZBX_CIPHERS_PSK_ECDHE ZBX_CIPHERS_PSK;
@@ -3626,6 +3991,8 @@ void	zbx_tls_free(void)
 	zbx_free(ciphersuites_cert);
 	zbx_free(ciphersuites_all);
 #elif defined(HAVE_GNUTLS)
+	zbx_tls_sessions_free();
+
 	if (NULL != my_cert_creds)
 	{
 		gnutls_certificate_free_credentials(my_cert_creds);
@@ -3666,6 +4033,9 @@ void	zbx_tls_free(void)
 	zbx_tls_library_deinit();
 #endif
 #elif defined(HAVE_OPENSSL)
+#if defined(ZBX_TLS_SESSION_CACHE)
+	zbx_tls_sessions_free();
+#endif
 	if (NULL != ctx_cert)
 		SSL_CTX_free(ctx_cert);
 
@@ -3907,6 +4277,8 @@ int	zbx_tls_connect(zbx_socket_t *s, unsigned int tls_connect, const char *tls_a
 
 	s->connection_type = tls_connect;
 
+	tls_stats.handshakes++;	/* session resumption is not supported with PolarSSL */
+
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():SUCCEED (established %s %s)", __func__,
 			ssl_get_version(s->tls_ctx->ctx), ssl_get_ciphersuite(s->tls_ctx->ctx));
 
@@ -3925,9 +4297,11 @@ out1:
 int	zbx_tls_connect(zbx_socket_t *s, unsigned int tls_connect, const char *tls_arg1, const char *tls_arg2,
 		char **error)
 {
-	int	ret = FAIL, res;
+	int		ret = FAIL, res;
+	unsigned int	flags = GNUTLS_CLIENT | GNUTLS_NO_EXTENSIONS;
+	char		*peer = NULL;
 #if defined(_WINDOWS)
-	double	sec;
+	double		sec;
 #endif
 
 	if (ZBX_TCP_SEC_TLS_CERT == tls_connect)
@@ -3952,10 +4326,14 @@ int	zbx_tls_connect(zbx_socket_t *s, unsigned int tls_connect, const char *tls_a
 	s->tls_ctx->ctx = NULL;
 	s->tls_ctx->psk_client_creds = NULL;
 	s->tls_ctx->psk_server_creds = NULL;
+	s->tls_ctx->session_peer = NULL;
 
-	if (GNUTLS_E_SUCCESS != (res = gnutls_init(&s->tls_ctx->ctx, GNUTLS_CLIENT | GNUTLS_NO_EXTENSIONS)))
-			/* GNUTLS_NO_EXTENSIONS is used because we do not currently support extensions (e.g. session */
-			/* tickets and OCSP) */
+	/* GNUTLS_NO_EXTENSIONS is used because we do not currently support extensions (e.g. OCSP) except */
+	/* session tickets for resumption of certificate-based sessions */
+	if (ZBX_TCP_SEC_TLS_CERT == tls_connect && NULL != (peer = zbx_tls_session_peer(s, tls_arg1, tls_arg2)))
+		flags &= ~GNUTLS_NO_EXTENSIONS;
+
+	if (GNUTLS_E_SUCCESS != (res = gnutls_init(&s->tls_ctx->ctx, flags)))
 	{
 		*error = zbx_dsprintf(*error, "gnutls_init() failed: %d %s", res, gnutls_strerror(res));
 		goto out;
@@ -4075,6 +4453,18 @@ int	zbx_tls_connect(zbx_socket_t *s, unsigned int tls_connect, const char *tls_a
 
 	gnutls_transport_set_int(s->tls_ctx->ctx, ZBX_SOCKET_TO_INT(s->socket));
 
+	if (NULL != peer)
+	{
+		int	index;
+
+		/* try to resume the last session with this peer */
+		if (FAIL != (index = zbx_tls_session_find(peer)) && GNUTLS_E_SUCCESS != gnutls_session_set_data(
+				s->tls_ctx->ctx, tls_sessions[index].data.data, tls_sessions[index].data.size))
+		{
+			zbx_tls_session_remove(index);
+		}
+	}
+
 	/* TLS handshake */
 
 #if defined(_WINDOWS)
@@ -4165,12 +4555,21 @@ int	zbx_tls_connect(zbx_socket_t *s, unsigned int tls_connect, const char *tls_a
 
 	s->connection_type = tls_connect;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():SUCCEED (established %s %s-%s-%s-" ZBX_FS_SIZE_T ")", __func__,
+	tls_stats.handshakes++;
+
+	if (0 != gnutls_session_is_resumed(s->tls_ctx->ctx))
+		tls_stats.resumed++;
+
+	/* session is cached when connection is closed */
+	s->tls_ctx->session_peer = peer;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():SUCCEED (established %s %s-%s-%s-" ZBX_FS_SIZE_T "%s)", __func__,
 			gnutls_protocol_get_name(gnutls_protocol_get_version(s->tls_ctx->ctx)),
 			gnutls_kx_get_name(gnutls_kx_get(s->tls_ctx->ctx)),
 			gnutls_cipher_get_name(gnutls_cipher_get(s->tls_ctx->ctx)),
 			gnutls_mac_get_name(gnutls_mac_get(s->tls_ctx->ctx)),
-			(zbx_fs_size_t)gnutls_mac_get_key_size(gnutls_mac_get(s->tls_ctx->ctx)));
+			(zbx_fs_size_t)gnutls_mac_get_key_size(gnutls_mac_get(s->tls_ctx->ctx)),
+			0 != gnutls_session_is_resumed(s->tls_ctx->ctx) ? ", resumed" : "");
 
 	return SUCCEED;
 
@@ -4186,6 +4585,9 @@ out:	/* an error occurred */
 
 	zbx_free(s->tls_ctx);
 out1:
+	zbx_tls_session_forget(peer);
+	zbx_free(peer);
+
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s error:'%s'", __func__, zbx_result_string(ret),
 			ZBX_NULL2EMPTY_STR(*error));
 	return ret;
@@ -4194,7 +4596,7 @@ out1:
 int	zbx_tls_connect(zbx_socket_t *s, unsigned int tls_connect, const char *tls_arg1, const char *tls_arg2,
 		char **error)
 {
-	int	ret = FAIL, res;
+	int	ret = FAIL, res, resumed;
 	size_t	error_alloc = 0, error_offset = 0;
 #if defined(_WINDOWS)
 	double	sec;
@@ -4202,9 +4604,13 @@ int	zbx_tls_connect(zbx_socket_t *s, unsigned int tls_connect, const char *tls_a
 #if defined(HAVE_OPENSSL_WITH_PSK)
 	char	psk_buf[HOST_TLS_PSK_LEN / 2];
 #endif
+#if defined(ZBX_TLS_SESSION_CACHE)
+	char	*peer = NULL;
+#endif
 
 	s->tls_ctx = zbx_malloc(s->tls_ctx, sizeof(zbx_tls_context_t));
 	s->tls_ctx->ctx = NULL;
+	s->tls_ctx->session_peer = NULL;
 
 	if (ZBX_TCP_SEC_TLS_CERT == tls_connect)
 	{
@@ -4297,7 +4703,16 @@ int	zbx_tls_connect(zbx_socket_t *s, unsigned int tls_connect, const char *tls_a
 		*error = zbx_strdup(*error, "cannot set socket for TLS context");
 		goto out;
 	}
+#if defined(ZBX_TLS_SESSION_CACHE)
+	/* try to resume the last session with this peer */
+	if (ZBX_TCP_SEC_TLS_CERT == tls_connect && NULL != (peer = zbx_tls_session_peer(s, tls_arg1, tls_arg2)))
+	{
+		int	index;
 
+		if (FAIL != (index = zbx_tls_session_find(peer)))
+			SSL_set_session(s->tls_ctx->ctx, tls_sessions[index].session);
+	}
+#endif
 	/* TLS handshake */
 
 	info_buf[0] = '\0';	/* empty buffer for zbx_openssl_info_cb() messages */
@@ -4413,8 +4828,20 @@ int	zbx_tls_connect(zbx_socket_t *s, unsigned int tls_connect, const char *tls_a
 
 	s->connection_type = tls_connect;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():SUCCEED (established %s %s)", __func__,
-			SSL_get_version(s->tls_ctx->ctx), SSL_get_cipher(s->tls_ctx->ctx));
+	/* TLS 1.3 handshake with external PSK is reported as reused session too, count only certificate-based */
+	resumed = (ZBX_TCP_SEC_TLS_CERT == tls_connect && 1 == SSL_session_reused(s->tls_ctx->ctx));
+
+	tls_stats.handshakes++;
+
+	if (0 != resumed)
+		tls_stats.resumed++;
+#if defined(ZBX_TLS_SESSION_CACHE)
+	/* session is cached when connection is closed, TLS 1.3 session ticket is received after handshake */
+	s->tls_ctx->session_peer = peer;
+#endif
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():SUCCEED (established %s %s%s)", __func__,
+			SSL_get_version(s->tls_ctx->ctx), SSL_get_cipher(s->tls_ctx->ctx),
+			0 != resumed ? ", resumed" : "");
 
 	return SUCCEED;
 
@@ -4424,6 +4851,10 @@ out:	/* an error occurred */
 
 	zbx_free(s->tls_ctx);
 out1:
+#if defined(ZBX_TLS_SESSION_CACHE)
+	zbx_tls_session_forget(peer);
+	zbx_free(peer);
+#endif
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s error:'%s'", __func__, zbx_result_string(ret),
 			ZBX_NULL2EMPTY_STR(*error));
 	return ret;
@@ -4625,6 +5056,8 @@ int	zbx_tls_accept(zbx_socket_t *s, unsigned int tls_accept, char **error)
 		/* Issuer and Subject will be verified later, after receiving sender type and host name */
 	}
 
+	tls_stats.handshakes++;	/* session resumption is not supported with PolarSSL */
+
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():SUCCEED (established %s %s)", __func__,
 			ssl_get_version(s->tls_ctx->ctx), ssl_get_ciphersuite(s->tls_ctx->ctx));
 
@@ -4655,6 +5088,7 @@ int	zbx_tls_accept(zbx_socket_t *s, unsigned int tls_accept, char **error)
 	s->tls_ctx->ctx = NULL;
 	s->tls_ctx->psk_client_creds = NULL;
 	s->tls_ctx->psk_server_creds = NULL;
+	s->tls_ctx->session_peer = NULL;
 
 	if (GNUTLS_E_SUCCESS != (res = gnutls_init(&s->tls_ctx->ctx, GNUTLS_SERVER)))
 	{
@@ -4662,6 +5096,20 @@ int	zbx_tls_accept(zbx_socket_t *s, unsigned int tls_accept, char **error)
 		goto out;
 	}
 
+	/* Issue session tickets for resumption of certificate-based sessions. Resumption of PSK-based sessions is */
+	/* refused after the handshake, see below. */
+	if (0 != CONFIG_TLS_SESSION_LIFETIME && NULL != ticket_key.data && 0 != (tls_accept & ZBX_TCP_SEC_TLS_CERT))
+	{
+		if (GNUTLS_E_SUCCESS != (res = gnutls_session_ticket_enable_server(s->tls_ctx->ctx, &ticket_key)))
+		{
+			*error = zbx_dsprintf(*error, "gnutls_session_ticket_enable_server() failed: %d %s", res,
+					gnutls_strerror(res));
+			goto out;
+		}
+
+		gnutls_db_set_cache_expiration(s->tls_ctx->ctx, CONFIG_TLS_SESSION_LIFETIME);
+	}
+
 	/* prepare to accept with certificate */
 
 	if (0 != (tls_accept & ZBX_TCP_SEC_TLS_CERT))
@@ -4868,6 +5316,17 @@ int	zbx_tls_accept(zbx_socket_t *s, unsigned int tls_accept, char **error)
 	{
 		s->connection_type = ZBX_TCP_SEC_TLS_PSK;
 
+		/* Resumed session would bypass the PSK callback that identifies the incoming connection. OpenSSL */
+		/* ignores such tickets in zbx_openssl_ticket_decrypt_cb(), GnuTLS has no callback for ignoring   */
+		/* a valid ticket, so the connection is refused. Zabbix components do not cache PSK-based         */
+		/* sessions, so they are not affected.                                                            */
+		if (0 != gnutls_session_is_resumed(s->tls_ctx->ctx))
+		{
+			*error = zbx_strdup(*error, "resumption of PSK-based session is not allowed");
+			zbx_tls_close(s);
+			goto out1;
+		}
+
 		if (SUCCEED == ZBX_CHECK_LOG_LEVEL(LOG_LEVEL_DEBUG))
 		{
 			const char	*psk_identity;
@@ -4885,12 +5344,18 @@ int	zbx_tls_accept(zbx_socket_t *s, unsigned int tls_accept, char **error)
 		return FAIL;
 	}
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():SUCCEED (established %s %s-%s-%s-" ZBX_FS_SIZE_T ")", __func__,
+	tls_stats.handshakes++;
+
+	if (0 != gnutls_session_is_resumed(s->tls_ctx->ctx))
+		tls_stats.resumed++;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():SUCCEED (established %s %s-%s-%s-" ZBX_FS_SIZE_T "%s)", __func__,
 			gnutls_protocol_get_name(gnutls_protocol_get_version(s->tls_ctx->ctx)),
 			gnutls_kx_get_name(gnutls_kx_get(s->tls_ctx->ctx)),
 			gnutls_cipher_get_name(gnutls_cipher_get(s->tls_ctx->ctx)),
 			gnutls_mac_get_name(gnutls_mac_get(s->tls_ctx->ctx)),
-			(zbx_fs_size_t)gnutls_mac_get_key_size(gnutls_mac_get(s->tls_ctx->ctx)));
+			(zbx_fs_size_t)gnutls_mac_get_key_size(gnutls_mac_get(s->tls_ctx->ctx)),
+			0 != gnutls_session_is_resumed(s->tls_ctx->ctx) ? ", resumed" : "");
 
 	return SUCCEED;
 
@@ -4914,7 +5379,7 @@ out1:
 int	zbx_tls_accept(zbx_socket_t *s, unsigned int tls_accept, char **error)
 {
 	const char	*cipher_name;
-	int		ret = FAIL, res;
+	int		ret = FAIL, res, resumed;
 	size_t		error_alloc = 0, error_offset = 0;
 	long		verify_result;
 #if defined(_WINDOWS)
@@ -4927,6 +5392,7 @@ int	zbx_tls_accept(zbx_socket_t *s, unsigned int tls_accept, char **error)
 
 	s->tls_ctx = zbx_malloc(s->tls_ctx, sizeof(zbx_tls_context_t));
 	s->tls_ctx->ctx = NULL;
+	s->tls_ctx->session_peer = NULL;
 
 #if defined(HAVE_OPENSSL_WITH_PSK)
 	incoming_connection_has_psk = 0;	/* assume certificate-based connection by default */
@@ -5136,8 +5602,16 @@ int	zbx_tls_accept(zbx_socket_t *s, unsigned int tls_accept, char **error)
 		return FAIL;
 	}
 #endif
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():SUCCEED (established %s %s)", __func__,
-			SSL_get_version(s->tls_ctx->ctx), cipher_name);
+	/* TLS 1.3 handshake with external PSK is reported as reused session too, count only certificate-based */
+	resumed = (ZBX_TCP_SEC_TLS_CERT == s->connection_type && 1 == SSL_session_reused(s->tls_ctx->ctx));
+
+	tls_stats.handshakes++;
+
+	if (0 != resumed)
+		tls_stats.resumed++;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():SUCCEED (established %s %s%s)", __func__,
+			SSL_get_version(s->tls_ctx->ctx), cipher_name, 0 != resumed ? ", resumed" : "");
 
 	return SUCCEED;
 
@@ -5392,7 +5866,15 @@ void	zbx_tls_close(zbx_socket_t *s)
 	{
 #if defined(_WINDOWS)
 		double	sec;
+#endif
+		if (NULL != s->tls_ctx->session_peer)
+		{
+			zbx_tls_session_t	session;
 
+			if (GNUTLS_E_SUCCESS == gnutls_session_get_data2(s->tls_ctx->ctx, &session.data))
+				zbx_tls_session_store(s->tls_ctx->session_peer, &session);
+		}
+#if defined(_WINDOWS)
 		zbx_alarm_flag_clear();
 		sec = zbx_time();
 #endif
@@ -5425,9 +5907,25 @@ void	zbx_tls_close(zbx_socket_t *s)
 
 	if (NULL != s->tls_ctx->psk_server_creds)
 		gnutls_psk_free_server_credentials(s->tls_ctx->psk_server_creds);
+
+	zbx_free(s->tls_ctx->session_peer);
 #elif defined(HAVE_OPENSSL)
 	if (NULL != s->tls_ctx->ctx)
 	{
+#if defined(ZBX_TLS_SESSION_CACHE)
+		if (NULL != s->tls_ctx->session_peer)
+		{
+			zbx_tls_session_t	session;
+
+			if (NULL != (session.session = SSL_get1_session(s->tls_ctx->ctx)))
+			{
+				if (1 == SSL_SESSION_is_resumable(session.session))
+					zbx_tls_session_store(s->tls_ctx->session_peer, &session);
+				else
+					SSL_SESSION_free(session.session);
+			}
+		}
+#endif
 		info_buf[0] = '\0';	/* empty buffer for zbx_openssl_info_cb() messages */
 
 		/* After TLS shutdown the TCP conection will be closed. So, there is no need to do a bidirectional */
@@ -5447,6 +5945,8 @@ void	zbx_tls_close(zbx_socket_t *s)
 
 		SSL_free(s->tls_ctx->ctx);
 	}
+
+	zbx_free(s->tls_ctx->session_peer);
 #endif
 	zbx_free(s->tls_ctx);
 }
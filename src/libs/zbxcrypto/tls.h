@@ -75,6 +75,14 @@ void	zbx_tls_pass_vars(ZBX_THREAD_SENDVAL_TLS_ARGS *args);
 void	zbx_tls_take_vars(ZBX_THREAD_SENDVAL_TLS_ARGS *args);
 #endif	/* #if defined(_WINDOWS) */
 
+/* TLS handshake statistics of the current process (thread) */
+typedef struct
+{
+	zbx_uint64_t	handshakes;	/* successful handshakes, incoming and outgoing */
+	zbx_uint64_t	resumed;	/* handshakes which resumed a previous session instead of a full handshake */
+}
+zbx_tls_stats_t;
+
 void	zbx_tls_validate_config(void);
 void	zbx_tls_library_deinit(void);
 void	zbx_tls_init_parent(void);
@@ -82,6 +90,7 @@ void	zbx_tls_init_child(void);
 void	zbx_tls_free(void);
 void	zbx_tls_free_on_signal(void);
 void	zbx_tls_version(void);
+void	zbx_tls_get_stats(zbx_tls_stats_t *stats);
 
 #endif	/* #if defined(HAVE_POLARSSL) || defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL) */
 
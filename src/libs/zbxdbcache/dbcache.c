@@ -2709,10 +2709,11 @@ static void	DCmodule_sync_history(int history_float_num, int history_integer_num
 
 static void	sync_proxy_history(int *total_num, int *more)
 {
-	int			history_num;
+	int			history_num, pb_mode;
 	time_t			sync_start;
 	zbx_vector_ptr_t	history_items;
 	ZBX_DC_HISTORY		history[ZBX_HC_SYNC_MAX];
+	zbx_uint64_t		db_lastid = 0;
 
 	zbx_vector_ptr_create(&history_items);
 	zbx_vector_ptr_reserve(&history_items, ZBX_HC_SYNC_MAX);
@@ -2735,15 +2736,23 @@ static void	sync_proxy_history(int *total_num, int *more)
 
 		hc_get_item_values(history, &history_items);	/* copy item data from history cache */
 
+		/* values are always written to database, proxy memory buffer keeps a copy to be sent from */
+		pb_mode = zbx_pb_history_write_begin();
+
 		do
 		{
 			DBbegin();
 
 			DCmass_proxy_add_history(history, history_num);
 			DCmass_proxy_update_items(history, history_num);
+
+			if (ZBX_PB_MODE_MEMORY == pb_mode)
+				db_lastid = zbx_pb_history_get_db_lastid();
 		}
 		while (ZBX_DB_DOWN == DBcommit());
 
+		zbx_pb_history_write_end(pb_mode, history, history_num, db_lastid);
+
 		LOCK_CACHE;
 
 		hc_push_items(&history_items);	/* return items to history cache */
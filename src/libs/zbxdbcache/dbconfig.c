@@ -94,6 +94,7 @@ extern int		CONFIG_TIMER_FORKS;
 ZBX_MEM_FUNC_IMPL(__config, config_mem)
 
 static void	dc_maintenance_precache_nested_groups(void);
+static void	dc_actions_precache_nested_groups(void);
 
 /******************************************************************************
  *                                                                            *
@@ -284,6 +285,10 @@ static zbx_uint64_t	get_item_nextcheck_seed(zbx_uint64_t itemid, zbx_uint64_t in
 	if (ITEM_TYPE_JMX == type)
 		return interfaceid;
 
+	/* agent items are requested in bulk if enabled, see DCconfig_get_poller_items() */
+	if (ITEM_TYPE_ZABBIX == type)
+		return 0 != CONFIG_AGENT_BULK_REQUESTS ? interfaceid : itemid;
+
 	if (SUCCEED == is_snmp_type(type))
 	{
 		ZBX_DC_INTERFACE	*interface;
@@ -1038,6 +1043,7 @@ static void	DCsync_hosts(zbx_dbsync_t *sync)
 		ZBX_STR2UCHAR(status, row[22]);
 
 		host = (ZBX_DC_HOST *)DCfind_id(&config->hosts, hostid, sizeof(ZBX_DC_HOST), &found);
+		host->revision = ++config->revision;
 
 		/* see whether we should and can update 'hosts_h' and 'hosts_p' indexes at this point */
 
@@ -1398,6 +1404,7 @@ done:
 				proxy->version = 0;
 				proxy->lastaccess = atoi(row[24]);
 				proxy->last_cfg_error_time = 0;
+				proxy->latency = 0;
 			}
 
 			proxy->auto_compress = atoi(row[32 + ZBX_HOST_TLS_OFFSET]);
@@ -1997,6 +2004,8 @@ static void	DCsync_interfaces(zbx_dbsync_t *sync)
 		if (NULL == (host = (ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &hostid)))
 			continue;
 
+		host->revision = ++config->revision;
+
 		interface = (ZBX_DC_INTERFACE *)DCfind_id(&config->interfaces, interfaceid, sizeof(ZBX_DC_INTERFACE), &found);
 		zbx_vector_ptr_append(&interfaces, interface);
 
@@ -2142,6 +2151,8 @@ static void	DCsync_interfaces(zbx_dbsync_t *sync)
 
 		if (NULL != (host = (ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &interface->hostid)))
 		{
+			host->revision = ++config->revision;
+
 			for (i = 0; i < host->interfaces_v.values_num; i++)
 			{
 				if (interface == host->interfaces_v.values[i])
@@ -2334,6 +2345,8 @@ static void	DCsync_items(zbx_dbsync_t *sync, int flags)
 		if (NULL == (host = (ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &hostid)))
 			continue;
 
+		host->revision = ++config->revision;
+
 		item = (ZBX_DC_ITEM *)DCfind_id(&config->items, itemid, sizeof(ZBX_DC_ITEM), &found);
 
 		/* template item */
@@ -2850,10 +2863,12 @@ static void	DCsync_items(zbx_dbsync_t *sync, int flags)
 		if (NULL == (item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &rowid)))
 			continue;
 
-		if (ITEM_STATUS_ACTIVE == item->status &&
-				NULL != (host = (ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &item->hostid)))
+		if (NULL != (host = (ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &item->hostid)))
 		{
-			dc_host_update_agent_stats(host, item->type, -1);
+			host->revision = ++config->revision;
+
+			if (ITEM_STATUS_ACTIVE == item->status)
+				dc_host_update_agent_stats(host, item->type, -1);
 		}
 
 		itemid = item->itemid;
@@ -4962,6 +4977,14 @@ void	DCsync_configuration(unsigned char mode)
 	sec = zbx_time();
 	DCsync_host_tags(&host_tag_sync);
 	host_tag_sec2 = zbx_time() - sec;
+
+	/* template links and macros can affect any host, invalidate all host revisions */
+	if (0 != htmpl_sync.add_num + htmpl_sync.update_num + htmpl_sync.remove_num +
+			gmacro_sync.add_num + gmacro_sync.update_num + gmacro_sync.remove_num +
+			hmacro_sync.add_num + hmacro_sync.update_num + hmacro_sync.remove_num)
+	{
+		config->global_revision = ++config->revision;
+	}
 	FINISH_SYNC;
 
 	/* sync host data to support host lookups when resolving macros during configuration sync */
@@ -5160,6 +5183,9 @@ void	DCsync_configuration(unsigned char mode)
 	DCsync_expressions(&expr_sync);
 	expr_sec2 = zbx_time() - sec;
 
+	if (0 != expr_sync.add_num + expr_sync.update_num + expr_sync.remove_num)
+		config->global_revision = ++config->revision;
+
 	sec = zbx_time();
 	DCsync_actions(&action_sync);
 	action_sec2 = zbx_time() - sec;
@@ -5172,6 +5198,13 @@ void	DCsync_configuration(unsigned char mode)
 	DCsync_action_conditions(&action_condition_sync);
 	action_condition_sec2 = zbx_time() - sec;
 
+	/* pre-cache nested groups used in action conditions to allow read lock during condition checks */
+	if (0 != (update_flags & ZBX_DBSYNC_UPDATE_HOST_GROUPS) || 0 != action_condition_sync.add_num +
+			action_condition_sync.update_num + action_condition_sync.remove_num)
+	{
+		dc_actions_precache_nested_groups();
+	}
+
 	sec = zbx_time();
 	/* relies on triggers, must be after DCsync_triggers() */
 	DCsync_trigger_tags(&trigger_tag_sync);
@@ -5665,6 +5698,22 @@ static int	__config_snmp_item_compare(const ZBX_DC_ITEM *i1, const ZBX_DC_ITEM *
 	return 0;
 }
 
+static int	__config_agent_item_compare(const ZBX_DC_ITEM *i1, const ZBX_DC_ITEM *i2)
+{
+	unsigned char	f1;
+	unsigned char	f2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(i1->interfaceid, i2->interfaceid);
+	ZBX_RETURN_IF_NOT_EQUAL(i1->type, i2->type);
+
+	f1 = ZBX_FLAG_DISCOVERY_RULE & i1->flags;
+	f2 = ZBX_FLAG_DISCOVERY_RULE & i2->flags;
+
+	ZBX_RETURN_IF_NOT_EQUAL(f1, f2);
+
+	return 0;
+}
+
 static int	__config_heap_elem_compare(const void *d1, const void *d2)
 {
 	const zbx_binary_heap_elem_t	*e1 = (const zbx_binary_heap_elem_t *)d1;
@@ -5679,7 +5728,16 @@ static int	__config_heap_elem_compare(const void *d1, const void *d2)
 	if (SUCCEED != is_snmp_type(i1->type))
 	{
 		if (SUCCEED != is_snmp_type(i2->type))
-			return 0;
+		{
+			if (0 == CONFIG_AGENT_BULK_REQUESTS)
+				return 0;
+
+			/* keep agent items of the same interface together for bulk requests */
+			if (ITEM_TYPE_ZABBIX != i1->type || ITEM_TYPE_ZABBIX != i2->type)
+				return (int)(ITEM_TYPE_ZABBIX == i1->type) - (int)(ITEM_TYPE_ZABBIX == i2->type);
+
+			return __config_agent_item_compare(i1, i2);
+		}
 
 		return -1;
 	}
@@ -5974,6 +6032,8 @@ int	init_configuration_cache(char **error)
 	config->availability_diff_ts = 0;
 	config->sync_ts = 0;
 	config->item_sync_ts = 0;
+	config->revision = 0;
+	config->global_revision = 0;
 
 	/* maintenance data are used only when timers are defined (server) */
 	if (0 != CONFIG_TIMER_FORKS)
@@ -6830,6 +6890,59 @@ void	DCconfig_get_items_by_itemids(DC_ITEM *items, const zbx_uint64_t *itemids,
 	UNLOCK_CACHE;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: DCconfig_get_function_items_by_itemids                           *
+ *                                                                            *
+ * Purpose: get items with the properties required to evaluate functions      *
+ *                                                                            *
+ * Parameters: items    - [OUT] pointer to DC_ITEM structures                 *
+ *             itemids  - [IN] array of item IDs                              *
+ *             errcodes - [OUT] SUCCEED if item found, otherwise FAIL         *
+ *             num      - [IN] number of elements                             *
+ *                                                                            *
+ * Comments: Only item identifier, type, value type, status, state, key and   *
+ *           host identifier, name and status are copied. No memory is        *
+ *           allocated, so the returned items must not be cleaned with        *
+ *           DCconfig_clean_items() function.                                 *
+ *                                                                            *
+ ******************************************************************************/
+void	DCconfig_get_function_items_by_itemids(DC_ITEM *items, const zbx_uint64_t *itemids, int *errcodes,
+		size_t num)
+{
+	size_t			i;
+	const ZBX_DC_ITEM	*dc_item;
+	const ZBX_DC_HOST	*dc_host;
+
+	RDLOCK_CACHE;
+
+	for (i = 0; i < num; i++)
+	{
+		if (NULL == (dc_item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &itemids[i])) ||
+				NULL == (dc_host = (ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &dc_item->hostid)))
+		{
+			errcodes[i] = FAIL;
+			continue;
+		}
+
+		items[i].host.hostid = dc_host->hostid;
+		strscpy(items[i].host.host, dc_host->host);
+		items[i].host.status = dc_host->status;
+
+		items[i].itemid = dc_item->itemid;
+		items[i].type = dc_item->type;
+		items[i].value_type = dc_item->value_type;
+		items[i].status = dc_item->status;
+		items[i].state = dc_item->state;
+		strscpy(items[i].key_orig, dc_item->key);
+		items[i].key = NULL;
+
+		errcodes[i] = SUCCEED;
+	}
+
+	UNLOCK_CACHE;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: dc_preproc_item_init                                             *
@@ -7776,9 +7889,11 @@ static void	dc_requeue_item_at(ZBX_DC_ITEM *dc_item, ZBX_DC_HOST *dc_host, int n
  *           always return the items they have taken using DCrequeue_items()  *
  *           or DCpoller_requeue_items().                                     *
  *                                                                            *
- *           Currently batch polling is supported only for JMX, SNMP and      *
- *           icmpping* simple checks. In other cases only single item is      *
- *           retrieved.                                                       *
+ *           Currently batch polling is supported only for JMX, SNMP,         *
+ *           icmpping* simple checks and, if AgentBulkRequests is enabled,    *
+ *           Zabbix agent items of the same interface (except low-level       *
+ *           discovery rules). In other cases only single item is retrieved.  *
+ *           JMX batches can contain items of different hosts.                *
  *                                                                            *
  *           IPMI poller queue are handled by DCconfig_get_ipmi_poller_items()*
  *           function.                                                        *
@@ -7798,7 +7913,8 @@ int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM *items)
 	switch (poller_type)
 	{
 		case ZBX_POLLER_TYPE_JAVA:
-			max_items = MAX_JAVA_ITEMS;
+			/* items of different JMX endpoints are requested in parallel by get_values_java() */
+			max_items = MAX_POLLER_ITEMS;
 			break;
 		case ZBX_POLLER_TYPE_PINGER:
 			max_items = MAX_PINGER_ITEMS;
@@ -7830,9 +7946,9 @@ int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM *items)
 				if (0 != __config_snmp_item_compare(dc_item_prev, dc_item))
 					break;
 			}
-			else if (ITEM_TYPE_JMX == dc_item_prev->type)
+			else if (ITEM_TYPE_ZABBIX == dc_item_prev->type)
 			{
-				if (0 != __config_java_item_compare(dc_item_prev, dc_item))
+				if (0 != __config_agent_item_compare(dc_item_prev, dc_item))
 					break;
 			}
 		}
@@ -7901,6 +8017,13 @@ int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM *items)
 				max_items = DCconfig_get_suggested_snmp_vars_nolock(dc_item->interfaceid, NULL);
 			}
 		}
+
+		/* due agent items of the same interface are requested over a single connection */
+		if (1 == num && 0 != CONFIG_AGENT_BULK_REQUESTS && ZBX_POLLER_TYPE_NORMAL == poller_type &&
+				ITEM_TYPE_ZABBIX == dc_item->type && 0 == (ZBX_FLAG_DISCOVERY_RULE & dc_item->flags))
+		{
+			max_items = MAX_AGENT_ITEMS;
+		}
 	}
 
 	UNLOCK_CACHE;
@@ -8744,6 +8867,14 @@ int	DCset_hosts_availability(zbx_vector_ptr_t *availabilities)
 	return ret;
 }
 
+/* trigger dependency check result, cached during bulk dependency checks */
+typedef struct
+{
+	zbx_uint64_t	triggerid;
+	int		status;
+}
+zbx_dc_trigdep_check_t;
+
 /******************************************************************************
  *                                                                            *
  * Comments: helper function for trigger dependency checking                  *
@@ -8757,6 +8888,14 @@ int	DCset_hosts_availability(zbx_vector_ptr_t *availabilities)
  *                                   for bulk trigger operations              *
  *                                   (optional together with triggerids       *
  *                                   parameter)                               *
+ *             checked        - [IN/OUT] the dependency check results of      *
+ *                                   already checked triggers for bulk        *
+ *                                   trigger operations                       *
+ *                                   (optional, can be NULL)                  *
+ *             truncated_num  - [IN/OUT] the number of checks cut short by    *
+ *                                   the dependency level limit               *
+ *                                   (optional together with checked          *
+ *                                   parameter)                               *
  *                                                                            *
  * Return value: SUCCEED - trigger dependency check succeed / was unresolved  *
  *               FAIL    - otherwise                                          *
@@ -8767,52 +8906,85 @@ int	DCset_hosts_availability(zbx_vector_ptr_t *availabilities)
  *           unresolved master trigger ids will be added to master_triggerids *
  *           vector, so the dependency check can be performed after a new     *
  *           master trigger value has been calculated.                        *
+ *           With bulk checks the failed and fully resolved results are       *
+ *           cached, so master triggers shared by several dependent triggers  *
+ *           are traversed only once. Successful results cut short by the     *
+ *           dependency level limit are not cached, because the same trigger  *
+ *           reached at a lower level must be checked deeper.                 *
  *                                                                            *
  ******************************************************************************/
 static int	DCconfig_check_trigger_dependencies_rec(const ZBX_DC_TRIGGER_DEPLIST *trigdep, int level,
-		const zbx_vector_uint64_t *triggerids, zbx_vector_uint64_t *master_triggerids)
+		const zbx_vector_uint64_t *triggerids, zbx_vector_uint64_t *master_triggerids, zbx_hashset_t *checked,
+		int *truncated_num)
 {
-	int				i;
+	int				i, masters_num = 0, truncated = 0, ret = SUCCEED;
 	const ZBX_DC_TRIGGER		*next_trigger;
 	const ZBX_DC_TRIGGER_DEPLIST	*next_trigdep;
+	zbx_dc_trigdep_check_t		*check, check_local;
 
 	if (ZBX_TRIGGER_DEPENDENCY_LEVELS_MAX < level)
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "recursive trigger dependency is too deep (triggerid:" ZBX_FS_UI64 ")",
 				trigdep->triggerid);
+
+		if (NULL != truncated_num)
+			(*truncated_num)++;
+
 		return SUCCEED;
 	}
 
-	if (0 != trigdep->dependencies.values_num)
+	if (0 == trigdep->dependencies.values_num)
+		return SUCCEED;
+
+	if (NULL != checked)
 	{
-		for (i = 0; i < trigdep->dependencies.values_num; i++)
+		if (NULL != (check = (zbx_dc_trigdep_check_t *)zbx_hashset_search(checked, &trigdep->triggerid)))
+			return check->status;
+
+		masters_num = master_triggerids->values_num;
+		truncated = *truncated_num;
+	}
+
+	for (i = 0; i < trigdep->dependencies.values_num; i++)
+	{
+		next_trigdep = (const ZBX_DC_TRIGGER_DEPLIST *)trigdep->dependencies.values[i];
+
+		if (NULL != (next_trigger = next_trigdep->trigger) &&
+				TRIGGER_STATUS_ENABLED == next_trigger->status &&
+				TRIGGER_FUNCTIONAL_TRUE == next_trigger->functional)
 		{
-			next_trigdep = (const ZBX_DC_TRIGGER_DEPLIST *)trigdep->dependencies.values[i];
 
-			if (NULL != (next_trigger = next_trigdep->trigger) &&
-					TRIGGER_STATUS_ENABLED == next_trigger->status &&
-					TRIGGER_FUNCTIONAL_TRUE == next_trigger->functional)
+			if (NULL == triggerids || FAIL == zbx_vector_uint64_bsearch(triggerids,
+					next_trigger->triggerid, ZBX_DEFAULT_UINT64_COMPARE_FUNC))
 			{
-
-				if (NULL == triggerids || FAIL == zbx_vector_uint64_bsearch(triggerids,
-						next_trigger->triggerid, ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+				if (TRIGGER_VALUE_PROBLEM == next_trigger->value)
 				{
-					if (TRIGGER_VALUE_PROBLEM == next_trigger->value)
-						return FAIL;
+					ret = FAIL;
+					break;
 				}
-				else
-					zbx_vector_uint64_append(master_triggerids, next_trigger->triggerid);
 			}
+			else
+				zbx_vector_uint64_append(master_triggerids, next_trigger->triggerid);
+		}
 
-			if (FAIL == DCconfig_check_trigger_dependencies_rec(next_trigdep, level + 1, triggerids,
-					master_triggerids))
-			{
-				return FAIL;
-			}
+		if (FAIL == DCconfig_check_trigger_dependencies_rec(next_trigdep, level + 1, triggerids,
+				master_triggerids, checked, truncated_num))
+		{
+			ret = FAIL;
+			break;
 		}
 	}
 
-	return SUCCEED;
+	/* checks with unresolved master triggers are not cached as they must return the master trigger ids */
+	if (NULL != checked && (FAIL == ret || (masters_num == master_triggerids->values_num &&
+			truncated == *truncated_num)))
+	{
+		check_local.triggerid = trigdep->triggerid;
+		check_local.status = ret;
+		zbx_hashset_insert(checked, &check_local, sizeof(check_local));
+	}
+
+	return ret;
 }
 
 /******************************************************************************
@@ -8835,7 +9007,7 @@ int	DCconfig_check_trigger_dependencies(zbx_uint64_t triggerid)
 	RDLOCK_CACHE;
 
 	if (NULL != (trigdep = (const ZBX_DC_TRIGGER_DEPLIST *)zbx_hashset_search(&config->trigdeps, &triggerid)))
-		ret = DCconfig_check_trigger_dependencies_rec(trigdep, 0, NULL, NULL);
+		ret = DCconfig_check_trigger_dependencies_rec(trigdep, 0, NULL, NULL, NULL, NULL);
 
 	UNLOCK_CACHE;
 
@@ -9074,6 +9246,43 @@ int	DCconfig_get_last_sync_time(void)
 	return config->sync_ts;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: DCconfig_get_host_revision                                       *
+ *                                                                            *
+ * Purpose: get configuration revision of a host                              *
+ *                                                                            *
+ * Parameters: hostid   - [IN] the host identifier                            *
+ *             revision - [OUT] the host configuration revision               *
+ *                                                                            *
+ * Return value: SUCCEED - the revision was returned                          *
+ *               FAIL    - the host was not found in configuration cache      *
+ *                                                                            *
+ * Comments: The revision changes whenever the host, its interfaces, items or *
+ *           item states change, and when any templates, macros or global     *
+ *           regular expressions change. It is valid only during the current  *
+ *           server run and can be used to detect that data derived from host *
+ *           configuration must be rebuilt.                                   *
+ *                                                                            *
+ ******************************************************************************/
+int	DCconfig_get_host_revision(zbx_uint64_t hostid, zbx_uint64_t *revision)
+{
+	const ZBX_DC_HOST	*dc_host;
+	int			ret = FAIL;
+
+	RDLOCK_CACHE;
+
+	if (NULL != (dc_host = (const ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &hostid)))
+	{
+		*revision = MAX(dc_host->revision, config->global_revision);
+		ret = SUCCEED;
+	}
+
+	UNLOCK_CACHE;
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: DCconfig_get_proxypoller_hosts                                   *
@@ -9171,7 +9380,21 @@ int	DCconfig_get_proxypoller_nextcheck(void)
 	return nextcheck;
 }
 
-void	DCrequeue_proxy(zbx_uint64_t hostid, unsigned char update_nextcheck, int proxy_conn_err)
+/******************************************************************************
+ *                                                                            *
+ * Function: DCrequeue_proxy                                                  *
+ *                                                                            *
+ * Purpose: return passive proxy taken by proxy poller back to the queue      *
+ *                                                                            *
+ * Parameters: hostid           - [IN] the proxy identifier                   *
+ *             update_nextcheck - [IN] the checks to reschedule               *
+ *             proxy_conn_err   - [IN] the poll result                        *
+ *             latency          - [IN] time the proxy took to respond to the  *
+ *                                     last request, negative if no request   *
+ *                                     was answered                           *
+ *                                                                            *
+ ******************************************************************************/
+void	DCrequeue_proxy(zbx_uint64_t hostid, unsigned char update_nextcheck, int proxy_conn_err, double latency)
 {
 	time_t		now;
 	ZBX_DC_HOST	*dc_host;
@@ -9189,6 +9412,9 @@ void	DCrequeue_proxy(zbx_uint64_t hostid, unsigned char update_nextcheck, int pr
 		if (ZBX_LOC_POLLER == dc_proxy->location)
 			dc_proxy->location = ZBX_LOC_NOWHERE;
 
+		if (0 <= latency)
+			dc_proxy->latency = latency;
+
 		/* set or clear passive proxy misconfiguration error timestamp */
 		if (SUCCEED == proxy_conn_err)
 			dc_proxy->last_cfg_error_time = 0;
@@ -10294,6 +10520,47 @@ void	DCget_hostids_by_functionids(zbx_vector_uint64_t *functionids, zbx_vector_u
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s(): found %d hosts", __func__, hostids->values_num);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_dc_get_event_query_functionids                               *
+ *                                                                            *
+ * Purpose: get functionids of event query triggers                           *
+ *                                                                            *
+ * Parameters: event_queries - [IN/OUT] the event suppress queries            *
+ *                                                                            *
+ * Comments: Functions of triggers missing in configuration cache are not     *
+ *           resolved, as their hosts cannot be matched to maintenances.      *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dc_get_event_query_functionids(zbx_vector_ptr_t *event_queries)
+{
+	int				i;
+	const ZBX_DC_TRIGGER		*trigger;
+	zbx_event_suppress_query_t	*query;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() queries:%d", __func__, event_queries->values_num);
+
+	RDLOCK_CACHE;
+
+	for (i = 0; i < event_queries->values_num; i++)
+	{
+		query = (zbx_event_suppress_query_t *)event_queries->values[i];
+
+		if (NULL == (trigger = (const ZBX_DC_TRIGGER *)zbx_hashset_search(&config->triggers,
+				&query->triggerid)))
+		{
+			continue;
+		}
+
+		get_functionids(&query->functionids, trigger->expression);
+		get_functionids(&query->functionids, trigger->recovery_expression);
+	}
+
+	UNLOCK_CACHE;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: dc_get_hosts_by_functionids                                      *
@@ -11178,6 +11445,37 @@ void	zbx_dc_correlation_rules_get(zbx_correlation_rules_t *rules)
 	zbx_vector_ptr_sort(&rules->correlations, ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_hostgroup_get_nested_groupids                                 *
+ *                                                                            *
+ * Purpose: get nested group identifiers without caching them                 *
+ *                                                                            *
+ * Parameters: parent_group    - [IN] the parent group                        *
+ *             nested_groupids - [OUT] the nested group ids                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_hostgroup_get_nested_groupids(const zbx_dc_hostgroup_t *parent_group,
+		zbx_vector_uint64_t *nested_groupids)
+{
+	const zbx_dc_hostgroup_t	*group;
+	int				index, len;
+
+	index = zbx_vector_ptr_bsearch(&config->hostgroups_name, parent_group, dc_compare_hgroups);
+	len = strlen(parent_group->name);
+
+	while (++index < config->hostgroups_name.values_num)
+	{
+		group = (const zbx_dc_hostgroup_t *)config->hostgroups_name.values[index];
+
+		if (0 != strncmp(group->name, parent_group->name, len))
+			break;
+
+		if ('\0' == group->name[len] || '/' == group->name[len])
+			zbx_vector_uint64_append(nested_groupids, group->groupid);
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: dc_hostgroup_cache_nested_groupids                               *
@@ -11187,28 +11485,12 @@ void	zbx_dc_correlation_rules_get(zbx_correlation_rules_t *rules)
  ******************************************************************************/
 void	dc_hostgroup_cache_nested_groupids(zbx_dc_hostgroup_t *parent_group)
 {
-	zbx_dc_hostgroup_t	*group;
-
 	if (0 == (parent_group->flags & ZBX_DC_HOSTGROUP_FLAGS_NESTED_GROUPIDS))
 	{
-		int	index, len;
-
 		zbx_vector_uint64_create_ext(&parent_group->nested_groupids, __config_mem_malloc_func,
 				__config_mem_realloc_func, __config_mem_free_func);
 
-		index = zbx_vector_ptr_bsearch(&config->hostgroups_name, parent_group, dc_compare_hgroups);
-		len = strlen(parent_group->name);
-
-		while (++index < config->hostgroups_name.values_num)
-		{
-			group = (zbx_dc_hostgroup_t *)config->hostgroups_name.values[index];
-
-			if (0 != strncmp(group->name, parent_group->name, len))
-				break;
-
-			if ('\0' == group->name[len] || '/' == group->name[len])
-				zbx_vector_uint64_append(&parent_group->nested_groupids, group->groupid);
-		}
+		dc_hostgroup_get_nested_groupids(parent_group, &parent_group->nested_groupids);
 
 		parent_group->flags |= ZBX_DC_HOSTGROUP_FLAGS_NESTED_GROUPIDS;
 	}
@@ -11258,6 +11540,34 @@ static void	dc_maintenance_precache_nested_groups(void)
 	zbx_vector_uint64_destroy(&groupids);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_actions_precache_nested_groups                                *
+ *                                                                            *
+ * Purpose: pre-caches nested groups for groups used in action conditions     *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_actions_precache_nested_groups(void)
+{
+	zbx_hashset_iter_t		iter;
+	const zbx_dc_action_condition_t	*condition;
+	zbx_dc_hostgroup_t		*group;
+	zbx_uint64_t			groupid;
+
+	zbx_hashset_iter_reset(&config->action_conditions, &iter);
+	while (NULL != (condition = (const zbx_dc_action_condition_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (CONDITION_TYPE_HOST_GROUP != condition->conditiontype)
+			continue;
+
+		if (SUCCEED != is_uint64(condition->value, &groupid))
+			continue;
+
+		if (NULL != (group = (zbx_dc_hostgroup_t *)zbx_hashset_search(&config->hostgroups, &groupid)))
+			dc_hostgroup_cache_nested_groupids(group);
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: dc_get_nested_hostgroupids                                       *
@@ -11318,6 +11628,74 @@ void	zbx_dc_get_nested_hostgroupids(zbx_uint64_t *groupids, int groupids_num, zb
 	zbx_vector_uint64_uniq(nested_groupids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_dc_check_hosts_in_hostgroup                                  *
+ *                                                                            *
+ * Purpose: checks if any of the hosts belongs to the host group or to its    *
+ *          nested groups                                                     *
+ *                                                                            *
+ * Parameter: hostids - [IN] the host identifiers                             *
+ *            groupid - [IN] the host group identifier                        *
+ *                                                                            *
+ * Return value: SUCCEED - at least one host belongs to the group             *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Nested groups of groups used in action conditions are cached     *
+ *           during configuration sync, other groups are resolved without     *
+ *           caching, so only read lock is needed.                            *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_dc_check_hosts_in_hostgroup(const zbx_vector_uint64_t *hostids, zbx_uint64_t groupid)
+{
+	int			i, j, ret = FAIL;
+	zbx_vector_uint64_t	groupids;
+	zbx_dc_hostgroup_t	*group;
+
+	if (0 == hostids->values_num)
+		return FAIL;
+
+	zbx_vector_uint64_create(&groupids);
+	zbx_vector_uint64_append(&groupids, groupid);
+
+	RDLOCK_CACHE;
+
+	if (NULL != (group = (zbx_dc_hostgroup_t *)zbx_hashset_search(&config->hostgroups, &groupid)))
+	{
+		if (0 != (group->flags & ZBX_DC_HOSTGROUP_FLAGS_NESTED_GROUPIDS))
+		{
+			zbx_vector_uint64_append_array(&groupids, group->nested_groupids.values,
+					group->nested_groupids.values_num);
+		}
+		else
+			dc_hostgroup_get_nested_groupids(group, &groupids);
+	}
+
+	for (i = 0; i < groupids.values_num && SUCCEED != ret; i++)
+	{
+		if (NULL == (group = (zbx_dc_hostgroup_t *)zbx_hashset_search(&config->hostgroups,
+				&groupids.values[i])))
+		{
+			continue;
+		}
+
+		for (j = 0; j < hostids->values_num; j++)
+		{
+			if (NULL != zbx_hashset_search(&group->hostids, &hostids->values[j]))
+			{
+				ret = SUCCEED;
+				break;
+			}
+		}
+	}
+
+	UNLOCK_CACHE;
+
+	zbx_vector_uint64_destroy(&groupids);
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_dc_get_nested_hostgroupids_by_names                          *
@@ -11405,6 +11783,57 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_dc_get_proxy_latency                                         *
+ *                                                                            *
+ * Purpose: gets time passive proxy took to respond to the last request of    *
+ *          proxy poller                                                      *
+ *                                                                            *
+ * Parameters:                                                                *
+ *     name    - [IN] the proxy name                                          *
+ *     latency - [OUT] the response time in seconds                           *
+ *     error   - [OUT] error message                                          *
+ *                                                                            *
+ * Return value:                                                              *
+ *     SUCCEED - the response time was retrieved successfully                 *
+ *     FAIL    - failed to retrieve the response time, error message is set   *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_dc_get_proxy_latency(const char *name, double *latency, char **error)
+{
+	int			ret = FAIL;
+	const ZBX_DC_HOST	*dc_host;
+	const ZBX_DC_PROXY	*dc_proxy;
+
+	RDLOCK_CACHE;
+
+	if (NULL == (dc_host = DCfind_proxy(name)))
+	{
+		*error = zbx_dsprintf(*error, "proxy \"%s\" not found", name);
+		goto out;
+	}
+
+	if (HOST_STATUS_PROXY_PASSIVE != dc_host->status)
+	{
+		*error = zbx_dsprintf(*error, "proxy \"%s\" is configured for active mode", name);
+		goto out;
+	}
+
+	if (NULL == (dc_proxy = (const ZBX_DC_PROXY *)zbx_hashset_search(&config->proxies, &dc_host->hostid)))
+	{
+		*error = zbx_dsprintf(*error, "proxy \"%s\" not found in configuration cache", name);
+		goto out;
+	}
+
+	*latency = dc_proxy->latency;
+	ret = SUCCEED;
+out:
+	UNLOCK_CACHE;
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_dc_items_update_nextcheck                                    *
@@ -11555,9 +11984,16 @@ void	DCconfig_items_apply_changes(const zbx_vector_ptr_t *item_diff)
 		if (0 != (ZBX_FLAGS_ITEM_DIFF_UPDATE_ERROR & diff->flags))
 			DCstrpool_replace(1, &dc_item->error, diff->error);
 
-		if (0 != (ZBX_FLAGS_ITEM_DIFF_UPDATE_STATE & diff->flags))
+		if (0 != (ZBX_FLAGS_ITEM_DIFF_UPDATE_STATE & diff->flags) && dc_item->state != diff->state)
+		{
+			ZBX_DC_HOST	*dc_host;
+
 			dc_item->state = diff->state;
 
+			if (NULL != (dc_host = (ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &dc_item->hostid)))
+				dc_host->revision = ++config->revision;
+		}
+
 		if (0 != (ZBX_FLAGS_ITEM_DIFF_UPDATE_LASTCLOCK & diff->flags))
 			dc_item->lastclock = diff->lastclock;
 	}
@@ -11700,14 +12136,18 @@ int	DCget_host_inventory_value_by_hostid(zbx_uint64_t hostid, char **replace_to,
  ******************************************************************************/
 void	zbx_dc_get_trigger_dependencies(const zbx_vector_uint64_t *triggerids, zbx_vector_ptr_t *deps)
 {
-	int				i, ret;
+	int				i, ret, truncated_num = 0;
 	const ZBX_DC_TRIGGER_DEPLIST	*trigdep;
 	zbx_vector_uint64_t		masterids;
 	zbx_trigger_dep_t		*dep;
+	zbx_hashset_t			checked;
 
 	zbx_vector_uint64_create(&masterids);
 	zbx_vector_uint64_reserve(&masterids, 64);
 
+	zbx_hashset_create(&checked, triggerids->values_num, ZBX_DEFAULT_UINT64_HASH_FUNC,
+			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
 	RDLOCK_CACHE;
 
 	for (i = 0; i < triggerids->values_num; i++)
@@ -11715,7 +12155,8 @@ void	zbx_dc_get_trigger_dependencies(const zbx_vector_uint64_t *triggerids, zbx_
 		if (NULL == (trigdep = (ZBX_DC_TRIGGER_DEPLIST *)zbx_hashset_search(&config->trigdeps, &triggerids->values[i])))
 			continue;
 
-		if (FAIL == (ret = DCconfig_check_trigger_dependencies_rec(trigdep, 0, triggerids, &masterids)) ||
+		if (FAIL == (ret = DCconfig_check_trigger_dependencies_rec(trigdep, 0, triggerids, &masterids,
+				&checked, &truncated_num)) ||
 				0 != masterids.values_num)
 		{
 			dep = (zbx_trigger_dep_t *)zbx_malloc(NULL, sizeof(zbx_trigger_dep_t));
@@ -11738,6 +12179,7 @@ void	zbx_dc_get_trigger_dependencies(const zbx_vector_uint64_t *triggerids, zbx_
 
 	UNLOCK_CACHE;
 
+	zbx_hashset_destroy(&checked);
 	zbx_vector_uint64_destroy(&masterids);
 }
 
@@ -339,6 +339,9 @@ typedef struct
 	/* flag to force update for all items */
 	unsigned char	update_items;
 
+	/* revision of the last change of host, its interfaces, items or their states */
+	zbx_uint64_t	revision;
+
 	/* 'tls_connect' and 'tls_accept' must be respected even if encryption support is not compiled in */
 	unsigned char	tls_connect;
 	unsigned char	tls_accept;
@@ -390,6 +393,7 @@ typedef struct
 	unsigned char	auto_compress;
 	const char	*proxy_address;
 	int		last_version_error_time;
+	double		latency;		/* time passive proxy took to respond to the last request */
 }
 ZBX_DC_PROXY;
 
@@ -729,6 +733,10 @@ typedef struct
 	int			sync_ts;
 	int			item_sync_ts;
 
+	/* configuration revisions, see DCconfig_get_host_revision() */
+	zbx_uint64_t		revision;
+	zbx_uint64_t		global_revision;
+
 	/* maintenance processing management */
 	unsigned char		maintenance_update;		/* flag to trigger maintenance update by timers  */
 	zbx_uint64_t		*maintenance_update_flags;	/* Array of flags to manage timer maintenance updates.*/
@@ -0,0 +1,695 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2019 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "common.h"
+#include "log.h"
+#include "db.h"
+#include "dbcache.h"
+#include "mutexs.h"
+#include "memalloc.h"
+#include "proxy.h"
+
+/*
+ * Proxy memory buffer
+ *
+ * Collected values are written to proxy_history table as usual and are also
+ * kept in shared memory, so that they are sent to server from memory without
+ * reading them back from database. The buffer falls back to database mode
+ * when it runs out of memory or when server cannot be reached - the buffered
+ * records are simply dropped as they are already stored in database. In
+ * database mode the values are sent from proxy_history table until the
+ * backlog is sent, then the buffer switches back to memory mode.
+ *
+ * The proxy_history record identifiers are generated by database, so in
+ * memory mode history syncers write proxy_history table one at a time and
+ * each buffered record remembers the last proxy_history identifier of its
+ * batch. The history_lastid in ids table is advanced to that identifier only
+ * after server has acknowledged all records of the batch. If proxy terminates
+ * abnormally the values not yet acknowledged are sent again from database.
+ *
+ * Record identifiers of memory and database modes are not related, so the
+ * database record identifiers are shifted by id_offset when sent to server
+ * to keep the identifiers within a data session increasing.
+ */
+
+struct zbx_pb_history
+{
+	zbx_uint64_t		id;
+	/* the last proxy_history record identifier of the batch the record was written with */
+	zbx_uint64_t		db_id;
+	zbx_uint64_t		itemid;
+	zbx_uint64_t		lastlogsize;
+	int			clock;
+	int			ns;
+	int			timestamp;
+	int			severity;
+	int			logeventid;
+	int			mtime;
+	unsigned char		state;
+	unsigned char		flags;
+	char			*source;
+	char			*value;
+	struct zbx_pb_history	*next;
+};
+
+typedef struct
+{
+	/* the buffered records, ordered by id */
+	zbx_pb_history_t	*head;
+	zbx_pb_history_t	*tail;
+	int			history_num;
+
+	int			mode;
+
+	/* the number of processes writing to proxy_history table */
+	int			db_writers;
+
+	/* the number of finished proxy_history table writes */
+	zbx_uint64_t		db_inserts;
+
+	/* the last record identifier assigned in memory mode */
+	zbx_uint64_t		history_lastid;
+
+	/* the last acknowledged proxy_history record identifier */
+	zbx_uint64_t		db_lastid;
+
+	/* the offset added to proxy_history record identifiers when sending them to server */
+	zbx_uint64_t		id_offset;
+}
+zbx_pb_t;
+
+static zbx_pb_t		*pb = NULL;
+static zbx_mem_info_t	*pb_mem = NULL;
+static zbx_mutex_t	pb_lock = ZBX_MUTEX_NULL;
+static zbx_mutex_t	pb_db_lock = ZBX_MUTEX_NULL;
+
+#define LOCK_PB		zbx_mutex_lock(pb_lock)
+#define UNLOCK_PB	zbx_mutex_unlock(pb_lock)
+
+/******************************************************************************
+ *                                                                            *
+ * Function: pb_history_append                                                *
+ *                                                                            *
+ * Purpose: copy history record to the memory buffer                          *
+ *                                                                            *
+ * Parameters: hd     - [IN] the history record without strings               *
+ *             source - [IN] the log source                                   *
+ *             value  - [IN] the value                                        *
+ *                                                                            *
+ * Return value: SUCCEED - the record was added                               *
+ *               FAIL    - not enough memory                                  *
+ *                                                                            *
+ * Comments: The record and its strings are allocated as a single block.      *
+ *                                                                            *
+ ******************************************************************************/
+static int	pb_history_append(const zbx_pb_history_t *hd, const char *source, const char *value)
+{
+	zbx_pb_history_t	*record;
+	size_t			source_len, value_len;
+
+	source_len = strlen(source) + 1;
+	value_len = strlen(value) + 1;
+
+	if (NULL == (record = (zbx_pb_history_t *)zbx_mem_malloc(pb_mem, NULL,
+			sizeof(zbx_pb_history_t) + source_len + value_len)))
+	{
+		return FAIL;
+	}
+
+	*record = *hd;
+	record->id = ++pb->history_lastid;
+	record->source = (char *)(record + 1);
+	record->value = record->source + source_len;
+	record->next = NULL;
+
+	memcpy(record->source, source, source_len);
+	memcpy(record->value, value, value_len);
+
+	if (NULL == pb->tail)
+		pb->head = record;
+	else
+		pb->tail->next = record;
+
+	pb->tail = record;
+	pb->history_num++;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: pb_history_add_value                                             *
+ *                                                                            *
+ * Purpose: add history value to the memory buffer                            *
+ *                                                                            *
+ * Parameters: h     - [IN] the history value                                 *
+ *             db_id - [IN] the last proxy_history record identifier of the   *
+ *                          batch the value was written with                  *
+ *                                                                            *
+ * Return value: SUCCEED - the value was added or skipped                     *
+ *               FAIL    - not enough memory                                  *
+ *                                                                            *
+ * Comments: The values are converted in the same way as in                   *
+ *           DCmass_proxy_add_history() for proxy_history table.              *
+ *                                                                            *
+ ******************************************************************************/
+static int	pb_history_add_value(const ZBX_DC_HISTORY *h, zbx_uint64_t db_id)
+{
+	zbx_pb_history_t	hd;
+	char			buffer[64];
+	const char		*value = "", *source = "";
+
+	memset(&hd, 0, sizeof(hd));
+	hd.db_id = db_id;
+	hd.itemid = h->itemid;
+	hd.clock = h->ts.sec;
+	hd.ns = h->ts.ns;
+
+	if (ITEM_STATE_NOTSUPPORTED == h->state)
+	{
+		hd.state = h->state;
+		return pb_history_append(&hd, source, ZBX_NULL2EMPTY_STR(h->value.err));
+	}
+
+	if (ITEM_VALUE_TYPE_LOG != h->value_type && 0 != (h->flags & ZBX_DC_FLAG_UNDEF))
+		return SUCCEED;
+
+	if (0 != (h->flags & ZBX_DC_FLAG_META) ||
+			(ITEM_VALUE_TYPE_LOG == h->value_type && 0 != (h->flags & ZBX_DC_FLAG_NOVALUE)))
+	{
+		hd.flags = PROXY_HISTORY_FLAG_META;
+		hd.lastlogsize = h->lastlogsize;
+		hd.mtime = h->mtime;
+	}
+
+	if (0 != (h->flags & ZBX_DC_FLAG_NOVALUE))
+	{
+		hd.flags |= PROXY_HISTORY_FLAG_NOVALUE;
+		return pb_history_append(&hd, source, value);
+	}
+
+	switch (h->value_type)
+	{
+		case ITEM_VALUE_TYPE_FLOAT:
+			zbx_snprintf(buffer, sizeof(buffer), ZBX_FS_DBL, h->value.dbl);
+			value = buffer;
+			break;
+		case ITEM_VALUE_TYPE_UINT64:
+			zbx_snprintf(buffer, sizeof(buffer), ZBX_FS_UI64, h->value.ui64);
+			value = buffer;
+			break;
+		case ITEM_VALUE_TYPE_STR:
+		case ITEM_VALUE_TYPE_TEXT:
+			value = h->value.str;
+			break;
+		case ITEM_VALUE_TYPE_LOG:
+			hd.timestamp = h->value.log->timestamp;
+			hd.severity = h->value.log->severity;
+			hd.logeventid = h->value.log->logeventid;
+			source = ZBX_NULL2EMPTY_STR(h->value.log->source);
+			value = h->value.log->value;
+			break;
+		default:
+			THIS_SHOULD_NEVER_HAPPEN;
+			return SUCCEED;
+	}
+
+	return pb_history_append(&hd, source, value);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: pb_history_free                                                  *
+ *                                                                            *
+ * Purpose: free a list of buffered records                                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	pb_history_free(zbx_pb_history_t *hd)
+{
+	zbx_pb_history_t	*next;
+
+	for (; NULL != hd; hd = next)
+	{
+		next = hd->next;
+		zbx_mem_free(pb_mem, hd);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: pb_spill                                                         *
+ *                                                                            *
+ * Purpose: drop the buffered records and switch the buffer to database mode  *
+ *                                                                            *
+ * Comments: This function must be called with the buffer locked in memory    *
+ *           mode. The buffered records are already stored in proxy_history   *
+ *           table, so they are sent again from there.                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	pb_spill(void)
+{
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() dropping %d buffered values", __func__, pb->history_num);
+
+	pb_history_free(pb->head);
+	pb->head = NULL;
+	pb->tail = NULL;
+	pb->history_num = 0;
+
+	/* all proxy_history records up to db_lastid were acknowledged, so the */
+	/* records sent from database will have identifiers greater than it    */
+	pb->id_offset = pb->history_lastid - pb->db_lastid;
+
+	pb->mode = ZBX_PB_MODE_DATABASE;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: init_proxy_buffer                                                *
+ *                                                                            *
+ * Purpose: create proxy memory buffer                                        *
+ *                                                                            *
+ * Parameters: size  - [IN] the buffer size, 0 - the buffer is disabled       *
+ *             error - [OUT] the error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - the buffer was created or is disabled              *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The buffer starts in database mode so that values left in        *
+ *           proxy_history table by previous proxy run are sent first.        *
+ *                                                                            *
+ ******************************************************************************/
+int	init_proxy_buffer(zbx_uint64_t size, char **error)
+{
+	int	ret = SUCCEED;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() size:" ZBX_FS_UI64, __func__, size);
+
+	if (0 == size)
+		goto out;
+
+	if (SUCCEED != (ret = zbx_mutex_create(&pb_lock, ZBX_MUTEX_PROXY_BUFFER, error)))
+		goto out;
+
+	if (SUCCEED != (ret = zbx_mutex_create(&pb_db_lock, ZBX_MUTEX_PROXY_BUFFER_DB, error)))
+		goto out;
+
+	if (SUCCEED != (ret = zbx_mem_create(&pb_mem, size, "proxy memory buffer", "ProxyMemoryBufferSize", 1,
+			error)))
+	{
+		goto out;
+	}
+
+	if (NULL == (pb = (zbx_pb_t *)zbx_mem_malloc(pb_mem, NULL, sizeof(zbx_pb_t))))
+	{
+		*error = zbx_strdup(*error, "not enough space for proxy memory buffer");
+		ret = FAIL;
+		goto out;
+	}
+
+	memset(pb, 0, sizeof(zbx_pb_t));
+	pb->mode = ZBX_PB_MODE_DATABASE;
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: free_proxy_buffer                                                *
+ *                                                                            *
+ * Purpose: destroy proxy memory buffer                                       *
+ *                                                                            *
+ * Comments: The buffered values are already stored in proxy_history table    *
+ *           and are sent from there after proxy restart.                     *
+ *                                                                            *
+ ******************************************************************************/
+void	free_proxy_buffer(void)
+{
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	if (NULL != pb)
+	{
+		pb = NULL;
+		zbx_mutex_destroy(&pb_db_lock);
+		zbx_mutex_destroy(&pb_lock);
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_pb_history_write_begin                                       *
+ *                                                                            *
+ * Purpose: start writing history values to proxy_history table               *
+ *                                                                            *
+ * Return value: ZBX_PB_MODE_MEMORY   - the values must be added to the       *
+ *                                      memory buffer after writing them to   *
+ *                                      database                              *
+ *               ZBX_PB_MODE_DATABASE - the values are sent from database     *
+ *                                                                            *
+ * Comments: In memory mode proxy_history table writes are serialized until   *
+ *           zbx_pb_history_write_end() is called, so that the buffered       *
+ *           records can be mapped to proxy_history record identifiers.       *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_pb_history_write_begin(void)
+{
+	int	mode;
+
+	if (NULL == pb)
+		return ZBX_PB_MODE_DATABASE;
+
+	LOCK_PB;
+
+	pb->db_writers++;
+	mode = pb->mode;
+
+	UNLOCK_PB;
+
+	if (ZBX_PB_MODE_MEMORY == mode)
+		zbx_mutex_lock(pb_db_lock);
+
+	return mode;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_pb_history_get_db_lastid                                     *
+ *                                                                            *
+ * Purpose: get the last proxy_history record identifier                      *
+ *                                                                            *
+ * Return value: the last proxy_history record identifier                     *
+ *                                                                            *
+ * Comments: Must be called inside the transaction writing the values in      *
+ *           memory mode, after the values have been written.                 *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint64_t	zbx_pb_history_get_db_lastid(void)
+{
+	DB_RESULT	result;
+	DB_ROW		row;
+	zbx_uint64_t	lastid = 0;
+
+	result = DBselect("select max(id) from proxy_history");
+
+	if (NULL != (row = DBfetch(result)) && SUCCEED != DBis_null(row[0]))
+		ZBX_STR2UINT64(lastid, row[0]);
+
+	DBfree_result(result);
+
+	return lastid;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_pb_history_write_end                                         *
+ *                                                                            *
+ * Purpose: finish writing history values to proxy_history table and add them *
+ *          to the memory buffer                                              *
+ *                                                                            *
+ * Parameters: mode        - [IN] the mode returned by                        *
+ *                                zbx_pb_history_write_begin()                *
+ *             history     - [IN] the written history values                  *
+ *             history_num - [IN] the number of history values                *
+ *             db_lastid   - [IN] the last proxy_history record identifier    *
+ *                                after the values were written               *
+ *                                                                            *
+ * Comments: Must be called after the values have been committed. If the      *
+ *           buffer ran out of memory or was switched to database mode        *
+ *           meanwhile, the values are sent from database.                    *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_pb_history_write_end(int mode, const ZBX_DC_HISTORY *history, int history_num,
+		zbx_uint64_t db_lastid)
+{
+	int	i;
+
+	if (NULL == pb)
+		return;
+
+	LOCK_PB;
+
+	if (ZBX_PB_MODE_MEMORY == mode && ZBX_PB_MODE_MEMORY == pb->mode)
+	{
+		for (i = 0; i < history_num; i++)
+		{
+			if (SUCCEED != pb_history_add_value(&history[i], db_lastid))
+			{
+				pb_spill();
+				break;
+			}
+		}
+	}
+
+	pb->db_writers--;
+	pb->db_inserts++;
+
+	UNLOCK_PB;
+
+	if (ZBX_PB_MODE_MEMORY == mode)
+		zbx_mutex_unlock(pb_db_lock);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_pb_history_spill                                             *
+ *                                                                            *
+ * Purpose: drop buffered values and continue sending them from database      *
+ *                                                                            *
+ * Comments: Called when server cannot be reached, so that the memory buffer  *
+ *           is not filled while the values are kept in database anyway.      *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_pb_history_spill(void)
+{
+	if (NULL == pb)
+		return;
+
+	LOCK_PB;
+
+	if (ZBX_PB_MODE_MEMORY == pb->mode)
+		pb_spill();
+
+	UNLOCK_PB;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_pb_get_state                                                 *
+ *                                                                            *
+ * Purpose: get the buffer state before reading history values to be sent     *
+ *                                                                            *
+ * Parameters: state - [OUT] the buffer state                                 *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_pb_get_state(zbx_pb_state_t *state)
+{
+	if (NULL == pb)
+	{
+		memset(state, 0, sizeof(zbx_pb_state_t));
+		state->mode = ZBX_PB_MODE_DATABASE;
+		return;
+	}
+
+	LOCK_PB;
+
+	state->mode = pb->mode;
+	state->db_writers = pb->db_writers;
+	state->db_inserts = pb->db_inserts;
+	state->id_offset = pb->id_offset;
+
+	UNLOCK_PB;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_pb_set_memory_mode                                           *
+ *                                                                            *
+ * Purpose: switch the buffer to memory mode after all proxy_history records  *
+ *          have been sent                                                    *
+ *                                                                            *
+ * Parameters: state  - [IN] the buffer state before proxy_history table was  *
+ *                           read                                             *
+ *             lastid - [IN] the last sent proxy_history record identifier    *
+ *                                                                            *
+ * Comments: The mode is not changed if proxy_history table was written since *
+ *           the state was taken, as new records might have been missed.      *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_pb_set_memory_mode(const zbx_pb_state_t *state, zbx_uint64_t lastid)
+{
+	if (NULL == pb || 0 != state->db_writers)
+		return;
+
+	LOCK_PB;
+
+	if (ZBX_PB_MODE_DATABASE == pb->mode && 0 == pb->db_writers && state->db_inserts == pb->db_inserts)
+	{
+		pb->mode = ZBX_PB_MODE_MEMORY;
+		pb->db_lastid = lastid;
+
+		if (pb->history_lastid < lastid + pb->id_offset)
+			pb->history_lastid = lastid + pb->id_offset;
+
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() switched proxy buffer to memory mode", __func__);
+	}
+
+	UNLOCK_PB;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_pb_history_get                                               *
+ *                                                                            *
+ * Purpose: read history data from the memory buffer                          *
+ *                                                                            *
+ * Comments: See proxy_get_history_data() for parameter descriptions.         *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_pb_history_get(zbx_uint64_t lastid, zbx_history_data_t **data, size_t *data_alloc,
+		char **string_buffer, size_t *string_buffer_alloc, int *more)
+{
+	size_t			data_num = 0, string_buffer_offset = 0;
+	const zbx_pb_history_t	*record;
+	zbx_history_data_t	*hd;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() lastid:" ZBX_FS_UI64, __func__, lastid);
+
+	if (NULL == pb)
+	{
+		*more = ZBX_PROXY_DATA_DONE;
+		goto out;
+	}
+
+	LOCK_PB;
+
+	for (record = pb->head; NULL != record && ZBX_MAX_HRECORDS != data_num; record = record->next)
+	{
+		if (record->id <= lastid)
+			continue;
+
+		if (*data_alloc == data_num)
+		{
+			*data_alloc *= 2;
+			*data = (zbx_history_data_t *)zbx_realloc(*data, sizeof(zbx_history_data_t) * *data_alloc);
+		}
+
+		hd = *data + data_num++;
+		hd->id = record->id;
+		hd->itemid = record->itemid;
+		hd->lastlogsize = record->lastlogsize;
+		hd->clock = record->clock;
+		hd->ns = record->ns;
+		hd->timestamp = record->timestamp;
+		hd->severity = record->severity;
+		hd->logeventid = record->logeventid;
+		hd->mtime = record->mtime;
+		hd->state = record->state;
+		hd->flags = record->flags;
+
+		if (0 == (hd->flags & PROXY_HISTORY_FLAG_NOVALUE))
+		{
+			size_t	len1, len2;
+
+			len1 = strlen(record->source) + 1;
+			len2 = strlen(record->value) + 1;
+
+			if (*string_buffer_alloc < string_buffer_offset + len1 + len2)
+			{
+				while (*string_buffer_alloc < string_buffer_offset + len1 + len2)
+					*string_buffer_alloc += ZBX_KIBIBYTE;
+
+				*string_buffer = (char *)zbx_realloc(*string_buffer, *string_buffer_alloc);
+			}
+
+			hd->source_offset = string_buffer_offset;
+			memcpy(*string_buffer + hd->source_offset, record->source, len1);
+			string_buffer_offset += len1;
+
+			hd->value_offset = string_buffer_offset;
+			memcpy(*string_buffer + hd->value_offset, record->value, len2);
+			string_buffer_offset += len2;
+		}
+	}
+
+	UNLOCK_PB;
+
+	if (ZBX_MAX_HRECORDS != data_num)
+		*more = ZBX_PROXY_DATA_DONE;
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() data_num:" ZBX_FS_SIZE_T, __func__, data_num);
+
+	return data_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_pb_history_ack                                               *
+ *                                                                            *
+ * Purpose: remove values sent to server from the memory buffer               *
+ *                                                                            *
+ * Parameters: lastid    - [IN] the last sent record identifier               *
+ *             db_lastid - [OUT] the last proxy_history record identifier     *
+ *                               with all preceding records acknowledged      *
+ *                                                                            *
+ * Return value: SUCCEED - db_lastid was advanced and must be stored as       *
+ *                         proxy_history last sent record identifier          *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The proxy_history identifier is advanced only when all records   *
+ *           of a batch are acknowledged. The values might have been spilled  *
+ *           to database meanwhile - then they are sent again from database.  *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_pb_history_ack(zbx_uint64_t lastid, zbx_uint64_t *db_lastid)
+{
+	zbx_pb_history_t	*hd;
+	zbx_uint64_t		db_id = 0;
+	int			ret = FAIL;
+
+	if (NULL == pb)
+		return FAIL;
+
+	LOCK_PB;
+
+	while (NULL != (hd = pb->head) && hd->id <= lastid)
+	{
+		db_id = hd->db_id;
+		pb->head = hd->next;
+		pb->history_num--;
+		zbx_mem_free(pb_mem, hd);
+	}
+
+	if (NULL == pb->head)
+		pb->tail = NULL;
+
+	/* the batch of the last removed record is acknowledged if no records of it are left */
+	if (0 != db_id && (NULL == pb->head || pb->head->db_id != db_id) && db_id > pb->db_lastid)
+	{
+		pb->db_lastid = db_id;
+		*db_lastid = db_id;
+		ret = SUCCEED;
+	}
+
+	UNLOCK_PB;
+
+	return ret;
+}
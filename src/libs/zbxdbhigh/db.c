@@ -2380,74 +2380,102 @@ void	zbx_db_insert_add_values(zbx_db_insert_t *self, ...)
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_db_insert_execute                                            *
+ * Function: db_insert_set_autoincrement                                      *
  *                                                                            *
- * Purpose: executes the prepared database bulk insert operation              *
+ * Purpose: sets the auto increment field values of bulk insert rows          *
  *                                                                            *
  * Parameters: self - [IN] the bulk insert data                               *
  *                                                                            *
+ ******************************************************************************/
+static void	db_insert_set_autoincrement(zbx_db_insert_t *self)
+{
+	zbx_uint64_t	id;
+	int		i;
+
+	if (-1 == self->autoincrement)
+		return;
+
+	id = DBget_maxid_num(self->table->table, self->rows.values_num);
+
+	for (i = 0; i < self->rows.values_num; i++)
+	{
+		zbx_db_value_t	*values = (zbx_db_value_t *)self->rows.values[i];
+
+		values[self->autoincrement].ui64 = id++;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: db_insert_command                                                *
+ *                                                                            *
+ * Purpose: creates the start of bulk insert statement - the table and field  *
+ *          list without the closing parenthesis                              *
+ *                                                                            *
+ * Parameters: self               - [IN] the bulk insert data                 *
+ *             sql_command        - [IN/OUT] the sql statement                *
+ *             sql_command_alloc  - [IN/OUT] the allocated statement size     *
+ *             sql_command_offset - [IN/OUT] the statement length             *
+ *                                                                            *
+ ******************************************************************************/
+static void	db_insert_command(const zbx_db_insert_t *self, char **sql_command, size_t *sql_command_alloc,
+		size_t *sql_command_offset)
+{
+	int		i;
+	const ZBX_FIELD	*field;
+	char		delim[2] = {',', '('};
+
+	zbx_strcpy_alloc(sql_command, sql_command_alloc, sql_command_offset, "insert into ");
+	zbx_strcpy_alloc(sql_command, sql_command_alloc, sql_command_offset, self->table->table);
+	zbx_chrcpy_alloc(sql_command, sql_command_alloc, sql_command_offset, ' ');
+
+	for (i = 0; i < self->fields.values_num; i++)
+	{
+		field = (ZBX_FIELD *)self->fields.values[i];
+
+		zbx_chrcpy_alloc(sql_command, sql_command_alloc, sql_command_offset, delim[0 == i]);
+		zbx_strcpy_alloc(sql_command, sql_command_alloc, sql_command_offset, field->name);
+	}
+}
+
+#ifndef HAVE_ORACLE
+/******************************************************************************
+ *                                                                            *
+ * Function: db_insert_append_sql                                             *
+ *                                                                            *
+ * Purpose: appends the bulk insert statements to multiple statement sql,     *
+ *          executing the sql when it overflows                               *
+ *                                                                            *
+ * Parameters: self       - [IN] the bulk insert data                         *
+ *             sql        - [IN/OUT] the multiple statement sql               *
+ *             sql_alloc  - [IN/OUT] the allocated sql size                   *
+ *             sql_offset - [IN/OUT] the sql length                           *
+ *                                                                            *
  * Return value: Returns SUCCEED if the operation completed successfully or   *
  *               FAIL otherwise.                                              *
  *                                                                            *
  ******************************************************************************/
-int	zbx_db_insert_execute(zbx_db_insert_t *self)
+static int	db_insert_append_sql(zbx_db_insert_t *self, char **sql, size_t *sql_alloc, size_t *sql_offset)
 {
-	int		ret = FAIL, i, j;
+	int		ret = SUCCEED, i, j;
 	const ZBX_FIELD	*field;
 	char		*sql_command, delim[2] = {',', '('};
 	size_t		sql_command_alloc = 512, sql_command_offset = 0;
 
-#ifndef HAVE_ORACLE
-	char		*sql;
-	size_t		sql_alloc = 16 * ZBX_KIBIBYTE, sql_offset = 0;
-
 #	ifdef HAVE_MYSQL
 	char		*sql_values = NULL;
 	size_t		sql_values_alloc = 0, sql_values_offset = 0;
 #	endif
-#else
-	zbx_db_bind_context_t	*contexts;
-	int			rc, tries = 0;
-#endif
-
-	if (0 == self->rows.values_num)
-		return SUCCEED;
-
-	/* process the auto increment field */
-	if (-1 != self->autoincrement)
-	{
-		zbx_uint64_t	id;
 
-		id = DBget_maxid_num(self->table->table, self->rows.values_num);
+	db_insert_set_autoincrement(self);
 
-		for (i = 0; i < self->rows.values_num; i++)
-		{
-			zbx_db_value_t	*values = (zbx_db_value_t *)self->rows.values[i];
-
-			values[self->autoincrement].ui64 = id++;
-		}
-	}
-
-#ifndef HAVE_ORACLE
-	sql = (char *)zbx_malloc(NULL, sql_alloc);
-#endif
 	sql_command = (char *)zbx_malloc(NULL, sql_command_alloc);
 
 	/* create sql insert statement command */
 
-	zbx_strcpy_alloc(&sql_command, &sql_command_alloc, &sql_command_offset, "insert into ");
-	zbx_strcpy_alloc(&sql_command, &sql_command_alloc, &sql_command_offset, self->table->table);
-	zbx_chrcpy_alloc(&sql_command, &sql_command_alloc, &sql_command_offset, ' ');
-
-	for (i = 0; i < self->fields.values_num; i++)
-	{
-		field = (ZBX_FIELD *)self->fields.values[i];
+	db_insert_command(self, &sql_command, &sql_command_alloc, &sql_command_offset);
 
-		zbx_chrcpy_alloc(&sql_command, &sql_command_alloc, &sql_command_offset, delim[0 == i]);
-		zbx_strcpy_alloc(&sql_command, &sql_command_alloc, &sql_command_offset, field->name);
-	}
-
-#ifdef HAVE_MYSQL
+#	ifdef HAVE_MYSQL
 	/* MySQL workaround - explicitly add missing text fields with '' default value */
 	for (field = (const ZBX_FIELD *)self->table->fields; NULL != field->name; field++)
 	{
@@ -2470,10 +2498,140 @@ int	zbx_db_insert_execute(zbx_db_insert_t *self)
 				break;
 		}
 	}
+#	endif
+	zbx_strcpy_alloc(&sql_command, &sql_command_alloc, &sql_command_offset, ") values ");
+
+	for (i = 0; i < self->rows.values_num; i++)
+	{
+		zbx_db_value_t	*values = (zbx_db_value_t *)self->rows.values[i];
+
+#	ifdef HAVE_MULTIROW_INSERT
+		/* start new statement for the first row and after the sql was executed because of overflow */
+		if (0 == i || 16 > *sql_offset)
+			zbx_strcpy_alloc(sql, sql_alloc, sql_offset, sql_command);
+#	else
+		zbx_strcpy_alloc(sql, sql_alloc, sql_offset, sql_command);
+#	endif
+
+		for (j = 0; j < self->fields.values_num; j++)
+		{
+			const zbx_db_value_t	*value = &values[j];
+
+			field = (const ZBX_FIELD *)self->fields.values[j];
+
+			zbx_chrcpy_alloc(sql, sql_alloc, sql_offset, delim[0 == j]);
+
+			switch (field->type)
+			{
+				case ZBX_TYPE_CHAR:
+				case ZBX_TYPE_TEXT:
+				case ZBX_TYPE_SHORTTEXT:
+				case ZBX_TYPE_LONGTEXT:
+					zbx_chrcpy_alloc(sql, sql_alloc, sql_offset, '\'');
+					zbx_strcpy_alloc(sql, sql_alloc, sql_offset, value->str);
+					zbx_chrcpy_alloc(sql, sql_alloc, sql_offset, '\'');
+					break;
+				case ZBX_TYPE_INT:
+					zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%d", value->i32);
+					break;
+				case ZBX_TYPE_FLOAT:
+					zbx_snprintf_alloc(sql, sql_alloc, sql_offset, ZBX_FS_DBL, value->dbl);
+					break;
+				case ZBX_TYPE_UINT:
+					zbx_snprintf_alloc(sql, sql_alloc, sql_offset, ZBX_FS_UI64, value->ui64);
+					break;
+				case ZBX_TYPE_ID:
+					zbx_strcpy_alloc(sql, sql_alloc, sql_offset, DBsql_id_ins(value->ui64));
+					break;
+				default:
+					THIS_SHOULD_NEVER_HAPPEN;
+					exit(EXIT_FAILURE);
+			}
+		}
+#	ifdef HAVE_MYSQL
+		if (NULL != sql_values)
+			zbx_strcpy_alloc(sql, sql_alloc, sql_offset, sql_values);
+#	endif
+
+		zbx_strcpy_alloc(sql, sql_alloc, sql_offset, ")" ZBX_ROW_DL);
+
+		if (SUCCEED != (ret = DBexecute_overflowed_sql(sql, sql_alloc, sql_offset)))
+			goto out;
+	}
+
+#	ifdef HAVE_MULTIROW_INSERT
+	/* terminate the statement so other statements can follow it */
+	if (0 != *sql_offset && ',' == (*sql)[*sql_offset - 1])
+	{
+		(*sql_offset)--;
+		zbx_strcpy_alloc(sql, sql_alloc, sql_offset, ";\n");
+	}
+#	endif
+out:
+	zbx_free(sql_command);
+
+#	ifdef HAVE_MYSQL
+	zbx_free(sql_values);
+#	endif
+
+	return ret;
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_db_insert_execute                                            *
+ *                                                                            *
+ * Purpose: executes the prepared database bulk insert operation              *
+ *                                                                            *
+ * Parameters: self - [IN] the bulk insert data                               *
+ *                                                                            *
+ * Return value: Returns SUCCEED if the operation completed successfully or   *
+ *               FAIL otherwise.                                              *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_db_insert_execute(zbx_db_insert_t *self)
+{
+	int		ret = FAIL;
+
+#ifndef HAVE_ORACLE
+	char		*sql;
+	size_t		sql_alloc = 16 * ZBX_KIBIBYTE, sql_offset = 0;
+#else
+	int			i, j, rc, tries = 0;
+	const ZBX_FIELD		*field;
+	char			*sql_command, delim[2] = {',', '('};
+	size_t			sql_command_alloc = 512, sql_command_offset = 0;
+	zbx_db_bind_context_t	*contexts;
 #endif
+
+	if (0 == self->rows.values_num)
+		return SUCCEED;
+
+#ifndef HAVE_ORACLE
+	sql = (char *)zbx_malloc(NULL, sql_alloc);
+
+	DBbegin_multiple_update(&sql, &sql_alloc, &sql_offset);
+
+	if (SUCCEED == (ret = db_insert_append_sql(self, &sql, &sql_alloc, &sql_offset)) && 16 < sql_offset)
+	{
+		DBend_multiple_update(&sql, &sql_alloc, &sql_offset);
+
+		if (ZBX_DB_OK > DBexecute("%s", sql))
+			ret = FAIL;
+	}
+
+	zbx_free(sql);
+#else
+	db_insert_set_autoincrement(self);
+
+	sql_command = (char *)zbx_malloc(NULL, sql_command_alloc);
+
+	/* create sql insert statement command */
+
+	db_insert_command(self, &sql_command, &sql_command_alloc, &sql_command_offset);
 	zbx_strcpy_alloc(&sql_command, &sql_command_alloc, &sql_command_offset, ") values ");
 
-#ifdef HAVE_ORACLE
 	for (i = 0; i < self->fields.values_num; i++)
 	{
 		zbx_chrcpy_alloc(&sql_command, &sql_command_alloc, &sql_command_offset, delim[0 == i]);
@@ -2534,99 +2692,56 @@ retry_oracle:
 	}
 
 	ret = (ZBX_DB_OK <= rc ? SUCCEED : FAIL);
+out:
+	zbx_free(sql_command);
+	zbx_free(contexts);
+#endif
+	return ret;
+}
 
-#else
-	DBbegin_multiple_update(&sql, &sql_alloc, &sql_offset);
-
-	for (i = 0; i < self->rows.values_num; i++)
-	{
-		zbx_db_value_t	*values = (zbx_db_value_t *)self->rows.values[i];
-
-#	ifdef HAVE_MULTIROW_INSERT
-		if (16 > sql_offset)
-			zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, sql_command);
-#	else
-		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, sql_command);
-#	endif
-
-		for (j = 0; j < self->fields.values_num; j++)
-		{
-			const zbx_db_value_t	*value = &values[j];
-
-			field = (const ZBX_FIELD *)self->fields.values[j];
-
-			zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, delim[0 == j]);
-
-			switch (field->type)
-			{
-				case ZBX_TYPE_CHAR:
-				case ZBX_TYPE_TEXT:
-				case ZBX_TYPE_SHORTTEXT:
-				case ZBX_TYPE_LONGTEXT:
-					zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, '\'');
-					zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, value->str);
-					zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, '\'');
-					break;
-				case ZBX_TYPE_INT:
-					zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "%d", value->i32);
-					break;
-				case ZBX_TYPE_FLOAT:
-					zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, ZBX_FS_DBL,
-							value->dbl);
-					break;
-				case ZBX_TYPE_UINT:
-					zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, ZBX_FS_UI64,
-							value->ui64);
-					break;
-				case ZBX_TYPE_ID:
-					zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset,
-							DBsql_id_ins(value->ui64));
-					break;
-				default:
-					THIS_SHOULD_NEVER_HAPPEN;
-					exit(EXIT_FAILURE);
-			}
-		}
-#	ifdef HAVE_MYSQL
-		if (NULL != sql_values)
-			zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, sql_values);
-#	endif
-
-		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, ")" ZBX_ROW_DL);
-
-		if (SUCCEED != (ret = DBexecute_overflowed_sql(&sql, &sql_alloc, &sql_offset)))
-			goto out;
-	}
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_db_insert_execute_sql                                        *
+ *                                                                            *
+ * Purpose: adds the prepared database bulk insert operation to multiple      *
+ *          statement sql, so it is executed together with other statements   *
+ *                                                                            *
+ * Parameters: self       - [IN] the bulk insert data                         *
+ *             sql        - [IN/OUT] the multiple statement sql, started with *
+ *                                   DBbegin_multiple_update()                *
+ *             sql_alloc  - [IN/OUT] the allocated sql size                   *
+ *             sql_offset - [IN/OUT] the sql length                           *
+ *                                                                            *
+ * Return value: Returns SUCCEED if the operation completed successfully or   *
+ *               FAIL otherwise.                                              *
+ *                                                                            *
+ * Comments: The sql is executed when it overflows, the remaining statements  *
+ *           must be executed by caller as with DBexecute_overflowed_sql().   *
+ *           On Oracle the bulk insert is executed with bound parameters      *
+ *           right away, after executing the statements already in sql.       *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_db_insert_execute_sql(zbx_db_insert_t *self, char **sql, size_t *sql_alloc, size_t *sql_offset)
+{
+	if (0 == self->rows.values_num)
+		return SUCCEED;
 
-	if (16 < sql_offset)
+#ifndef HAVE_ORACLE
+	return db_insert_append_sql(self, sql, sql_alloc, sql_offset);
+#else
+	if (16 < *sql_offset)
 	{
-#	ifdef HAVE_MULTIROW_INSERT
-		if (',' == sql[sql_offset - 1])
-		{
-			sql_offset--;
-			zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, ";\n");
-		}
-#	endif
 		DBend_multiple_update(sql, sql_alloc, sql_offset);
 
-		if (ZBX_DB_OK > DBexecute("%s", sql))
-			ret = FAIL;
-	}
-#endif
-
-out:
-	zbx_free(sql_command);
+		if (ZBX_DB_OK > DBexecute("%s", *sql))
+			return FAIL;
 
-#ifndef HAVE_ORACLE
-	zbx_free(sql);
+		*sql_offset = 0;
+		DBbegin_multiple_update(sql, sql_alloc, sql_offset);
+	}
 
-#	ifdef HAVE_MYSQL
-	zbx_free(sql_values);
-#	endif
-#else
-	zbx_free(contexts);
+	return zbx_db_insert_execute(self);
 #endif
-	return ret;
 }
 
 /******************************************************************************
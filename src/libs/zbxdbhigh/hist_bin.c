@@ -0,0 +1,531 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2019 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "common.h"
+#include "base64.h"
+
+#include "hist_bin.h"
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hist_bin_reserve                                                 *
+ *                                                                            *
+ * Purpose: ensures the binary history buffer can hold the specified number   *
+ *          of additional bytes                                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	hist_bin_reserve(zbx_hist_bin_t *bin, size_t size)
+{
+	if (bin->data_alloc >= bin->data_offset + size)
+		return;
+
+	while (bin->data_alloc < bin->data_offset + size)
+		bin->data_alloc *= 2;
+
+	bin->data = (unsigned char *)zbx_realloc(bin->data, bin->data_alloc);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hist_bin_write_uint                                              *
+ *                                                                            *
+ * Purpose: writes unsigned integer as variable length quantity - 7 bits per  *
+ *          byte, least significant group first, high bit set on all bytes    *
+ *          except the last one                                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	hist_bin_write_uint(zbx_hist_bin_t *bin, zbx_uint64_t value)
+{
+	hist_bin_reserve(bin, 10);
+
+	while (0x80 <= value)
+	{
+		bin->data[bin->data_offset++] = (unsigned char)(value | 0x80);
+		value >>= 7;
+	}
+
+	bin->data[bin->data_offset++] = (unsigned char)value;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hist_bin_write_int                                               *
+ *                                                                            *
+ * Purpose: writes signed integer as zigzag encoded variable length quantity, *
+ *          so that values close to zero take few bytes regardless of sign    *
+ *                                                                            *
+ ******************************************************************************/
+static void	hist_bin_write_int(zbx_hist_bin_t *bin, zbx_int64_t value)
+{
+	if (0 > value)
+		hist_bin_write_uint(bin, ((~(zbx_uint64_t)value) << 1) | 1);
+	else
+		hist_bin_write_uint(bin, (zbx_uint64_t)value << 1);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hist_bin_write_double                                            *
+ *                                                                            *
+ * Purpose: writes IEEE 754 double value in little endian byte order          *
+ *                                                                            *
+ ******************************************************************************/
+static void	hist_bin_write_double(zbx_hist_bin_t *bin, double value)
+{
+	zbx_uint64_t	bits;
+	int		i;
+
+	memcpy(&bits, &value, sizeof(bits));
+	hist_bin_reserve(bin, sizeof(bits));
+
+	for (i = 0; i < (int)sizeof(bits); i++)
+	{
+		bin->data[bin->data_offset++] = (unsigned char)(bits & 0xff);
+		bits >>= 8;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hist_bin_write_str                                               *
+ *                                                                            *
+ * Purpose: writes length prefixed string                                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	hist_bin_write_str(zbx_hist_bin_t *bin, const char *str)
+{
+	size_t	len;
+
+	len = strlen(str);
+	hist_bin_write_uint(bin, len);
+	hist_bin_reserve(bin, len);
+	memcpy(bin->data + bin->data_offset, str, len);
+	bin->data_offset += len;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hist_bin_read_uint                                               *
+ *                                                                            *
+ * Purpose: reads unsigned integer written by hist_bin_write_uint()           *
+ *                                                                            *
+ * Return value: SUCCEED - the value was read successfully                    *
+ *               FAIL    - the data is truncated or malformed                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	hist_bin_read_uint(zbx_hist_bin_t *bin, zbx_uint64_t *value)
+{
+	int		shift;
+	unsigned char	c;
+
+	*value = 0;
+
+	for (shift = 0; 64 > shift && bin->data_offset < bin->data_size; shift += 7)
+	{
+		c = bin->data[bin->data_offset++];
+		*value |= (zbx_uint64_t)(c & 0x7f) << shift;
+
+		if (0 == (c & 0x80))
+			return SUCCEED;
+	}
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hist_bin_read_int                                                *
+ *                                                                            *
+ * Purpose: reads signed integer written by hist_bin_write_int()              *
+ *                                                                            *
+ ******************************************************************************/
+static int	hist_bin_read_int(zbx_hist_bin_t *bin, zbx_int64_t *value)
+{
+	zbx_uint64_t	uvalue;
+
+	if (SUCCEED != hist_bin_read_uint(bin, &uvalue))
+		return FAIL;
+
+	if (0 != (uvalue & 1))
+		*value = -(zbx_int64_t)(uvalue >> 1) - 1;
+	else
+		*value = (zbx_int64_t)(uvalue >> 1);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hist_bin_read_double                                             *
+ *                                                                            *
+ * Purpose: reads double value written by hist_bin_write_double()             *
+ *                                                                            *
+ ******************************************************************************/
+static int	hist_bin_read_double(zbx_hist_bin_t *bin, double *value)
+{
+	zbx_uint64_t	bits = 0;
+	int		i;
+
+	if (bin->data_size - bin->data_offset < sizeof(bits))
+		return FAIL;
+
+	for (i = (int)sizeof(bits) - 1; i >= 0; i--)
+		bits = (bits << 8) | bin->data[bin->data_offset + i];
+
+	bin->data_offset += sizeof(bits);
+	memcpy(value, &bits, sizeof(bits));
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hist_bin_read_str                                                *
+ *                                                                            *
+ * Purpose: reads string written by hist_bin_write_str()                      *
+ *                                                                            *
+ * Comments: The returned string must be freed by the caller.                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	hist_bin_read_str(zbx_hist_bin_t *bin, char **str)
+{
+	zbx_uint64_t	len;
+
+	if (SUCCEED != hist_bin_read_uint(bin, &len) || bin->data_size - bin->data_offset < len)
+		return FAIL;
+
+	*str = (char *)zbx_malloc(*str, (size_t)len + 1);
+	memcpy(*str, bin->data + bin->data_offset, (size_t)len);
+	(*str)[len] = '\0';
+	bin->data_offset += (size_t)len;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hist_bin_write_value                                             *
+ *                                                                            *
+ * Purpose: writes history value using the most compact encoding that         *
+ *          restores the original string                                      *
+ *                                                                            *
+ * Parameters: bin   - [IN/OUT] the binary history data                       *
+ *             value - [IN] the value to write                                *
+ *                                                                            *
+ * Return value: The value encoding flag (ZBX_HIST_BIN_VALUE_*).              *
+ *                                                                            *
+ * Comments: Numeric values are written as raw numbers only when formatting   *
+ *           them back produces exactly the same string, so the receiver      *
+ *           gets identical values regardless of encoding.                    *
+ *                                                                            *
+ ******************************************************************************/
+static unsigned char	hist_bin_write_value(zbx_hist_bin_t *bin, const char *value)
+{
+	char		buffer[MAX_STRING_LEN];
+	zbx_uint64_t	value_ui64;
+	double		value_dbl;
+
+	/* long strings are not numbers that would benefit from binary encoding */
+	if (ZBX_MAX_UINT64_LEN * 2 > strlen(value))
+	{
+		if (SUCCEED == is_uint64(value, &value_ui64))
+		{
+			zbx_snprintf(buffer, sizeof(buffer), ZBX_FS_UI64, value_ui64);
+
+			if (0 == strcmp(buffer, value))
+			{
+				hist_bin_write_uint(bin, value_ui64);
+				return ZBX_HIST_BIN_VALUE_UI64;
+			}
+		}
+		else if (SUCCEED == is_double(value))
+		{
+			value_dbl = atof(value);
+			zbx_snprintf(buffer, sizeof(buffer), ZBX_FS_DBL, value_dbl);
+
+			if (0 == strcmp(buffer, value))
+			{
+				hist_bin_write_double(bin, value_dbl);
+				return ZBX_HIST_BIN_VALUE_DBL;
+			}
+		}
+	}
+
+	hist_bin_write_str(bin, value);
+
+	return ZBX_HIST_BIN_VALUE_STR;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_hist_bin_init                                                *
+ *                                                                            *
+ * Purpose: initializes binary history data encoder                           *
+ *                                                                            *
+ * Comments: The encoded data starts with ZBX_PROXY_HISTORY_BINARY_FORMAT     *
+ *           format version byte.                                             *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_hist_bin_init(zbx_hist_bin_t *bin)
+{
+	memset(bin, 0, sizeof(zbx_hist_bin_t));
+	bin->data_alloc = 16 * ZBX_KIBIBYTE;
+	bin->data = (unsigned char *)zbx_malloc(NULL, bin->data_alloc);
+	bin->data[bin->data_offset++] = ZBX_PROXY_HISTORY_BINARY_FORMAT;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_hist_bin_add_record                                          *
+ *                                                                            *
+ * Purpose: writes history record in binary format                            *
+ *                                                                            *
+ * Parameters: bin           - [IN/OUT] the binary history data               *
+ *             hd            - [IN] the history record                        *
+ *             id            - [IN] the record id sent to server              *
+ *             string_buffer - [IN] the string buffer holding string values   *
+ *                                                                            *
+ * Comments: The record contains the same fields as JSON history data row:    *
+ *             flags      - 1 byte, ZBX_HIST_BIN_* flags                      *
+ *             id         - delta from the previous record id                 *
+ *             itemid     - delta from the previous record itemid             *
+ *             clock      - delta of the delta from the previous record clock *
+ *             ns                                                             *
+ *             timestamp, severity, logeventid, source - if FLAG_LOG is set   *
+ *             value      - string, uint64 or double, depending on flags      *
+ *             lastlogsize, mtime - if FLAG_META is set                       *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_hist_bin_add_record(zbx_hist_bin_t *bin, const zbx_history_data_t *hd, zbx_uint64_t id,
+		const char *string_buffer)
+{
+	unsigned char	flags = ZBX_HIST_BIN_VALUE_NONE;
+	size_t		flags_offset;
+	zbx_int64_t	clock_delta;
+
+	hist_bin_reserve(bin, 1);
+	flags_offset = bin->data_offset++;
+
+	clock_delta = (zbx_int64_t)hd->clock - bin->clock;
+
+	hist_bin_write_int(bin, (zbx_int64_t)(id - bin->id));
+	hist_bin_write_int(bin, (zbx_int64_t)(hd->itemid - bin->itemid));
+	hist_bin_write_int(bin, clock_delta - bin->clock_delta);
+	hist_bin_write_uint(bin, (zbx_uint64_t)hd->ns);
+
+	bin->id = id;
+	bin->itemid = hd->itemid;
+	bin->clock = hd->clock;
+	bin->clock_delta = clock_delta;
+
+	if (PROXY_HISTORY_FLAG_NOVALUE != (hd->flags & PROXY_HISTORY_MASK_NOVALUE))
+	{
+		if (0 != hd->state)
+			flags |= ZBX_HIST_BIN_FLAG_NOTSUPPORTED;
+
+		if (0 == (hd->flags & PROXY_HISTORY_FLAG_NOVALUE))
+		{
+			if (0 != hd->timestamp || '\0' != string_buffer[hd->source_offset] || 0 != hd->severity ||
+					0 != hd->logeventid)
+			{
+				flags |= ZBX_HIST_BIN_FLAG_LOG;
+
+				hist_bin_write_int(bin, hd->timestamp);
+				hist_bin_write_int(bin, hd->severity);
+				hist_bin_write_int(bin, hd->logeventid);
+				hist_bin_write_str(bin, string_buffer + hd->source_offset);
+			}
+
+			flags |= hist_bin_write_value(bin, string_buffer + hd->value_offset);
+		}
+
+		if (0 != (hd->flags & PROXY_HISTORY_FLAG_META))
+		{
+			flags |= ZBX_HIST_BIN_FLAG_META;
+
+			hist_bin_write_uint(bin, hd->lastlogsize);
+			hist_bin_write_int(bin, hd->mtime);
+		}
+	}
+
+	bin->data[flags_offset] = flags;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_hist_bin_open                                                *
+ *                                                                            *
+ * Purpose: initializes binary history data decoder                           *
+ *                                                                            *
+ * Parameters: bin    - [OUT] the binary history data                         *
+ *             base64 - [IN] the base64 encoded binary history data           *
+ *                                                                            *
+ * Return value:  SUCCEED - the data has supported format                     *
+ *                FAIL    - otherwise                                         *
+ *                                                                            *
+ * Comments: The decoder must be freed with zbx_hist_bin_clear() also when    *
+ *           this function fails.                                             *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_hist_bin_open(zbx_hist_bin_t *bin, const char *base64)
+{
+	int	size;
+
+	memset(bin, 0, sizeof(zbx_hist_bin_t));
+	bin->data_alloc = strlen(base64) / 4 * 3 + 3;
+	bin->data = (unsigned char *)zbx_malloc(NULL, bin->data_alloc);
+	str_base64_decode(base64, (char *)bin->data, (int)bin->data_alloc, &size);
+	bin->data_size = (size_t)size;
+
+	if (0 == bin->data_size || ZBX_PROXY_HISTORY_BINARY_FORMAT != bin->data[bin->data_offset++])
+		return FAIL;
+
+	return SUCCEED;
+}
+
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_hist_bin_read_record                                         *
+ *                                                                            *
+ * Purpose: parses one record from binary history data                        *
+ *                                                                            *
+ * Parameters: bin    - [IN/OUT] the binary history data                      *
+ *             itemid - [OUT] the item identifier                             *
+ *             av     - [OUT] the agent value                                 *
+ *                                                                            *
+ * Return value:  SUCCEED - the record was parsed successfully                *
+ *                FAIL    - the data is truncated or malformed                *
+ *                                                                            *
+ * Comments: See zbx_hist_bin_add_record() for the record layout.             *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_hist_bin_read_record(zbx_hist_bin_t *bin, zbx_uint64_t *itemid, zbx_agent_value_t *av)
+{
+	unsigned char	flags;
+	zbx_int64_t	delta, value_int;
+	zbx_uint64_t	value_ui64;
+	double		value_dbl;
+
+	memset(av, 0, sizeof(zbx_agent_value_t));
+
+	if (bin->data_offset >= bin->data_size)
+		return FAIL;
+
+	flags = bin->data[bin->data_offset++];
+
+	if (SUCCEED != hist_bin_read_int(bin, &delta))
+		return FAIL;
+
+	bin->id += (zbx_uint64_t)delta;
+
+	if (SUCCEED != hist_bin_read_int(bin, &delta))
+		return FAIL;
+
+	bin->itemid += (zbx_uint64_t)delta;
+
+	if (SUCCEED != hist_bin_read_int(bin, &delta))
+		return FAIL;
+
+	bin->clock_delta += delta;
+	bin->clock = (int)(bin->clock + bin->clock_delta);
+
+	if (SUCCEED != hist_bin_read_uint(bin, &value_ui64) || 999999999 < value_ui64)
+		return FAIL;
+
+	av->id = bin->id;
+	*itemid = bin->itemid;
+	av->ts.sec = bin->clock;
+	av->ts.ns = (int)value_ui64;
+
+	if (0 != (flags & ZBX_HIST_BIN_FLAG_NOTSUPPORTED))
+		av->state = ITEM_STATE_NOTSUPPORTED;
+
+	if (0 != (flags & ZBX_HIST_BIN_FLAG_LOG))
+	{
+		if (SUCCEED != hist_bin_read_int(bin, &value_int))
+			return FAIL;
+
+		av->timestamp = (int)value_int;
+
+		if (SUCCEED != hist_bin_read_int(bin, &value_int))
+			return FAIL;
+
+		av->severity = (int)value_int;
+
+		if (SUCCEED != hist_bin_read_int(bin, &value_int))
+			return FAIL;
+
+		av->logeventid = (int)value_int;
+
+		if (SUCCEED != hist_bin_read_str(bin, &av->source))
+			return FAIL;
+
+		if ('\0' == *av->source)
+			zbx_free(av->source);
+	}
+
+	switch (flags & ZBX_HIST_BIN_VALUE_MASK)
+	{
+		case ZBX_HIST_BIN_VALUE_STR:
+			if (SUCCEED != hist_bin_read_str(bin, &av->value))
+				return FAIL;
+			break;
+		case ZBX_HIST_BIN_VALUE_UI64:
+			if (SUCCEED != hist_bin_read_uint(bin, &value_ui64))
+				return FAIL;
+
+			av->value = zbx_dsprintf(NULL, ZBX_FS_UI64, value_ui64);
+			break;
+		case ZBX_HIST_BIN_VALUE_DBL:
+			if (SUCCEED != hist_bin_read_double(bin, &value_dbl))
+				return FAIL;
+
+			av->value = zbx_dsprintf(NULL, ZBX_FS_DBL, value_dbl);
+			break;
+	}
+
+	if (0 != (flags & ZBX_HIST_BIN_FLAG_META))
+	{
+		if (SUCCEED != hist_bin_read_uint(bin, &value_ui64) || SUCCEED != hist_bin_read_int(bin, &value_int))
+			return FAIL;
+
+		/* unsupported item meta information must be ignored, the same as in json rows */
+		if (ITEM_STATE_NOTSUPPORTED != av->state)
+		{
+			av->meta = 1;
+			av->lastlogsize = value_ui64;
+			av->mtime = (int)value_int;
+		}
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_hist_bin_clear                                               *
+ *                                                                            *
+ * Purpose: frees binary history data                                         *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_hist_bin_clear(zbx_hist_bin_t *bin)
+{
+	zbx_free(bin->data);
+}
@@ -0,0 +1,59 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2019 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#ifndef ZABBIX_HIST_BIN_H
+#define ZABBIX_HIST_BIN_H
+
+#include "proxy.h"
+#include "dbcache.h"
+
+/* binary history record flags */
+#define ZBX_HIST_BIN_VALUE_NONE		0x00
+#define ZBX_HIST_BIN_VALUE_STR		0x01
+#define ZBX_HIST_BIN_VALUE_UI64		0x02
+#define ZBX_HIST_BIN_VALUE_DBL		0x03
+#define ZBX_HIST_BIN_VALUE_MASK		0x03
+#define ZBX_HIST_BIN_FLAG_NOTSUPPORTED	0x04
+#define ZBX_HIST_BIN_FLAG_LOG		0x08
+#define ZBX_HIST_BIN_FLAG_META		0x10
+
+/* binary history data encoder/decoder state */
+typedef struct
+{
+	unsigned char	*data;
+	size_t		data_alloc;
+	size_t		data_offset;
+	size_t		data_size;
+
+	/* the last record values, used to calculate deltas */
+	zbx_uint64_t	id;
+	zbx_uint64_t	itemid;
+	int		clock;
+	zbx_int64_t	clock_delta;
+}
+zbx_hist_bin_t;
+
+void	zbx_hist_bin_init(zbx_hist_bin_t *bin);
+int	zbx_hist_bin_open(zbx_hist_bin_t *bin, const char *base64);
+void	zbx_hist_bin_clear(zbx_hist_bin_t *bin);
+void	zbx_hist_bin_add_record(zbx_hist_bin_t *bin, const zbx_history_data_t *hd, zbx_uint64_t id,
+		const char *string_buffer);
+int	zbx_hist_bin_read_record(zbx_hist_bin_t *bin, zbx_uint64_t *itemid, zbx_agent_value_t *av);
+
+#endif
@@ -31,6 +31,9 @@
 #include "preproc.h"
 #include "../zbxcrypto/tls_tcp_active.h"
 #include "zbxlld.h"
+#include "base64.h"
+#include "md5.h"
+#include "hist_bin.h"
 
 extern char	*CONFIG_SERVER;
 
@@ -43,6 +46,10 @@ extern char	*CONFIG_SERVER;
 /* the maximum number of values processed in one batch */
 #define ZBX_HISTORY_VALUES_MAX		256
 
+/* the average number of configuration table rows covered by one proxy configuration digest bucket */
+#define ZBX_PROXYCONFIG_BUCKET_ROWS	64
+#define ZBX_PROXYCONFIG_BUCKETS_MAX	65536
+
 typedef struct
 {
 	zbx_uint64_t		druleid;
@@ -82,6 +89,39 @@ typedef struct
 }
 zbx_id_offset_t;
 
+/* configuration row hash, calculated from the values sent by server */
+typedef struct
+{
+	zbx_uint64_t	recid;
+	zbx_uint64_t	hash;
+}
+zbx_proxyconfig_row_t;
+
+/* row hashes of a configuration table as last received from server */
+typedef struct
+{
+	const ZBX_TABLE	*table;
+	zbx_hashset_t	rows;
+}
+zbx_proxyconfig_table_t;
+
+/* configuration table changes received from server */
+typedef struct
+{
+	const ZBX_TABLE			*table;
+	zbx_vector_uint64_t		ids;		/* the rows to delete */
+	zbx_vector_uint64_t		buckets;	/* the changed buckets for partial table data */
+	zbx_vector_uint64_pair_t	rows;		/* the received row identifiers and hashes */
+	int				buckets_num;
+	int				delta;
+	zbx_uint64_t			digest;
+}
+zbx_proxyconfig_update_t;
+
+/* the configuration tables synced by active proxy, used to request configuration changes only */
+static zbx_vector_ptr_t	proxyconfig_tables;
+static int		proxyconfig_tables_init = 0;
+
 
 typedef int	(*zbx_client_item_validator_t)(DC_ITEM *item, zbx_socket_t *sock, void *args, char **error);
 
@@ -120,6 +160,12 @@ static zbx_history_table_t	areg = {
 		}
 };
 
+typedef int	(*zbx_history_data_get_func_t)(zbx_uint64_t lastid, zbx_history_data_t **data, size_t *data_alloc,
+		char **string_buffer, size_t *string_buffer_alloc, int *more);
+
+/* the proxy buffer mode of the last history data read, see proxy_set_hist_lastid() */
+static int	hist_mode = ZBX_PB_MODE_DATABASE;
+
 static const char	*availability_tag_available[ZBX_AGENT_MAX] = {ZBX_PROTO_TAG_AVAILABLE,
 					ZBX_PROTO_TAG_SNMP_AVAILABLE, ZBX_PROTO_TAG_IPMI_AVAILABLE,
 					ZBX_PROTO_TAG_JMX_AVAILABLE};
@@ -412,21 +458,253 @@ int	check_access_passive_proxy(zbx_socket_t *sock, int send_response, const char
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: proxyconfig_field_is_hashed                                      *
+ *                                                                            *
+ * Purpose: check if configuration field is included in the row hash         *
+ *                                                                            *
+ * Comments: item lastlogsize and mtime fields are not updated by proxy after *
+ *           the item is created, so their changes are ignored               *
+ *                                                                            *
+ ******************************************************************************/
+static int	proxyconfig_field_is_hashed(const ZBX_TABLE *table, const char *field_name)
+{
+	if (0 == strcmp(table->table, "items") &&
+			(0 == strcmp(field_name, "lastlogsize") || 0 == strcmp(field_name, "mtime")))
+	{
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: proxyconfig_hash_append                                          *
+ *                                                                            *
+ * Purpose: add configuration field value to the row hash                     *
+ *                                                                            *
+ * Parameters: state - [IN/OUT] the md5 state                                 *
+ *             value - [IN] the field value, NULL for database NULL           *
+ *                                                                            *
+ ******************************************************************************/
+static void	proxyconfig_hash_append(md5_state_t *state, const char *value)
+{
+	if (NULL == value)
+	{
+		zbx_md5_append(state, (const md5_byte_t *)"\2", 1);
+		return;
+	}
+
+	zbx_md5_append(state, (const md5_byte_t *)"\1", 1);
+	zbx_md5_append(state, (const md5_byte_t *)value, (int)strlen(value) + 1);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: proxyconfig_hash_finish                                          *
+ *                                                                            *
+ * Purpose: get 64 bit row hash from the md5 state                            *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_t	proxyconfig_hash_finish(md5_state_t *state)
+{
+	md5_byte_t	hash[MD5_DIGEST_SIZE];
+	zbx_uint64_t	value = 0;
+	int		i;
+
+	zbx_md5_finish(state, hash);
+
+	for (i = 0; i < 8; i++)
+		value = (value << 8) | hash[i];
+
+	return value;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: proxyconfig_digest_decode                                        *
+ *                                                                            *
+ * Purpose: decode configuration table digest received from proxy            *
+ *                                                                            *
+ * Parameters: base64      - [IN] the digest - base64 encoded array of 64 bit *
+ *                                bucket hashes in little endian byte order   *
+ *             buckets     - [OUT] the bucket hashes                          *
+ *             buckets_num - [OUT] the number of buckets                      *
+ *                                                                            *
+ * Return value: SUCCEED - the digest was decoded successfully                *
+ *               FAIL    - invalid digest                                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	proxyconfig_digest_decode(const char *base64, zbx_uint64_t **buckets, int *buckets_num)
+{
+	unsigned char	*data;
+	int		size, i, k, ret = FAIL;
+	size_t		data_alloc;
+
+	data_alloc = strlen(base64) / 4 * 3 + 3;
+	data = (unsigned char *)zbx_malloc(NULL, data_alloc);
+	str_base64_decode(base64, (char *)data, (int)data_alloc, &size);
+
+	if (0 == size || 0 != size % 8 || ZBX_PROXYCONFIG_BUCKETS_MAX < size / 8)
+		goto out;
+
+	*buckets_num = size / 8;
+	*buckets = (zbx_uint64_t *)zbx_malloc(NULL, sizeof(zbx_uint64_t) * *buckets_num);
+
+	for (i = 0; i < *buckets_num; i++)
+	{
+		(*buckets)[i] = 0;
+
+		for (k = 7; 0 <= k; k--)
+			(*buckets)[i] = ((*buckets)[i] << 8) | data[i * 8 + k];
+	}
+
+	ret = SUCCEED;
+out:
+	zbx_free(data);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: get_proxyconfig_table_changes                                    *
+ *                                                                            *
+ * Purpose: find configuration table buckets that differ from proxy          *
+ *                                                                            *
+ * Parameters: table         - [IN] the configuration table                   *
+ *             sql           - [IN] the configuration data query              *
+ *             fld_type      - [IN] the item type field number (items table)  *
+ *             fld_key       - [IN] the item key field number (items table)   *
+ *             proxy_buckets - [IN] the bucket hashes reported by proxy       *
+ *             buckets_num   - [IN] the number of buckets                     *
+ *             buckets       - [OUT] the changed buckets                      *
+ *             recids        - [OUT] the records in changed buckets           *
+ *             digest        - [OUT] the table hash                           *
+ *                                                                            *
+ * Return value: SUCCEED - the changes were found successfully                *
+ *               FAIL    - database error                                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	get_proxyconfig_table_changes(const ZBX_TABLE *table, const char *sql, int fld_type, int fld_key,
+		const zbx_uint64_t *proxy_buckets, int buckets_num, zbx_vector_uint64_t *buckets,
+		zbx_vector_uint64_t *recids, zbx_uint64_t *digest)
+{
+	DB_RESULT		result;
+	DB_ROW			row;
+	zbx_uint64_t		*server_buckets, recid;
+	int			f, fld, i, fields_num = 0;
+	unsigned char		hashed[ZBX_MAX_FIELDS], *changed;
+	md5_state_t		state;
+	zbx_vector_uint64_t	ids;
+
+	if (NULL == (result = DBselect("%s", sql)))
+		return FAIL;
+
+	for (f = 0; 0 != table->fields[f].name; f++)
+	{
+		if (0 == (table->fields[f].flags & ZBX_PROXY))
+			continue;
+
+		hashed[fields_num++] = (SUCCEED == proxyconfig_field_is_hashed(table, table->fields[f].name));
+	}
+
+	server_buckets = (zbx_uint64_t *)zbx_calloc(NULL, (size_t)buckets_num, sizeof(zbx_uint64_t));
+	zbx_vector_uint64_create(&ids);
+
+	while (NULL != (row = DBfetch(result)))
+	{
+		if (-1 != fld_type)
+		{
+			unsigned char	type;
+
+			ZBX_STR2UCHAR(type, row[fld_type]);
+
+			if (SUCCEED == is_item_processed_by_server(type, row[fld_key]))
+				continue;
+		}
+
+		ZBX_STR2UINT64(recid, row[0]);
+
+		zbx_md5_init(&state);
+		proxyconfig_hash_append(&state, row[0]);
+
+		for (fld = 1; fld <= fields_num; fld++)
+		{
+			if (0 != hashed[fld - 1])
+				proxyconfig_hash_append(&state, SUCCEED != DBis_null(row[fld]) ? row[fld] : NULL);
+		}
+
+		server_buckets[recid % buckets_num] ^= proxyconfig_hash_finish(&state);
+		zbx_vector_uint64_append(&ids, recid);
+	}
+	DBfree_result(result);
+
+	changed = (unsigned char *)zbx_calloc(NULL, (size_t)buckets_num, sizeof(unsigned char));
+	*digest = 0;
+
+	for (i = 0; i < buckets_num; i++)
+	{
+		*digest ^= server_buckets[i];
+
+		if (server_buckets[i] != proxy_buckets[i])
+		{
+			zbx_vector_uint64_append(buckets, (zbx_uint64_t)i);
+			changed[i] = 1;
+		}
+	}
+
+	for (i = 0; i < ids.values_num; i++)
+	{
+		if (0 != changed[ids.values[i] % buckets_num])
+			zbx_vector_uint64_append(recids, ids.values[i]);
+	}
+
+	zbx_vector_uint64_sort(recids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	zbx_free(changed);
+	zbx_vector_uint64_destroy(&ids);
+	zbx_free(server_buckets);
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: get_proxyconfig_table                                            *
  *                                                                            *
  * Purpose: prepare proxy configuration data                                  *
  *                                                                            *
+ * Parameters: proxy_hostid - [IN] the proxy identifier                       *
+ *             j            - [OUT] the configuration data                    *
+ *             table        - [IN] the configuration table                    *
+ *             hosts        - [IN] the hosts monitored by proxy               *
+ *             httptests    - [IN] the web scenarios monitored by proxy       *
+ *             digest       - [IN] the table digest reported by proxy,        *
+ *                                 NULL to send all table rows                *
+ *                                                                            *
+ * Comments: When proxy digest is given only the rows from buckets that      *
+ *           differ are sent together with the list of changed buckets, so   *
+ *           proxy can remove rows missing in those buckets. Unchanged tables *
+ *           are not sent at all.                                             *
+ *           All table rows are still selected and hashed on every sync, so   *
+ *           the digest saves network traffic and proxy database updates,     *
+ *           not server database load.                                        *
+ *                                                                            *
  ******************************************************************************/
 static int	get_proxyconfig_table(zbx_uint64_t proxy_hostid, struct zbx_json *j, const ZBX_TABLE *table,
-		zbx_vector_uint64_t *hosts, zbx_vector_uint64_t *httptests)
+		zbx_vector_uint64_t *hosts, zbx_vector_uint64_t *httptests, const char *digest)
 {
 	char			*sql = NULL;
 	size_t			sql_alloc = 4 * ZBX_KIBIBYTE, sql_offset = 0;
-	int			f, fld, fld_type = -1, fld_key = -1, ret = SUCCEED;
+	int			f, fld, fld_type = -1, fld_key = -1, ret = SUCCEED, where = 1, nodata = 0,
+				buckets_num = 0;
 	DB_RESULT		result;
 	DB_ROW			row;
+	zbx_uint64_t		*proxy_buckets = NULL, table_digest = 0;
+	zbx_vector_uint64_t	buckets, recids;
 	static const ZBX_TABLE	*table_items = NULL;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() proxy_hostid:" ZBX_FS_UI64 " table:'%s'",
@@ -435,15 +713,13 @@ static int	get_proxyconfig_table(zbx_uint64_t proxy_hostid, struct zbx_json *j,
 	if (NULL == table_items)
 		table_items = DBget_table("items");
 
-	zbx_json_addobject(j, table->table);
-	zbx_json_addarray(j, "fields");
+	zbx_vector_uint64_create(&buckets);
+	zbx_vector_uint64_create(&recids);
 
 	sql = (char *)zbx_malloc(sql, sql_alloc);
 
 	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "select t.%s", table->recid);
 
-	zbx_json_addstring(j, NULL, table->recid, ZBX_JSON_TYPE_STRING);
-
 	for (f = 0, fld = 1; 0 != table->fields[f].name; f++)
 	{
 		if (0 == (table->fields[f].flags & ZBX_PROXY))
@@ -452,17 +728,15 @@ static int	get_proxyconfig_table(zbx_uint64_t proxy_hostid, struct zbx_json *j,
 		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, ",t.");
 		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, table->fields[f].name);
 
-		zbx_json_addstring(j, NULL, table->fields[f].name, ZBX_JSON_TYPE_STRING);
-
 		if (table == table_items)
 		{
 			if (0 == strcmp(table->fields[f].name, "type"))
 				fld_type = fld;
 			else if (0 == strcmp(table->fields[f].name, "key_"))
 				fld_key = fld;
-
-			fld++;
 		}
+
+		fld++;
 	}
 
 	if (table == table_items && (-1 == fld_type || -1 == fld_key))
@@ -471,16 +745,12 @@ static int	get_proxyconfig_table(zbx_uint64_t proxy_hostid, struct zbx_json *j,
 		exit(EXIT_FAILURE);
 	}
 
-	zbx_json_close(j);	/* fields */
-
-	zbx_json_addarray(j, "data");
-
 	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, " from %s t", table->table);
 
 	if (SUCCEED == str_in_list("hosts,interface,hosts_templates,hostmacro", table->table, ','))
 	{
 		if (0 == hosts->values_num)
-			goto skip_data;
+			nodata = 1;
 
 		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " where");
 		DBadd_condition_alloc(&sql, &sql_alloc, &sql_offset, "t.hostid", hosts->values, hosts->values_num);
@@ -543,7 +813,7 @@ static int	get_proxyconfig_table(zbx_uint64_t proxy_hostid, struct zbx_json *j,
 	else if (SUCCEED == str_in_list("httptest,httptest_field,httptestitem,httpstep", table->table, ','))
 	{
 		if (0 == httptests->values_num)
-			goto skip_data;
+			nodata = 1;
 
 		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " where");
 		DBadd_condition_alloc(&sql, &sql_alloc, &sql_offset, "t.httptestid",
@@ -552,7 +822,7 @@ static int	get_proxyconfig_table(zbx_uint64_t proxy_hostid, struct zbx_json *j,
 	else if (SUCCEED == str_in_list("httpstepitem,httpstep_field", table->table, ','))
 	{
 		if (0 == httptests->values_num)
-			goto skip_data;
+			nodata = 1;
 
 		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset,
 				",httpstep r where t.httpstepid=r.httpstepid"
@@ -560,6 +830,73 @@ static int	get_proxyconfig_table(zbx_uint64_t proxy_hostid, struct zbx_json *j,
 		DBadd_condition_alloc(&sql, &sql_alloc, &sql_offset, "r.httptestid",
 				httptests->values, httptests->values_num);
 	}
+	else
+		where = 0;
+
+	if (NULL != digest && SUCCEED == proxyconfig_digest_decode(digest, &proxy_buckets, &buckets_num))
+	{
+		if (0 != nodata)
+		{
+			/* proxy must remove all table rows it has */
+			for (f = 0; f < buckets_num; f++)
+			{
+				if (0 != proxy_buckets[f])
+					zbx_vector_uint64_append(&buckets, (zbx_uint64_t)f);
+			}
+		}
+		else if (SUCCEED != (ret = get_proxyconfig_table_changes(table, sql,
+				(table == table_items ? fld_type : -1), fld_key, proxy_buckets, buckets_num, &buckets,
+				&recids, &table_digest)))
+		{
+			goto out;
+		}
+
+		if (0 == buckets.values_num)
+			goto out;
+
+		if (0 == recids.values_num)
+			nodata = 1;
+	}
+
+	zbx_json_addobject(j, table->table);
+	zbx_json_addarray(j, "fields");
+	zbx_json_addstring(j, NULL, table->recid, ZBX_JSON_TYPE_STRING);
+
+	for (f = 0; 0 != table->fields[f].name; f++)
+	{
+		if (0 != (table->fields[f].flags & ZBX_PROXY))
+			zbx_json_addstring(j, NULL, table->fields[f].name, ZBX_JSON_TYPE_STRING);
+	}
+
+	zbx_json_close(j);	/* fields */
+
+	if (NULL != proxy_buckets)
+	{
+		zbx_json_addobject(j, "delta");
+		zbx_json_adduint64(j, "buckets", (zbx_uint64_t)buckets_num);
+		zbx_json_addarray(j, "changed");
+
+		for (f = 0; f < buckets.values_num; f++)
+			zbx_json_adduint64(j, NULL, buckets.values[f]);
+
+		zbx_json_close(j);	/* changed */
+		zbx_json_adduint64(j, "digest", table_digest);
+		zbx_json_close(j);	/* delta */
+	}
+
+	zbx_json_addarray(j, "data");
+
+	if (0 != nodata)
+		goto skip_data;
+
+	if (0 != recids.values_num)
+	{
+		char	field[ZBX_FIELDNAME_LEN_MAX + 2];
+
+		zbx_snprintf(field, sizeof(field), "t.%s", table->recid);
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, 0 != where ? " and" : " where");
+		DBadd_condition_alloc(&sql, &sql_alloc, &sql_offset, field, recids.values, recids.values_num);
+	}
 
 	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " order by t.");
 	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, table->recid);
@@ -612,10 +949,13 @@ static int	get_proxyconfig_table(zbx_uint64_t proxy_hostid, struct zbx_json *j,
 	}
 	DBfree_result(result);
 skip_data:
-	zbx_free(sql);
-
 	zbx_json_close(j);	/* data */
 	zbx_json_close(j);	/* table->table */
+out:
+	zbx_free(sql);
+	zbx_free(proxy_buckets);
+	zbx_vector_uint64_destroy(&recids);
+	zbx_vector_uint64_destroy(&buckets);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
@@ -711,8 +1051,16 @@ static void	get_proxy_monitored_httptests(zbx_uint64_t proxy_hostid, zbx_vector_
  *                                                                            *
  * Purpose: prepare proxy configuration data                                  *
  *                                                                            *
+ * Parameters: proxy_hostid - [IN] the proxy identifier                       *
+ *             j            - [OUT] the configuration data                    *
+ *             jp_digest    - [IN] the configuration digest reported by proxy *
+ *                                 (optional). Only changed rows are sent     *
+ *                                 for tables present in the digest.          *
+ *             error        - [OUT] the error message                         *
+ *                                                                            *
  ******************************************************************************/
-int	get_proxyconfig_data(zbx_uint64_t proxy_hostid, struct zbx_json *j, char **error)
+int	get_proxyconfig_data(zbx_uint64_t proxy_hostid, struct zbx_json *j, const struct zbx_json_parse *jp_digest,
+		char **error)
 {
 	static const char	*proxytable[] =
 	{
@@ -741,6 +1089,8 @@ int	get_proxyconfig_data(zbx_uint64_t proxy_hostid, struct zbx_json *j, char **e
 	int			i, ret = FAIL;
 	const ZBX_TABLE		*table;
 	zbx_vector_uint64_t	hosts, httptests;
+	char			*digest = NULL;
+	size_t			digest_alloc = 0;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() proxy_hostid:" ZBX_FS_UI64, __func__, proxy_hostid);
 
@@ -757,7 +1107,14 @@ int	get_proxyconfig_data(zbx_uint64_t proxy_hostid, struct zbx_json *j, char **e
 		table = DBget_table(proxytable[i]);
 		assert(NULL != table);
 
-		if (SUCCEED != get_proxyconfig_table(proxy_hostid, j, table, &hosts, &httptests))
+		if (NULL == jp_digest || SUCCEED != zbx_json_value_by_name_dyn(jp_digest, table->table, &digest,
+				&digest_alloc))
+		{
+			zbx_free(digest);
+			digest_alloc = 0;
+		}
+
+		if (SUCCEED != get_proxyconfig_table(proxy_hostid, j, table, &hosts, &httptests, digest))
 		{
 			*error = zbx_dsprintf(*error, "failed to get data from table \"%s\"", table->table);
 			goto out;
@@ -766,6 +1123,7 @@ int	get_proxyconfig_data(zbx_uint64_t proxy_hostid, struct zbx_json *j, char **e
 
 	ret = SUCCEED;
 out:
+	zbx_free(digest);
 	zbx_vector_uint64_destroy(&httptests);
 	zbx_vector_uint64_destroy(&hosts);
 
@@ -935,18 +1293,57 @@ static int	compare_nth_field(const ZBX_FIELD **fields, const char *rec_data, int
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: proxyconfig_add_buckets_condition                                *
+ *                                                                            *
+ * Purpose: add condition selecting configuration table rows of the given     *
+ *          buckets to SQL query                                              *
+ *                                                                            *
+ * Parameters: sql         - [IN/OUT] the SQL query                           *
+ *             sql_alloc   - [IN/OUT] the allocated size of SQL query         *
+ *             sql_offset  - [IN/OUT] the end of SQL query                    *
+ *             table       - [IN] the configuration table                     *
+ *             buckets     - [IN] the buckets, sorted                         *
+ *             buckets_num - [IN] the number of buckets                       *
+ *                                                                            *
+ * Comments: The row bucket is the remainder of record identifier divided by  *
+ *           the number of buckets, the same as used for table digest.        *
+ *                                                                            *
+ ******************************************************************************/
+static void	proxyconfig_add_buckets_condition(char **sql, size_t *sql_alloc, size_t *sql_offset,
+		const ZBX_TABLE *table, const zbx_vector_uint64_t *buckets, int buckets_num)
+{
+	char	*field;
+
+	field = zbx_dsprintf(NULL, ZBX_SQL_MOD(%s,%d), table->recid, buckets_num);
+	DBadd_condition_alloc(sql, sql_alloc, sql_offset, field, buckets->values, buckets->values_num);
+	zbx_free(field);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: process_proxyconfig_table                                        *
  *                                                                            *
  * Purpose: update configuration table                                        *
  *                                                                            *
+ * Parameters: table       - [IN] the configuration table                     *
+ *             jp_obj      - [IN] the table data                              *
+ *             buckets     - [IN] the changed buckets, NULL if all table rows *
+ *                                were received                               *
+ *             buckets_num - [IN] the number of buckets                       *
+ *             del         - [OUT] the rows to delete                         *
+ *             error       - [OUT] the error message                          *
+ *                                                                            *
  * Return value: SUCCEED - processed successfully                             *
  *               FAIL - an error occurred                                     *
  *                                                                            *
+ * Comments: When only the changed buckets were received the existing rows    *
+ *           outside those buckets are left as they are.                      *
+ *                                                                            *
  ******************************************************************************/
 static int	process_proxyconfig_table(const ZBX_TABLE *table, struct zbx_json_parse *jp_obj,
-		zbx_vector_uint64_t *del, char **error)
+		const zbx_vector_uint64_t *buckets, int buckets_num, zbx_vector_uint64_t *del, char **error)
 {
 	int			f, fields_count, insert, i, ret = FAIL, id_field_nr = 0, move_out = 0,
 				move_field_nr = 0;
@@ -1091,6 +1488,12 @@ static int	process_proxyconfig_table(const ZBX_TABLE *table, struct zbx_json_par
 	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " from ");
 	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, table->table);
 
+	if (NULL != buckets)
+	{
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " where");
+		proxyconfig_add_buckets_condition(&sql, &sql_alloc, &sql_offset, table, buckets, buckets_num);
+	}
+
 	/* Find a number of the ID field. Usually the 1st field. */
 	id_field_nr = find_field_by_name(fields, fields_count, table->recid);
 
@@ -1553,32 +1956,363 @@ out:
 
 /******************************************************************************
  *                                                                            *
- * Function: process_proxyconfig                                              *
+ * Function: proxyconfig_table_get                                            *
  *                                                                            *
- * Purpose: update configuration                                              *
+ * Purpose: find synced configuration table row hashes                        *
  *                                                                            *
  ******************************************************************************/
-void	process_proxyconfig(struct zbx_json_parse *jp_data)
+static zbx_proxyconfig_table_t	*proxyconfig_table_get(const ZBX_TABLE *table)
+{
+	int	i;
+
+	for (i = 0; i < proxyconfig_tables.values_num; i++)
+	{
+		zbx_proxyconfig_table_t	*pt = (zbx_proxyconfig_table_t *)proxyconfig_tables.values[i];
+
+		if (pt->table == table)
+			return pt;
+	}
+
+	return NULL;
+}
+
+static void	proxyconfig_table_free(zbx_proxyconfig_table_t *pt)
+{
+	zbx_hashset_destroy(&pt->rows);
+	zbx_free(pt);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: proxyconfig_hash_rows                                            *
+ *                                                                            *
+ * Purpose: calculate hashes of configuration table rows received from server *
+ *                                                                            *
+ * Parameters: table  - [IN] the configuration table                          *
+ *             jp_obj - [IN] the table data                                   *
+ *             rows   - [OUT] the row identifiers and hashes                  *
+ *             error  - [OUT] the error message                               *
+ *                                                                            *
+ * Return value: SUCCEED - the hashes were calculated successfully            *
+ *               FAIL    - invalid table data                                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	proxyconfig_hash_rows(const ZBX_TABLE *table, const struct zbx_json_parse *jp_obj,
+		zbx_vector_uint64_pair_t *rows, char **error)
 {
-	typedef struct
+	struct zbx_json_parse	jp_fields, jp_data, jp_row;
+	const char		*p, *pf;
+	char			*buf = NULL;
+	size_t			buf_alloc = 0;
+	unsigned char		hashed[ZBX_MAX_FIELDS];
+	int			f, fields_num = 0, ret = FAIL;
+	zbx_json_type_t		type;
+	md5_state_t		state;
+	zbx_uint64_pair_t	pair;
+
+	if (SUCCEED != zbx_json_brackets_by_name(jp_obj, "fields", &jp_fields) ||
+			SUCCEED != zbx_json_brackets_by_name(jp_obj, ZBX_PROTO_TAG_DATA, &jp_data))
 	{
-		const ZBX_TABLE		*table;
-		zbx_vector_uint64_t	ids;
+		*error = zbx_strdup(*error, zbx_json_strerror());
+		goto out;
 	}
-	table_ids_t;
 
-	char			buf[ZBX_TABLENAME_LEN_MAX];
+	for (p = NULL; NULL != (p = zbx_json_next_value_dyn(&jp_fields, p, &buf, &buf_alloc, NULL)); fields_num++)
+	{
+		if (ZBX_MAX_FIELDS == fields_num)
+		{
+			*error = zbx_dsprintf(*error, "too many fields in table \"%s\"", table->table);
+			goto out;
+		}
+
+		hashed[fields_num] = (SUCCEED == proxyconfig_field_is_hashed(table, buf));
+	}
+
+	for (p = NULL; NULL != (p = zbx_json_next(&jp_data, p));)
+	{
+		if (FAIL == zbx_json_brackets_open(p, &jp_row))
+		{
+			*error = zbx_strdup(*error, zbx_json_strerror());
+			goto out;
+		}
+
+		pair.first = 0;
+		zbx_md5_init(&state);
+
+		for (f = 0, pf = NULL; NULL != (pf = zbx_json_next_value_dyn(&jp_row, pf, &buf, &buf_alloc, &type));
+				f++)
+		{
+			if (0 == f && SUCCEED != is_uint64(buf, &pair.first))
+			{
+				*error = zbx_dsprintf(*error, "invalid record identifier \"%s\" in table \"%s\"", buf,
+						table->table);
+				goto out;
+			}
+
+			if (f < fields_num && 0 != hashed[f])
+				proxyconfig_hash_append(&state, ZBX_JSON_TYPE_NULL != type ? buf : NULL);
+		}
+
+		pair.second = proxyconfig_hash_finish(&state);
+		zbx_vector_uint64_pair_append(rows, pair);
+	}
+
+	ret = SUCCEED;
+out:
+	zbx_free(buf);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: proxyconfig_parse_delta                                          *
+ *                                                                            *
+ * Purpose: parse the list of changed buckets for partial table data          *
+ *                                                                            *
+ * Parameters: jp_obj - [IN] the table data                                   *
+ *             update - [OUT] the table update                                *
+ *             error  - [OUT] the error message                               *
+ *                                                                            *
+ * Return value: SUCCEED - the table data was parsed successfully             *
+ *               FAIL    - invalid table data                                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	proxyconfig_parse_delta(const struct zbx_json_parse *jp_obj, zbx_proxyconfig_update_t *update,
+		char **error)
+{
+	struct zbx_json_parse	jp_delta, jp_changed;
+	char			buf[MAX_ID_LEN + 1];
 	const char		*p = NULL;
-	struct zbx_json_parse	jp_obj;
-	char			*error = NULL;
-	int			i, ret = SUCCEED;
+	zbx_uint64_t		bucket;
 
-	table_ids_t		*table_ids;
-	zbx_vector_ptr_t	tables_proxy;
-	const ZBX_TABLE		*table;
+	if (SUCCEED != zbx_json_brackets_by_name(jp_obj, "delta", &jp_delta))
+		return SUCCEED;
+
+	if (0 == proxyconfig_tables_init || NULL == proxyconfig_table_get(update->table))
+	{
+		*error = zbx_dsprintf(*error, "unexpected partial data of table \"%s\"", update->table->table);
+		return FAIL;
+	}
+
+	if (SUCCEED != zbx_json_value_by_name(&jp_delta, "buckets", buf, sizeof(buf)) ||
+			SUCCEED != is_uint31(buf, &update->buckets_num) || 0 == update->buckets_num ||
+			ZBX_PROXYCONFIG_BUCKETS_MAX < update->buckets_num ||
+			SUCCEED != zbx_json_value_by_name(&jp_delta, "digest", buf, sizeof(buf)) ||
+			SUCCEED != is_uint64(buf, &update->digest) ||
+			SUCCEED != zbx_json_brackets_by_name(&jp_delta, "changed", &jp_changed))
+	{
+		*error = zbx_dsprintf(*error, "invalid partial data of table \"%s\"", update->table->table);
+		return FAIL;
+	}
+
+	while (NULL != (p = zbx_json_next_value(&jp_changed, p, buf, sizeof(buf), NULL)))
+	{
+		if (SUCCEED != is_uint64(buf, &bucket) || (zbx_uint64_t)update->buckets_num <= bucket)
+		{
+			*error = zbx_dsprintf(*error, "invalid bucket \"%s\" of table \"%s\"", buf,
+					update->table->table);
+			return FAIL;
+		}
+
+		zbx_vector_uint64_append(&update->buckets, bucket);
+	}
+
+	if (0 == update->buckets.values_num)
+	{
+		*error = zbx_dsprintf(*error, "empty list of changed buckets of table \"%s\"", update->table->table);
+		return FAIL;
+	}
+
+	zbx_vector_uint64_sort(&update->buckets, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_uniq(&update->buckets, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	update->delta = 1;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: proxyconfig_tables_update                                        *
+ *                                                                            *
+ * Purpose: update synced configuration row hashes after the received         *
+ *          configuration has been stored in database                         *
+ *                                                                            *
+ * Comments: A table that does not match server digest after update is       *
+ *           dropped, so all its rows are requested during the next sync.     *
+ *                                                                            *
+ ******************************************************************************/
+static void	proxyconfig_tables_update(const zbx_vector_ptr_t *updates)
+{
+	int				i, k;
+	zbx_proxyconfig_update_t	*update;
+	zbx_proxyconfig_table_t		*pt;
+	zbx_proxyconfig_row_t		*prow, row_local;
+	zbx_hashset_iter_t		iter;
+	zbx_uint64_t			digest;
+	unsigned char			*changed;
+
+	for (i = 0; i < updates->values_num; i++)
+	{
+		update = (zbx_proxyconfig_update_t *)updates->values[i];
+
+		if (NULL == (pt = proxyconfig_table_get(update->table)))
+		{
+			pt = (zbx_proxyconfig_table_t *)zbx_malloc(NULL, sizeof(zbx_proxyconfig_table_t));
+			pt->table = update->table;
+			zbx_hashset_create(&pt->rows, (size_t)update->rows.values_num, ZBX_DEFAULT_UINT64_HASH_FUNC,
+					ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+			zbx_vector_ptr_append(&proxyconfig_tables, pt);
+		}
+
+		if (0 == update->delta)
+		{
+			zbx_hashset_clear(&pt->rows);
+		}
+		else
+		{
+			changed = (unsigned char *)zbx_calloc(NULL, (size_t)update->buckets_num, sizeof(unsigned char));
+
+			for (k = 0; k < update->buckets.values_num; k++)
+				changed[update->buckets.values[k]] = 1;
+
+			zbx_hashset_iter_reset(&pt->rows, &iter);
+			while (NULL != (prow = (zbx_proxyconfig_row_t *)zbx_hashset_iter_next(&iter)))
+			{
+				if (0 != changed[prow->recid % update->buckets_num])
+					zbx_hashset_iter_remove(&iter);
+			}
+
+			zbx_free(changed);
+		}
+
+		for (k = 0; k < update->rows.values_num; k++)
+		{
+			row_local.recid = update->rows.values[k].first;
+			row_local.hash = update->rows.values[k].second;
+
+			if (NULL != (prow = (zbx_proxyconfig_row_t *)zbx_hashset_search(&pt->rows, &row_local)))
+				prow->hash = row_local.hash;
+			else
+				zbx_hashset_insert(&pt->rows, &row_local, sizeof(row_local));
+		}
+
+		if (0 == update->delta)
+			continue;
+
+		digest = 0;
+		zbx_hashset_iter_reset(&pt->rows, &iter);
+		while (NULL != (prow = (zbx_proxyconfig_row_t *)zbx_hashset_iter_next(&iter)))
+			digest ^= prow->hash;
+
+		if (digest != update->digest)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "configuration table \"%s\" does not match server copy, all its"
+					" rows will be requested during the next synchronization", pt->table->table);
+
+			zbx_vector_ptr_remove_noorder(&proxyconfig_tables,
+					zbx_vector_ptr_search(&proxyconfig_tables, pt, ZBX_DEFAULT_PTR_COMPARE_FUNC));
+			proxyconfig_table_free(pt);
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: get_proxyconfig_digest                                           *
+ *                                                                            *
+ * Purpose: add the digest of synced configuration to proxy configuration    *
+ *          request                                                           *
+ *                                                                            *
+ * Parameters: j - [OUT] the configuration request                            *
+ *                                                                            *
+ * Comments: Every table is split into buckets by record identifier and the   *
+ *           digest contains XOR of row hashes in each bucket, so server can  *
+ *           send only the rows of buckets that differ. The first call        *
+ *           enables tracking of received configuration, until then no       *
+ *           digest is added and all configuration is requested.              *
+ *                                                                            *
+ ******************************************************************************/
+void	get_proxyconfig_digest(struct zbx_json *j)
+{
+	int			i, k, buckets_num;
+	zbx_proxyconfig_table_t	*pt;
+	zbx_proxyconfig_row_t	*prow;
+	zbx_hashset_iter_t	iter;
+	zbx_uint64_t		*buckets;
+	unsigned char		*data;
+	char			*base64 = NULL;
+
+	if (0 == proxyconfig_tables_init)
+	{
+		zbx_vector_ptr_create(&proxyconfig_tables);
+		proxyconfig_tables_init = 1;
+	}
+
+	if (0 == proxyconfig_tables.values_num)
+		return;
+
+	zbx_json_addobject(j, ZBX_PROTO_TAG_CONFIG_DIGEST);
+
+	for (i = 0; i < proxyconfig_tables.values_num; i++)
+	{
+		pt = (zbx_proxyconfig_table_t *)proxyconfig_tables.values[i];
+
+		if (ZBX_PROXYCONFIG_BUCKETS_MAX < (buckets_num = pt->rows.num_data / ZBX_PROXYCONFIG_BUCKET_ROWS + 1))
+			buckets_num = ZBX_PROXYCONFIG_BUCKETS_MAX;
+
+		buckets = (zbx_uint64_t *)zbx_calloc(NULL, (size_t)buckets_num, sizeof(zbx_uint64_t));
+
+		zbx_hashset_iter_reset(&pt->rows, &iter);
+		while (NULL != (prow = (zbx_proxyconfig_row_t *)zbx_hashset_iter_next(&iter)))
+			buckets[prow->recid % buckets_num] ^= prow->hash;
+
+		data = (unsigned char *)zbx_malloc(NULL, (size_t)buckets_num * 8);
+
+		for (k = 0; k < buckets_num * 8; k++)
+			data[k] = (unsigned char)(buckets[k / 8] >> ((k % 8) * 8));
+
+		str_base64_encode_dyn((const char *)data, &base64, buckets_num * 8);
+		zbx_json_addstring(j, pt->table->table, base64, ZBX_JSON_TYPE_STRING);
+
+		zbx_free(base64);
+		zbx_free(data);
+		zbx_free(buckets);
+	}
+
+	zbx_json_close(j);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: process_proxyconfig                                              *
+ *                                                                            *
+ * Purpose: update configuration                                              *
+ *                                                                            *
+ * Comments: Tables missing in the received data are left unchanged. Tables  *
+ *           with "delta" tag contain only rows of the changed buckets.       *
+ *                                                                            *
+ ******************************************************************************/
+void	process_proxyconfig(struct zbx_json_parse *jp_data)
+{
+	char				buf[ZBX_TABLENAME_LEN_MAX];
+	const char			*p = NULL;
+	struct zbx_json_parse		jp_obj;
+	char				*error = NULL;
+	int				i, ret = SUCCEED;
+
+	zbx_proxyconfig_update_t	*table_ids;
+	zbx_vector_ptr_t		tables_proxy;
+	const ZBX_TABLE			*table;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
+	if (NULL == zbx_json_pair_next(jp_data, NULL, buf, sizeof(buf)))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "End of %s(): configuration is up to date", __func__);
+		return;
+	}
+
 	zbx_vector_ptr_create(&tables_proxy);
 
 	DBbegin();
@@ -1600,12 +2334,24 @@ void	process_proxyconfig(struct zbx_json_parse *jp_data)
 			break;
 		}
 
-		table_ids = (table_ids_t *)zbx_malloc(NULL, sizeof(table_ids_t));
+		table_ids = (zbx_proxyconfig_update_t *)zbx_malloc(NULL, sizeof(zbx_proxyconfig_update_t));
 		table_ids->table = table;
+		table_ids->delta = 0;
+		table_ids->buckets_num = 0;
+		table_ids->digest = 0;
 		zbx_vector_uint64_create(&table_ids->ids);
+		zbx_vector_uint64_create(&table_ids->buckets);
+		zbx_vector_uint64_pair_create(&table_ids->rows);
 		zbx_vector_ptr_append(&tables_proxy, table_ids);
 
-		ret = process_proxyconfig_table(table, &jp_obj, &table_ids->ids, &error);
+		if (SUCCEED != (ret = proxyconfig_parse_delta(&jp_obj, table_ids, &error)))
+			break;
+
+		ret = process_proxyconfig_table(table, &jp_obj, (0 != table_ids->delta ? &table_ids->buckets : NULL),
+				table_ids->buckets_num, &table_ids->ids, &error);
+
+		if (SUCCEED == ret && 0 != proxyconfig_tables_init)
+			ret = proxyconfig_hash_rows(table, &jp_obj, &table_ids->rows, &error);
 	}
 
 	if (SUCCEED == ret)
@@ -1619,7 +2365,7 @@ void	process_proxyconfig(struct zbx_json_parse *jp_data)
 
 		for (i = tables_proxy.values_num - 1; 0 <= i; i--)
 		{
-			table_ids = (table_ids_t *)tables_proxy.values[i];
+			table_ids = (zbx_proxyconfig_update_t *)tables_proxy.values[i];
 
 			if (0 == table_ids->ids.values_num)
 				continue;
@@ -1642,26 +2388,35 @@ void	process_proxyconfig(struct zbx_json_parse *jp_data)
 		zbx_free(sql);
 	}
 
-	for (i = 0; i < tables_proxy.values_num; i++)
-	{
-		table_ids = (table_ids_t *)tables_proxy.values[i];
-
-		zbx_vector_uint64_destroy(&table_ids->ids);
-		zbx_free(table_ids);
-	}
-	zbx_vector_ptr_destroy(&tables_proxy);
-
 	if (SUCCEED != (ret = DBend(ret)))
 	{
 		zabbix_log(LOG_LEVEL_ERR, "failed to update local proxy configuration copy: %s",
 				(NULL == error ? "database error" : error));
+
+		/* request all configuration during the next sync */
+		if (0 != proxyconfig_tables_init)
+			zbx_vector_ptr_clear_ext(&proxyconfig_tables, (zbx_mem_free_func_t)proxyconfig_table_free);
 	}
 	else
 	{
+		if (0 != proxyconfig_tables_init)
+			proxyconfig_tables_update(&tables_proxy);
+
 		DCsync_configuration(ZBX_DBSYNC_UPDATE);
 		DCupdate_hosts_availability();
 	}
 
+	for (i = 0; i < tables_proxy.values_num; i++)
+	{
+		table_ids = (zbx_proxyconfig_update_t *)tables_proxy.values[i];
+
+		zbx_vector_uint64_pair_destroy(&table_ids->rows);
+		zbx_vector_uint64_destroy(&table_ids->buckets);
+		zbx_vector_uint64_destroy(&table_ids->ids);
+		zbx_free(table_ids);
+	}
+	zbx_vector_ptr_destroy(&tables_proxy);
+
 	zbx_free(error);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
@@ -1925,7 +2680,12 @@ static void	proxy_set_lastid(const char *table_name, const char *lastidfield, co
 
 void	proxy_set_hist_lastid(const zbx_uint64_t lastid)
 {
-	proxy_set_lastid("proxy_history", "history_lastid", lastid);
+	zbx_uint64_t	db_lastid;
+
+	if (ZBX_PB_MODE_MEMORY != hist_mode)
+		proxy_set_lastid("proxy_history", "history_lastid", lastid);
+	else if (SUCCEED == zbx_pb_history_ack(lastid, &db_lastid))
+		proxy_set_lastid("proxy_history", "history_lastid", db_lastid);
 }
 
 void	proxy_set_dhis_lastid(const zbx_uint64_t lastid)
@@ -2030,24 +2790,6 @@ try_again:
 			(zbx_fs_size_t)j->buffer_offset);
 }
 
-typedef struct
-{
-	zbx_uint64_t	id;
-	zbx_uint64_t	itemid;
-	zbx_uint64_t	lastlogsize;
-	size_t		source_offset;
-	size_t		value_offset;
-	int		clock;
-	int		ns;
-	int		timestamp;
-	int		severity;
-	int		logeventid;
-	int		mtime;
-	unsigned char	state;
-	unsigned char	flags;
-}
-zbx_history_data_t;
-
 /******************************************************************************
  *                                                                            *
  * Function: proxy_get_history_data                                           *
@@ -2192,6 +2934,23 @@ try_again:
 	return data_num;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: proxy_hist_data_size                                             *
+ *                                                                            *
+ * Purpose: returns the estimated size of 'proxy data' request with history   *
+ *          data added so far                                                 *
+ *                                                                            *
+ ******************************************************************************/
+static size_t	proxy_hist_data_size(const struct zbx_json *j, const zbx_hist_bin_t *bin)
+{
+	if (NULL == bin)
+		return j->buffer_offset;
+
+	/* binary data is added to json as base64 string */
+	return j->buffer_offset + (bin->data_offset + 2) / 3 * 4;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: proxy_add_hist_data                                              *
@@ -2199,18 +2958,23 @@ try_again:
  * Purpose: add history records to output json                                *
  *                                                                            *
  * Parameters: j             - [IN] the json output buffer                    *
+ *             bin           - [IN/OUT] the binary history data, NULL when    *
+ *                                      records are added to json             *
  *             records_num   - [IN] the total number of records added         *
  *             dc_items      - [IN] the item configuration data               *
  *             errcodes      - [IN] the item configuration status codes       *
  *             records       - [IN] the records to add                        *
  *             string_buffer - [IN] the string buffer holding string values   *
+ *             id_offset     - [IN] the offset added to record ids sent to    *
+ *                                  server                                    *
  *             lastid        - [OUT] the id of last added record              *
  *                                                                            *
  * Return value: The total number of records added.                           *
  *                                                                            *
  ******************************************************************************/
-static int	proxy_add_hist_data(struct zbx_json *j, int records_num, const DC_ITEM *dc_items, const int *errcodes,
-		const zbx_vector_ptr_t *records, const char *string_buffer, zbx_uint64_t *lastid)
+static int	proxy_add_hist_data(struct zbx_json *j, zbx_hist_bin_t *bin, int records_num, const DC_ITEM *dc_items,
+		const int *errcodes, const zbx_vector_ptr_t *records, const char *string_buffer, zbx_uint64_t id_offset,
+		zbx_uint64_t *lastid)
 {
 	int				i;
 	const zbx_history_data_t	*hd;
@@ -2235,11 +2999,23 @@ static int	proxy_add_hist_data(struct zbx_json *j, int records_num, const DC_ITE
 				continue;
 		}
 
+		if (NULL != bin)
+		{
+			zbx_hist_bin_add_record(bin, hd, hd->id + id_offset, string_buffer);
+			records_num++;
+
+			/* stop gathering data to avoid exceeding the maximum packet size */
+			if (ZBX_DATA_JSON_RECORD_LIMIT < proxy_hist_data_size(j, bin))
+				break;
+
+			continue;
+		}
+
 		if (0 == records_num)
 			zbx_json_addarray(j, ZBX_PROTO_TAG_HISTORY_DATA);
 
 		zbx_json_addobject(j, NULL);
-		zbx_json_adduint64(j, ZBX_PROTO_TAG_ID, hd->id);
+		zbx_json_adduint64(j, ZBX_PROTO_TAG_ID, hd->id + id_offset);
 		zbx_json_adduint64(j, ZBX_PROTO_TAG_ITEMID, hd->itemid);
 		zbx_json_adduint64(j, ZBX_PROTO_TAG_CLOCK, hd->clock);
 		zbx_json_adduint64(j, ZBX_PROTO_TAG_NS, hd->ns);
@@ -2288,12 +3064,37 @@ static int	proxy_add_hist_data(struct zbx_json *j, int records_num, const DC_ITE
 	return records_num;
 }
 
-int	proxy_get_hist_data(struct zbx_json *j, zbx_uint64_t *lastid, int *more)
+/******************************************************************************
+ *                                                                            *
+ * Function: proxy_get_hist_data                                              *
+ *                                                                            *
+ * Purpose: add history data to 'proxy data' request                          *
+ *                                                                            *
+ * Parameters: j       - [IN/OUT] the json output buffer                      *
+ *             binary  - [IN] 1 - add records in binary format                *
+ *                            0 - add records as json array                   *
+ *             lastid  - [OUT] the id of last added record                    *
+ *             more    - [OUT] ZBX_PROXY_DATA_MORE - there are more records   *
+ *                             to send                                        *
+ *                             ZBX_PROXY_DATA_DONE - otherwise                *
+ *                                                                            *
+ * Return value: The number of records added.                                 *
+ *                                                                            *
+ * Comments: Binary records are sent only to servers that advertised          *
+ *           ZBX_PROXY_HISTORY_BINARY_FORMAT support, encoded as base64       *
+ *           string in 'history binary' tag. Other servers receive            *
+ *           'history data' json array.                                       *
+ *                                                                            *
+ ******************************************************************************/
+int	proxy_get_hist_data(struct zbx_json *j, int binary, zbx_uint64_t *lastid, int *more)
 {
-	int			records_num = 0, data_num, i, *errcodes = NULL, items_alloc = 0;
-	zbx_uint64_t		id;
+	int			records_num = 0, data_num, read_num = 0, i, *errcodes = NULL, items_alloc = 0;
+	zbx_uint64_t		id, id_offset = 0;
 	zbx_hashset_t		itemids_added;
+	zbx_pb_state_t		pb_state;
+	zbx_history_data_get_func_t	get_history_data;
 	zbx_history_data_t	*data;
+	zbx_hist_bin_t		bin, *pbin = NULL;
 	char			*string_buffer;
 	size_t			data_alloc = 16, string_buffer_alloc = ZBX_KIBIBYTE;
 	zbx_vector_uint64_t	itemids;
@@ -2308,7 +3109,27 @@ int	proxy_get_hist_data(struct zbx_json *j, zbx_uint64_t *lastid, int *more)
 	string_buffer = (char *)zbx_malloc(NULL, string_buffer_alloc);
 
 	*more = ZBX_PROXY_DATA_MORE;
-	proxy_get_lastid("proxy_history", "history_lastid", &id);
+
+	if (0 != binary)
+	{
+		zbx_hist_bin_init(&bin);
+		pbin = &bin;
+	}
+
+	zbx_pb_get_state(&pb_state);
+
+	if (ZBX_PB_MODE_MEMORY == (hist_mode = pb_state.mode))
+	{
+		/* values sent from memory buffer are removed when acknowledged */
+		id = 0;
+		get_history_data = zbx_pb_history_get;
+	}
+	else
+	{
+		proxy_get_lastid("proxy_history", "history_lastid", &id);
+		id_offset = pb_state.id_offset;
+		get_history_data = proxy_get_history_data;
+	}
 
 	zbx_hashset_create(&itemids_added, data_alloc, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
@@ -2316,10 +3137,12 @@ int	proxy_get_hist_data(struct zbx_json *j, zbx_uint64_t *lastid, int *more)
 	/*   1) there are no more data to read                                  */
 	/*   2) we have retrieved more than the total maximum number of records */
 	/*   3) we have gathered more than half of the maximum packet size      */
-	while (ZBX_DATA_JSON_BATCH_LIMIT > j->buffer_offset && ZBX_MAX_HRECORDS_TOTAL > records_num &&
-			0 != (data_num = proxy_get_history_data(id, &data, &data_alloc, &string_buffer,
+	while (ZBX_DATA_JSON_BATCH_LIMIT > proxy_hist_data_size(j, pbin) && ZBX_MAX_HRECORDS_TOTAL > records_num &&
+			0 != (data_num = get_history_data(id, &data, &data_alloc, &string_buffer,
 					&string_buffer_alloc, more)))
 	{
+		read_num += data_num;
+
 		zbx_vector_uint64_reserve(&itemids, data_num);
 		zbx_vector_ptr_reserve(&records, data_num);
 
@@ -2349,7 +3172,8 @@ int	proxy_get_hist_data(struct zbx_json *j, zbx_uint64_t *lastid, int *more)
 
 		DCconfig_get_items_by_itemids(dc_items, itemids.values, errcodes, itemids.values_num);
 
-		records_num = proxy_add_hist_data(j, records_num, dc_items, errcodes, &records, string_buffer, lastid);
+		records_num = proxy_add_hist_data(j, pbin, records_num, dc_items, errcodes, &records, string_buffer,
+				id_offset, lastid);
 		DCconfig_clean_items(dc_items, errcodes, itemids.values_num);
 
 		/* got less data than requested - either no more data to read or the history is full of */
@@ -2363,9 +3187,26 @@ int	proxy_get_hist_data(struct zbx_json *j, zbx_uint64_t *lastid, int *more)
 		id = *lastid;
 	}
 
-	if (0 != records_num)
+	if (NULL != pbin)
+	{
+		if (0 != records_num)
+		{
+			char	*base64 = NULL;
+
+			str_base64_encode_dyn((const char *)bin.data, &base64, (int)bin.data_offset);
+			zbx_json_addstring(j, ZBX_PROTO_TAG_HISTORY_BINARY, base64, ZBX_JSON_TYPE_STRING);
+			zbx_free(base64);
+		}
+
+		zbx_hist_bin_clear(&bin);
+	}
+	else if (0 != records_num)
 		zbx_json_close(j);
 
+	/* switch to memory buffer when all values have been sent from database */
+	if (ZBX_PB_MODE_DATABASE == pb_state.mode && 0 == read_num && ZBX_PROXY_DATA_DONE == *more)
+		zbx_pb_set_memory_mode(&pb_state, id);
+
 	zbx_hashset_destroy(&itemids_added);
 
 	zbx_free(dc_items);
@@ -2628,6 +3469,59 @@ static int	process_history_data_value(DC_ITEM *item, zbx_agent_value_t *value)
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: process_history_values                                           *
+ *                                                                            *
+ * Purpose: process new item values without flushing them                     *
+ *                                                                            *
+ * Parameters: items      - [IN] the items to process                         *
+ *             values     - [IN] the item values value to process             *
+ *             errcodes   - [IN/OUT] in - item configuration error code       *
+ *                                      (FAIL - item/host was not found)      *
+ *                                   out - value processing result            *
+ *                                      (SUCCEED - processed, FAIL - error)   *
+ *             values_num - [IN] the number of items/values to process        *
+ *                                                                            *
+ * Return value: the number of processed values                               *
+ *                                                                            *
+ * Comments: The values are buffered locally and sent to preprocessing        *
+ *           manager or history cache in batches of their own size, so a      *
+ *           request is not split into one message per parsed slice. The      *
+ *           caller must flush the buffers after the last slice of request.   *
+ *                                                                            *
+ ******************************************************************************/
+static int	process_history_values(DC_ITEM *items, zbx_agent_value_t *values, int *errcodes, size_t values_num)
+{
+	size_t	i;
+	int	processed_num = 0;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	for (i = 0; i < values_num; i++)
+	{
+		if (SUCCEED != errcodes[i])
+			continue;
+
+		if (SUCCEED != process_history_data_value(&items[i], &values[i]))
+		{
+			/* clean failed items to avoid updating their runtime data */
+			DCconfig_clean_items(&items[i], &errcodes[i], 1);
+			errcodes[i] = FAIL;
+			continue;
+		}
+
+		processed_num++;
+	}
+
+	if (0 < processed_num)
+		zbx_dc_items_update_nextcheck(items, values, errcodes, values_num);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() processed:%d", __func__, processed_num);
+
+	return processed_num;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: process_history_data                                             *
@@ -2647,35 +3541,13 @@ static int	process_history_data_value(DC_ITEM *item, zbx_agent_value_t *value)
  ******************************************************************************/
 int	process_history_data(DC_ITEM *items, zbx_agent_value_t *values, int *errcodes, size_t values_num)
 {
-	size_t	i;
-	int	processed_num = 0;
-
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
-
-	for (i = 0; i < values_num; i++)
-	{
-		if (SUCCEED != errcodes[i])
-			continue;
-
-		if (SUCCEED != process_history_data_value(&items[i], &values[i]))
-		{
-			/* clean failed items to avoid updating their runtime data */
-			DCconfig_clean_items(&items[i], &errcodes[i], 1);
-			errcodes[i] = FAIL;
-			continue;
-		}
-
-		processed_num++;
-	}
+	int	processed_num;
 
-	if (0 < processed_num)
-		zbx_dc_items_update_nextcheck(items, values, errcodes, values_num);
+	processed_num = process_history_values(items, values, errcodes, values_num);
 
 	zbx_preprocessor_flush();
 	dc_flush_history();
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() processed:%d", __func__, processed_num);
-
 	return processed_num;
 }
 
@@ -2754,6 +3626,41 @@ static void	log_client_timediff(int level, struct zbx_json_parse *jp, const zbx_
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: decode_history_data_row_field                                    *
+ *                                                                            *
+ * Purpose: decodes numeric field of history data json row                    *
+ *                                                                            *
+ * Parameters: p         - [IN] the field value in json row (optional)        *
+ *             buffer    - [OUT] the buffer for short values                  *
+ *             size      - [IN] the buffer size                               *
+ *             tmp       - [IN/OUT] the dynamic buffer for long values        *
+ *             tmp_alloc - [IN/OUT] the dynamic buffer size                   *
+ *                                                                            *
+ * Return value: The decoded value or NULL if the field is missing or cannot  *
+ *               be decoded.                                                  *
+ *                                                                            *
+ * Comments: Values that do not fit the buffer are decoded in full, so they   *
+ *           are validated the same way as short values instead of being      *
+ *           treated as missing.                                              *
+ *                                                                            *
+ ******************************************************************************/
+static const char	*decode_history_data_row_field(const char *p, char *buffer, size_t size, char **tmp,
+		size_t *tmp_alloc)
+{
+	if (NULL == p)
+		return NULL;
+
+	if (NULL != zbx_json_decodevalue(p, buffer, size, NULL))
+		return buffer;
+
+	if (NULL != zbx_json_decodevalue_dyn(p, tmp, tmp_alloc, NULL))
+		return *tmp;
+
+	return NULL;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: parse_history_data_row_value                                     *
@@ -2768,24 +3675,63 @@ static void	log_client_timediff(int level, struct zbx_json_parse *jp, const zbx_
  * Return value:  SUCCEED - the value was parsed successfully                 *
  *                FAIL    - otherwise                                         *
  *                                                                            *
+ * Comments: When a row contains the same tag more than once the first one    *
+ *           is used.                                                         *
+ *                                                                            *
  ******************************************************************************/
 static int	parse_history_data_row_value(const struct zbx_json_parse *jp_row, zbx_timespec_t *unique_shift,
 		zbx_agent_value_t *av)
 {
-	char	*tmp = NULL;
-	size_t	tmp_alloc = 0;
-	int	ret = FAIL;
+	const char	*p = NULL, *pclock = NULL, *pns = NULL, *pstate = NULL, *plastlogsize = NULL, *pmtime = NULL,
+			*pvalue = NULL, *ptimestamp = NULL, *psource = NULL, *pseverity = NULL, *plogeventid = NULL,
+			*pid = NULL, **pfield, *field;
+	char		tag[MAX_STRING_LEN], buffer[MAX_ID_LEN + 1], *tmp = NULL;
+	size_t		value_alloc = 0, source_alloc = 0, tmp_alloc = 0;
+	int		ret = FAIL;
 
 	memset(av, 0, sizeof(zbx_agent_value_t));
 
-	if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_CLOCK, &tmp, &tmp_alloc))
+	/* locate all row fields in a single pass instead of searching the row for every field */
+	while (NULL != (p = zbx_json_pair_next(jp_row, p, tag, sizeof(tag))))
+	{
+		if (0 == strcmp(tag, ZBX_PROTO_TAG_CLOCK))
+			pfield = &pclock;
+		else if (0 == strcmp(tag, ZBX_PROTO_TAG_NS))
+			pfield = &pns;
+		else if (0 == strcmp(tag, ZBX_PROTO_TAG_VALUE))
+			pfield = &pvalue;
+		else if (0 == strcmp(tag, ZBX_PROTO_TAG_ID))
+			pfield = &pid;
+		else if (0 == strcmp(tag, ZBX_PROTO_TAG_STATE))
+			pfield = &pstate;
+		else if (0 == strcmp(tag, ZBX_PROTO_TAG_LASTLOGSIZE))
+			pfield = &plastlogsize;
+		else if (0 == strcmp(tag, ZBX_PROTO_TAG_MTIME))
+			pfield = &pmtime;
+		else if (0 == strcmp(tag, ZBX_PROTO_TAG_LOGTIMESTAMP))
+			pfield = &ptimestamp;
+		else if (0 == strcmp(tag, ZBX_PROTO_TAG_LOGSOURCE))
+			pfield = &psource;
+		else if (0 == strcmp(tag, ZBX_PROTO_TAG_LOGSEVERITY))
+			pfield = &pseverity;
+		else if (0 == strcmp(tag, ZBX_PROTO_TAG_LOGEVENTID))
+			pfield = &plogeventid;
+		else
+			continue;
+
+		/* the same as searching the row by tag name, the first duplicate tag wins */
+		if (NULL == *pfield)
+			*pfield = p;
+	}
+
+	if (NULL != (field = decode_history_data_row_field(pclock, buffer, sizeof(buffer), &tmp, &tmp_alloc)))
 	{
-		if (FAIL == is_uint31(tmp, &av->ts.sec))
+		if (FAIL == is_uint31(field, &av->ts.sec))
 			goto out;
 
-		if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_NS, &tmp, &tmp_alloc))
+		if (NULL != (field = decode_history_data_row_field(pns, buffer, sizeof(buffer), &tmp, &tmp_alloc)))
 		{
-			if (FAIL == is_uint_n_range(tmp, tmp_alloc, &av->ts.ns, sizeof(av->ts.ns),
+			if (FAIL == is_uint_n_range(field, ZBX_SIZE_T_MAX, &av->ts.ns, sizeof(av->ts.ns),
 				0LL, 999999999LL))
 			{
 				goto out;
@@ -2808,49 +3754,54 @@ static int	parse_history_data_row_value(const struct zbx_json_parse *jp_row, zbx
 	else
 		zbx_timespec(&av->ts);
 
-	if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_STATE, &tmp, &tmp_alloc))
-		av->state = (unsigned char)atoi(tmp);
+	if (NULL != (field = decode_history_data_row_field(pstate, buffer, sizeof(buffer), &tmp, &tmp_alloc)))
+		av->state = (unsigned char)atoi(field);
 
 	/* Unsupported item meta information must be ignored for backwards compatibility. */
 	/* New agents will not send meta information for items in unsupported state.      */
 	if (ITEM_STATE_NOTSUPPORTED != av->state)
 	{
-		if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_LASTLOGSIZE, &tmp, &tmp_alloc))
+		if (NULL != (field = decode_history_data_row_field(plastlogsize, buffer, sizeof(buffer), &tmp,
+				&tmp_alloc)))
 		{
 			av->meta = 1;	/* contains meta information */
 
-			is_uint64(tmp, &av->lastlogsize);
+			is_uint64(field, &av->lastlogsize);
 
-			if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_MTIME, &tmp, &tmp_alloc))
-				av->mtime = atoi(tmp);
+			if (NULL != (field = decode_history_data_row_field(pmtime, buffer, sizeof(buffer), &tmp,
+					&tmp_alloc)))
+			{
+				av->mtime = atoi(field);
+			}
 		}
 	}
 
-	if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_VALUE, &tmp, &tmp_alloc))
-		av->value = zbx_strdup(av->value, tmp);
+	/* values are decoded directly into the agent value without intermediate copies */
+	if (NULL != pvalue && NULL == zbx_json_decodevalue_dyn(pvalue, &av->value, &value_alloc, NULL))
+		zbx_free(av->value);
 
-	if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_LOGTIMESTAMP, &tmp, &tmp_alloc))
-		av->timestamp = atoi(tmp);
+	if (NULL != (field = decode_history_data_row_field(ptimestamp, buffer, sizeof(buffer), &tmp, &tmp_alloc)))
+		av->timestamp = atoi(field);
 
-	if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_LOGSOURCE, &tmp, &tmp_alloc))
-		av->source = zbx_strdup(av->source, tmp);
+	if (NULL != psource && NULL == zbx_json_decodevalue_dyn(psource, &av->source, &source_alloc, NULL))
+		zbx_free(av->source);
 
-	if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_LOGSEVERITY, &tmp, &tmp_alloc))
-		av->severity = atoi(tmp);
+	if (NULL != (field = decode_history_data_row_field(pseverity, buffer, sizeof(buffer), &tmp, &tmp_alloc)))
+		av->severity = atoi(field);
 
-	if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_LOGEVENTID, &tmp, &tmp_alloc))
-		av->logeventid = atoi(tmp);
+	if (NULL != (field = decode_history_data_row_field(plogeventid, buffer, sizeof(buffer), &tmp, &tmp_alloc)))
+		av->logeventid = atoi(field);
 
-	if (SUCCEED != zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_ID, &tmp, &tmp_alloc) ||
-			SUCCEED != is_uint64(tmp, &av->id))
+	if (NULL == (field = decode_history_data_row_field(pid, buffer, sizeof(buffer), &tmp, &tmp_alloc)) ||
+			SUCCEED != is_uint64(field, &av->id))
 	{
 		av->id = 0;
 	}
 
-	zbx_free(tmp);
-
 	ret = SUCCEED;
 out:
+	zbx_free(tmp);
+
 	return ret;
 }
 
@@ -3306,7 +4257,7 @@ static int	process_client_history_data(zbx_socket_t *sock, struct zbx_json_parse
 				session->last_valueid = values[i].id;
 		}
 
-		processed_num += process_history_data(items, values, errcodes, values_num);
+		processed_num += process_history_values(items, values, errcodes, values_num);
 		total_num += read_num;
 
 		DCconfig_clean_items(items, errcodes, values_num);
@@ -3316,6 +4267,9 @@ static int	process_client_history_data(zbx_socket_t *sock, struct zbx_json_parse
 			break;
 	}
 
+	zbx_preprocessor_flush();
+	dc_flush_history();
+
 	for (i = 0; i < ZBX_HISTORY_VALUES_MAX; i++)
 	{
 		zbx_free(hostkeys[i].host);
@@ -4046,6 +5000,68 @@ int	zbx_get_protocol_version(struct zbx_json_parse *jp)
 	return version;
 
 }
+/******************************************************************************
+ *                                                                            *
+ * Function: process_proxy_history_values                                     *
+ *                                                                            *
+ * Purpose: validates and processes a batch of values received from proxy     *
+ *                                                                            *
+ * Parameters: proxy      - [IN] the proxy                                    *
+ *             session    - [IN] the data session                             *
+ *             items      - [IN] the item buffer                              *
+ *             errcodes   - [IN] the item error code buffer                   *
+ *             itemids    - [IN] the item identifiers                         *
+ *             values     - [IN] the item values                              *
+ *             values_num - [IN] the number of values                         *
+ *                                                                            *
+ * Return value: The number of processed values.                              *
+ *                                                                            *
+ ******************************************************************************/
+static int	process_proxy_history_values(const DC_PROXY *proxy, zbx_data_session_t *session, DC_ITEM *items,
+		int *errcodes, const zbx_uint64_t *itemids, zbx_agent_value_t *values, int values_num)
+{
+	int	i, processed_num;
+	char	*error = NULL;
+
+	DCconfig_get_items_by_itemids(items, itemids, errcodes, values_num);
+
+	for (i = 0; i < values_num; i++)
+	{
+		if (SUCCEED != errcodes[i])
+			continue;
+
+		/* check and discard if duplicate data */
+		if (NULL != session && 0 != values[i].id && values[i].id <= session->last_valueid)
+		{
+			DCconfig_clean_items(&items[i], &errcodes[i], 1);
+			errcodes[i] = FAIL;
+			continue;
+		}
+
+		if (SUCCEED != proxy_item_validator(&items[i], NULL, (void *)&proxy->hostid, &error))
+		{
+			if (NULL != error)
+			{
+				zabbix_log(LOG_LEVEL_WARNING, "%s", error);
+				zbx_free(error);
+			}
+
+			DCconfig_clean_items(&items[i], &errcodes[i], 1);
+			errcodes[i] = FAIL;
+		}
+	}
+
+	processed_num = process_history_values(items, values, errcodes, values_num);
+
+	if (NULL != session)
+		session->last_valueid = values[values_num - 1].id;
+
+	DCconfig_clean_items(items, errcodes, values_num);
+	zbx_agent_values_clean(values, values_num);
+
+	return processed_num;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: process_proxy_history_data_33                                    *
@@ -4071,7 +5087,7 @@ static int	process_proxy_history_data_33(const DC_PROXY *proxy, struct zbx_json_
 		zbx_data_session_t *session, zbx_timespec_t *unique_shift, char **info)
 {
 	const char		*pnext = NULL;
-	int			ret = SUCCEED, processed_num = 0, total_num = 0, values_num, read_num, i, *errcodes;
+	int			ret = SUCCEED, processed_num = 0, total_num = 0, values_num, read_num, *errcodes;
 	double			sec;
 	DC_ITEM			*items;
 	char			*error = NULL;
@@ -4088,50 +5104,136 @@ static int	process_proxy_history_data_33(const DC_PROXY *proxy, struct zbx_json_
 	while (SUCCEED == parse_history_data_33(jp_data, &pnext, values, itemids, &values_num, &read_num,
 			unique_shift, &error) && 0 != values_num)
 	{
-		DCconfig_get_items_by_itemids(items, itemids, errcodes, values_num);
+		processed_num += process_proxy_history_values(proxy, session, items, errcodes, itemids, values,
+				values_num);
+		total_num += read_num;
 
-		for (i = 0; i < values_num; i++)
-		{
-			if (SUCCEED != errcodes[i])
-				continue;
+		if (NULL == pnext)
+			break;
+	}
 
-			/* check and discard if duplicate data */
-			if (NULL != session && 0 != values[i].id && values[i].id <= session->last_valueid)
-			{
-				DCconfig_clean_items(&items[i], &errcodes[i], 1);
-				errcodes[i] = FAIL;
-				continue;
-			}
+	zbx_preprocessor_flush();
+	dc_flush_history();
 
-			if (SUCCEED != proxy_item_validator(&items[i], NULL, (void *)&proxy->hostid, &error))
-			{
-				if (NULL != error)
-				{
-					zabbix_log(LOG_LEVEL_WARNING, "%s", error);
-					zbx_free(error);
-				}
+	zbx_free(errcodes);
+	zbx_free(items);
 
-				DCconfig_clean_items(&items[i], &errcodes[i], 1);
-				errcodes[i] = FAIL;
-			}
+	if (NULL == error)
+	{
+		ret = SUCCEED;
+		*info = zbx_dsprintf(*info, "processed: %d; failed: %d; total: %d; seconds spent: " ZBX_FS_DBL,
+				processed_num, total_num - processed_num, total_num, zbx_time() - sec);
+	}
+	else
+	{
+		zbx_free(*info);
+		*info = error;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: parse_history_data_bin                                           *
+ *                                                                            *
+ * Purpose: parses up to ZBX_HISTORY_VALUES_MAX item values and item          *
+ *          identifiers from binary history data                              *
+ *                                                                            *
+ * Parameters: bin        - [IN/OUT] the binary history data                  *
+ *             values     - [OUT] the item values                             *
+ *             itemids    - [OUT] the corresponding item identifiers          *
+ *             values_num - [OUT] number of elements in values and itemids    *
+ *                                arrays                                      *
+ *             error      - [OUT] the error message                           *
+ *                                                                            *
+ * Return value:  SUCCEED - values were parsed successfully                   *
+ *                FAIL    - the data is truncated or malformed                *
+ *                                                                            *
+ ******************************************************************************/
+static int	parse_history_data_bin(zbx_hist_bin_t *bin, zbx_agent_value_t *values, zbx_uint64_t *itemids,
+		int *values_num, char **error)
+{
+	for (*values_num = 0; *values_num < ZBX_HISTORY_VALUES_MAX && bin->data_offset < bin->data_size;
+			(*values_num)++)
+	{
+		if (SUCCEED != zbx_hist_bin_read_record(bin, &itemids[*values_num], &values[*values_num]))
+		{
+			zbx_agent_values_clean(&values[*values_num], 1);
+			*error = zbx_dsprintf(*error, "invalid binary history data at offset " ZBX_FS_SIZE_T,
+					(zbx_fs_size_t)bin->data_offset);
+			return FAIL;
 		}
+	}
 
-		processed_num += process_history_data(items, values, errcodes, values_num);
+	return SUCCEED;
+}
 
-		total_num += read_num;
+/******************************************************************************
+ *                                                                            *
+ * Function: process_proxy_history_data_bin                                   *
+ *                                                                            *
+ * Purpose: parses binary history data and process the data                   *
+ *                                                                            *
+ * Parameters: proxy   - [IN] the proxy                                       *
+ *             base64  - [IN] the base64 encoded binary history data          *
+ *             session - [IN] the data session                                *
+ *             info    - [OUT] address of a pointer to the info string        *
+ *                             (should be freed by the caller)                *
+ *                                                                            *
+ * Return value:  SUCCEED - processed successfully                            *
+ *                FAIL - an error occurred                                    *
+ *                                                                            *
+ * Comments: The values that were parsed before encountering malformed        *
+ *           record are processed.                                            *
+ *                                                                            *
+ ******************************************************************************/
+static int	process_proxy_history_data_bin(const DC_PROXY *proxy, const char *base64, zbx_data_session_t *session,
+		char **info)
+{
+	int			ret, processed_num = 0, total_num = 0, values_num, *errcodes;
+	double			sec;
+	DC_ITEM			*items;
+	char			*error = NULL;
+	zbx_hist_bin_t		bin;
+	zbx_uint64_t		itemids[ZBX_HISTORY_VALUES_MAX];
+	zbx_agent_value_t	values[ZBX_HISTORY_VALUES_MAX];
 
-		if (NULL != session)
-			session->last_valueid = values[values_num - 1].id;
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-		DCconfig_clean_items(items, errcodes, values_num);
-		zbx_agent_values_clean(values, values_num);
+	sec = zbx_time();
 
-		if (NULL == pnext)
-			break;
+	if (SUCCEED != zbx_hist_bin_open(&bin, base64))
+	{
+		error = zbx_strdup(NULL, "unsupported binary history data format");
+		goto out;
 	}
 
+	items = (DC_ITEM *)zbx_malloc(NULL, sizeof(DC_ITEM) * ZBX_HISTORY_VALUES_MAX);
+	errcodes = (int *)zbx_malloc(NULL, sizeof(int) * ZBX_HISTORY_VALUES_MAX);
+
+	do
+	{
+		ret = parse_history_data_bin(&bin, values, itemids, &values_num, &error);
+
+		if (0 != values_num)
+		{
+			processed_num += process_proxy_history_values(proxy, session, items, errcodes, itemids, values,
+					values_num);
+			total_num += values_num;
+		}
+	}
+	while (SUCCEED == ret && bin.data_offset < bin.data_size);
+
+	zbx_preprocessor_flush();
+	dc_flush_history();
+
 	zbx_free(errcodes);
 	zbx_free(items);
+out:
+	zbx_hist_bin_clear(&bin);
 
 	if (NULL == error)
 	{
@@ -4141,6 +5243,7 @@ static int	process_proxy_history_data_33(const DC_PROXY *proxy, struct zbx_json_
 	}
 	else
 	{
+		ret = FAIL;
 		zbx_free(*info);
 		*info = error;
 	}
@@ -4150,6 +5253,105 @@ static int	process_proxy_history_data_33(const DC_PROXY *proxy, struct zbx_json_
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_proxy_hist_bin_records                                       *
+ *                                                                            *
+ * Purpose: decodes binary history data of 'proxy data' request               *
+ *                                                                            *
+ * Parameters: jp          - [IN] JSON with proxy data                        *
+ *             records_num - [OUT] the number of decoded records              *
+ *                                                                            *
+ * Return value:  SUCCEED - the request has binary history data and all its   *
+ *                          records were decoded                              *
+ *                FAIL    - otherwise                                         *
+ *                                                                            *
+ * Comments: Server returns the number of decoded records to proxy, so that   *
+ *           proxy keeps binary history data the server did not understand.   *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_proxy_hist_bin_records(const struct zbx_json_parse *jp, int *records_num)
+{
+	char			*base64 = NULL;
+	size_t			base64_alloc = 0;
+	int			ret;
+	zbx_hist_bin_t		bin;
+	zbx_uint64_t		itemid;
+	zbx_agent_value_t	av;
+
+	if (SUCCEED != zbx_json_value_by_name_dyn(jp, ZBX_PROTO_TAG_HISTORY_BINARY, &base64, &base64_alloc))
+		return FAIL;
+
+	if (SUCCEED == (ret = zbx_hist_bin_open(&bin, base64)))
+	{
+		for (*records_num = 0; bin.data_offset < bin.data_size; (*records_num)++)
+		{
+			ret = zbx_hist_bin_read_record(&bin, &itemid, &av);
+			zbx_agent_values_clean(&av, 1);
+
+			if (SUCCEED != ret)
+				break;
+		}
+	}
+
+	zbx_hist_bin_clear(&bin);
+	zbx_free(base64);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_proxy_hist_bin_supported                                     *
+ *                                                                            *
+ * Purpose: checks if server accepts binary history data                      *
+ *                                                                            *
+ * Parameters: jp - [IN] JSON with server request or response                 *
+ *                                                                            *
+ * Return value:  SUCCEED - server advertised ZBX_PROXY_HISTORY_BINARY_FORMAT *
+ *                          support                                           *
+ *                FAIL    - otherwise                                         *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_proxy_hist_bin_supported(const struct zbx_json_parse *jp)
+{
+	char	value[MAX_ID_LEN + 1];
+
+	if (SUCCEED != zbx_json_value_by_name(jp, ZBX_PROTO_TAG_HISTORY_BINARY_FORMAT, value, sizeof(value)))
+		return FAIL;
+
+	if (ZBX_PROXY_HISTORY_BINARY_FORMAT != atoi(value))
+		return FAIL;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_proxy_hist_bin_confirmed                                     *
+ *                                                                            *
+ * Purpose: checks if server decoded the sent binary history data             *
+ *                                                                            *
+ * Parameters: jp          - [IN] JSON with server response                   *
+ *             records_num - [IN] the number of sent binary history records   *
+ *                                                                            *
+ * Return value:  SUCCEED - server confirmed decoding all sent records        *
+ *                FAIL    - otherwise                                         *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_proxy_hist_bin_confirmed(const struct zbx_json_parse *jp, int records_num)
+{
+	char	value[MAX_ID_LEN + 1];
+
+	if (SUCCEED != zbx_json_value_by_name(jp, ZBX_PROTO_TAG_HISTORY_BINARY_RECORDS, value, sizeof(value)))
+		return FAIL;
+
+	if (records_num != atoi(value))
+		return FAIL;
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: process_tasks_contents                                           *
@@ -4213,8 +5415,8 @@ int	process_proxy_data(const DC_PROXY *proxy, struct zbx_json_parse *jp, zbx_tim
 	struct zbx_json_parse	jp_data;
 	int			ret = SUCCEED;
 	zbx_timespec_t		unique_shift = {0, 0};
-	char			*error_step = NULL;
-	size_t			error_alloc = 0, error_offset = 0;
+	char			*error_step = NULL, *history_bin = NULL;
+	size_t			error_alloc = 0, error_offset = 0, history_bin_alloc = 0;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -4226,7 +5428,9 @@ int	process_proxy_data(const DC_PROXY *proxy, struct zbx_json_parse *jp, zbx_tim
 			zbx_strcatnl_alloc(error, &error_alloc, &error_offset, error_step);
 	}
 
-	if (SUCCEED == zbx_json_brackets_by_name(jp, ZBX_PROTO_TAG_HISTORY_DATA, &jp_data))
+	if (SUCCEED == zbx_json_brackets_by_name(jp, ZBX_PROTO_TAG_HISTORY_DATA, &jp_data) ||
+			SUCCEED == zbx_json_value_by_name_dyn(jp, ZBX_PROTO_TAG_HISTORY_BINARY, &history_bin,
+			&history_bin_alloc))
 	{
 		char			*token = NULL;
 		size_t			token_alloc = 0;
@@ -4248,11 +5452,13 @@ int	process_proxy_data(const DC_PROXY *proxy, struct zbx_json_parse *jp, zbx_tim
 			zbx_free(token);
 		}
 
-		if (SUCCEED != (ret = process_proxy_history_data_33(proxy, &jp_data, session, &unique_shift,
-				&error_step)))
-		{
+		if (NULL != history_bin)
+			ret = process_proxy_history_data_bin(proxy, history_bin, session, &error_step);
+		else
+			ret = process_proxy_history_data_33(proxy, &jp_data, session, &unique_shift, &error_step);
+
+		if (SUCCEED != ret)
 			zbx_strcatnl_alloc(error, &error_alloc, &error_offset, error_step);
-		}
 	}
 
 	if (SUCCEED == zbx_json_brackets_by_name(jp, ZBX_PROTO_TAG_DISCOVERY_DATA, &jp_data))
@@ -4271,6 +5477,7 @@ int	process_proxy_data(const DC_PROXY *proxy, struct zbx_json_parse *jp, zbx_tim
 		process_tasks_contents(&jp_data);
 
 out:
+	zbx_free(history_bin);
 	zbx_free(error_step);
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
@@ -4459,3 +5666,7 @@ int	zbx_check_protocol_version(DC_PROXY *proxy)
 out:
 	return ret;
 }
+
+#ifdef HAVE_TESTS
+#	include "../../../tests/libs/zbxdbhigh/proxy_test.c"
+#endif
@@ -17,8 +17,12 @@
 ** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 **/
 
-#include "zbxself.h"
 #include "common.h"
+#include "zbxself.h"
+
+#if defined(HAVE_POLARSSL) || defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
+#	include "../zbxcrypto/tls.h"
+#endif
 
 #ifndef _WINDOWS
 #	include "mutexs.h"
@@ -60,6 +64,15 @@ typedef struct
 
 	/* the process state cache */
 	zxb_stat_process_cache_t	cache;
+
+	/* TLS handshakes done by the process since start, updated on cache flush */
+	zbx_uint64_t			tls_handshakes;
+	zbx_uint64_t			tls_resumed;
+
+	/* SSH checks done by the process since start and its open SSH sessions, updated on cache flush */
+	zbx_uint64_t			ssh_requests;
+	zbx_uint64_t			ssh_reused;
+	zbx_uint64_t			ssh_sessions;
 }
 zbx_stat_process_t;
 
@@ -314,6 +327,29 @@ void	free_selfmon_collector(void)
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/* SSH session pool statistics of the current process, see update_selfmon_ssh_stats() */
+static zbx_uint64_t	ssh_requests, ssh_reused, ssh_sessions;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: update_selfmon_ssh_stats                                         *
+ *                                                                            *
+ * Purpose: set SSH session pool statistics of the current process, they are  *
+ *          published with the next self monitoring cache flush               *
+ *                                                                            *
+ * Parameters: requests - [IN] number of SSH checks                           *
+ *             reused   - [IN] number of SSH checks done over an already      *
+ *                             authenticated session                          *
+ *             sessions - [IN] number of open SSH sessions                    *
+ *                                                                            *
+ ******************************************************************************/
+void	update_selfmon_ssh_stats(zbx_uint64_t requests, zbx_uint64_t reused, int sessions)
+{
+	ssh_requests = requests;
+	ssh_reused = reused;
+	ssh_sessions = (zbx_uint64_t)sessions;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: update_selfmon_counter                                           *
@@ -329,6 +365,9 @@ void	update_selfmon_counter(unsigned char state)
 	clock_t			ticks;
 	struct tms		buf;
 	int			i;
+#if defined(HAVE_POLARSSL) || defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
+	zbx_tls_stats_t		tls_stats;
+#endif
 
 	if (ZBX_PROCESS_TYPE_UNKNOWN == process_type)
 		return;
@@ -341,6 +380,9 @@ void	update_selfmon_counter(unsigned char state)
 
 	if (ZBX_SELFMON_FLUSH_DELAY < (double)(ticks - process->cache.ticks_flush) / collector->ticks_per_sec)
 	{
+#if defined(HAVE_POLARSSL) || defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
+		zbx_tls_get_stats(&tls_stats);
+#endif
 		LOCK_SM;
 
 		for (i = 0; i < ZBX_PROCESS_STATE_COUNT; i++)
@@ -362,7 +404,13 @@ void	update_selfmon_counter(unsigned char state)
 		}
 
 		process->cache.ticks_flush = ticks;
-
+#if defined(HAVE_POLARSSL) || defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
+		process->tls_handshakes = tls_stats.handshakes;
+		process->tls_resumed = tls_stats.resumed;
+#endif
+		process->ssh_requests = ssh_requests;
+		process->ssh_reused = ssh_reused;
+		process->ssh_sessions = ssh_sessions;
 		UNLOCK_SM;
 	}
 
@@ -634,6 +682,79 @@ unlock:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: get_selfmon_tls_stats                                            *
+ *                                                                            *
+ * Purpose: get number of TLS handshakes done by all processes                *
+ *                                                                            *
+ * Parameters: handshakes - [OUT] number of successful TLS handshakes         *
+ *             resumed    - [OUT] number of handshakes which resumed a        *
+ *                                previous session                            *
+ *                                                                            *
+ ******************************************************************************/
+void	get_selfmon_tls_stats(zbx_uint64_t *handshakes, zbx_uint64_t *resumed)
+{
+	unsigned char	proc_type;
+	int		proc_num, process_forks;
+
+	*handshakes = 0;
+	*resumed = 0;
+
+	LOCK_SM;
+
+	for (proc_type = 0; proc_type < ZBX_PROCESS_TYPE_COUNT; proc_type++)
+	{
+		process_forks = get_process_type_forks(proc_type);
+
+		for (proc_num = 0; proc_num < process_forks; proc_num++)
+		{
+			*handshakes += collector->process[proc_type][proc_num].tls_handshakes;
+			*resumed += collector->process[proc_type][proc_num].tls_resumed;
+		}
+	}
+
+	UNLOCK_SM;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: get_selfmon_ssh_stats                                            *
+ *                                                                            *
+ * Purpose: get SSH session pool statistics of all processes                  *
+ *                                                                            *
+ * Parameters: requests - [OUT] number of SSH checks                          *
+ *             reused   - [OUT] number of SSH checks done over an already     *
+ *                              authenticated session                         *
+ *             sessions - [OUT] number of open SSH sessions                   *
+ *                                                                            *
+ ******************************************************************************/
+void	get_selfmon_ssh_stats(zbx_uint64_t *requests, zbx_uint64_t *reused, zbx_uint64_t *sessions)
+{
+	unsigned char	proc_type;
+	int		proc_num, process_forks;
+
+	*requests = 0;
+	*reused = 0;
+	*sessions = 0;
+
+	LOCK_SM;
+
+	for (proc_type = 0; proc_type < ZBX_PROCESS_TYPE_COUNT; proc_type++)
+	{
+		process_forks = get_process_type_forks(proc_type);
+
+		for (proc_num = 0; proc_num < process_forks; proc_num++)
+		{
+			*requests += collector->process[proc_type][proc_num].ssh_requests;
+			*reused += collector->process[proc_type][proc_num].ssh_reused;
+			*sessions += collector->process[proc_type][proc_num].ssh_sessions;
+		}
+	}
+
+	UNLOCK_SM;
+}
+
 static int	sleep_remains;
 
 /******************************************************************************
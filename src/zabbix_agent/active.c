@@ -51,6 +51,9 @@ ZBX_THREAD_LOCAL static zbx_vector_ptr_t	active_metrics;
 ZBX_THREAD_LOCAL static zbx_vector_ptr_t	regexps;
 ZBX_THREAD_LOCAL static char			*session_token;
 ZBX_THREAD_LOCAL static zbx_uint64_t		last_valueid = 0;
+ZBX_THREAD_LOCAL static char			*config_revision;	/* revision of the received list */
+ZBX_THREAD_LOCAL static zbx_socket_t		server_conn;	/* connection kept open between requests */
+ZBX_THREAD_LOCAL static int			server_conn_open = 0;
 
 #ifdef _WINDOWS
 LONG WINAPI	DelayLoadDllExceptionFilter(PEXCEPTION_POINTERS excpointers)
@@ -361,15 +364,43 @@ static int	parse_list_of_checks(char *str, const char *host, unsigned short port
 		else
 			zabbix_log(LOG_LEVEL_WARNING, "no active checks on server");
 
+		zbx_free(config_revision);
 		goto out;
 	}
 
 	if (SUCCEED != zbx_json_brackets_by_name(&jp, ZBX_PROTO_TAG_DATA, &jp_data))
 	{
+		/* server sends only the revision if the list did not change since the last refresh */
+		if (NULL != config_revision &&
+				SUCCEED == zbx_json_value_by_name(&jp, ZBX_PROTO_TAG_CONFIG_REVISION, tmp, sizeof(tmp)) &&
+				0 == strcmp(tmp, config_revision))
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "list of active checks was not modified");
+
+			for (i = 0; i < active_metrics.values_num; i++)
+			{
+				metric = (ZBX_ACTIVE_METRIC *)active_metrics.values[i];
+
+				/* receiving the list is a signal to refresh unsupported items, see add_check() */
+				if (ITEM_STATE_NOTSUPPORTED == metric->state)
+				{
+					metric->refresh_unsupported = 1;
+					metric->start_time = 0.0;
+					metric->processed_bytes = 0;
+				}
+			}
+
+			ret = SUCCEED;
+			goto out;
+		}
+
 		zabbix_log(LOG_LEVEL_ERR, "cannot parse list of active checks: %s", zbx_json_strerror());
 		goto out;
 	}
 
+	/* forget the revision until the new list is fully processed */
+	zbx_free(config_revision);
+
  	p = NULL;
 	while (NULL != (p = zbx_json_next(&jp_data, p)))
 	{
@@ -514,6 +545,9 @@ static int	parse_list_of_checks(char *str, const char *host, unsigned short port
 		}
 	}
 
+	if (SUCCEED == zbx_json_value_by_name(&jp, ZBX_PROTO_TAG_CONFIG_REVISION, tmp, sizeof(tmp)))
+		config_revision = zbx_strdup(NULL, tmp);
+
 	ret = SUCCEED;
 out:
 	zbx_vector_str_clear_ext(&received_metrics, zbx_str_free);
@@ -524,6 +558,133 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: server_conn_close                                                *
+ *                                                                            *
+ ******************************************************************************/
+static void	server_conn_close(void)
+{
+	if (0 == server_conn_open)
+		return;
+
+	zbx_tcp_close(&server_conn);
+	server_conn_open = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: server_conn_is_alive                                             *
+ *                                                                            *
+ * Purpose: check if kept open connection was not closed by server            *
+ *                                                                            *
+ * Comments: There are no outstanding requests on a kept open connection, so  *
+ *           any readable data means that it was closed or is out of sync.    *
+ *                                                                            *
+ ******************************************************************************/
+static int	server_conn_is_alive(void)
+{
+	fd_set		fdr;
+	struct timeval	tv = {0, 0};
+
+	FD_ZERO(&fdr);
+	FD_SET(server_conn.socket, &fdr);
+
+	if (0 != select(ZBX_SOCKET_TO_INT(server_conn.socket) + 1, &fdr, NULL, NULL, &tv))
+		return FAIL;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: server_conn_exchange                                             *
+ *                                                                            *
+ * Purpose: send request to server and receive response, reusing connection  *
+ *          of the previous request when server kept it open                  *
+ *                                                                            *
+ * Parameters: host     - [IN] IP or Hostname of Zabbix server                *
+ *             port     - [IN] port number                                    *
+ *             timeout  - [IN] the connection timeout                         *
+ *             request  - [IN] the request                                    *
+ *             err_step - [OUT] the failed step for error message             *
+ *                                                                            *
+ * Return value: SUCCEED - the response is stored in server_conn buffer       *
+ *               FAIL    - an error occurred                                  *
+ *                                                                            *
+ * Comments: Requests ask server to keep connection open. Servers that do not *
+ *           support it close the connection after response and a new one is  *
+ *           opened for the next request.                                     *
+ *           A request that failed over reused connection is resent once over *
+ *           a new connection, as server could have closed the idle           *
+ *           connection at the same time.                                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	server_conn_exchange(const char *host, unsigned short port, int timeout, const char *request,
+		const char **err_step)
+{
+	int	ret, reused;
+	char	*tls_arg1, *tls_arg2;
+
+	if (0 != server_conn_open && SUCCEED != server_conn_is_alive())
+		server_conn_close();
+
+	switch (configured_tls_connect_mode)
+	{
+		case ZBX_TCP_SEC_UNENCRYPTED:
+			tls_arg1 = NULL;
+			tls_arg2 = NULL;
+			break;
+#if defined(HAVE_POLARSSL) || defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
+		case ZBX_TCP_SEC_TLS_CERT:
+			tls_arg1 = CONFIG_TLS_SERVER_CERT_ISSUER;
+			tls_arg2 = CONFIG_TLS_SERVER_CERT_SUBJECT;
+			break;
+		case ZBX_TCP_SEC_TLS_PSK:
+			tls_arg1 = CONFIG_TLS_PSK_IDENTITY;
+			tls_arg2 = NULL;	/* zbx_tls_connect() will find PSK */
+			break;
+#endif
+		default:
+			THIS_SHOULD_NEVER_HAPPEN;
+			*err_step = "[connect] ";
+			return FAIL;
+	}
+
+	do
+	{
+		if (0 == (reused = server_conn_open))
+		{
+			if (SUCCEED != zbx_tcp_connect(&server_conn, CONFIG_SOURCE_IP, host, port, timeout,
+					configured_tls_connect_mode, tls_arg1, tls_arg2))
+			{
+				*err_step = "[connect] ";
+				return FAIL;
+			}
+
+			server_conn_open = 1;
+		}
+
+		/* use explicit timeouts so that no alarm is left pending while connection is kept open */
+		if (SUCCEED == (ret = zbx_tcp_send_to(&server_conn, request, timeout)))
+		{
+			if (SUCCEED != (ret = zbx_tcp_recv_to(&server_conn, timeout)) || 0 == server_conn.read_bytes)
+			{
+				ret = FAIL;
+				*err_step = "[recv] ";
+			}
+		}
+		else
+			*err_step = "[send] ";
+
+		if (SUCCEED != ret)
+			server_conn_close();
+	}
+	while (SUCCEED != ret && 0 != reused);
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: refresh_active_checks                                            *
@@ -545,8 +706,7 @@ static int	refresh_active_checks(const char *host, unsigned short port)
 {
 	ZBX_THREAD_LOCAL static int	last_ret = SUCCEED;
 	int				ret;
-	char				*tls_arg1, *tls_arg2;
-	zbx_socket_t			s;
+	const char			*err_step = "";
 	struct zbx_json			json;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() host:'%s' port:%hu", __func__, host, port);
@@ -555,6 +715,10 @@ static int	refresh_active_checks(const char *host, unsigned short port)
 
 	zbx_json_addstring(&json, ZBX_PROTO_TAG_REQUEST, ZBX_PROTO_VALUE_GET_ACTIVE_CHECKS, ZBX_JSON_TYPE_STRING);
 	zbx_json_addstring(&json, ZBX_PROTO_TAG_HOST, CONFIG_HOSTNAME, ZBX_JSON_TYPE_STRING);
+	zbx_json_adduint64(&json, ZBX_PROTO_TAG_KEEPALIVE, 1);
+
+	if (NULL != config_revision)
+		zbx_json_addstring(&json, ZBX_PROTO_TAG_CONFIG_REVISION, config_revision, ZBX_JSON_TYPE_STRING);
 
 	if (NULL != CONFIG_HOST_METADATA)
 	{
@@ -616,58 +780,25 @@ static int	refresh_active_checks(const char *host, unsigned short port)
 	if (ZBX_DEFAULT_AGENT_PORT != CONFIG_LISTEN_PORT)
 		zbx_json_adduint64(&json, ZBX_PROTO_TAG_PORT, CONFIG_LISTEN_PORT);
 
-	switch (configured_tls_connect_mode)
-	{
-		case ZBX_TCP_SEC_UNENCRYPTED:
-			tls_arg1 = NULL;
-			tls_arg2 = NULL;
-			break;
-#if defined(HAVE_POLARSSL) || defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
-		case ZBX_TCP_SEC_TLS_CERT:
-			tls_arg1 = CONFIG_TLS_SERVER_CERT_ISSUER;
-			tls_arg2 = CONFIG_TLS_SERVER_CERT_SUBJECT;
-			break;
-		case ZBX_TCP_SEC_TLS_PSK:
-			tls_arg1 = CONFIG_TLS_PSK_IDENTITY;
-			tls_arg2 = NULL;	/* zbx_tls_connect() will find PSK */
-			break;
-#endif
-		default:
-			THIS_SHOULD_NEVER_HAPPEN;
-			ret = FAIL;
-			goto out;
-	}
+	zabbix_log(LOG_LEVEL_DEBUG, "sending [%s]", json.buffer);
 
-	if (SUCCEED == (ret = zbx_tcp_connect(&s, CONFIG_SOURCE_IP, host, port, CONFIG_TIMEOUT,
-			configured_tls_connect_mode, tls_arg1, tls_arg2)))
+	if (SUCCEED == (ret = server_conn_exchange(host, port, CONFIG_TIMEOUT, json.buffer, &err_step)))
 	{
-		zabbix_log(LOG_LEVEL_DEBUG, "sending [%s]", json.buffer);
+		zabbix_log(LOG_LEVEL_DEBUG, "got [%s]", server_conn.buffer);
 
-		if (SUCCEED == (ret = zbx_tcp_send(&s, json.buffer)))
+		if (SUCCEED != last_ret)
 		{
-			zabbix_log(LOG_LEVEL_DEBUG, "before read");
-
-			if (SUCCEED == (ret = zbx_tcp_recv(&s)))
-			{
-				zabbix_log(LOG_LEVEL_DEBUG, "got [%s]", s.buffer);
-
-				if (SUCCEED != last_ret)
-				{
-					zabbix_log(LOG_LEVEL_WARNING, "active check configuration update from [%s:%hu]"
-							" is working again", host, port);
-				}
-				parse_list_of_checks(s.buffer, host, port);
-			}
+			zabbix_log(LOG_LEVEL_WARNING, "active check configuration update from [%s:%hu]"
+					" is working again", host, port);
 		}
-
-		zbx_tcp_close(&s);
+		parse_list_of_checks(server_conn.buffer, host, port);
 	}
-out:
+
 	if (SUCCEED != ret && SUCCEED == last_ret)
 	{
 		zabbix_log(LOG_LEVEL_WARNING,
-				"active check configuration update from [%s:%hu] started to fail (%s)",
-				host, port, zbx_socket_strerror());
+				"active check configuration update from [%s:%hu] started to fail (%s%s)",
+				host, port, err_step, zbx_socket_strerror());
 	}
 
 	last_ret = ret;
@@ -739,10 +870,8 @@ static int	send_buffer(const char *host, unsigned short port)
 {
 	ZBX_ACTIVE_BUFFER_ELEMENT	*el;
 	int				ret = SUCCEED, i, now;
-	char				*tls_arg1, *tls_arg2;
 	zbx_timespec_t			ts;
 	const char			*err_send_step = "";
-	zbx_socket_t			s;
 	struct zbx_json 		json;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() host:'%s' port:%d entries:%d/%d",
@@ -764,6 +893,7 @@ static int	send_buffer(const char *host, unsigned short port)
 	zbx_json_init(&json, ZBX_JSON_STAT_BUF_LEN);
 	zbx_json_addstring(&json, ZBX_PROTO_TAG_REQUEST, ZBX_PROTO_VALUE_AGENT_DATA, ZBX_JSON_TYPE_STRING);
 	zbx_json_addstring(&json, ZBX_PROTO_TAG_SESSION, session_token, ZBX_JSON_TYPE_STRING);
+	zbx_json_adduint64(&json, ZBX_PROTO_TAG_KEEPALIVE, 1);
 	zbx_json_addarray(&json, ZBX_PROTO_TAG_DATA);
 
 	for (i = 0; i < buffer.count; i++)
@@ -811,62 +941,26 @@ static int	send_buffer(const char *host, unsigned short port)
 
 	zbx_json_close(&json);
 
-	switch (configured_tls_connect_mode)
-	{
-		case ZBX_TCP_SEC_UNENCRYPTED:
-			tls_arg1 = NULL;
-			tls_arg2 = NULL;
-			break;
-#if defined(HAVE_POLARSSL) || defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
-		case ZBX_TCP_SEC_TLS_CERT:
-			tls_arg1 = CONFIG_TLS_SERVER_CERT_ISSUER;
-			tls_arg2 = CONFIG_TLS_SERVER_CERT_SUBJECT;
-			break;
-		case ZBX_TCP_SEC_TLS_PSK:
-			tls_arg1 = CONFIG_TLS_PSK_IDENTITY;
-			tls_arg2 = NULL;	/* zbx_tls_connect() will find PSK */
-			break;
-#endif
-		default:
-			THIS_SHOULD_NEVER_HAPPEN;
-			ret = FAIL;
-			goto out;
-	}
+	zbx_timespec(&ts);
+	zbx_json_adduint64(&json, ZBX_PROTO_TAG_CLOCK, ts.sec);
+	zbx_json_adduint64(&json, ZBX_PROTO_TAG_NS, ts.ns);
 
-	if (SUCCEED == (ret = zbx_tcp_connect(&s, CONFIG_SOURCE_IP, host, port, MIN(buffer.count * CONFIG_TIMEOUT, 60),
-			configured_tls_connect_mode, tls_arg1, tls_arg2)))
-	{
-		zbx_timespec(&ts);
-		zbx_json_adduint64(&json, ZBX_PROTO_TAG_CLOCK, ts.sec);
-		zbx_json_adduint64(&json, ZBX_PROTO_TAG_NS, ts.ns);
+	zabbix_log(LOG_LEVEL_DEBUG, "JSON before sending [%s]", json.buffer);
 
-		zabbix_log(LOG_LEVEL_DEBUG, "JSON before sending [%s]", json.buffer);
+	if (SUCCEED == (ret = server_conn_exchange(host, port, MIN(buffer.count * CONFIG_TIMEOUT, 60), json.buffer,
+			&err_send_step)))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "JSON back [%s]", server_conn.buffer);
 
-		if (SUCCEED == (ret = zbx_tcp_send(&s, json.buffer)))
+		if (SUCCEED != check_response(server_conn.buffer))
 		{
-			if (SUCCEED == (ret = zbx_tcp_recv(&s)))
-			{
-				zabbix_log(LOG_LEVEL_DEBUG, "JSON back [%s]", s.buffer);
-
-				if (NULL == s.buffer || SUCCEED != check_response(s.buffer))
-				{
-					ret = FAIL;
-					zabbix_log(LOG_LEVEL_DEBUG, "NOT OK");
-				}
-				else
-					zabbix_log(LOG_LEVEL_DEBUG, "OK");
-			}
-			else
-				err_send_step = "[recv] ";
+			ret = FAIL;
+			zabbix_log(LOG_LEVEL_DEBUG, "NOT OK");
 		}
 		else
-			err_send_step = "[send] ";
-
-		zbx_tcp_close(&s);
+			zabbix_log(LOG_LEVEL_DEBUG, "OK");
 	}
-	else
-		err_send_step = "[connect] ";
-out:
+
 	zbx_json_free(&json);
 
 	if (SUCCEED == ret)
@@ -1823,6 +1917,8 @@ ZBX_THREAD_ENTRY(active_checks_thread, args)
 	}
 
 	zbx_free(session_token);
+	zbx_free(config_revision);
+	server_conn_close();
 
 #ifdef _WINDOWS
 	zbx_free(activechk_args.host);
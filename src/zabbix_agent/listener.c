@@ -26,6 +26,7 @@
 #include "stats.h"
 #include "sysinfo.h"
 #include "log.h"
+#include "zbxjson.h"
 
 extern unsigned char			program_type;
 extern ZBX_THREAD_LOCAL unsigned char	process_type;
@@ -40,16 +41,119 @@ extern ZBX_THREAD_LOCAL int		server_num, process_num;
 #include "../libs/zbxcrypto/tls.h"
 #include "../libs/zbxcrypto/tls_tcp_active.h"
 
+/******************************************************************************
+ *                                                                            *
+ * Function: process_passive_checks                                           *
+ *                                                                            *
+ * Purpose: process multiple item keys requested over a single connection     *
+ *                                                                            *
+ * Parameters: s  - [IN] the connection socket                                *
+ *             jp - [IN] the request                                          *
+ *                                                                            *
+ * Return value: SUCCEED - the response was sent                              *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The request format is:                                           *
+ *             {"request":"passive checks","timeout":<seconds>,               *
+ *              "data":[{"key":"<key>"},...]}                                 *
+ *           and the response format is:                                      *
+ *             {"response":"success",                                         *
+ *              "data":[{"value":"<value>"},{"error":"<error>"},{},...]}      *
+ *           where the empty object stands for a key without value, which     *
+ *           is an empty reply for a single key request.                      *
+ *           Values are returned in the order of requested keys. Keys are not *
+ *           processed after half of the requested timeout has passed, the    *
+ *           requester must retrieve the remaining keys separately.           *
+ *                                                                            *
+ ******************************************************************************/
+static int	process_passive_checks(zbx_socket_t *s, const struct zbx_json_parse *jp)
+{
+	struct zbx_json_parse	jp_data, jp_row;
+	struct zbx_json		j;
+	const char		*p = NULL;
+	char			*key = NULL, **value, tmp[MAX_STRING_LEN];
+	size_t			key_alloc = 0;
+	int			ret, timeout = CONFIG_TIMEOUT, keys_num = 0;
+	double			deadline;
+	AGENT_RESULT		result;
+
+	if (SUCCEED != zbx_json_brackets_by_name(jp, ZBX_PROTO_TAG_DATA, &jp_data))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot parse passive checks request: %s", zbx_json_strerror());
+		return zbx_tcp_send_to(s, ZBX_NOTSUPPORTED, CONFIG_TIMEOUT);
+	}
+
+	if (SUCCEED == zbx_json_value_by_name(jp, ZBX_PROTO_TAG_TIMEOUT, tmp, sizeof(tmp)) && 0 < atoi(tmp))
+		timeout = MIN(atoi(tmp), CONFIG_TIMEOUT);
+
+	deadline = zbx_time() + timeout / 2.0;
+
+	zbx_json_init(&j, ZBX_JSON_STAT_BUF_LEN);
+	zbx_json_addstring(&j, ZBX_PROTO_TAG_RESPONSE, ZBX_PROTO_VALUE_SUCCESS, ZBX_JSON_TYPE_STRING);
+	zbx_json_addarray(&j, ZBX_PROTO_TAG_DATA);
+
+	while (NULL != (p = zbx_json_next(&jp_data, p)) && zbx_time() < deadline)
+	{
+		if (SUCCEED != zbx_json_brackets_open(p, &jp_row) ||
+				SUCCEED != zbx_json_value_by_name_dyn(&jp_row, ZBX_PROTO_TAG_KEY, &key, &key_alloc))
+		{
+			break;
+		}
+
+		zabbix_log(LOG_LEVEL_DEBUG, "Requested [%s]", key);
+
+		init_result(&result);
+		zbx_json_addobject(&j, NULL);
+
+		/* the value without text result is left out as it is not sent for a single key either */
+		if (SUCCEED == process(key, PROCESS_WITH_ALIAS, &result))
+		{
+			if (NULL != (value = GET_TEXT_RESULT(&result)))
+				zbx_json_addstring(&j, ZBX_PROTO_TAG_VALUE, *value, ZBX_JSON_TYPE_STRING);
+		}
+		else
+		{
+			value = GET_MSG_RESULT(&result);
+			zbx_json_addstring(&j, ZBX_PROTO_TAG_ERROR, NULL != value ? *value : "", ZBX_JSON_TYPE_STRING);
+		}
+
+		zbx_json_close(&j);
+		free_result(&result);
+		keys_num++;
+	}
+
+	zbx_json_close(&j);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "Sending back values of %d keys", keys_num);
+
+	ret = zbx_tcp_send_to(s, j.buffer, CONFIG_TIMEOUT);
+
+	zbx_json_free(&j);
+	zbx_free(key);
+
+	return ret;
+}
+
 static void	process_listener(zbx_socket_t *s)
 {
-	AGENT_RESULT	result;
-	char		**value = NULL;
-	int		ret;
+	AGENT_RESULT		result;
+	struct zbx_json_parse	jp;
+	char			**value = NULL, request[MAX_STRING_LEN];
+	int			ret;
 
 	if (SUCCEED == (ret = zbx_tcp_recv_to(s, CONFIG_TIMEOUT)))
 	{
 		zbx_rtrim(s->buffer, "\r\n");
 
+		/* item keys cannot start with '{', so a JSON object can only be a multi-key request */
+		if ('{' == *s->buffer && SUCCEED == zbx_json_open(s->buffer, &jp) &&
+				SUCCEED == zbx_json_value_by_name(&jp, ZBX_PROTO_TAG_REQUEST, request, sizeof(request)) &&
+				0 == strcmp(request, ZBX_PROTO_VALUE_PASSIVE_CHECKS))
+		{
+			ret = process_passive_checks(s, &jp);
+			goto out;
+		}
+
 		zabbix_log(LOG_LEVEL_DEBUG, "Requested [%s]", s->buffer);
 
 		init_result(&result);
@@ -94,7 +198,7 @@ static void	process_listener(zbx_socket_t *s)
 
 		free_result(&result);
 	}
-
+out:
 	if (FAIL == ret)
 		zabbix_log(LOG_LEVEL_DEBUG, "Process listener error: %s", zbx_socket_strerror());
 }
@@ -76,6 +76,8 @@ char	*CONFIG_TLS_CERT_FILE		= NULL;
 char	*CONFIG_TLS_KEY_FILE		= NULL;
 char	*CONFIG_TLS_PSK_IDENTITY	= NULL;
 char	*CONFIG_TLS_PSK_FILE		= NULL;
+int	CONFIG_TLS_SESSION_CACHE_SIZE	= 1000;
+int	CONFIG_TLS_SESSION_LIFETIME	= SEC_PER_HOUR;
 
 #ifndef _WINDOWS
 #	include "../libs/zbxnix/control.h"
@@ -787,6 +789,10 @@ static void	zbx_load_config(int requirement, ZBX_TASK_EX *task)
 			PARM_OPT,	0,			0},
 		{"TLSPSKFile",			&CONFIG_TLS_PSK_FILE,			TYPE_STRING,
 			PARM_OPT,	0,			0},
+		{"TLSSessionCacheSize",		&CONFIG_TLS_SESSION_CACHE_SIZE,		TYPE_INT,
+			PARM_OPT,	0,			100000},
+		{"TLSSessionLifetime",		&CONFIG_TLS_SESSION_LIFETIME,		TYPE_INT,
+			PARM_OPT,	0,			SEC_PER_DAY},
 		{NULL}
 	};
 
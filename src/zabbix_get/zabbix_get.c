@@ -132,6 +132,8 @@ char	*CONFIG_TLS_CERT_FILE		= NULL;
 char	*CONFIG_TLS_KEY_FILE		= NULL;
 char	*CONFIG_TLS_PSK_IDENTITY	= NULL;
 char	*CONFIG_TLS_PSK_FILE		= NULL;
+int	CONFIG_TLS_SESSION_CACHE_SIZE	= 0;	/* not used in zabbix_get, just for linking with tls.c */
+int	CONFIG_TLS_SESSION_LIFETIME	= 0;	/* not used in zabbix_get, just for linking with tls.c */
 
 int	CONFIG_PASSIVE_FORKS		= 0;	/* not used in zabbix_get, just for linking with tls.c */
 int	CONFIG_ACTIVE_FORKS		= 0;	/* not used in zabbix_get, just for linking with tls.c */
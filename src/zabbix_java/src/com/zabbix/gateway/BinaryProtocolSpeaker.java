@@ -47,13 +47,24 @@ class BinaryProtocolSpeaker
 
 	String getRequest() throws IOException, ZabbixException
 	{
-		dis = new DataInputStream(socket.getInputStream());
+		if (null == dis)
+			dis = new DataInputStream(socket.getInputStream());
 
 		byte[] data;
 
 		logger.debug("reading Zabbix protocol header");
 		data = new byte[5];
-		dis.readFully(data);
+
+		int first = dis.read();
+
+		if (-1 == first)
+		{
+			logger.debug("connection closed by peer");
+			return null;
+		}
+
+		data[0] = (byte)first;
+		dis.readFully(data, 1, data.length - 1);
 
 		if (!Arrays.equals(data, PROTOCOL_HEADER))
 			throw new ZabbixException("bad protocol header: %02X %02X %02X %02X %02X", data[0], data[1], data[2], data[3], data[4]);
@@ -80,7 +91,8 @@ class BinaryProtocolSpeaker
 
 	void sendResponse(String response) throws IOException, ZabbixException
 	{
-		bos = new BufferedOutputStream(socket.getOutputStream());
+		if (null == bos)
+			bos = new BufferedOutputStream(socket.getOutputStream());
 
 		logger.debug("sending the following data in response: {}", response);
 
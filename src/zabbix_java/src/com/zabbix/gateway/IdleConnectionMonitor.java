@@ -0,0 +1,142 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2019 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+package com.zabbix.gateway;
+
+import java.nio.channels.SelectionKey;
+import java.nio.channels.Selector;
+import java.nio.channels.SocketChannel;
+import java.util.ArrayList;
+import java.util.List;
+import java.util.concurrent.ConcurrentLinkedQueue;
+import java.util.concurrent.ExecutorService;
+
+import org.slf4j.Logger;
+import org.slf4j.LoggerFactory;
+
+// Watches connections between requests, so that an idle persistent connection does not hold a poller thread.
+// A connection is passed back to the thread pool when its next request arrives and is closed when it has been
+// idle for the gateway timeout.
+class IdleConnectionMonitor extends Thread
+{
+	private static final Logger logger = LoggerFactory.getLogger(IdleConnectionMonitor.class);
+
+	private Selector selector;
+	private ExecutorService threadPool;
+	private ConcurrentLinkedQueue<SocketChannel> pending = new ConcurrentLinkedQueue<SocketChannel>();
+
+	IdleConnectionMonitor(ExecutorService threadPool) throws java.io.IOException
+	{
+		super("idle connection monitor");
+		setDaemon(true);
+
+		this.selector = Selector.open();
+		this.threadPool = threadPool;
+	}
+
+	void register(SocketChannel channel)
+	{
+		pending.add(channel);
+		selector.wakeup();
+	}
+
+	@Override
+	public void run()
+	{
+		long timeout = ConfigurationManager.getIntegerParameterValue(ConfigurationManager.TIMEOUT) * 1000L;
+		List<SocketChannel> ready = new ArrayList<SocketChannel>();
+
+		while (true)
+		{
+			try
+			{
+				selector.select(1000);
+
+				long now = System.currentTimeMillis();
+				SocketChannel channel;
+
+				while (null != (channel = pending.poll()))
+				{
+					try
+					{
+						channel.configureBlocking(false);
+						channel.register(selector, SelectionKey.OP_READ, Long.valueOf(now));
+					}
+					catch (Exception e)
+					{
+						logger.debug("cannot watch idle connection: {}", ZabbixException.getRootCauseMessage(e));
+						close(channel);
+					}
+				}
+
+				for (SelectionKey key : selector.selectedKeys())
+				{
+					key.cancel();
+					ready.add((SocketChannel)key.channel());
+				}
+
+				selector.selectedKeys().clear();
+
+				for (SelectionKey key : selector.keys())
+				{
+					if (key.isValid() && now - (Long)key.attachment() >= timeout)
+					{
+						logger.debug("closing idle connection");
+						key.cancel();
+						close((SocketChannel)key.channel());
+					}
+				}
+
+				if (ready.isEmpty())
+					continue;
+
+				// a channel can be switched back to blocking mode only after its cancelled key is deregistered
+				selector.selectNow();
+				selector.selectedKeys().clear();
+
+				for (SocketChannel readyChannel : ready)
+				{
+					try
+					{
+						readyChannel.configureBlocking(true);
+						threadPool.execute(new SocketProcessor(readyChannel, this));
+					}
+					catch (Exception e)
+					{
+						logger.warn("cannot process connection: {}", ZabbixException.getRootCauseMessage(e));
+						logger.debug("error caused by", e);
+						close(readyChannel);
+					}
+				}
+
+				ready.clear();
+			}
+			catch (Exception e)
+			{
+				logger.warn("error watching idle connections: {}", ZabbixException.getRootCauseMessage(e));
+				logger.debug("error caused by", e);
+			}
+		}
+	}
+
+	private static void close(SocketChannel channel)
+	{
+		try { channel.close(); } catch (Exception e) { }
+	}
+}
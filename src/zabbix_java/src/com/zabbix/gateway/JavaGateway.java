@@ -20,7 +20,10 @@
 package com.zabbix.gateway;
 
 import java.net.InetAddress;
+import java.net.InetSocketAddress;
 import java.net.ServerSocket;
+import java.nio.channels.ServerSocketChannel;
+import java.nio.channels.SocketChannel;
 import java.util.concurrent.*;
 
 import org.slf4j.Logger;
@@ -63,21 +66,60 @@ public class JavaGateway
 			InetAddress listenIP = (InetAddress)ConfigurationManager.getParameter(ConfigurationManager.LISTEN_IP).getValue();
 			int listenPort = ConfigurationManager.getIntegerParameterValue(ConfigurationManager.LISTEN_PORT);
 
-			ServerSocket socket = new ServerSocket(listenPort, 0, listenIP);
+			ServerSocketChannel channel = ServerSocketChannel.open();
+			ServerSocket socket = channel.socket();
 			socket.setReuseAddress(true);
+			socket.bind(new InetSocketAddress(listenIP, listenPort));
 			logger.info("listening on {}:{}", socket.getInetAddress(), socket.getLocalPort());
 
+			// Pollers are taken only for processing a request. Idle persistent connections are watched by
+			// the idle connection monitor, so requests wait in the queue only while all pollers are busy.
+			// When the queue is full, the accepting thread and the idle connection monitor wait for room
+			// in it, leaving further connections and requests in the socket buffers.
 			int startPollers = ConfigurationManager.getIntegerParameterValue(ConfigurationManager.START_POLLERS);
 			ExecutorService threadPool = new ThreadPoolExecutor(
 					startPollers,
 					startPollers,
 					30L, TimeUnit.SECONDS,
 					new ArrayBlockingQueue<Runnable>(startPollers),
-					new ThreadPoolExecutor.CallerRunsPolicy());
+					new RejectedExecutionHandler()
+					{
+						@Override
+						public void rejectedExecution(Runnable r, ThreadPoolExecutor executor)
+						{
+							if (executor.isShutdown())
+								throw new RejectedExecutionException("thread pool is shut down");
+
+							try
+							{
+								executor.getQueue().put(r);
+							}
+							catch (InterruptedException e)
+							{
+								Thread.currentThread().interrupt();
+								throw new RejectedExecutionException(e);
+							}
+						}
+					});
 			logger.debug("created a thread pool of {} pollers", startPollers);
 
+			IdleConnectionMonitor monitor = new IdleConnectionMonitor(threadPool);
+			monitor.start();
+
 			while (true)
-				threadPool.execute(new SocketProcessor(socket.accept()));
+			{
+				SocketChannel client = channel.accept();
+
+				try
+				{
+					threadPool.execute(new SocketProcessor(client, monitor));
+				}
+				catch (RejectedExecutionException e)
+				{
+					logger.warn("cannot process connection: {}", ZabbixException.getRootCauseMessage(e));
+					try { client.close(); } catch (Exception e2) { }
+				}
+			}
 		}
 		catch (Exception e)
 		{
@@ -20,6 +20,8 @@
 package com.zabbix.gateway;
 
 import java.net.Socket;
+import java.net.SocketTimeoutException;
+import java.nio.channels.SocketChannel;
 
 import org.json.*;
 
@@ -30,26 +32,74 @@ class SocketProcessor implements Runnable
 {
 	private static final Logger logger = LoggerFactory.getLogger(SocketProcessor.class);
 
-	private Socket socket;
+	private SocketChannel channel;
+	private IdleConnectionMonitor monitor;
 
-	SocketProcessor(Socket socket)
+	SocketProcessor(SocketChannel channel, IdleConnectionMonitor monitor)
 	{
-		this.socket = socket;
+		this.channel = channel;
+		this.monitor = monitor;
 	}
 
 	@Override
 	public void run()
 	{
-		logger.debug("starting to process incoming connection");
+		logger.debug("starting to process incoming request");
 
+		Socket socket = channel.socket();
 		BinaryProtocolSpeaker speaker = null;
-		ItemChecker checker = null;
+		boolean keep = false;
 
 		try
 		{
+			// a request that has started to arrive must not hold this poller for longer than the timeout
+			socket.setSoTimeout(ConfigurationManager.getIntegerParameterValue(ConfigurationManager.TIMEOUT) * 1000);
+
 			speaker = new BinaryProtocolSpeaker(socket);
 
-			JSONObject request = new JSONObject(speaker.getRequest());
+			// Zabbix server and proxy keep the connection open and may send further requests before reading
+			// responses to the previous ones. This thread processes one request and leaves the connection to
+			// the idle connection monitor, which passes it back to the thread pool when the next request
+			// arrives. Requests of a connection are therefore processed one at a time in the order received.
+			keep = processRequest(speaker);
+		}
+		catch (Exception e)
+		{
+			logger.warn("error processing connection: {}", ZabbixException.getRootCauseMessage(e));
+			logger.debug("error caused by", e);
+		}
+		finally
+		{
+			if (keep)
+			{
+				monitor.register(channel);
+			}
+			else
+			{
+				try { if (null != speaker) speaker.close(); } catch (Exception e) { }
+				try { channel.close(); } catch (Exception e) { }
+			}
+		}
+
+		logger.debug("finished processing incoming request");
+	}
+
+	// returns false if the connection was closed by peer or cannot be used for further requests
+	private boolean processRequest(BinaryProtocolSpeaker speaker)
+	{
+		ItemChecker checker = null;
+		boolean received = false;
+
+		try
+		{
+			String data = speaker.getRequest();
+
+			if (null == data)
+				return false;
+
+			received = true;
+
+			JSONObject request = new JSONObject(data);
 
 			if (request.getString(ItemChecker.JSON_TAG_REQUEST).equals(ItemChecker.JSON_REQUEST_INTERNAL))
 				checker = new InternalItemChecker(request);
@@ -66,6 +116,13 @@ class SocketProcessor implements Runnable
 			response.put(ItemChecker.JSON_TAG_DATA, values);
 
 			speaker.sendResponse(response.toString());
+
+			return true;
+		}
+		catch (SocketTimeoutException e)
+		{
+			logger.debug("closing idle connection");
+			return false;
 		}
 		catch (Exception e1)
 		{
@@ -91,14 +148,11 @@ class SocketProcessor implements Runnable
 			{
 				logger.warn("error sending failure notification: {}", ZabbixException.getRootCauseMessage(e1));
 				logger.debug("error caused by", e2);
+				return false;
 			}
-		}
-		finally
-		{
-			try { if (null != speaker) speaker.close(); } catch (Exception e) { }
-			try { if (null != socket) socket.close(); } catch (Exception e) { }
-		}
 
-		logger.debug("finished processing incoming connection");
+			// the request was read completely, so the connection is still usable
+			return received;
+		}
 	}
 }
@@ -48,6 +48,29 @@ extern int		server_num, process_num;
 					ZBX_DATASENDER_AUTOREGISTRATION | ZBX_DATASENDER_TASKS |	\
 					ZBX_DATASENDER_TASKS_RECV)
 
+/* the server connection kept open to send the next proxy data request */
+static zbx_socket_t	data_sock;
+static int		data_sock_keepalive = 0;
+
+/* 1 - server advertised binary history data support in the last response, 0 - otherwise */
+static int		server_history_bin = 0;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: proxy_data_connection_close                                      *
+ *                                                                            *
+ * Purpose: close the server connection kept open for proxy data requests     *
+ *                                                                            *
+ ******************************************************************************/
+static void	proxy_data_connection_close(void)
+{
+	if (0 == data_sock_keepalive)
+		return;
+
+	disconnect_server(&data_sock);
+	data_sock_keepalive = 0;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: proxy_data_sender                                                *
@@ -60,14 +83,14 @@ static int	proxy_data_sender(int *more, int now)
 {
 	static int		data_timestamp = 0, task_timestamp = 0, upload_state = SUCCEED;
 
-	zbx_socket_t		sock;
 	struct zbx_json		j;
 	struct zbx_json_parse	jp, jp_tasks;
 	int			availability_ts, history_records = 0, discovery_records = 0,
-				areg_records = 0, more_history = 0, more_discovery = 0, more_areg = 0;
+				areg_records = 0, more_history = 0, more_discovery = 0, more_areg = 0,
+				history_bin = server_history_bin;
 	zbx_uint64_t		history_lastid = 0, discovery_lastid = 0, areg_lastid = 0, flags = 0;
 	zbx_timespec_t		ts;
-	char			*error = NULL;
+	char			*error = NULL, value[MAX_ID_LEN + 1];
 	zbx_vector_ptr_t	tasks;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
@@ -84,7 +107,7 @@ static int	proxy_data_sender(int *more, int now)
 		if (SUCCEED == get_host_availability_data(&j, &availability_ts))
 			flags |= ZBX_DATASENDER_AVAILABILITY;
 
-		history_records = proxy_get_hist_data(&j, &history_lastid, &more_history);
+		history_records = proxy_get_hist_data(&j, history_bin, &history_lastid, &more_history);
 		if (0 != history_lastid)
 			flags |= ZBX_DATASENDER_HISTORY;
 
@@ -134,28 +157,69 @@ static int	proxy_data_sender(int *more, int now)
 
 		zbx_json_addstring(&j, ZBX_PROTO_TAG_VERSION, ZABBIX_VERSION, ZBX_JSON_TYPE_STRING);
 
-		connect_to_server(&sock, 600, CONFIG_PROXYDATA_FREQUENCY); /* retry till have a connection */
+		if (0 == data_sock_keepalive)
+			connect_to_server(&data_sock, 600, CONFIG_PROXYDATA_FREQUENCY); /* retry till have a connection */
 
 		zbx_timespec(&ts);
 		zbx_json_adduint64(&j, ZBX_PROTO_TAG_CLOCK, ts.sec);
 		zbx_json_adduint64(&j, ZBX_PROTO_TAG_NS, ts.ns);
 
-		if (SUCCEED != (upload_state = put_data_to_server(&sock, &j, &error)))
+		if (SUCCEED != (upload_state = put_data_to_server(&data_sock, &j, &error)) && 0 != data_sock_keepalive)
+		{
+			/* server might have closed the kept connection, resend over a new one */
+			zabbix_log(LOG_LEVEL_DEBUG, "cannot send proxy data over kept connection to server at \"%s\": %s",
+					data_sock.peer, error);
+			zbx_free(error);
+
+			disconnect_server(&data_sock);
+			connect_to_server(&data_sock, 600, CONFIG_PROXYDATA_FREQUENCY);
+			upload_state = put_data_to_server(&data_sock, &j, &error);
+		}
+
+		data_sock_keepalive = 0;
+
+		if (SUCCEED != upload_state)
 		{
 			*more = ZBX_PROXY_DATA_DONE;
 			zabbix_log(LOG_LEVEL_WARNING, "cannot send proxy data to server at \"%s\": %s",
-					sock.peer, error);
+					data_sock.peer, error);
 			zbx_free(error);
+
+			/* keep collected values in database while server cannot be reached */
+			zbx_pb_history_spill();
 		}
 		else
 		{
 			if (0 != (flags & ZBX_DATASENDER_AVAILABILITY))
 				zbx_set_availability_diff_ts(availability_ts);
 
-			if (SUCCEED == zbx_json_open(sock.buffer, &jp))
+			server_history_bin = 0;
+
+			if (SUCCEED == zbx_json_open(data_sock.buffer, &jp))
 			{
+				if (SUCCEED == zbx_proxy_hist_bin_supported(&jp))
+					server_history_bin = 1;
+
 				if (SUCCEED == zbx_json_brackets_by_name(&jp, ZBX_PROTO_TAG_TASKS, &jp_tasks))
 					flags |= ZBX_DATASENDER_TASKS_RECV;
+
+				/* server accepts the next request over the same connection */
+				if (ZBX_PROXY_DATA_MORE == *more && SUCCEED == zbx_json_value_by_name(&jp,
+						ZBX_PROTO_TAG_KEEPALIVE, value, sizeof(value)) && 0 != atoi(value))
+				{
+					data_sock_keepalive = 1;
+				}
+			}
+
+			/* keep binary history data until server confirms it was decoded, resend it as json */
+			if (0 != (flags & ZBX_DATASENDER_HISTORY) && 0 != history_bin && 0 != history_records &&
+					(0 == server_history_bin ||
+					SUCCEED != zbx_proxy_hist_bin_confirmed(&jp, history_records)))
+			{
+				zabbix_log(LOG_LEVEL_WARNING, "server at \"%s\" did not confirm binary history data,"
+						" the data will be sent again", data_sock.peer);
+				flags &= ~ZBX_DATASENDER_HISTORY;
+				server_history_bin = 0;
 			}
 
 			if (0 != (flags & ZBX_DATASENDER_DB_UPDATE))
@@ -187,8 +251,11 @@ static int	proxy_data_sender(int *more, int now)
 			}
 		}
 
-		disconnect_server(&sock);
+		if (0 == data_sock_keepalive)
+			disconnect_server(&data_sock);
 	}
+	else
+		proxy_data_connection_close();
 
 	zbx_vector_ptr_clear_ext(&tasks, (zbx_clean_func_t)zbx_tm_task_free);
 	zbx_vector_ptr_destroy(&tasks);
@@ -247,6 +314,8 @@ ZBX_THREAD_ENTRY(datasender_thread, args)
 		}
 		while (ZBX_PROXY_DATA_MORE == more && time_diff < SEC_PER_MIN);
 
+		proxy_data_connection_close();
+
 		zbx_setproctitle("%s [sent %d values in " ZBX_FS_DBL " sec, idle %d sec]",
 				get_process_type_string(process_type), records, time_diff,
 				ZBX_PROXY_DATA_MORE != more ? ZBX_TASK_UPDATE_FREQUENCY : 0);
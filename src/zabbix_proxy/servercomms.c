@@ -25,6 +25,7 @@
 #include "zbxjson.h"
 
 #include "comms.h"
+#include "proxy.h"
 #include "servercomms.h"
 
 extern unsigned int	configured_tls_connect_mode;
@@ -128,6 +129,9 @@ int	get_data_from_server(zbx_socket_t *sock, const char *request, char **error)
 	zbx_json_addstring(&j, "host", CONFIG_HOSTNAME, ZBX_JSON_TYPE_STRING);
 	zbx_json_addstring(&j, ZBX_PROTO_TAG_VERSION, ZABBIX_VERSION, ZBX_JSON_TYPE_STRING);
 
+	if (0 == strcmp(request, ZBX_PROTO_VALUE_PROXY_CONFIG))
+		get_proxyconfig_digest(&j);
+
 	if (SUCCEED != zbx_tcp_send_ext(sock, j.buffer, strlen(j.buffer), ZBX_TCP_PROTOCOL | ZBX_TCP_COMPRESS, 0))
 	{
 		*error = zbx_strdup(*error, zbx_socket_strerror());
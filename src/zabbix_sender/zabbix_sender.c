@@ -26,6 +26,7 @@
 #include "zbxgetopt.h"
 #include "zbxjson.h"
 #include "mutexs.h"
+#include "zbxalgo.h"
 #include "../libs/zbxcrypto/tls.h"
 
 #ifndef _WINDOWS
@@ -38,11 +39,12 @@ const char	syslog_app_name[] = "zabbix_sender";
 
 const char	*usage_message[] = {
 	"[-v]", "-z server", "[-p port]", "[-I IP-address]", "-s host", "-k key", "-o value", NULL,
-	"[-v]", "-z server", "[-p port]", "[-I IP-address]", "[-s host]", "[-T]", "[-r]", "-i input-file", NULL,
+	"[-v]", "-z server", "[-p port]", "[-I IP-address]", "[-s host]", "[-T]", "[-r]", "[--stream connections]",
+	"-i input-file", NULL,
 	"[-v]", "-c config-file", "[-z server]", "[-p port]", "[-I IP-address]", "[-s host]", "-k key", "-o value",
 	NULL,
 	"[-v]", "-c config-file", "[-z server]", "[-p port]", "[-I IP-address]", "[-s host]", "[-T]", "[-r]",
-	"-i input-file", NULL,
+	"[--stream connections]", "-i input-file", NULL,
 #if defined(HAVE_POLARSSL) || defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
 	"[-v]", "-z server", "[-p port]", "[-I IP-address]", "-s host", "--tls-connect cert", "--tls-ca-file CA-file",
 	"[--tls-crl-file CRL-file]", "[--tls-server-cert-issuer cert-issuer]",
@@ -51,7 +53,7 @@ const char	*usage_message[] = {
 	"[-v]", "-z server", "[-p port]", "[-I IP-address]", "[-s host]", "--tls-connect cert", "--tls-ca-file CA-file",
 	"[--tls-crl-file CRL-file]", "[--tls-server-cert-issuer cert-issuer]",
 	"[--tls-server-cert-subject cert-subject]", "--tls-cert-file cert-file", "--tls-key-file key-file", "[-T]",
-	"[-r]", "-i input-file", NULL,
+	"[-r]", "[--stream connections]", "-i input-file", NULL,
 	"[-v]", "-c config-file [-z server]", "[-p port]", "[-I IP-address]", "[-s host]", "--tls-connect cert",
 	"--tls-ca-file CA-file", "[--tls-crl-file CRL-file]", "[--tls-server-cert-issuer cert-issuer]",
 	"[--tls-server-cert-subject cert-subject]", "--tls-cert-file cert-file", "--tls-key-file key-file", "-k key",
@@ -59,15 +61,17 @@ const char	*usage_message[] = {
 	"[-v]", "-c config-file", "[-z server]", "[-p port]", "[-I IP-address]", "[-s host]", "--tls-connect cert",
 	"--tls-ca-file CA-file", "[--tls-crl-file CRL-file]", "[--tls-server-cert-issuer cert-issuer]",
 	"[--tls-server-cert-subject cert-subject]", "--tls-cert-file cert-file", "--tls-key-file key-file", "[-T]",
-	"[-r]", "-i input-file", NULL,
+	"[-r]", "[--stream connections]", "-i input-file", NULL,
 	"[-v]", "-z server", "[-p port]", "[-I IP-address]", "-s host", "--tls-connect psk",
 	"--tls-psk-identity PSK-identity", "--tls-psk-file PSK-file", "-k key", "-o value", NULL,
 	"[-v]", "-z server", "[-p port]", "[-I IP-address]", "[-s host]", "--tls-connect psk",
-	"--tls-psk-identity PSK-identity", "--tls-psk-file PSK-file", "[-T]", "[-r]", "-i input-file", NULL,
+	"--tls-psk-identity PSK-identity", "--tls-psk-file PSK-file", "[-T]", "[-r]",
+	"[--stream connections]", "-i input-file", NULL,
 	"[-v]", "-c config-file", "[-z server]", "[-p port]", "[-I IP-address]", "[-s host]", "--tls-connect psk",
 	"--tls-psk-identity PSK-identity", "--tls-psk-file PSK-file", "-k key", "-o value", NULL,
 	"[-v]", "-c config-file", "[-z server]", "[-p port]", "[-I IP-address]", "[-s host]", "--tls-connect psk",
-	"--tls-psk-identity PSK-identity", "--tls-psk-file PSK-file", "[-T]", "[-r]", "-i input-file", NULL,
+	"--tls-psk-identity PSK-identity", "--tls-psk-file PSK-file", "[-T]", "[-r]",
+	"[--stream connections]", "-i input-file", NULL,
 #endif
 	"-h", NULL,
 	"-V", NULL,
@@ -121,6 +125,14 @@ const char	*help_message[] = {
 	"                             received. This can be used when reading from",
 	"                             standard input",
 	"",
+	"  --stream connections       Keep the specified number of connections open to",
+	"                             each server or proxy and send next batches of",
+	"                             values without waiting for responses to the",
+	"                             previous ones. Values of the same host and key",
+	"                             are always sent over the same connection. Data",
+	"                             is sent compressed. This can be used with",
+	"                             --input-file option",
+	"",
 	"  -v --verbose               Verbose mode, -vv for more details",
 	"",
 	"  -h --help                  Display this help message",
@@ -195,6 +207,9 @@ char	*CONFIG_TLS_CERT_FILE		= NULL;
 char	*CONFIG_TLS_KEY_FILE		= NULL;
 char	*CONFIG_TLS_PSK_IDENTITY	= NULL;
 char	*CONFIG_TLS_PSK_FILE		= NULL;
+/* sessions are resumed by the following connections to the same destination during one run */
+int	CONFIG_TLS_SESSION_CACHE_SIZE	= 16;
+int	CONFIG_TLS_SESSION_LIFETIME	= SEC_PER_HOUR;
 
 int	CONFIG_PASSIVE_FORKS		= 0;	/* not used in zabbix_sender, just for linking with tls.c */
 int	CONFIG_ACTIVE_FORKS		= 0;	/* not used in zabbix_sender, just for linking with tls.c */
@@ -226,6 +241,7 @@ static struct zbx_option	longopts[] =
 	{"tls-key-file",		1,	NULL,	'7'},
 	{"tls-psk-identity",		1,	NULL,	'8'},
 	{"tls-psk-file",		1,	NULL,	'9'},
+	{"stream",			1,	NULL,	'S'},
 	{NULL}
 };
 
@@ -239,6 +255,7 @@ static int	CONFIG_LOG_LEVEL = LOG_LEVEL_CRIT;
 static char	*INPUT_FILE = NULL;
 static int	WITH_TIMESTAMPS = 0;
 static int	REAL_TIME = 0;
+static int	STREAM_CONNECTIONS = 0;
 
 static char	*CONFIG_SOURCE_IP = NULL;
 static char	*ZABBIX_SERVER = NULL;
@@ -247,14 +264,38 @@ static char	*ZABBIX_HOSTNAME = NULL;
 static char	*ZABBIX_KEY = NULL;
 static char	*ZABBIX_KEY_VALUE = NULL;
 
+/* maximum number of connections kept open to a single destination in stream mode */
+#define ZBX_SENDER_STREAM_CONNECTIONS_MAX	64
+
+typedef struct
+{
+	zbx_socket_t	sock;
+	int		connected;
+	int		reused;		/* the batch was sent over connection that served previous batches */
+	int		in_flight;	/* the batch was sent and its response is not received yet */
+	char		*batch;
+	size_t		batch_alloc;
+	size_t		batch_len;
+}
+zbx_sender_conn_t;
+
 typedef struct
 {
 	char			*host;
 	unsigned short		port;
 	ZBX_THREAD_HANDLE	*thread;
+	zbx_sender_conn_t	*conns;		/* stream mode connections */
 }
 zbx_send_destinations_t;
 
+/* stream mode batch of values sent over the connection with the same index at every destination */
+typedef struct
+{
+	struct zbx_json	json;
+	int		values_num;
+}
+zbx_sender_batch_t;
+
 static zbx_send_destinations_t	*destinations = NULL;		/* list of servers to send data to */
 static int			destinations_count = 0;
 
@@ -267,6 +308,24 @@ static void	send_signal_handler(int sig)
 	/* Calling _exit() to terminate the process immediately is important. See ZBX-5732 for details. */
 	_exit(EXIT_FAILURE);
 }
+
+/******************************************************************************
+ *                                                                            *
+ * Function: stream_alarm_signal_handler                                      *
+ *                                                                            *
+ * Purpose: handle alarm signal SIGALRM in stream mode                        *
+ *                                                                            *
+ * Comments: In stream mode data is sent by the main process, which must not  *
+ *           exit on a timeout of a single connection. Only the alarm flag is *
+ *           set, so the interrupted socket operation fails with a timeout.   *
+ *                                                                            *
+ ******************************************************************************/
+static void	stream_alarm_signal_handler(int sig)
+{
+	ZBX_UNUSED(sig);
+
+	zbx_alarm_flag_set();	/* set alarm flag */
+}
 #endif
 
 typedef struct
@@ -631,6 +690,437 @@ static int	perform_data_sending(ZBX_THREAD_SENDVAL_ARGS *sendval_args, int old_s
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: sender_stream_close                                              *
+ *                                                                            *
+ * Purpose: close stream mode connections of the destination                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	sender_stream_close(zbx_send_destinations_t *destination)
+{
+	int	i;
+
+	if (NULL == destination->conns)
+		return;
+
+	for (i = 0; i < STREAM_CONNECTIONS; i++)
+	{
+		if (0 != destination->conns[i].connected)
+			zbx_tcp_close(&destination->conns[i].sock);
+
+		zbx_free(destination->conns[i].batch);
+	}
+
+	zbx_free(destination->conns);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: sender_stream_conn_is_alive                                      *
+ *                                                                            *
+ * Purpose: check if idle connection was not closed by server                 *
+ *                                                                            *
+ * Comments: There are no outstanding requests on an idle connection, so any  *
+ *           readable data means that it was closed or is out of sync.        *
+ *                                                                            *
+ ******************************************************************************/
+static int	sender_stream_conn_is_alive(const zbx_sender_conn_t *conn)
+{
+	fd_set		fdr;
+	struct timeval	tv = {0, 0};
+
+	FD_ZERO(&fdr);
+	FD_SET(conn->sock.socket, &fdr);
+
+	if (0 != select(ZBX_SOCKET_TO_INT(conn->sock.socket) + 1, &fdr, NULL, NULL, &tv))
+		return FAIL;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: sender_stream_conn_send                                          *
+ *                                                                            *
+ * Purpose: send batch of the connection, connecting first if necessary       *
+ *                                                                            *
+ * Parameters: destination - [IN] the destination                             *
+ *             conn        - [IN/OUT] the connection                          *
+ *                                                                            *
+ * Return value:  SUCCEED - the batch was sent                                *
+ *                FAIL - an error occurred, the connection is closed          *
+ *                                                                            *
+ ******************************************************************************/
+static int	sender_stream_conn_send(const zbx_send_destinations_t *destination, zbx_sender_conn_t *conn)
+{
+	unsigned char	flags = ZBX_TCP_PROTOCOL;
+	char		*tls_arg1, *tls_arg2;
+
+	switch (configured_tls_connect_mode)
+	{
+		case ZBX_TCP_SEC_UNENCRYPTED:
+			tls_arg1 = NULL;
+			tls_arg2 = NULL;
+			break;
+#if defined(HAVE_POLARSSL) || defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
+		case ZBX_TCP_SEC_TLS_CERT:
+			tls_arg1 = CONFIG_TLS_SERVER_CERT_ISSUER;
+			tls_arg2 = CONFIG_TLS_SERVER_CERT_SUBJECT;
+			break;
+		case ZBX_TCP_SEC_TLS_PSK:
+			tls_arg1 = CONFIG_TLS_PSK_IDENTITY;
+			tls_arg2 = NULL;	/* zbx_tls_connect() will find PSK */
+			break;
+#endif
+		default:
+			THIS_SHOULD_NEVER_HAPPEN;
+			return FAIL;
+	}
+
+	if (0 == (conn->reused = conn->connected))
+	{
+		if (SUCCEED != zbx_tcp_connect(&conn->sock, CONFIG_SOURCE_IP, destination->host, destination->port,
+				GET_SENDER_TIMEOUT, configured_tls_connect_mode, tls_arg1, tls_arg2))
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "send value error: %s", zbx_socket_strerror());
+			return FAIL;
+		}
+
+		conn->connected = 1;
+	}
+#ifdef HAVE_ZLIB
+	flags |= ZBX_TCP_COMPRESS;
+#endif
+	/* use explicit timeouts so that no alarm is left pending while connection is kept open */
+	if (SUCCEED != zbx_tcp_send_ext(&conn->sock, conn->batch, conn->batch_len, flags, GET_SENDER_TIMEOUT))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "send value error: %s", zbx_socket_strerror());
+		zbx_tcp_close(&conn->sock);
+		conn->connected = 0;
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: sender_stream_recv                                               *
+ *                                                                            *
+ * Purpose: receive response to the batch sent over the connection            *
+ *                                                                            *
+ * Parameters: destination - [IN] the destination                             *
+ *             conn        - [IN/OUT] the connection with a batch in flight   *
+ *                                                                            *
+ * Return value:  SUCCEED - the batch was processed                           *
+ *                FAIL - an error occurred                                    *
+ *                SUCCEED_PARTIAL - the batch was processed, but processing   *
+ *                of at least one value failed                                *
+ *                                                                            *
+ * Comments: Server closes idle kept open connection without reading requests *
+ *           that arrive at the same time, so a batch sent over reused        *
+ *           connection that was closed without response is sent once again   *
+ *           over a new connection.                                           *
+ *                                                                            *
+ ******************************************************************************/
+static int	sender_stream_recv(const zbx_send_destinations_t *destination, zbx_sender_conn_t *conn)
+{
+	int	ret = FAIL;
+
+	conn->in_flight = 0;
+
+	while (SUCCEED == zbx_tcp_recv_to(&conn->sock, GET_SENDER_TIMEOUT))
+	{
+		if (0 != conn->sock.read_bytes)
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "answer [%s]", conn->sock.buffer);
+
+			if (FAIL == (ret = check_response(conn->sock.buffer, destination->host, destination->port)))
+			{
+				zabbix_log(LOG_LEVEL_WARNING, "incorrect answer from \"%s:%hu\": [%s]",
+						destination->host, destination->port, conn->sock.buffer);
+			}
+
+			return ret;
+		}
+
+		zbx_tcp_close(&conn->sock);
+		conn->connected = 0;
+
+		if (0 == conn->reused)
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "send value error: connection closed by server");
+			return FAIL;
+		}
+
+		if (SUCCEED != sender_stream_conn_send(destination, conn))
+			return FAIL;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "send value error: %s", zbx_socket_strerror());
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: sender_stream_conn_index                                         *
+ *                                                                            *
+ * Purpose: get index of the stream mode connection to send value over        *
+ *                                                                            *
+ * Parameters: host - [IN] the host name                                      *
+ *             key  - [IN] the item key                                       *
+ *                                                                            *
+ * Return value: The connection index.                                        *
+ *                                                                            *
+ * Comments: Values of the same host and key are always sent over the same    *
+ *           connection, so they are processed by server in the input order.  *
+ *                                                                            *
+ ******************************************************************************/
+static int	sender_stream_conn_index(const char *host, const char *key)
+{
+	zbx_hash_t	hash;
+
+	hash = ZBX_DEFAULT_STRING_HASH_ALGO(host, strlen(host), ZBX_DEFAULT_HASH_SEED);
+	hash = ZBX_DEFAULT_STRING_HASH_ALGO(key, strlen(key), hash);
+
+	return (int)(hash % (zbx_hash_t)STREAM_CONNECTIONS);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: sender_stream_send                                               *
+ *                                                                            *
+ * Purpose: send batch to the destination over the specified connection       *
+ *                                                                            *
+ * Parameters: destination - [IN] the destination                             *
+ *             index       - [IN] the connection index                        *
+ *             json        - [IN] the batch                                   *
+ *                                                                            *
+ * Return value:  SUCCEED - the batch was sent                                *
+ *                FAIL - an error occurred                                    *
+ *                SUCCEED_PARTIAL - the batch was sent, but processing of at  *
+ *                least one value of the batch previously sent over the same  *
+ *                connection failed                                           *
+ *                                                                            *
+ * Comments: The response to the previous batch of the connection is received *
+ *           before the next batch is sent, so batches of a connection are    *
+ *           processed in the order they were sent. The batch is kept until   *
+ *           the response is received, see sender_stream_recv().              *
+ *                                                                            *
+ ******************************************************************************/
+static int	sender_stream_send(zbx_send_destinations_t *destination, int index, const struct zbx_json *json)
+{
+	zbx_sender_conn_t	*conn;
+	int			ret = SUCCEED;
+
+	if (NULL == destination->conns)
+	{
+		destination->conns = (zbx_sender_conn_t *)zbx_calloc(NULL, STREAM_CONNECTIONS,
+				sizeof(zbx_sender_conn_t));
+	}
+
+	conn = &destination->conns[index];
+
+	if (0 != conn->in_flight && FAIL == (ret = sender_stream_recv(destination, conn)))
+		return FAIL;
+
+	if (0 != conn->connected && SUCCEED != sender_stream_conn_is_alive(conn))
+	{
+		zbx_tcp_close(&conn->sock);
+		conn->connected = 0;
+	}
+
+	if (conn->batch_alloc < json->buffer_size)
+	{
+		conn->batch_alloc = json->buffer_size;
+		conn->batch = (char *)zbx_realloc(conn->batch, conn->batch_alloc);
+	}
+
+	memcpy(conn->batch, json->buffer, json->buffer_size);
+	conn->batch_len = json->buffer_size;
+
+	/* a batch that failed to be sent over reused connection was not received by server */
+	if (SUCCEED != sender_stream_conn_send(destination, conn) &&
+			(0 == conn->reused || SUCCEED != sender_stream_conn_send(destination, conn)))
+	{
+		return FAIL;
+	}
+
+	conn->in_flight = 1;
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: sender_stream_flush                                              *
+ *                                                                            *
+ * Purpose: receive responses to all batches in flight to the destination     *
+ *          and close its connections                                         *
+ *                                                                            *
+ * Parameters: destination - [IN] the destination                             *
+ *                                                                            *
+ * Return value:  SUCCEED - all batches were processed                        *
+ *                FAIL - an error occurred                                    *
+ *                SUCCEED_PARTIAL - processing of at least one value failed   *
+ *                                                                            *
+ ******************************************************************************/
+static int	sender_stream_flush(zbx_send_destinations_t *destination)
+{
+	int	i, ret = SUCCEED;
+
+	for (i = 0; NULL != destination->conns && i < STREAM_CONNECTIONS; i++)
+	{
+		zbx_sender_conn_t	*conn = &destination->conns[i];
+		int			status;
+
+		if (0 == conn->in_flight)
+			continue;
+
+		if (FAIL == (status = sender_stream_recv(destination, conn)))
+		{
+			ret = FAIL;
+			break;
+		}
+
+		if (SUCCEED_PARTIAL == status)
+			ret = SUCCEED_PARTIAL;
+	}
+
+	sender_stream_close(destination);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: perform_stream_sending                                           *
+ *                                                                            *
+ * Purpose: Send data to all destinations over kept open connections without  *
+ *          waiting for responses, or wait for all responses when flushing    *
+ *                                                                            *
+ * Parameters:                                                                *
+ *      batch          - [IN/OUT] the batch to send, NULL to flush            *
+ *      index          - [IN] the index of connection to send the batch over  *
+ *      sync_timestamp - [IN] 1 if the batch contains value timestamps        *
+ *      old_status     - [IN] previous status                                 *
+ *                                                                            *
+ * Return value:  SUCCEED - success with all values at all destinations       *
+ *                FAIL - an error occurred                                    *
+ *                SUCCEED_PARTIAL - data sending was completed successfully   *
+ *                to at least one destination or processing of at least one   *
+ *                value at least at one destination failed                    *
+ *                                                                            *
+ * Comments: Destinations that failed are removed from the list in the same   *
+ *           way as in perform_data_sending().                                *
+ *                                                                            *
+ ******************************************************************************/
+static int	perform_stream_sending(zbx_sender_batch_t *batch, int index, int sync_timestamp, int old_status)
+{
+	int	i = 0, destinations_num = destinations_count, sp_count = 0, fail_count = 0;
+
+	if (NULL != batch)
+	{
+		zbx_json_close(&batch->json);
+		zbx_json_adduint64(&batch->json, ZBX_PROTO_TAG_KEEPALIVE, 1);
+
+		if (1 == sync_timestamp)
+		{
+			zbx_timespec_t	ts;
+
+			zbx_timespec(&ts);
+
+			zbx_json_adduint64(&batch->json, ZBX_PROTO_TAG_CLOCK, ts.sec);
+			zbx_json_adduint64(&batch->json, ZBX_PROTO_TAG_NS, ts.ns);
+		}
+	}
+
+	while (i < destinations_count)
+	{
+		int	new_status;
+
+		if (NULL != batch)
+			new_status = sender_stream_send(&destinations[i], index, &batch->json);
+		else
+			new_status = sender_stream_flush(&destinations[i]);
+
+		if (SUCCEED_PARTIAL == new_status)
+			sp_count++;
+
+		if (FAIL == new_status)
+		{
+			fail_count++;
+			sender_stream_close(&destinations[i]);
+			zbx_free(destinations[i].host);
+			destinations[i] = destinations[--destinations_count];
+			continue;
+		}
+
+		i++;
+	}
+
+	if (destinations_num == fail_count)
+		return FAIL;
+	else if (SUCCEED_PARTIAL == old_status || 0 != sp_count || 0 != fail_count)
+		return SUCCEED_PARTIAL;
+	else
+		return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: sender_stream_batch_clean                                        *
+ *                                                                            *
+ * Purpose: prepare stream mode batch for new values                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	sender_stream_batch_clean(zbx_sender_batch_t *batch)
+{
+	zbx_json_clean(&batch->json);
+	zbx_json_addstring(&batch->json, ZBX_PROTO_TAG_REQUEST, ZBX_PROTO_VALUE_SENDER_DATA, ZBX_JSON_TYPE_STRING);
+	zbx_json_addarray(&batch->json, ZBX_PROTO_TAG_DATA);
+	batch->values_num = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: sender_stream_batches_send                                       *
+ *                                                                            *
+ * Purpose: send stream mode batches that contain at least the specified      *
+ *          number of values                                                  *
+ *                                                                            *
+ * Parameters:                                                                *
+ *      batches        - [IN/OUT] the batches, one per connection             *
+ *      values_min     - [IN] the minimum number of values in batch to send   *
+ *      sync_timestamp - [IN] 1 if the batches contain value timestamps       *
+ *      old_status     - [IN] previous status                                 *
+ *                                                                            *
+ * Return value:  SUCCEED - success with all values at all destinations       *
+ *                FAIL - an error occurred                                    *
+ *                SUCCEED_PARTIAL - data sending was completed successfully   *
+ *                to at least one destination or processing of at least one   *
+ *                value at least at one destination failed                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	sender_stream_batches_send(zbx_sender_batch_t *batches, int values_min, int sync_timestamp,
+		int old_status)
+{
+	int	i, ret = old_status;
+
+	for (i = 0; i < STREAM_CONNECTIONS && FAIL != ret; i++)
+	{
+		if (values_min > batches[i].values_num)
+			continue;
+
+		ret = perform_stream_sending(&batches[i], i, sync_timestamp, ret);
+		sender_stream_batch_clean(&batches[i]);
+	}
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: sender_add_serveractive_host_cb                                  *
@@ -669,6 +1159,7 @@ static int	sender_add_serveractive_host_cb(const char *host, unsigned short port
 
 	destinations[destinations_count - 1].host = zbx_strdup(NULL, host);
 	destinations[destinations_count - 1].port = port;
+	destinations[destinations_count - 1].conns = NULL;
 
 	return SUCCEED;
 }
@@ -814,6 +1305,16 @@ static void	parse_commandline(int argc, char **argv)
 			case 'r':
 				REAL_TIME = 1;
 				break;
+			case 'S':
+				if (FAIL == is_uint_range(zbx_optarg, &STREAM_CONNECTIONS, 1,
+						ZBX_SENDER_STREAM_CONNECTIONS_MAX))
+				{
+					zbx_error("option \"--stream\" used with invalid number of connections \"%s\","
+							" valid values are 1-%d", zbx_optarg,
+							ZBX_SENDER_STREAM_CONNECTIONS_MAX);
+					exit(EXIT_FAILURE);
+				}
+				break;
 			case 'v':
 				if (LOG_LEVEL_WARNING > CONFIG_LOG_LEVEL)
 					CONFIG_LOG_LEVEL = LOG_LEVEL_WARNING;
@@ -1097,6 +1598,13 @@ static void	parse_commandline(int argc, char **argv)
 		exit(EXIT_FAILURE);
 	}
 
+	if (0 != opt_count['S'] && 0 == opt_count['i'])
+	{
+		zbx_error("option \"--stream\" can be used only with option \"-i\"");
+		usage();
+		exit(EXIT_FAILURE);
+	}
+
 	/* Parameters which are not option values are invalid. The check relies on zbx_getopt_internal() which */
 	/* always permutes command line arguments regardless of POSIXLY_CORRECT environment variable. */
 	if (argc > zbx_optind)
@@ -1155,6 +1663,9 @@ static char	*zbx_fgets_alloc(char **buffer, size_t *buffer_alloc, FILE *fp)
 /* take long and hit timeout, so we limit values to 250 per connection */
 #define VALUES_MAX	250
 
+/* input buffer size, large enough to read big files in few system calls */
+#define INPUT_BUFFER_SIZE	ZBX_MEBIBYTE
+
 int	main(int argc, char **argv)
 {
 	char			*error = NULL;
@@ -1241,11 +1752,14 @@ int	main(int argc, char **argv)
 
 	if (INPUT_FILE)
 	{
-		FILE	*in;
-		char	*in_line = NULL, *key_value = NULL;
-		int	buffer_count = 0;
-		size_t	in_line_alloc = MAX_BUFFER_LEN;
-		double	last_send = 0;
+		static char		in_buffer[INPUT_BUFFER_SIZE];
+		FILE			*in;
+		char			*in_line = NULL, *key_value = NULL;
+		int			buffer_count = 0, index = 0, i;
+		size_t			in_line_alloc = MAX_BUFFER_LEN;
+		double			last_send = 0;
+		struct zbx_json		*json = &sendval_args->json;
+		zbx_sender_batch_t	*batches = NULL;
 
 		if (0 == strcmp(INPUT_FILE, "-"))
 		{
@@ -1262,6 +1776,35 @@ int	main(int argc, char **argv)
 			goto free;
 		}
 
+		if (stdin != in || 0 == REAL_TIME)
+			setvbuf(in, in_buffer, _IOFBF, sizeof(in_buffer));
+
+		if (0 != STREAM_CONNECTIONS)
+		{
+#if !defined(_WINDOWS)
+			struct sigaction	phan;
+
+			/* in stream mode data is sent by the main process itself */
+			signal(SIGINT,  send_signal_handler);
+			signal(SIGTERM, send_signal_handler);
+			signal(SIGQUIT, send_signal_handler);
+			signal(SIGPIPE, SIG_IGN);
+
+			/* without SA_RESTART flag alarm interrupts the blocked socket operation */
+			sigemptyset(&phan.sa_mask);
+			phan.sa_flags = 0;
+			phan.sa_handler = stream_alarm_signal_handler;
+			sigaction(SIGALRM, &phan, NULL);
+#endif
+			batches = (zbx_sender_batch_t *)zbx_malloc(NULL, STREAM_CONNECTIONS * sizeof(zbx_sender_batch_t));
+
+			for (i = 0; i < STREAM_CONNECTIONS; i++)
+			{
+				zbx_json_init(&batches[i].json, ZBX_JSON_STAT_BUF_LEN);
+				sender_stream_batch_clean(&batches[i]);
+			}
+		}
+
 		sendval_args->sync_timestamp = WITH_TIMESTAMPS;
 		in_line = (char *)zbx_malloc(NULL, in_line_alloc);
 
@@ -1351,13 +1894,20 @@ int	main(int argc, char **argv)
 				break;
 			}
 
-			zbx_json_addobject(&sendval_args->json, NULL);
-			zbx_json_addstring(&sendval_args->json, ZBX_PROTO_TAG_HOST, hostname, ZBX_JSON_TYPE_STRING);
-			zbx_json_addstring(&sendval_args->json, ZBX_PROTO_TAG_KEY, key, ZBX_JSON_TYPE_STRING);
-			zbx_json_addstring(&sendval_args->json, ZBX_PROTO_TAG_VALUE, key_value, ZBX_JSON_TYPE_STRING);
+			if (0 != STREAM_CONNECTIONS)
+			{
+				index = sender_stream_conn_index(hostname, key);
+				json = &batches[index].json;
+				batches[index].values_num++;
+			}
+
+			zbx_json_addobject(json, NULL);
+			zbx_json_addstring(json, ZBX_PROTO_TAG_HOST, hostname, ZBX_JSON_TYPE_STRING);
+			zbx_json_addstring(json, ZBX_PROTO_TAG_KEY, key, ZBX_JSON_TYPE_STRING);
+			zbx_json_addstring(json, ZBX_PROTO_TAG_VALUE, key_value, ZBX_JSON_TYPE_STRING);
 			if (1 == WITH_TIMESTAMPS)
-				zbx_json_adduint64(&sendval_args->json, ZBX_PROTO_TAG_CLOCK, timestamp);
-			zbx_json_close(&sendval_args->json);
+				zbx_json_adduint64(json, ZBX_PROTO_TAG_CLOCK, timestamp);
+			zbx_json_close(json);
 
 			succeed_count++;
 			buffer_count++;
@@ -1389,7 +1939,20 @@ int	main(int argc, char **argv)
 				}
 			}
 
-			if (VALUES_MAX == buffer_count || (stdin == in && 1 == REAL_TIME && 0 >= read_more))
+			if (0 != STREAM_CONNECTIONS)
+			{
+				if (stdin == in && 1 == REAL_TIME && 0 >= read_more)
+				{
+					last_send = zbx_time();
+					ret = sender_stream_batches_send(batches, 1, sendval_args->sync_timestamp, ret);
+				}
+				else if (VALUES_MAX == batches[index].values_num)
+				{
+					ret = sender_stream_batches_send(batches, VALUES_MAX, sendval_args->sync_timestamp,
+							ret);
+				}
+			}
+			else if (VALUES_MAX == buffer_count || (stdin == in && 1 == REAL_TIME && 0 >= read_more))
 			{
 				zbx_json_close(&sendval_args->json);
 
@@ -1405,7 +1968,25 @@ int	main(int argc, char **argv)
 			}
 		}
 
-		if (FAIL != ret && 0 != buffer_count)
+		if (0 != STREAM_CONNECTIONS)
+		{
+			/* batches already sent are processed regardless of errors in the rest of input */
+			int	flush_ret;
+
+			if (FAIL != ret)
+				ret = sender_stream_batches_send(batches, 1, sendval_args->sync_timestamp, ret);
+
+			flush_ret = perform_stream_sending(NULL, 0, 0, ret);
+
+			if (FAIL != ret)
+				ret = flush_ret;
+
+			for (i = 0; i < STREAM_CONNECTIONS; i++)
+				zbx_json_free(&batches[i].json);
+
+			zbx_free(batches);
+		}
+		else if (FAIL != ret && 0 != buffer_count)
 		{
 			zbx_json_close(&sendval_args->json);
 			ret = perform_data_sending(sendval_args, ret);
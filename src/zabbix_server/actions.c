@@ -27,6 +27,9 @@
 #include "events.h"
 #include "zbxregexp.h"
 
+/* condition result placeholder, SUCCEED, FAIL and NOTSUPPORTED are never positive */
+#define ZBX_CONDITION_RESULT_UNKNOWN	1
+
 /******************************************************************************
  *                                                                            *
  * Function: check_condition_event_tag                                        *
@@ -94,6 +97,31 @@ static int	check_condition_event_tag_value(const DB_EVENT *event, DB_CONDITION *
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: get_trigger_event_hostids                                        *
+ *                                                                            *
+ * Purpose: gets hosts of the trigger that generated the event from           *
+ *          configuration cache                                               *
+ *                                                                            *
+ * Parameters: event   - [IN] the trigger event                               *
+ *             hostids - [OUT] the sorted host identifiers                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	get_trigger_event_hostids(const DB_EVENT *event, zbx_vector_uint64_t *hostids)
+{
+	zbx_vector_uint64_t	functionids;
+
+	zbx_vector_uint64_create(&functionids);
+
+	get_functionids(&functionids, event->trigger.expression);
+	get_functionids(&functionids, event->trigger.recovery_expression);
+
+	DCget_hostids_by_functionids(&functionids, hostids);
+
+	zbx_vector_uint64_destroy(&functionids);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: check_trigger_condition                                          *
@@ -121,47 +149,29 @@ static int	check_trigger_condition(const DB_EVENT *event, DB_CONDITION *conditio
 
 	if (CONDITION_TYPE_HOST_GROUP == condition->conditiontype)
 	{
-		zbx_vector_uint64_t	groupids;
-		char			*sql = NULL;
-		size_t			sql_alloc = 0, sql_offset = 0;
+		zbx_vector_uint64_t	hostids;
+		int			found;
 
 		ZBX_STR2UINT64(condition_value, condition->value);
 
-		zbx_vector_uint64_create(&groupids);
-		zbx_dc_get_nested_hostgroupids(&condition_value, 1, &groupids);
-
-		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
-				"select distinct hg.groupid"
-				" from hosts_groups hg,hosts h,items i,functions f,triggers t"
-				" where hg.hostid=h.hostid"
-					" and h.hostid=i.hostid"
-					" and i.itemid=f.itemid"
-					" and f.triggerid=t.triggerid"
-					" and t.triggerid=" ZBX_FS_UI64
-					" and",
-				event->objectid);
-
-		DBadd_condition_alloc(&sql, &sql_alloc, &sql_offset, "hg.groupid", groupids.values,
-				groupids.values_num);
-
-		result = DBselect("%s", sql);
-		zbx_free(sql);
-		zbx_vector_uint64_destroy(&groupids);
+		zbx_vector_uint64_create(&hostids);
+		get_trigger_event_hostids(event, &hostids);
+		found = zbx_dc_check_hosts_in_hostgroup(&hostids, condition_value);
+		zbx_vector_uint64_destroy(&hostids);
 
 		switch (condition->op)
 		{
 			case CONDITION_OPERATOR_EQUAL:
-				if (NULL != DBfetch(result))
+				if (SUCCEED == found)
 					ret = SUCCEED;
 				break;
 			case CONDITION_OPERATOR_NOT_EQUAL:
-				if (NULL == DBfetch(result))
+				if (SUCCEED != found)
 					ret = SUCCEED;
 				break;
 			default:
 				ret = NOTSUPPORTED;
 		}
-		DBfree_result(result);
 	}
 	else if (CONDITION_TYPE_HOST_TEMPLATE == condition->conditiontype)
 	{
@@ -228,25 +238,24 @@ static int	check_trigger_condition(const DB_EVENT *event, DB_CONDITION *conditio
 	}
 	else if (CONDITION_TYPE_HOST == condition->conditiontype)
 	{
+		zbx_vector_uint64_t	hostids;
+
 		ZBX_STR2UINT64(condition_value, condition->value);
 
 		switch (condition->op)
 		{
 			case CONDITION_OPERATOR_EQUAL:
 			case CONDITION_OPERATOR_NOT_EQUAL:
-				result = DBselect(
-						"select distinct i.hostid"
-						" from items i,functions f,triggers t"
-						" where i.itemid=f.itemid"
-							" and f.triggerid=t.triggerid"
-							" and t.triggerid=" ZBX_FS_UI64
-							" and i.hostid=" ZBX_FS_UI64,
-						event->objectid,
-						condition_value);
+				zbx_vector_uint64_create(&hostids);
+				get_trigger_event_hostids(event, &hostids);
 
-				if (NULL != DBfetch(result))
+				if (FAIL != zbx_vector_uint64_bsearch(&hostids, condition_value,
+						ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+				{
 					ret = SUCCEED;
-				DBfree_result(result);
+				}
+
+				zbx_vector_uint64_destroy(&hostids);
 
 				if (CONDITION_OPERATOR_NOT_EQUAL == condition->op)
 					ret = (SUCCEED == ret) ? FAIL : SUCCEED;
@@ -1356,14 +1365,19 @@ int	check_action_condition(const DB_EVENT *event, DB_CONDITION *condition)
  * Purpose: check if actions have to be processed for the event               *
  *          (check all conditions of the action)                              *
  *                                                                            *
- * Parameters: actionid - action ID for matching                              *
+ * Parameters: event  - [IN] the event to check                               *
+ *             action - [IN] the action for matching                          *
  *                                                                            *
  * Return value: SUCCEED - matches, FAIL - otherwise                          *
  *                                                                            *
  * Author: Alexei Vladishev                                                   *
  *                                                                            *
+ * Comments: Conditions are checked only when their result is required and    *
+ *           the result is cached in the unique condition, so conditions      *
+ *           skipped by short-circuit evaluation are never checked.           *
+ *                                                                            *
  ******************************************************************************/
-static int	check_action_conditions(zbx_action_eval_t *action)
+static int	check_action_conditions(const DB_EVENT *event, zbx_action_eval_t *action)
 {
 	DB_CONDITION	*condition;
 	int		condition_result, ret = SUCCEED, id_len, i;
@@ -1386,7 +1400,8 @@ static int	check_action_conditions(zbx_action_eval_t *action)
 			continue;	/* short-circuit true OR condition block to the next AND condition */
 		}
 
-		condition_result = condition->condition_result;
+		if (ZBX_CONDITION_RESULT_UNKNOWN == (condition_result = condition->condition_result))
+			condition_result = condition->condition_result = check_action_condition(event, condition);
 
 		switch (action->evaltype)
 		{
@@ -1687,11 +1702,11 @@ static zbx_hash_t	uniq_conditions_hash_func(const void *data)
  *                                                                            *
  * Function: check_event_conditions                                           *
  *                                                                            *
- * Purpose: check all unique conditions for given event and source            *
+ * Purpose: reset results of all unique conditions for given event source     *
  *                                                                            *
  * Parameters: event           - [IN]     event that need conditions checking *
- *             uniq_conditions - [IN/OUT] conditions that will be checked and *
- *                                        updated with result                 *
+ *             uniq_conditions - [IN/OUT] conditions that will be checked     *
+ *                                        when required by actions            *
  *                                                                            *
  * Return value: SICCESS if valid event source, otherwise FAIL                *
  *                                                                            *
@@ -1707,7 +1722,7 @@ static int	check_event_conditions(const DB_EVENT *event, zbx_hashset_t *uniq_con
 	zbx_hashset_iter_reset(&uniq_conditions[event->source], &iter);
 
 	while (NULL != (condition = (DB_CONDITION *)zbx_hashset_iter_next(&iter)))
-		condition->condition_result = check_action_condition(event, condition);
+		condition->condition_result = ZBX_CONDITION_RESULT_UNKNOWN;
 
 	return SUCCEED;
 }
@@ -1771,7 +1786,7 @@ void	process_actions(const zbx_vector_ptr_t *events, const zbx_vector_uint64_pai
 				if (action->eventsource != event->source)
 					continue;
 
-				if (SUCCEED == check_action_conditions(action))
+				if (SUCCEED == check_action_conditions(event, action))
 				{
 					zbx_escalation_new_t	*new_escalation;
 
@@ -2000,7 +2015,7 @@ int	process_actions_by_acknowledgements(const zbx_vector_ptr_t *ack_tasks)
 			if (action->eventsource != event->source)
 				continue;
 
-			if (SUCCEED != check_action_conditions(action))
+			if (SUCCEED != check_action_conditions(event, action))
 				continue;
 
 			for (k = kcurr; k < knext; k++)
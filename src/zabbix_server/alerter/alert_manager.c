@@ -1458,6 +1458,49 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: am_alertstatus_compare                                           *
+ *                                                                            *
+ * Purpose: sorts alert status updates by the updated values and alert        *
+ *          identifier so that identical updates are grouped together         *
+ *                                                                            *
+ ******************************************************************************/
+static int	am_alertstatus_compare(const void *d1, const void *d2)
+{
+	const zbx_am_alertstatus_t	*update1 = *(const zbx_am_alertstatus_t **)d1;
+	const zbx_am_alertstatus_t	*update2 = *(const zbx_am_alertstatus_t **)d2;
+	int				ret;
+
+	ZBX_RETURN_IF_NOT_EQUAL(update1->status, update2->status);
+	ZBX_RETURN_IF_NOT_EQUAL(update1->retries, update2->retries);
+
+	if (0 != (ret = strcmp(update1->error, update2->error)))
+		return ret;
+
+	ZBX_RETURN_IF_NOT_EQUAL(update1->alertid, update2->alertid);
+
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: am_alertstatus_equal                                             *
+ *                                                                            *
+ * Purpose: checks if two alert status updates set the same values            *
+ *                                                                            *
+ ******************************************************************************/
+static int	am_alertstatus_equal(const zbx_am_alertstatus_t *update1, const zbx_am_alertstatus_t *update2)
+{
+	if (update1->status != update2->status || update1->retries != update2->retries ||
+			0 != strcmp(update1->error, update2->error))
+	{
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: am_db_flush_alert_updates                                        *
@@ -1473,11 +1516,12 @@ out:
 static int	am_db_flush_alert_updates(zbx_am_t *manager)
 {
 	zbx_vector_ptr_t	updates;
+	zbx_vector_uint64_t	alertids;
 	zbx_hashset_iter_t	iter;
 	zbx_am_alertstatus_t	*update;
 	char			*sql = NULL, *error_esc;
 	size_t			sql_alloc = 0, sql_offset = 0;
-	int			i, j, ret = FAIL, limit;
+	int			i, statements, ret = FAIL;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() updates:%d", __func__, manager->alertupdates.num_data);
 
@@ -1488,37 +1532,45 @@ static int	am_db_flush_alert_updates(zbx_am_t *manager)
 	}
 
 	zbx_vector_ptr_create(&updates);
+	zbx_vector_uint64_create(&alertids);
 
 	zbx_hashset_iter_reset(&manager->alertupdates, &iter);
 	while (NULL != (update = (zbx_am_alertstatus_t *)zbx_hashset_iter_next(&iter)))
 		zbx_vector_ptr_append(&updates, update);
 
-	zbx_vector_ptr_sort(&updates, ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC);
+	/* group alerts with identical status updates to update them with a single statement */
+	zbx_vector_ptr_sort(&updates, am_alertstatus_compare);
 
 	if (ZBX_DB_DOWN == zbx_db_begin())
 		goto cleanup;
 
 #if defined(HAVE_ORACLE) && 0 == ZBX_MAX_OVERFLOW_SQL_SIZE
 #	define ZBX_SQL_UPDATE_BATCH_SIZE	1
-#	define ZBX_SQL_DELIMITER
+#	define ZBX_SQL_DELIMITER		""
 #else
 #	define ZBX_SQL_UPDATE_BATCH_SIZE	100
 #	define ZBX_SQL_DELIMITER		";\n"
 #endif
 
-	for (i = 0; i < updates.values_num; i += ZBX_SQL_UPDATE_BATCH_SIZE)
+	for (i = 0; i < updates.values_num;)
 	{
 		sql_offset = 0;
 
-		limit = MIN(i + ZBX_SQL_UPDATE_BATCH_SIZE, updates.values_num);
-
 #if !defined(HAVE_ORACLE) || 0 != ZBX_MAX_OVERFLOW_SQL_SIZE
 		DBbegin_multiple_update(&sql, &sql_alloc, &sql_offset);
 #endif
 
-		for (j = i; j < limit; j++)
+		for (statements = 0; statements < ZBX_SQL_UPDATE_BATCH_SIZE && i < updates.values_num; statements++)
 		{
-			update = (zbx_am_alertstatus_t *)updates.values[j];
+			update = (zbx_am_alertstatus_t *)updates.values[i];
+
+			zbx_vector_uint64_clear(&alertids);
+
+			for (; i < updates.values_num && SUCCEED == am_alertstatus_equal(update,
+					(zbx_am_alertstatus_t *)updates.values[i]); i++)
+			{
+				zbx_vector_uint64_append(&alertids, ((zbx_am_alertstatus_t *)updates.values[i])->alertid);
+			}
 
 			error_esc = DBdyn_escape_string_len(update->error, ALERT_ERROR_LEN);
 
@@ -1527,10 +1579,14 @@ static int	am_db_flush_alert_updates(zbx_am_t *manager)
 					" set status=%d,"
 						"retries=%d,"
 						"error='%s'"
-					" where alertid=" ZBX_FS_UI64 ZBX_SQL_DELIMITER,
-					update->status, update->retries, error_esc, update->alertid);
+					" where",
+					update->status, update->retries, error_esc);
 
 			zbx_free(error_esc);
+
+			DBadd_condition_alloc(&sql, &sql_alloc, &sql_offset, "alertid", alertids.values,
+					alertids.values_num);
+			zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, ZBX_SQL_DELIMITER);
 		}
 
 #if !defined(HAVE_ORACLE) || 0 != ZBX_MAX_OVERFLOW_SQL_SIZE
@@ -1553,6 +1609,7 @@ static int	am_db_flush_alert_updates(zbx_am_t *manager)
 	ret = SUCCEED;
 cleanup:
 	zbx_free(sql);
+	zbx_vector_uint64_destroy(&alertids);
 	zbx_vector_ptr_destroy(&updates);
 out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
@@ -34,10 +34,40 @@
 #include "../../libs/zbxcrypto/tls.h"
 
 extern int		CONFIG_DISCOVERER_FORKS;
+extern int		CONFIG_DISCOVERER_CONCURRENCY;
+extern char		*CONFIG_SOURCE_IP;
 extern unsigned char	process_type, program_type;
 extern int		server_num, process_num;
 
 #define ZBX_DISCOVERER_IPRANGE_LIMIT	(1 << 16)
+#define ZBX_DISCOVERER_BATCH_MAX	256		/* maximum number of addresses probed together */
+#define ZBX_DISCOVERER_PROBES_MAX	(1 << 20)	/* maximum number of TCP probe results per batch */
+
+#define ZBX_DISCOVERY_PROBE_NONE	0	/* not probed, the full check must be done */
+#define ZBX_DISCOVERY_PROBE_OPEN	1
+#define ZBX_DISCOVERY_PROBE_CLOSED	2
+#define ZBX_DISCOVERY_PROBE_PENDING	3
+
+typedef struct
+{
+	DB_DCHECK			dcheck;
+
+	/* the port ranges (first, last) */
+	zbx_vector_uint64_pair_t	ports;
+	int				ports_num;
+
+	/* offset of the check ports in per address TCP probe results, -1 if the ports are not probed */
+	int				probe_offset;
+}
+zbx_dcheck_t;
+
+typedef struct
+{
+	ZBX_SOCKET	socket;
+	int		index;
+	double		deadline;
+}
+zbx_discovery_probe_t;
 
 /******************************************************************************
  *                                                                            *
@@ -326,128 +356,504 @@ static int	discover_service(const DB_DCHECK *dcheck, char *ip, int port, char **
 
 /******************************************************************************
  *                                                                            *
- * Function: process_check                                                    *
+ * Function: dcheck_free                                                      *
  *                                                                            *
- * Purpose: check if service is available and update database                 *
+ ******************************************************************************/
+static void	dcheck_free(zbx_dcheck_t *dcheck)
+{
+	zbx_free(dcheck->dcheck.ports);
+	zbx_free(dcheck->dcheck.key_);
+	zbx_free(dcheck->dcheck.snmp_community);
+	zbx_free(dcheck->dcheck.snmpv3_securityname);
+	zbx_free(dcheck->dcheck.snmpv3_authpassphrase);
+	zbx_free(dcheck->dcheck.snmpv3_privpassphrase);
+	zbx_free(dcheck->dcheck.snmpv3_contextname);
+	zbx_vector_uint64_pair_destroy(&dcheck->ports);
+	zbx_free(dcheck);
+}
+
+/******************************************************************************
  *                                                                            *
- * Parameters: service - service info                                         *
+ * Function: dcheck_is_tcp                                                    *
+ *                                                                            *
+ * Purpose: check if the discovery check requires TCP connection              *
  *                                                                            *
  ******************************************************************************/
-static void	process_check(const DB_DCHECK *dcheck, int *host_status, char *ip, int now, zbx_vector_ptr_t *services)
+static int	dcheck_is_tcp(int type)
 {
-	const char	*start;
-	char		*value = NULL;
-	size_t		value_alloc = 128;
-
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+	switch (type)
+	{
+		case SVC_SSH:
+		case SVC_LDAP:
+		case SVC_SMTP:
+		case SVC_FTP:
+		case SVC_HTTP:
+		case SVC_POP:
+		case SVC_NNTP:
+		case SVC_IMAP:
+		case SVC_TCP:
+		case SVC_HTTPS:
+		case SVC_TELNET:
+		case SVC_AGENT:
+			return SUCCEED;
+		default:
+			return FAIL;
+	}
+}
 
-	value = (char *)zbx_malloc(value, value_alloc);
+/******************************************************************************
+ *                                                                            *
+ * Function: dcheck_parse_ports                                               *
+ *                                                                            *
+ * Purpose: parse discovery check port list into port ranges                  *
+ *                                                                            *
+ * Parameters: ports - [IN] the port list, for example "22,80,8000-8080"      *
+ *             pairs - [OUT] the port ranges (first, last)                    *
+ *                                                                            *
+ * Return value: the total number of ports                                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	dcheck_parse_ports(const char *ports, zbx_vector_uint64_pair_t *pairs)
+{
+	const char		*start, *comma, *last_port;
+	int			ports_num = 0;
+	zbx_uint64_pair_t	pair;
 
-	for (start = dcheck->ports; '\0' != *start;)
+	for (start = ports; '\0' != *start; start = comma + 1)
 	{
-		char	*comma, *last_port;
-		int	port, first, last;
+		comma = strchr(start, ',');
 
-		if (NULL != (comma = strchr(start, ',')))
-			*comma = '\0';
-
-		if (NULL != (last_port = strchr(start, '-')))
+		if (NULL != (last_port = strchr(start, '-')) && (NULL == comma || last_port < comma))
 		{
-			*last_port = '\0';
-			first = atoi(start);
-			last = atoi(last_port + 1);
-			*last_port = '-';
+			pair.first = (zbx_uint64_t)atoi(start);
+			pair.second = (zbx_uint64_t)atoi(last_port + 1);
 		}
 		else
-			first = last = atoi(start);
+			pair.first = pair.second = (zbx_uint64_t)atoi(start);
 
-		for (port = first; port <= last; port++)
+		if (pair.first <= pair.second)
 		{
-			zbx_service_t	*service;
-
-			zabbix_log(LOG_LEVEL_DEBUG, "%s() port:%d", __func__, port);
-
-			service = (zbx_service_t *)zbx_malloc(NULL, sizeof(zbx_service_t));
-			service->status = (SUCCEED == discover_service(dcheck, ip, port, &value, &value_alloc) ?
-					DOBJECT_STATUS_UP : DOBJECT_STATUS_DOWN);
-			service->dcheckid = dcheck->dcheckid;
-			service->itemtime = (time_t)now;
-			service->port = port;
-			zbx_strlcpy_utf8(service->value, value, MAX_DISCOVERED_VALUE_SIZE);
-			zbx_vector_ptr_append(services, service);
-
-			/* update host status */
-			if (-1 == *host_status || DOBJECT_STATUS_UP == service->status)
-				*host_status = service->status;
+			zbx_vector_uint64_pair_append(pairs, pair);
+			ports_num += (int)(pair.second - pair.first + 1);
 		}
 
-		if (NULL != comma)
-		{
-			*comma = ',';
-			start = comma + 1;
-		}
-		else
+		if (NULL == comma)
 			break;
 	}
-	zbx_free(value);
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+	return ports_num;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: process_checks                                                   *
+ * Function: discoverer_load_dchecks                                          *
+ *                                                                            *
+ * Purpose: load discovery rule checks                                        *
+ *                                                                            *
+ * Parameters: drule      - [IN] the discovery rule                           *
+ *             dchecks    - [OUT] the discovery checks ordered by dcheckid    *
+ *             dcheckids  - [OUT] sorted discovery check identifiers          *
+ *             probes_num - [OUT] the number of TCP ports probed per address  *
  *                                                                            *
  ******************************************************************************/
-static void	process_checks(const DB_DRULE *drule, int *host_status, char *ip, int unique, int now,
-		zbx_vector_ptr_t *services, zbx_vector_uint64_t *dcheckids)
+static void	discoverer_load_dchecks(const DB_DRULE *drule, zbx_vector_ptr_t *dchecks,
+		zbx_vector_uint64_t *dcheckids, int *probes_num)
 {
 	DB_RESULT	result;
 	DB_ROW		row;
-	DB_DCHECK	dcheck;
-	char		sql[MAX_STRING_LEN];
-	size_t		offset = 0;
+	zbx_dcheck_t	*dcheck;
 
-	offset += zbx_snprintf(sql + offset, sizeof(sql) - offset,
+	result = DBselect(
 			"select dcheckid,type,key_,snmp_community,snmpv3_securityname,snmpv3_securitylevel,"
 				"snmpv3_authpassphrase,snmpv3_privpassphrase,snmpv3_authprotocol,snmpv3_privprotocol,"
 				"ports,snmpv3_contextname"
 			" from dchecks"
-			" where druleid=" ZBX_FS_UI64,
+			" where druleid=" ZBX_FS_UI64
+			" order by dcheckid",
 			drule->druleid);
 
-	if (0 != drule->unique_dcheckid)
+	*probes_num = 0;
+
+	while (NULL != (row = DBfetch(result)))
+	{
+		dcheck = (zbx_dcheck_t *)zbx_malloc(NULL, sizeof(zbx_dcheck_t));
+
+		ZBX_STR2UINT64(dcheck->dcheck.dcheckid, row[0]);
+		dcheck->dcheck.type = atoi(row[1]);
+		dcheck->dcheck.key_ = zbx_strdup(NULL, row[2]);
+		dcheck->dcheck.snmp_community = zbx_strdup(NULL, row[3]);
+		dcheck->dcheck.snmpv3_securityname = zbx_strdup(NULL, row[4]);
+		dcheck->dcheck.snmpv3_securitylevel = (unsigned char)atoi(row[5]);
+		dcheck->dcheck.snmpv3_authpassphrase = zbx_strdup(NULL, row[6]);
+		dcheck->dcheck.snmpv3_privpassphrase = zbx_strdup(NULL, row[7]);
+		dcheck->dcheck.snmpv3_authprotocol = (unsigned char)atoi(row[8]);
+		dcheck->dcheck.snmpv3_privprotocol = (unsigned char)atoi(row[9]);
+		dcheck->dcheck.ports = zbx_strdup(NULL, row[10]);
+		dcheck->dcheck.snmpv3_contextname = zbx_strdup(NULL, row[11]);
+
+		zbx_vector_uint64_pair_create(&dcheck->ports);
+		dcheck->ports_num = dcheck_parse_ports(dcheck->dcheck.ports, &dcheck->ports);
+
+		if (SUCCEED == dcheck_is_tcp(dcheck->dcheck.type))
+		{
+			dcheck->probe_offset = *probes_num;
+			*probes_num += dcheck->ports_num;
+		}
+		else
+			dcheck->probe_offset = -1;
+
+		zbx_vector_ptr_append(dchecks, dcheck);
+		zbx_vector_uint64_append(dcheckids, dcheck->dcheck.dcheckid);
+	}
+	DBfree_result(result);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: discoverer_probe_connect                                         *
+ *                                                                            *
+ * Purpose: start non-blocking TCP connection to the specified address        *
+ *                                                                            *
+ * Parameters: ip        - [IN] the IP address                                *
+ *             port      - [IN] the port                                      *
+ *             socket_fd - [OUT] the socket of pending connection             *
+ *                                                                            *
+ * Return value: ZBX_DISCOVERY_PROBE_PENDING - the connection is in progress, *
+ *                                             socket must be polled          *
+ *               ZBX_DISCOVERY_PROBE_OPEN    - the port accepted connection   *
+ *               ZBX_DISCOVERY_PROBE_CLOSED  - the connection was refused     *
+ *               ZBX_DISCOVERY_PROBE_NONE    - the port cannot be probed      *
+ *                                                                            *
+ ******************************************************************************/
+static int	discoverer_probe_connect(const char *ip, unsigned short port, ZBX_SOCKET *socket_fd)
+{
+	int			ret = ZBX_DISCOVERY_PROBE_NONE;
+	const struct sockaddr	*addr;
+	socklen_t		addrlen;
+#ifdef HAVE_IPV6
+	struct addrinfo		hints, *ai = NULL, *ai_bind = NULL;
+	char			service[8];
+
+	zbx_snprintf(service, sizeof(service), "%hu", port);
+	memset(&hints, 0x00, sizeof(struct addrinfo));
+	hints.ai_family = PF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_NUMERICHOST;
+
+	if (0 != getaddrinfo(ip, service, &hints, &ai))
+		goto out;
+
+	addr = ai->ai_addr;
+	addrlen = (socklen_t)ai->ai_addrlen;
+
+	if (ZBX_SOCKET_ERROR == (*socket_fd = socket(ai->ai_family, SOCK_STREAM, 0)))
+		goto out;
+
+	if (NULL != CONFIG_SOURCE_IP)
 	{
-		offset += zbx_snprintf(sql + offset, sizeof(sql) - offset, " and dcheckid%s" ZBX_FS_UI64,
-				unique ? "=" : "<>", drule->unique_dcheckid);
+		hints.ai_family = ai->ai_family;
+
+		if (0 != getaddrinfo(CONFIG_SOURCE_IP, NULL, &hints, &ai_bind) ||
+				ZBX_PROTO_ERROR == zbx_bind(*socket_fd, ai_bind->ai_addr, ai_bind->ai_addrlen))
+		{
+			goto close;
+		}
 	}
+#else
+	struct sockaddr_in	servaddr_in, source_addr;
 
-	zbx_snprintf(sql + offset, sizeof(sql) - offset, " order by dcheckid");
+	memset(&servaddr_in, 0, sizeof(servaddr_in));
+	servaddr_in.sin_family = AF_INET;
+	servaddr_in.sin_addr.s_addr = inet_addr(ip);
+	servaddr_in.sin_port = htons(port);
 
-	result = DBselect("%s", sql);
+	addr = (struct sockaddr *)&servaddr_in;
+	addrlen = sizeof(servaddr_in);
 
-	while (NULL != (row = DBfetch(result)))
+	if (ZBX_SOCKET_ERROR == (*socket_fd = socket(AF_INET, SOCK_STREAM, 0)))
+		goto out;
+
+	if (NULL != CONFIG_SOURCE_IP)
 	{
-		memset(&dcheck, 0, sizeof(dcheck));
-
-		ZBX_STR2UINT64(dcheck.dcheckid, row[0]);
-		dcheck.type = atoi(row[1]);
-		dcheck.key_ = row[2];
-		dcheck.snmp_community = row[3];
-		dcheck.snmpv3_securityname = row[4];
-		dcheck.snmpv3_securitylevel = (unsigned char)atoi(row[5]);
-		dcheck.snmpv3_authpassphrase = row[6];
-		dcheck.snmpv3_privpassphrase = row[7];
-		dcheck.snmpv3_authprotocol = (unsigned char)atoi(row[8]);
-		dcheck.snmpv3_privprotocol = (unsigned char)atoi(row[9]);
-		dcheck.ports = row[10];
-		dcheck.snmpv3_contextname = row[11];
-
-		zbx_vector_uint64_append(dcheckids, dcheck.dcheckid);
-
-		process_check(&dcheck, host_status, ip, now, services);
+		memset(&source_addr, 0, sizeof(source_addr));
+		source_addr.sin_family = AF_INET;
+		source_addr.sin_addr.s_addr = inet_addr(CONFIG_SOURCE_IP);
+		source_addr.sin_port = 0;
+
+		if (ZBX_PROTO_ERROR == zbx_bind(*socket_fd, (struct sockaddr *)&source_addr, sizeof(source_addr)))
+			goto close;
 	}
-	DBfree_result(result);
+#endif
+	/* select() cannot monitor descriptors above FD_SETSIZE, leave such ports for the full check */
+	if (FD_SETSIZE <= *socket_fd || -1 == fcntl(*socket_fd, F_SETFL, fcntl(*socket_fd, F_GETFL) | O_NONBLOCK))
+		goto close;
+
+	fcntl(*socket_fd, F_SETFD, FD_CLOEXEC);
+
+	if (ZBX_PROTO_ERROR != connect(*socket_fd, addr, addrlen))
+		ret = ZBX_DISCOVERY_PROBE_OPEN;
+	else if (EINPROGRESS == zbx_socket_last_error())
+		ret = ZBX_DISCOVERY_PROBE_PENDING;
+	else
+		ret = ZBX_DISCOVERY_PROBE_CLOSED;
+close:
+	if (ZBX_DISCOVERY_PROBE_PENDING != ret)
+		zbx_socket_close(*socket_fd);
+out:
+#ifdef HAVE_IPV6
+	if (NULL != ai)
+		freeaddrinfo(ai);
+
+	if (NULL != ai_bind)
+		freeaddrinfo(ai_bind);
+#endif
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: discoverer_probe_tcp                                             *
+ *                                                                            *
+ * Purpose: probe TCP ports of a batch of addresses with non-blocking         *
+ *          connections                                                       *
+ *                                                                            *
+ * Parameters: ips        - [IN] the addresses to probe                       *
+ *             ports      - [IN] the ports to probe on each address           *
+ *             probes_num - [IN] the number of ports                          *
+ *             probes     - [OUT] the probe results, probes_num per address   *
+ *                                                                            *
+ * Comments: Up to CONFIG_DISCOVERER_CONCURRENCY connections are kept in      *
+ *           flight. Connections not established within CONFIG_TIMEOUT are    *
+ *           treated as closed ports - the full service check would fail in   *
+ *           the same way.                                                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	discoverer_probe_tcp(const zbx_vector_str_t *ips, const unsigned short *ports, int probes_num,
+		unsigned char *probes)
+{
+	zbx_discovery_probe_t	*inflight;
+	int			inflight_num = 0, next = 0, total, i, rc, open_num = 0;
+	double			now, deadline;
+	fd_set			fdw;
+	ZBX_SOCKET		max_fd;
+	struct timeval		tv;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() addresses:%d ports:%d", __func__, ips->values_num, probes_num);
+
+	total = ips->values_num * probes_num;
+	inflight = (zbx_discovery_probe_t *)zbx_malloc(NULL, sizeof(zbx_discovery_probe_t) *
+			CONFIG_DISCOVERER_CONCURRENCY);
+
+	while (next < total || 0 != inflight_num)
+	{
+		now = zbx_time();
+
+		for (; next < total && inflight_num < CONFIG_DISCOVERER_CONCURRENCY; next++)
+		{
+			zbx_discovery_probe_t	*probe = &inflight[inflight_num];
+
+			probes[next] = (unsigned char)discoverer_probe_connect(ips->values[next / probes_num],
+					ports[next % probes_num], &probe->socket);
+
+			if (ZBX_DISCOVERY_PROBE_PENDING != probes[next])
+				continue;
+
+			probe->index = next;
+			probe->deadline = now + CONFIG_TIMEOUT;
+			inflight_num++;
+		}
+
+		if (0 == inflight_num)
+			continue;
+
+		FD_ZERO(&fdw);
+		max_fd = inflight[0].socket;
+		deadline = inflight[0].deadline;
+
+		for (i = 0; i < inflight_num; i++)
+		{
+			FD_SET(inflight[i].socket, &fdw);
+
+			if (max_fd < inflight[i].socket)
+				max_fd = inflight[i].socket;
+
+			if (deadline > inflight[i].deadline)
+				deadline = inflight[i].deadline;
+		}
+
+		if (0 > (deadline -= now))
+			deadline = 0;
+
+		tv.tv_sec = (time_t)deadline;
+		tv.tv_usec = (suseconds_t)((deadline - tv.tv_sec) * 1000000);
+
+		if (-1 == (rc = select(ZBX_SOCKET_TO_INT(max_fd) + 1, NULL, &fdw, NULL, &tv)) && EINTR != errno)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot probe discovered ports: %s", zbx_strerror(errno));
+			break;
+		}
+
+		now = zbx_time();
+
+		for (i = 0; i < inflight_num; i++)
+		{
+			zbx_discovery_probe_t	*probe = &inflight[i];
+			int			socket_error = 0;
+			socklen_t		socket_error_len = sizeof(socket_error);
+
+			if (0 < rc && FD_ISSET(probe->socket, &fdw))
+			{
+				if (ZBX_PROTO_ERROR != getsockopt(probe->socket, SOL_SOCKET, SO_ERROR, &socket_error,
+						&socket_error_len) && 0 == socket_error)
+				{
+					probes[probe->index] = ZBX_DISCOVERY_PROBE_OPEN;
+				}
+				else
+					probes[probe->index] = ZBX_DISCOVERY_PROBE_CLOSED;
+			}
+			else if (probe->deadline <= now)
+				probes[probe->index] = ZBX_DISCOVERY_PROBE_CLOSED;
+			else
+				continue;
+
+			zbx_socket_close(probe->socket);
+			inflight[i--] = inflight[--inflight_num];
+		}
+	}
+
+	/* leave the remaining ports for the full check if probing was aborted */
+	for (i = 0; i < inflight_num; i++)
+	{
+		probes[inflight[i].index] = ZBX_DISCOVERY_PROBE_NONE;
+		zbx_socket_close(inflight[i].socket);
+	}
+
+	for (; next < total; next++)
+		probes[next] = ZBX_DISCOVERY_PROBE_NONE;
+
+	zbx_free(inflight);
+
+	if (SUCCEED == ZBX_CHECK_LOG_LEVEL(LOG_LEVEL_DEBUG))
+	{
+		for (i = 0; i < total; i++)
+		{
+			if (ZBX_DISCOVERY_PROBE_OPEN == probes[i])
+				open_num++;
+		}
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() open:%d", __func__, open_num);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: discoverer_ping                                                  *
+ *                                                                            *
+ * Purpose: ping a batch of addresses with a single fping invocation          *
+ *                                                                            *
+ * Parameters: ips   - [IN] the addresses to ping                             *
+ *             alive - [OUT] SUCCEED/FAIL per address                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	discoverer_ping(const zbx_vector_str_t *ips, int *alive)
+{
+	ZBX_FPING_HOST	*hosts;
+	int		i, offset, hosts_num;
+	char		error[ITEM_ERROR_LEN_MAX];
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() addresses:%d", __func__, ips->values_num);
+
+	hosts = (ZBX_FPING_HOST *)zbx_malloc(NULL, sizeof(ZBX_FPING_HOST) * CONFIG_DISCOVERER_CONCURRENCY);
+
+	for (offset = 0; offset < ips->values_num; offset += hosts_num)
+	{
+		hosts_num = MIN(ips->values_num - offset, CONFIG_DISCOVERER_CONCURRENCY);
+		memset(hosts, 0, sizeof(ZBX_FPING_HOST) * hosts_num);
+
+		for (i = 0; i < hosts_num; i++)
+			hosts[i].addr = ips->values[offset + i];
+
+		if (SUCCEED != do_ping(hosts, hosts_num, 3, 0, 0, 0, error, sizeof(error)))
+			zabbix_log(LOG_LEVEL_DEBUG, "%s() cannot ping addresses: %s", __func__, error);
+
+		for (i = 0; i < hosts_num; i++)
+			alive[offset + i] = (0 != hosts[i].rcv ? SUCCEED : FAIL);
+	}
+
+	zbx_free(hosts);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: process_check                                                    *
+ *                                                                            *
+ * Purpose: check if service is available and update database                 *
+ *                                                                            *
+ * Parameters: dcheck      - [IN] the discovery check                         *
+ *             host_status - [IN/OUT] the discovered host status              *
+ *             ip          - [IN] the address being checked                   *
+ *             probes      - [IN] the TCP probe results of the address        *
+ *             alive       - [IN] the ICMP ping result of the address         *
+ *             now         - [IN] the check time                              *
+ *             services    - [OUT] the discovered services                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	process_check(const zbx_dcheck_t *dcheck, int *host_status, char *ip, const unsigned char *probes,
+		int alive, int now, zbx_vector_ptr_t *services)
+{
+	char		*value = NULL;
+	size_t		value_alloc = 128;
+	int		i, port, probe_index = dcheck->probe_offset, status;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	value = (char *)zbx_malloc(value, value_alloc);
+
+	for (i = 0; i < dcheck->ports.values_num; i++)
+	{
+		for (port = (int)dcheck->ports.values[i].first; port <= (int)dcheck->ports.values[i].second; port++)
+		{
+			zbx_service_t	*service;
+			unsigned char	probe = ZBX_DISCOVERY_PROBE_NONE;
+
+			zabbix_log(LOG_LEVEL_DEBUG, "%s() port:%d", __func__, port);
+
+			*value = '\0';
+
+			if (-1 != dcheck->probe_offset)
+				probe = probes[probe_index++];
+
+			/* ICMP and plain TCP checks are fully answered by the batch results, other services */
+			/* are checked only on the ports that accepted a connection                          */
+			if (SVC_ICMPPING == dcheck->dcheck.type)
+				status = (SUCCEED == alive ? DOBJECT_STATUS_UP : DOBJECT_STATUS_DOWN);
+			else if (ZBX_DISCOVERY_PROBE_CLOSED == probe)
+				status = DOBJECT_STATUS_DOWN;
+			else if (ZBX_DISCOVERY_PROBE_OPEN == probe && SVC_TCP == dcheck->dcheck.type)
+				status = DOBJECT_STATUS_UP;
+			else if (SUCCEED == discover_service(&dcheck->dcheck, ip, port, &value, &value_alloc))
+				status = DOBJECT_STATUS_UP;
+			else
+				status = DOBJECT_STATUS_DOWN;
+
+			service = (zbx_service_t *)zbx_malloc(NULL, sizeof(zbx_service_t));
+			service->status = status;
+			service->dcheckid = dcheck->dcheck.dcheckid;
+			service->itemtime = (time_t)now;
+			service->port = port;
+			zbx_strlcpy_utf8(service->value, value, MAX_DISCOVERED_VALUE_SIZE);
+			zbx_vector_ptr_append(services, service);
+
+			/* update host status */
+			if (-1 == *host_status || DOBJECT_STATUS_UP == service->status)
+				*host_status = service->status;
+		}
+	}
+	zbx_free(value);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
 /******************************************************************************
@@ -462,8 +868,6 @@ static int	process_services(const DB_DRULE *drule, DB_DHOST *dhost, const char *
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_vector_uint64_sort(dcheckids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-
 	if (SUCCEED != (ret = DBlock_ids("dchecks", "dcheckid", dcheckids)))
 		goto fail;
 
@@ -491,6 +895,127 @@ fail:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: process_batch                                                    *
+ *                                                                            *
+ * Purpose: discover a batch of addresses                                     *
+ *                                                                            *
+ * Parameters: drule      - [IN] the discovery rule                           *
+ *             dchecks    - [IN] the discovery checks                         *
+ *             dcheckids  - [IN/OUT] the discovery check identifiers, deleted *
+ *                                   checks are removed                       *
+ *             ips        - [IN] the addresses to discover                    *
+ *             ports      - [IN] the TCP ports probed on each address         *
+ *             probes_num - [IN] the number of probed TCP ports               *
+ *             ping       - [IN] SUCCEED if ICMP checks are defined           *
+ *                                                                            *
+ * Return value: SUCCEED - the batch was processed                            *
+ *               FAIL    - the discovery rule or all its checks were deleted  *
+ *                                                                            *
+ * Comments: TCP ports and ICMP reachability of all batch addresses are       *
+ *           probed in parallel first, then the remaining checks are done     *
+ *           and the results are saved address by address.                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	process_batch(const DB_DRULE *drule, const zbx_vector_ptr_t *dchecks, zbx_vector_uint64_t *dcheckids,
+		const zbx_vector_str_t *ips, const unsigned short *ports, int probes_num, int ping)
+{
+	DB_DHOST		dhost;
+	int			host_status, now, i, j, *alive, ret = SUCCEED;
+	char			dns[INTERFACE_DNS_LEN_MAX];
+	unsigned char		*probes = NULL;
+	zbx_vector_ptr_t	services;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() addresses:%d", __func__, ips->values_num);
+
+	zbx_vector_ptr_create(&services);
+	alive = (int *)zbx_calloc(NULL, ips->values_num, sizeof(int));
+
+	if (0 != probes_num)
+	{
+		probes = (unsigned char *)zbx_malloc(NULL, (size_t)ips->values_num * probes_num);
+		discoverer_probe_tcp(ips, ports, probes_num, probes);
+	}
+
+	if (SUCCEED == ping)
+		discoverer_ping(ips, alive);
+
+	for (i = 0; i < ips->values_num; i++)
+	{
+		char		*ip = ips->values[i];
+		unsigned char	*ip_probes = (NULL != probes ? probes + (size_t)i * probes_num : NULL);
+
+		memset(&dhost, 0, sizeof(dhost));
+		host_status = -1;
+
+		now = time(NULL);
+
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() ip:'%s'", __func__, ip);
+
+		zbx_alarm_on(CONFIG_TIMEOUT);
+		zbx_gethost_by_ip(ip, dns, sizeof(dns));
+		zbx_alarm_off();
+
+		/* the unique check must be processed first */
+		for (j = 0; j < dchecks->values_num; j++)
+		{
+			const zbx_dcheck_t	*dcheck = (const zbx_dcheck_t *)dchecks->values[j];
+
+			if (dcheck->dcheck.dcheckid == drule->unique_dcheckid)
+				process_check(dcheck, &host_status, ip, ip_probes, alive[i], now, &services);
+		}
+
+		for (j = 0; j < dchecks->values_num; j++)
+		{
+			const zbx_dcheck_t	*dcheck = (const zbx_dcheck_t *)dchecks->values[j];
+
+			if (dcheck->dcheck.dcheckid != drule->unique_dcheckid)
+				process_check(dcheck, &host_status, ip, ip_probes, alive[i], now, &services);
+		}
+
+		DBbegin();
+
+		if (SUCCEED != DBlock_druleid(drule->druleid))
+		{
+			DBrollback();
+
+			zabbix_log(LOG_LEVEL_DEBUG, "discovery rule '%s' was deleted during processing,"
+					" stopping", drule->name);
+			ret = FAIL;
+			break;
+		}
+
+		if (SUCCEED != process_services(drule, &dhost, ip, dns, now, &services, dcheckids))
+		{
+			DBrollback();
+
+			zabbix_log(LOG_LEVEL_DEBUG, "all checks where deleted for discovery rule '%s'"
+					" during processing, stopping", drule->name);
+			ret = FAIL;
+			break;
+		}
+
+		zbx_vector_ptr_clear_ext(&services, zbx_ptr_free);
+
+		if (0 != (program_type & ZBX_PROGRAM_TYPE_SERVER))
+			discovery_update_host(&dhost, host_status, now);
+		else if (0 != (program_type & ZBX_PROGRAM_TYPE_PROXY))
+			proxy_update_host(drule->druleid, ip, dns, host_status, now);
+
+		DBcommit();
+	}
+
+	zbx_vector_ptr_clear_ext(&services, zbx_ptr_free);
+	zbx_vector_ptr_destroy(&services);
+	zbx_free(probes);
+	zbx_free(alive);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: process_rule                                                     *
@@ -500,18 +1025,55 @@ fail:
  ******************************************************************************/
 static void	process_rule(DB_DRULE *drule)
 {
-	DB_DHOST		dhost;
-	int			host_status, now;
-	char			ip[INTERFACE_IP_LEN_MAX], *start, *comma, dns[INTERFACE_DNS_LEN_MAX];
-	int			ipaddress[8];
+	char			ip[INTERFACE_IP_LEN_MAX], *start, *comma;
+	int			ipaddress[8], i, j, port, probes_num, batch_max, ping = FAIL;
+	unsigned short		*ports = NULL;
 	zbx_iprange_t		iprange;
-	zbx_vector_ptr_t	services;
+	zbx_vector_ptr_t	dchecks;
 	zbx_vector_uint64_t	dcheckids;
+	zbx_vector_str_t	ips;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() rule:'%s' range:'%s'", __func__, drule->name, drule->iprange);
 
-	zbx_vector_ptr_create(&services);
+	zbx_vector_ptr_create(&dchecks);
 	zbx_vector_uint64_create(&dcheckids);
+	zbx_vector_str_create(&ips);
+
+	discoverer_load_dchecks(drule, &dchecks, &dcheckids, &probes_num);
+	zbx_vector_uint64_sort(&dcheckids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	if (0 == dchecks.values_num)
+		goto out;
+
+	/* list of the TCP ports probed on every address, in the order of the probe results */
+	if (0 != probes_num)
+		ports = (unsigned short *)zbx_malloc(NULL, sizeof(unsigned short) * probes_num);
+
+	for (i = 0; i < dchecks.values_num; i++)
+	{
+		const zbx_dcheck_t	*dcheck = (const zbx_dcheck_t *)dchecks.values[i];
+		int			index = dcheck->probe_offset;
+
+		if (SVC_ICMPPING == dcheck->dcheck.type)
+			ping = SUCCEED;
+
+		if (-1 == index)
+			continue;
+
+		for (j = 0; j < dcheck->ports.values_num; j++)
+		{
+			for (port = (int)dcheck->ports.values[j].first; port <= (int)dcheck->ports.values[j].second;
+					port++)
+			{
+				ports[index++] = (unsigned short)port;
+			}
+		}
+	}
+
+	batch_max = ZBX_DISCOVERER_BATCH_MAX;
+
+	if (0 != probes_num && batch_max > ZBX_DISCOVERER_PROBES_MAX / probes_num)
+		batch_max = MAX(1, ZBX_DISCOVERER_PROBES_MAX / probes_num);
 
 	for (start = drule->iprange; '\0' != *start;)
 	{
@@ -563,52 +1125,15 @@ static void	process_rule(DB_DRULE *drule)
 #ifdef HAVE_IPV6
 			}
 #endif
-			memset(&dhost, 0, sizeof(dhost));
-			host_status = -1;
-
-			now = time(NULL);
-
-			zabbix_log(LOG_LEVEL_DEBUG, "%s() ip:'%s'", __func__, ip);
-
-			zbx_alarm_on(CONFIG_TIMEOUT);
-			zbx_gethost_by_ip(ip, dns, sizeof(dns));
-			zbx_alarm_off();
-
-			if (0 != drule->unique_dcheckid)
-				process_checks(drule, &host_status, ip, 1, now, &services, &dcheckids);
-			process_checks(drule, &host_status, ip, 0, now, &services, &dcheckids);
-
-			DBbegin();
-
-			if (SUCCEED != DBlock_druleid(drule->druleid))
-			{
-				DBrollback();
+			zbx_vector_str_append(&ips, zbx_strdup(NULL, ip));
 
-				zabbix_log(LOG_LEVEL_DEBUG, "discovery rule '%s' was deleted during processing,"
-						" stopping", drule->name);
-				zbx_vector_ptr_clear_ext(&services, zbx_ptr_free);
-				goto out;
-			}
-
-			if (SUCCEED != process_services(drule, &dhost, ip, dns, now, &services, &dcheckids))
-			{
-				DBrollback();
+			if (batch_max > ips.values_num)
+				continue;
 
-				zabbix_log(LOG_LEVEL_DEBUG, "all checks where deleted for discovery rule '%s'"
-						" during processing, stopping", drule->name);
-				zbx_vector_ptr_clear_ext(&services, zbx_ptr_free);
+			if (SUCCEED != process_batch(drule, &dchecks, &dcheckids, &ips, ports, probes_num, ping))
 				goto out;
-			}
-
-			zbx_vector_uint64_clear(&dcheckids);
-			zbx_vector_ptr_clear_ext(&services, zbx_ptr_free);
-
-			if (0 != (program_type & ZBX_PROGRAM_TYPE_SERVER))
-				discovery_update_host(&dhost, host_status, now);
-			else if (0 != (program_type & ZBX_PROGRAM_TYPE_PROXY))
-				proxy_update_host(drule->druleid, ip, dns, host_status, now);
 
-			DBcommit();
+			zbx_vector_str_clear_ext(&ips, zbx_str_free);
 		}
 		while (SUCCEED == iprange_next(&iprange, ipaddress));
 next:
@@ -620,8 +1145,15 @@ next:
 		else
 			break;
 	}
+
+	if (0 != ips.values_num)
+		process_batch(drule, &dchecks, &dcheckids, &ips, ports, probes_num, ping);
 out:
-	zbx_vector_ptr_destroy(&services);
+	zbx_free(ports);
+	zbx_vector_str_clear_ext(&ips, zbx_str_free);
+	zbx_vector_str_destroy(&ips);
+	zbx_vector_ptr_clear_ext(&dchecks, (zbx_clean_func_t)dcheck_free);
+	zbx_vector_ptr_destroy(&dchecks);
 	zbx_vector_uint64_destroy(&dcheckids);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
@@ -68,6 +68,28 @@ typedef struct
 }
 zbx_tag_filter_t;
 
+/* user permission data, cached for the duration of one escalation batch */
+typedef struct
+{
+	zbx_uint64_t			userid;
+	int				type;
+	int				perm2system;
+	zbx_vector_uint64_pair_t	rights;		/* host group id, permission pairs sorted by group id */
+	zbx_vector_ptr_t		tag_filters;
+}
+zbx_user_perm_t;
+
+/* host groups of trigger hosts, cached for the duration of one escalation batch */
+typedef struct
+{
+	zbx_uint64_t		triggerid;
+	zbx_vector_uint64_t	hostgroupids;
+}
+zbx_trigger_hostgroups_t;
+
+static zbx_hashset_t	user_perms;
+static zbx_hashset_t	trigger_hostgroups;
+
 static void	zbx_tag_filter_free(zbx_tag_filter_t *tag_filter)
 {
 	zbx_free(tag_filter->tag);
@@ -84,20 +106,80 @@ static void	add_message_alert(const DB_EVENT *event, const DB_EVENT *r_event, zb
 
 /******************************************************************************
  *                                                                            *
- * Function: check_perm2system                                                *
+ * Function: perm_cache_clear                                                 *
  *                                                                            *
- * Purpose: Check user permissions to access system                           *
+ * Purpose: removes cached user permissions and trigger host groups           *
+ *                                                                            *
+ * Comments: The cache is cleared after each escalation batch, so             *
+ *           configuration changes are picked up by the next batch.           *
+ *                                                                            *
+ ******************************************************************************/
+static void	perm_cache_clear(void)
+{
+	zbx_hashset_iter_t		iter;
+	zbx_user_perm_t			*user_perm;
+	zbx_trigger_hostgroups_t	*trigger;
+
+	zbx_hashset_iter_reset(&user_perms, &iter);
+
+	while (NULL != (user_perm = (zbx_user_perm_t *)zbx_hashset_iter_next(&iter)))
+	{
+		zbx_vector_uint64_pair_destroy(&user_perm->rights);
+		zbx_vector_ptr_clear_ext(&user_perm->tag_filters, (zbx_clean_func_t)zbx_tag_filter_free);
+		zbx_vector_ptr_destroy(&user_perm->tag_filters);
+	}
+
+	zbx_hashset_clear(&user_perms);
+
+	zbx_hashset_iter_reset(&trigger_hostgroups, &iter);
+
+	while (NULL != (trigger = (zbx_trigger_hostgroups_t *)zbx_hashset_iter_next(&iter)))
+		zbx_vector_uint64_destroy(&trigger->hostgroupids);
+
+	zbx_hashset_clear(&trigger_hostgroups);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: get_user_perm                                                    *
+ *                                                                            *
+ * Purpose: gets user type, system access, host group rights and tag filters  *
  *                                                                            *
  * Parameters: userid - user ID                                               *
  *                                                                            *
- * Return value: SUCCEED - access allowed, FAIL - otherwise                   *
+ * Return value: the cached user permission data                              *
+ *                                                                            *
+ * Comments: User data is read from database once per escalation batch        *
+ *           instead of once per message recipient.                           *
  *                                                                            *
  ******************************************************************************/
-static int	check_perm2system(zbx_uint64_t userid)
+static const zbx_user_perm_t	*get_user_perm(zbx_uint64_t userid)
 {
-	DB_RESULT	result;
-	DB_ROW		row;
-	int		res = SUCCEED;
+	DB_RESULT		result;
+	DB_ROW			row;
+	zbx_user_perm_t		*user_perm, user_perm_local;
+	zbx_uint64_pair_t	right;
+	zbx_tag_filter_t	*tag_filter;
+
+	if (NULL != (user_perm = (zbx_user_perm_t *)zbx_hashset_search(&user_perms, &userid)))
+		return user_perm;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() userid:" ZBX_FS_UI64, __func__, userid);
+
+	user_perm_local.userid = userid;
+	user_perm_local.type = -1;
+	user_perm_local.perm2system = SUCCEED;
+
+	user_perm = (zbx_user_perm_t *)zbx_hashset_insert(&user_perms, &user_perm_local, sizeof(user_perm_local));
+	zbx_vector_uint64_pair_create(&user_perm->rights);
+	zbx_vector_ptr_create(&user_perm->tag_filters);
+
+	result = DBselect("select type from users where userid=" ZBX_FS_UI64, userid);
+
+	if (NULL != (row = DBfetch(result)) && FAIL == DBis_null(row[0]))
+		user_perm->type = atoi(row[0]);
+
+	DBfree_result(result);
 
 	result = DBselect(
 			"select count(*)"
@@ -108,27 +190,70 @@ static int	check_perm2system(zbx_uint64_t userid)
 			userid, GROUP_STATUS_DISABLED);
 
 	if (NULL != (row = DBfetch(result)) && SUCCEED != DBis_null(row[0]) && atoi(row[0]) > 0)
-		res = FAIL;
+		user_perm->perm2system = FAIL;
 
 	DBfree_result(result);
 
-	return res;
-}
+	result = DBselect(
+			"select r.id,min(r.permission)"
+			" from rights r"
+			" join users_groups ug on ug.usrgrpid=r.groupid"
+				" where ug.userid=" ZBX_FS_UI64
+			" group by r.id",
+			userid);
 
-static	int	get_user_type(zbx_uint64_t userid)
-{
-	int		user_type = -1;
-	DB_RESULT	result;
-	DB_ROW		row;
+	while (NULL != (row = DBfetch(result)))
+	{
+		ZBX_STR2UINT64(right.first, row[0]);
+		right.second = (zbx_uint64_t)atoi(row[1]);
+		zbx_vector_uint64_pair_append(&user_perm->rights, right);
+	}
+	DBfree_result(result);
 
-	result = DBselect("select type from users where userid=" ZBX_FS_UI64, userid);
+	zbx_vector_uint64_pair_sort(&user_perm->rights, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
-	if (NULL != (row = DBfetch(result)) && FAIL == DBis_null(row[0]))
-		user_type = atoi(row[0]);
+	result = DBselect(
+			"select tf.groupid,tf.tag,tf.value from tag_filter tf"
+			" join users_groups ug on ug.usrgrpid=tf.usrgrpid"
+				" where ug.userid=" ZBX_FS_UI64
+			" order by tf.groupid",
+			userid);
 
+	while (NULL != (row = DBfetch(result)))
+	{
+		tag_filter = (zbx_tag_filter_t *)zbx_malloc(NULL, sizeof(zbx_tag_filter_t));
+		ZBX_STR2UINT64(tag_filter->hostgroupid, row[0]);
+		tag_filter->tag = zbx_strdup(NULL, row[1]);
+		tag_filter->value = zbx_strdup(NULL, row[2]);
+		zbx_vector_ptr_append(&user_perm->tag_filters, tag_filter);
+	}
 	DBfree_result(result);
 
-	return user_type;
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() rights:%d tag filters:%d", __func__, user_perm->rights.values_num,
+			user_perm->tag_filters.values_num);
+
+	return user_perm;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: check_perm2system                                                *
+ *                                                                            *
+ * Purpose: Check user permissions to access system                           *
+ *                                                                            *
+ * Parameters: userid - user ID                                               *
+ *                                                                            *
+ * Return value: SUCCEED - access allowed, FAIL - otherwise                   *
+ *                                                                            *
+ ******************************************************************************/
+static int	check_perm2system(zbx_uint64_t userid)
+{
+	return get_user_perm(userid)->perm2system;
+}
+
+static	int	get_user_type(zbx_uint64_t userid)
+{
+	return get_user_perm(userid)->type;
 }
 
 /******************************************************************************
@@ -143,33 +268,37 @@ static	int	get_user_type(zbx_uint64_t userid)
  *                   or permission otherwise                                  *
  *                                                                            *
  ******************************************************************************/
-static int	get_hostgroups_permission(zbx_uint64_t userid, zbx_vector_uint64_t *hostgroupids)
+static int	get_hostgroups_permission(zbx_uint64_t userid, const zbx_vector_uint64_t *hostgroupids)
 {
-	int		perm = PERM_DENY;
-	char		*sql = NULL;
-	size_t		sql_alloc = 0, sql_offset = 0;
-	DB_RESULT	result;
-	DB_ROW		row;
+	int			perm = PERM_DENY, right_perm, found = FAIL, i, index;
+	const zbx_user_perm_t	*user_perm;
+	zbx_uint64_pair_t	right;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	if (0 == hostgroupids->values_num)
 		goto out;
 
-	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
-			"select min(r.permission)"
-			" from rights r"
-			" join users_groups ug on ug.usrgrpid=r.groupid"
-				" where ug.userid=" ZBX_FS_UI64 " and", userid);
-	DBadd_condition_alloc(&sql, &sql_alloc, &sql_offset, "r.id",
-			hostgroupids->values, hostgroupids->values_num);
-	result = DBselect("%s", sql);
+	user_perm = get_user_perm(userid);
 
-	if (NULL != (row = DBfetch(result)) && FAIL == DBis_null(row[0]))
-		perm = atoi(row[0]);
+	for (i = 0; i < hostgroupids->values_num; i++)
+	{
+		right.first = hostgroupids->values[i];
 
-	DBfree_result(result);
-	zbx_free(sql);
+		if (FAIL == (index = zbx_vector_uint64_pair_bsearch(&user_perm->rights, right,
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC)))
+		{
+			continue;
+		}
+
+		right_perm = (int)user_perm->rights.values[index].second;
+
+		if (FAIL == found || right_perm < perm)
+		{
+			perm = right_perm;
+			found = SUCCEED;
+		}
+	}
 out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_permission_string(perm));
 
@@ -191,49 +320,28 @@ out:
  *               FAIL    - user does not have access                          *
  *                                                                            *
  ******************************************************************************/
-static int	check_tag_based_permission(zbx_uint64_t userid, zbx_vector_uint64_t *hostgroupids,
+static int	check_tag_based_permission(zbx_uint64_t userid, const zbx_vector_uint64_t *hostgroupids,
 		const DB_EVENT *event)
 {
-	char			*sql = NULL, hostgroupid[ZBX_MAX_UINT64_LEN + 1];
-	size_t			sql_alloc = 0, sql_offset = 0;
-	DB_RESULT		result;
-	DB_ROW			row;
 	int			ret = FAIL, i;
-	zbx_vector_ptr_t	tag_filters;
+	const zbx_user_perm_t	*user_perm;
 	zbx_tag_filter_t	*tag_filter;
 	DB_CONDITION		condition;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_vector_ptr_create(&tag_filters);
-
-	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
-			"select tf.groupid,tf.tag,tf.value from tag_filter tf"
-			" join users_groups ug on ug.usrgrpid=tf.usrgrpid"
-				" where ug.userid=" ZBX_FS_UI64, userid);
-	result = DBselect("%s order by tf.groupid", sql);
-
-	while (NULL != (row = DBfetch(result)))
-	{
-		tag_filter = (zbx_tag_filter_t *)zbx_malloc(NULL, sizeof(zbx_tag_filter_t));
-		ZBX_STR2UINT64(tag_filter->hostgroupid, row[0]);
-		tag_filter->tag = zbx_strdup(NULL, row[1]);
-		tag_filter->value = zbx_strdup(NULL, row[2]);
-		zbx_vector_ptr_append(&tag_filters, tag_filter);
-	}
-	zbx_free(sql);
-	DBfree_result(result);
+	user_perm = get_user_perm(userid);
 
-	if (0 < tag_filters.values_num)
+	if (0 < user_perm->tag_filters.values_num)
 		condition.op = CONDITION_OPERATOR_EQUAL;
 	else
 		ret = SUCCEED;
 
-	for (i = 0; i < tag_filters.values_num && SUCCEED != ret; i++)
+	for (i = 0; i < user_perm->tag_filters.values_num && SUCCEED != ret; i++)
 	{
-		tag_filter = (zbx_tag_filter_t *)tag_filters.values[i];
+		tag_filter = (zbx_tag_filter_t *)user_perm->tag_filters.values[i];
 
-		if (FAIL == zbx_vector_uint64_search(hostgroupids, tag_filter->hostgroupid,
+		if (FAIL == zbx_vector_uint64_bsearch(hostgroupids, tag_filter->hostgroupid,
 				ZBX_DEFAULT_UINT64_COMPARE_FUNC))
 		{
 			continue;
@@ -241,8 +349,6 @@ static int	check_tag_based_permission(zbx_uint64_t userid, zbx_vector_uint64_t *
 
 		if (NULL != tag_filter->tag && 0 != strlen(tag_filter->tag))
 		{
-			zbx_snprintf(hostgroupid, sizeof(hostgroupid), ZBX_FS_UI64, tag_filter->hostgroupid);
-
 			if (NULL != tag_filter->value && 0 != strlen(tag_filter->value))
 			{
 				condition.conditiontype = CONDITION_TYPE_EVENT_TAG_VALUE;
@@ -260,8 +366,6 @@ static int	check_tag_based_permission(zbx_uint64_t userid, zbx_vector_uint64_t *
 		else
 			ret = SUCCEED;
 	}
-	zbx_vector_ptr_clear_ext(&tag_filters, (zbx_clean_func_t)zbx_tag_filter_free);
-	zbx_vector_ptr_destroy(&tag_filters);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
@@ -270,55 +374,79 @@ static int	check_tag_based_permission(zbx_uint64_t userid, zbx_vector_uint64_t *
 
 /******************************************************************************
  *                                                                            *
- * Function: get_trigger_permission                                           *
+ * Function: get_trigger_hostgroupids                                         *
  *                                                                            *
- * Purpose: Return user permissions for access to trigger                     *
+ * Purpose: gets host groups of the trigger hosts                             *
  *                                                                            *
- * Return value: PERM_DENY - if host or user not found,                       *
- *                   or permission otherwise                                  *
+ * Parameters: triggerid - trigger ID                                         *
+ *                                                                            *
+ * Return value: the cached sorted host group identifiers                     *
  *                                                                            *
  ******************************************************************************/
-static int	get_trigger_permission(zbx_uint64_t userid, const DB_EVENT *event)
+static const zbx_vector_uint64_t	*get_trigger_hostgroupids(zbx_uint64_t triggerid)
 {
-	int			perm = PERM_DENY;
-	DB_RESULT		result;
-	DB_ROW			row;
-	zbx_vector_uint64_t	hostgroupids;
-	zbx_uint64_t		hostgroupid;
+	DB_RESULT			result;
+	DB_ROW				row;
+	zbx_uint64_t			hostgroupid;
+	zbx_trigger_hostgroups_t	*trigger, trigger_local;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
-
-	if (USER_TYPE_SUPER_ADMIN == get_user_type(userid))
-	{
-		perm = PERM_READ_WRITE;
-		goto out;
-	}
+	if (NULL != (trigger = (zbx_trigger_hostgroups_t *)zbx_hashset_search(&trigger_hostgroups, &triggerid)))
+		return &trigger->hostgroupids;
 
-	zbx_vector_uint64_create(&hostgroupids);
+	trigger_local.triggerid = triggerid;
+	trigger = (zbx_trigger_hostgroups_t *)zbx_hashset_insert(&trigger_hostgroups, &trigger_local,
+			sizeof(trigger_local));
+	zbx_vector_uint64_create(&trigger->hostgroupids);
 
 	result = DBselect(
 			"select distinct hg.groupid from items i"
 			" join functions f on i.itemid=f.itemid"
 			" join hosts_groups hg on hg.hostid = i.hostid"
 				" and f.triggerid=" ZBX_FS_UI64,
-			event->objectid);
+			triggerid);
 
 	while (NULL != (row = DBfetch(result)))
 	{
 		ZBX_STR2UINT64(hostgroupid, row[0]);
-		zbx_vector_uint64_append(&hostgroupids, hostgroupid);
+		zbx_vector_uint64_append(&trigger->hostgroupids, hostgroupid);
 	}
 	DBfree_result(result);
 
-	zbx_vector_uint64_sort(&hostgroupids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_sort(&trigger->hostgroupids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	return &trigger->hostgroupids;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: get_trigger_permission                                           *
+ *                                                                            *
+ * Purpose: Return user permissions for access to trigger                     *
+ *                                                                            *
+ * Return value: PERM_DENY - if host or user not found,                       *
+ *                   or permission otherwise                                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	get_trigger_permission(zbx_uint64_t userid, const DB_EVENT *event)
+{
+	int				perm = PERM_DENY;
+	const zbx_vector_uint64_t	*hostgroupids;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	if (PERM_DENY < (perm = get_hostgroups_permission(userid, &hostgroupids)) &&
-			FAIL == check_tag_based_permission(userid, &hostgroupids, event))
+	if (USER_TYPE_SUPER_ADMIN == get_user_type(userid))
 	{
-		perm = PERM_DENY;
+		perm = PERM_READ_WRITE;
+		goto out;
 	}
 
-	zbx_vector_uint64_destroy(&hostgroupids);
+	hostgroupids = get_trigger_hostgroupids(event->objectid);
+
+	if (PERM_DENY < (perm = get_hostgroups_permission(userid, hostgroupids)) &&
+			FAIL == check_tag_based_permission(userid, hostgroupids, event))
+	{
+		perm = PERM_DENY;
+	}
 out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_permission_string(perm));
 
@@ -2418,6 +2546,8 @@ out:
 
 	zbx_vector_uint64_pair_destroy(&event_pairs);
 
+	perm_cache_clear();
+
 	ret = escalationids.values_num; /* performance metric */
 
 	zbx_vector_uint64_destroy(&escalationids);
@@ -2617,6 +2747,9 @@ ZBX_THREAD_ENTRY(escalator_thread, args)
 
 	DBconnect(ZBX_DB_CONNECT_NORMAL);
 
+	zbx_hashset_create(&user_perms, 100, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_hashset_create(&trigger_hostgroups, 100, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
 	for (;;)
 	{
 		sec = zbx_time();
@@ -49,6 +49,34 @@ typedef struct
 }
 zbx_event_problem_t;
 
+/* global correlation rules matching new event */
+typedef struct
+{
+	DB_EVENT		*event;
+
+	/* correlations using or affecting old events, sorted by identifiers */
+	zbx_vector_ptr_t	corr_old;
+
+	/* correlations affecting only the new event */
+	zbx_vector_ptr_t	corr_new;
+
+	/* old events matching corr_old correlations (zbx_corr_match_t) */
+	zbx_vector_ptr_t	matches;
+}
+zbx_corr_event_t;
+
+/* old event matching global correlation rule */
+typedef struct
+{
+	zbx_uint64_t	eventid;
+	zbx_uint64_t	objectid;
+	zbx_uint64_t	correlationid;
+}
+zbx_corr_match_t;
+
+/* the maximum number of new events checked against old events with one query */
+#define ZBX_CORRELATION_QUERY_EVENTS_MAX	100
+
 static zbx_vector_ptr_t		events;
 static zbx_hashset_t		event_recovery;
 static zbx_hashset_t		correlation_cache;
@@ -312,8 +340,12 @@ static DB_EVENT	*close_trigger_event(zbx_uint64_t eventid, zbx_uint64_t objectid
  *                                                                            *
  * Purpose: flushes the events into a database                                *
  *                                                                            *
+ * Parameters: sql        - [IN/OUT] the multiple statement sql               *
+ *             sql_alloc  - [IN/OUT] the allocated sql size                   *
+ *             sql_offset - [IN/OUT] the sql length                           *
+ *                                                                            *
  ******************************************************************************/
-static int	save_events(void)
+static int	save_events(char **sql, size_t *sql_alloc, size_t *sql_offset)
 {
 	int			i;
 	zbx_db_insert_t		db_insert, db_insert_tags;
@@ -373,13 +405,13 @@ static int	save_events(void)
 		}
 	}
 
-	zbx_db_insert_execute(&db_insert);
+	zbx_db_insert_execute_sql(&db_insert, sql, sql_alloc, sql_offset);
 	zbx_db_insert_clean(&db_insert);
 
 	if (0 != insert_tags)
 	{
 		zbx_db_insert_autoincrement(&db_insert_tags, "eventtagid");
-		zbx_db_insert_execute(&db_insert_tags);
+		zbx_db_insert_execute_sql(&db_insert_tags, sql, sql_alloc, sql_offset);
 		zbx_db_insert_clean(&db_insert_tags);
 	}
 
@@ -393,8 +425,12 @@ static int	save_events(void)
  * Purpose: generates problems from problem events (trigger and internal      *
  *          event sources)                                                    *
  *                                                                            *
+ * Parameters: sql        - [IN/OUT] the multiple statement sql               *
+ *             sql_alloc  - [IN/OUT] the allocated sql size                   *
+ *             sql_offset - [IN/OUT] the sql length                           *
+ *                                                                            *
  ******************************************************************************/
-static void	save_problems(void)
+static void	save_problems(char **sql, size_t *sql_alloc, size_t *sql_offset)
 {
 	int			i;
 	zbx_vector_ptr_t	problems;
@@ -458,7 +494,7 @@ static void	save_problems(void)
 					event->severity);
 		}
 
-		zbx_db_insert_execute(&db_insert);
+		zbx_db_insert_execute_sql(&db_insert, sql, sql_alloc, sql_offset);
 		zbx_db_insert_clean(&db_insert);
 
 		if (0 != tags_num)
@@ -485,7 +521,7 @@ static void	save_problems(void)
 			}
 
 			zbx_db_insert_autoincrement(&db_insert, "problemtagid");
-			zbx_db_insert_execute(&db_insert);
+			zbx_db_insert_execute_sql(&db_insert, sql, sql_alloc, sql_offset);
 			zbx_db_insert_clean(&db_insert);
 		}
 	}
@@ -500,20 +536,20 @@ static void	save_problems(void)
  * Purpose: saves event recovery data and removes recovered events from       *
  *          problem table                                                     *
  *                                                                            *
+ * Parameters: sql        - [IN/OUT] the multiple statement sql               *
+ *             sql_alloc  - [IN/OUT] the allocated sql size                   *
+ *             sql_offset - [IN/OUT] the sql length                           *
+ *                                                                            *
  ******************************************************************************/
-static void	save_event_recovery(void)
+static void	save_event_recovery(char **sql, size_t *sql_alloc, size_t *sql_offset)
 {
 	zbx_db_insert_t		db_insert;
 	zbx_event_recovery_t	*recovery;
-	char			*sql = NULL;
-	size_t			sql_alloc = 0, sql_offset = 0;
 	zbx_hashset_iter_t	iter;
 
 	if (0 == event_recovery.num_data)
 		return;
 
-	DBbegin_multiple_update(&sql, &sql_alloc, &sql_offset);
-
 	zbx_db_insert_prepare(&db_insert, "event_recovery", "eventid", "r_eventid", "correlationid", "c_eventid",
 			"userid", NULL);
 
@@ -522,8 +558,15 @@ static void	save_event_recovery(void)
 	{
 		zbx_db_insert_add_values(&db_insert, recovery->eventid, recovery->r_event->eventid,
 				recovery->correlationid, recovery->c_eventid, recovery->userid);
+	}
 
-		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
+	zbx_db_insert_execute_sql(&db_insert, sql, sql_alloc, sql_offset);
+	zbx_db_insert_clean(&db_insert);
+
+	zbx_hashset_iter_reset(&event_recovery, &iter);
+	while (NULL != (recovery = (zbx_event_recovery_t *)zbx_hashset_iter_next(&iter)))
+	{
+		zbx_snprintf_alloc(sql, sql_alloc, sql_offset,
 			"update problem set"
 			" r_eventid=" ZBX_FS_UI64
 			",r_clock=%d"
@@ -536,25 +579,15 @@ static void	save_event_recovery(void)
 
 		if (0 != recovery->correlationid)
 		{
-			zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, ",correlationid=" ZBX_FS_UI64,
+			zbx_snprintf_alloc(sql, sql_alloc, sql_offset, ",correlationid=" ZBX_FS_UI64,
 					recovery->correlationid);
 		}
 
-		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, " where eventid=" ZBX_FS_UI64 ";\n",
+		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, " where eventid=" ZBX_FS_UI64 ";\n",
 				recovery->eventid);
 
-		DBexecute_overflowed_sql(&sql, &sql_alloc, &sql_offset);
+		DBexecute_overflowed_sql(sql, sql_alloc, sql_offset);
 	}
-
-	zbx_db_insert_execute(&db_insert);
-	zbx_db_insert_clean(&db_insert);
-
-	DBend_multiple_update(&sql, &sql_alloc, &sql_offset);
-
-	if (16 < sql_offset)	/* in ORACLE always present begin..end; */
-		DBexecute("%s", sql);
-
-	zbx_free(sql);
 }
 
 /******************************************************************************
@@ -1129,35 +1162,45 @@ static void	correlation_execute_operations(zbx_correlation_t *correlation, DB_EV
 
 /******************************************************************************
  *                                                                            *
- * Function: correlate_event_by_global_rules                                  *
+ * Function: corr_event_free                                                  *
  *                                                                            *
- * Purpose: find problem events that must be recovered by global correlation  *
- *          rules and check if the new event must be closed                   *
+ * Purpose: frees new event correlation data                                  *
  *                                                                            *
- * Comments: The correlation data (zbx_event_recovery_t) of events that       *
- *           must be closed are added to event_correlation hashset            *
+ ******************************************************************************/
+static void	corr_event_free(zbx_corr_event_t *corr_event)
+{
+	zbx_vector_ptr_destroy(&corr_event->corr_old);
+	zbx_vector_ptr_destroy(&corr_event->corr_new);
+	zbx_vector_ptr_clear_ext(&corr_event->matches, zbx_ptr_free);
+	zbx_vector_ptr_destroy(&corr_event->matches);
+	zbx_free(corr_event);
+}
+
+/******************************************************************************
  *                                                                            *
- *           The global event correlation matching is done in two parts:      *
- *             1) exclude correlations that can't possibly match the event    *
- *                based on new event tag/value/group conditions               *
- *             2) assemble sql statement to select problems/correlations      *
- *                based on the rest correlation conditions                    *
+ * Function: correlation_match_event                                          *
+ *                                                                            *
+ * Purpose: finds global correlation rules that can match the new event       *
+ *                                                                            *
+ * Parameters: event - [IN] the new event                                     *
+ *                                                                            *
+ * Return value: the matching correlation rules or NULL if there are none     *
+ *                                                                            *
+ * Comments: The correlations that can't possibly match the event are         *
+ *           excluded based on new event tag/value/group conditions.          *
  *                                                                            *
  ******************************************************************************/
-static void	correlate_event_by_global_rules(DB_EVENT *event)
+static zbx_corr_event_t	*correlation_match_event(DB_EVENT *event)
 {
 	int			i;
 	zbx_correlation_t	*correlation;
-	zbx_vector_ptr_t	corr_old, corr_new;
-	char			*sql = NULL;
-	const char		*delim = "";
-	size_t			sql_alloc = 0, sql_offset = 0;
-	zbx_uint64_t		eventid, correlationid, objectid;
-	DB_RESULT		result;
-	DB_ROW			row;
+	zbx_corr_event_t	*corr_event;
 
-	zbx_vector_ptr_create(&corr_old);
-	zbx_vector_ptr_create(&corr_new);
+	corr_event = (zbx_corr_event_t *)zbx_malloc(NULL, sizeof(zbx_corr_event_t));
+	corr_event->event = event;
+	zbx_vector_ptr_create(&corr_event->corr_old);
+	zbx_vector_ptr_create(&corr_event->corr_new);
+	zbx_vector_ptr_create(&corr_event->matches);
 
 	for (i = 0; i < correlation_rules.correlations.values_num; i++)
 	{
@@ -1168,73 +1211,161 @@ static void	correlate_event_by_global_rules(DB_EVENT *event)
 			if (SUCCEED == correlation_has_old_event_filter(correlation) ||
 					SUCCEED == correlation_has_old_event_operation(correlation))
 			{
-				zbx_vector_ptr_append(&corr_old, correlation);
+				zbx_vector_ptr_append(&corr_event->corr_old, correlation);
 			}
 			else
 			{
 				if (SUCCEED == correlation_match_new_event(correlation, event, FAIL))
-					zbx_vector_ptr_append(&corr_new, correlation);
+					zbx_vector_ptr_append(&corr_event->corr_new, correlation);
 			}
 		}
 	}
 
-	if (0 != corr_new.values_num)
+	if (0 == corr_event->corr_old.values_num && 0 == corr_event->corr_new.values_num)
 	{
-		/* Process correlations that matches new event and does not use or affect old events. */
-		/* Those correlations can be executed directly, without checking database.            */
-		for (i = 0; i < corr_new.values_num; i++)
-			correlation_execute_operations((zbx_correlation_t *)corr_new.values[i], event, 0, 0);
+		corr_event_free(corr_event);
+		return NULL;
 	}
 
-	if (0 != corr_old.values_num)
+	return corr_event;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: correlation_get_old_events                                       *
+ *                                                                            *
+ * Purpose: selects problems matching correlation rules of the new events     *
+ *                                                                            *
+ * Parameters: corr_events - [IN/OUT] the new events with matching rules      *
+ *             start       - [IN] the first new event to check                *
+ *             end         - [IN] the new event after the last one to check   *
+ *                                                                            *
+ * Comments: The problems are selected with a single query for all new        *
+ *           events - a union of per event queries, each of them returning    *
+ *           the event index to assign the problems to the right event.       *
+ *                                                                            *
+ ******************************************************************************/
+static void	correlation_get_old_events(zbx_vector_ptr_t *corr_events, int start, int end)
+{
+	int			i, j, index;
+	zbx_corr_event_t	*corr_event;
+	zbx_corr_match_t	*match;
+	char			*sql = NULL;
+	const char		*delim;
+	size_t			sql_alloc = 0, sql_offset = 0;
+	DB_RESULT		result;
+	DB_ROW			row;
+
+	for (i = start; i < end; i++)
 	{
-		/* Process correlations that matches new event and either uses old events in conditions */
-		/* or has operations involving old events.                                              */
+		corr_event = (zbx_corr_event_t *)corr_events->values[i];
 
-		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, "select p.eventid,p.objectid,c.correlationid"
-								" from correlation c,problem p"
-								" where p.r_eventid is null"
-								" and (");
+		if (0 == corr_event->corr_old.values_num)
+			continue;
 
-		for (i = 0; i < corr_old.values_num; i++)
-		{
-			correlation = (zbx_correlation_t *)corr_old.values[i];
+		if (0 != sql_offset)
+			zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " union all ");
 
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "select p.eventid,p.objectid,c.correlationid,%d"
+				" from correlation c,problem p"
+				" where p.r_eventid is null"
+				" and (", i);
+
+		delim = "";
+
+		for (j = 0; j < corr_event->corr_old.values_num; j++)
+		{
 			zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, delim);
-			correlation_add_event_filter(&sql, &sql_alloc, &sql_offset, correlation, event);
+			correlation_add_event_filter(&sql, &sql_alloc, &sql_offset,
+					(zbx_correlation_t *)corr_event->corr_old.values[j], corr_event->event);
 			delim = " or ";
 		}
 
 		zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, ')');
-		result = DBselect("%s", sql);
+	}
 
-		while (NULL != (row = DBfetch(result)))
+	if (0 == sql_offset)
+		return;
+
+	result = DBselect("%s", sql);
+
+	while (NULL != (row = DBfetch(result)))
+	{
+		index = atoi(row[3]);
+
+		if (start > index || end <= index)
 		{
-			ZBX_STR2UINT64(eventid, row[0]);
+			THIS_SHOULD_NEVER_HAPPEN;
+			continue;
+		}
 
-			/* check if this event is not already recovered by another correlation rule */
-			if (NULL != zbx_hashset_search(&correlation_cache, &eventid))
-				continue;
+		corr_event = (zbx_corr_event_t *)corr_events->values[index];
 
-			ZBX_STR2UINT64(correlationid, row[2]);
+		match = (zbx_corr_match_t *)zbx_malloc(NULL, sizeof(zbx_corr_match_t));
+		ZBX_STR2UINT64(match->eventid, row[0]);
+		ZBX_STR2UINT64(match->objectid, row[1]);
+		ZBX_STR2UINT64(match->correlationid, row[2]);
+		zbx_vector_ptr_append(&corr_event->matches, match);
+	}
 
-			if (FAIL == (i = zbx_vector_ptr_bsearch(&corr_old, &correlationid,
-					ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC)))
-			{
-				THIS_SHOULD_NEVER_HAPPEN;
-				continue;
-			}
+	DBfree_result(result);
+	zbx_free(sql);
+}
 
-			ZBX_STR2UINT64(objectid, row[1]);
-			correlation_execute_operations((zbx_correlation_t *)corr_old.values[i], event, eventid, objectid);
-		}
+/******************************************************************************
+ *                                                                            *
+ * Function: correlate_event_by_global_rules                                  *
+ *                                                                            *
+ * Purpose: find problem events that must be recovered by global correlation  *
+ *          rules and check if the new event must be closed                   *
+ *                                                                            *
+ * Parameters: corr_event - [IN] the new event with matching correlation      *
+ *                               rules and old events                         *
+ *                                                                            *
+ * Comments: The correlation data (zbx_event_recovery_t) of events that       *
+ *           must be closed are added to event_correlation hashset            *
+ *                                                                            *
+ *           The global event correlation matching is done in two parts:      *
+ *             1) exclude correlations that can't possibly match the event    *
+ *                based on new event tag/value/group conditions               *
+ *             2) assemble sql statement to select problems/correlations      *
+ *                based on the rest correlation conditions                    *
+ *           Both parts are done before calling this function.                *
+ *                                                                            *
+ ******************************************************************************/
+static void	correlate_event_by_global_rules(zbx_corr_event_t *corr_event)
+{
+	int			i, index;
+	zbx_corr_match_t	*match;
 
-		DBfree_result(result);
-		zbx_free(sql);
+	/* Process correlations that matches new event and does not use or affect old events. */
+	/* Those correlations can be executed directly, without checking database.            */
+	for (i = 0; i < corr_event->corr_new.values_num; i++)
+	{
+		correlation_execute_operations((zbx_correlation_t *)corr_event->corr_new.values[i], corr_event->event,
+				0, 0);
 	}
 
-	zbx_vector_ptr_destroy(&corr_new);
-	zbx_vector_ptr_destroy(&corr_old);
+	/* Process correlations that matches new event and either uses old events in conditions */
+	/* or has operations involving old events.                                              */
+	for (i = 0; i < corr_event->matches.values_num; i++)
+	{
+		match = (zbx_corr_match_t *)corr_event->matches.values[i];
+
+		/* check if this event is not already recovered by another correlation rule */
+		if (NULL != zbx_hashset_search(&correlation_cache, &match->eventid))
+			continue;
+
+		if (FAIL == (index = zbx_vector_ptr_bsearch(&corr_event->corr_old, &match->correlationid,
+				ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC)))
+		{
+			THIS_SHOULD_NEVER_HAPPEN;
+			continue;
+		}
+
+		correlation_execute_operations((zbx_correlation_t *)corr_event->corr_old.values[index],
+				corr_event->event, match->eventid, match->objectid);
+	}
 }
 
 /******************************************************************************
@@ -1244,17 +1375,25 @@ static void	correlate_event_by_global_rules(DB_EVENT *event)
  * Purpose: add events to the closing queue according to global correlation   *
  *          rules                                                             *
  *                                                                            *
+ * Comments: Problems matching the new events are selected with one query per *
+ *           ZBX_CORRELATION_QUERY_EVENTS_MAX events instead of a query per   *
+ *           event. The new events are still correlated one by one, in the    *
+ *           order they were generated.                                       *
+ *                                                                            *
  ******************************************************************************/
 static void	correlate_events_by_global_rules(zbx_vector_ptr_t *trigger_events, zbx_vector_ptr_t *trigger_diff)
 {
-	int			i, index;
+	int			i, j, index;
 	zbx_trigger_diff_t	*diff;
+	zbx_vector_ptr_t	corr_events;
+	zbx_corr_event_t	*corr_event;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() events:%d", __func__, correlation_cache.num_data);
 
 	zbx_dc_correlation_rules_get(&correlation_rules);
 
-	/* process global correlation and queue the events that must be closed */
+	zbx_vector_ptr_create(&corr_events);
+
 	for (i = 0; i < trigger_events->values_num; i++)
 	{
 		DB_EVENT	*event = (DB_EVENT *)trigger_events->values[i];
@@ -1262,7 +1401,30 @@ static void	correlate_events_by_global_rules(zbx_vector_ptr_t *trigger_events, z
 		if (0 == (ZBX_FLAGS_DB_EVENT_CREATE & event->flags))
 			continue;
 
-		correlate_event_by_global_rules(event);
+		if (NULL != (corr_event = correlation_match_event(event)))
+			zbx_vector_ptr_append(&corr_events, corr_event);
+	}
+
+	/* process global correlation and queue the events that must be closed */
+	for (i = 0; i < corr_events.values_num; i += ZBX_CORRELATION_QUERY_EVENTS_MAX)
+	{
+		int	end = MIN(i + ZBX_CORRELATION_QUERY_EVENTS_MAX, corr_events.values_num);
+
+		correlation_get_old_events(&corr_events, i, end);
+
+		for (j = i; j < end; j++)
+			correlate_event_by_global_rules((zbx_corr_event_t *)corr_events.values[j]);
+	}
+
+	zbx_vector_ptr_clear_ext(&corr_events, (zbx_clean_func_t)corr_event_free);
+	zbx_vector_ptr_destroy(&corr_events);
+
+	for (i = 0; i < trigger_events->values_num; i++)
+	{
+		DB_EVENT	*event = (DB_EVENT *)trigger_events->values[i];
+
+		if (0 == (ZBX_FLAGS_DB_EVENT_CREATE & event->flags))
+			continue;
 
 		/* force value recalculation based on open problems for triggers with */
 		/* events closed by 'close new' correlation operation                */
@@ -1959,6 +2121,10 @@ out:
  *                                                                            *
  * Purpose: flushes local event cache to database                             *
  *                                                                            *
+ * Comments: Events, problems, their tags and event recovery data are written *
+ *           with a single multiple statement sql (executed in chunks if it   *
+ *           is too large) instead of separate database requests per table.   *
+ *                                                                            *
  ******************************************************************************/
 static int	flush_events(void)
 {
@@ -1966,10 +2132,24 @@ static int	flush_events(void)
 	zbx_event_recovery_t		*recovery;
 	zbx_vector_uint64_pair_t	closed_events;
 	zbx_hashset_iter_t		iter;
+	char				*sql = NULL;
+	size_t				sql_alloc = 16 * ZBX_KIBIBYTE, sql_offset = 0;
+
+	sql = (char *)zbx_malloc(sql, sql_alloc);
+
+	DBbegin_multiple_update(&sql, &sql_alloc, &sql_offset);
+
+	ret = save_events(&sql, &sql_alloc, &sql_offset);
+	save_problems(&sql, &sql_alloc, &sql_offset);
+	save_event_recovery(&sql, &sql_alloc, &sql_offset);
+
+	DBend_multiple_update(&sql, &sql_alloc, &sql_offset);
+
+	if (16 < sql_offset)	/* in ORACLE always present begin..end; */
+		DBexecute("%s", sql);
+
+	zbx_free(sql);
 
-	ret = save_events();
-	save_problems();
-	save_event_recovery();
 	update_event_suppress_data();
 
 	zbx_vector_uint64_pair_create(&closed_events);
@@ -2134,6 +2314,24 @@ out:
 	zbx_vector_uint64_destroy(&triggerids);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: event_problem_compare_by_trigger                                 *
+ *                                                                            *
+ * Purpose: compares problems by trigger and event identifiers                *
+ *                                                                            *
+ ******************************************************************************/
+static int	event_problem_compare_by_trigger(const void *d1, const void *d2)
+{
+	const zbx_event_problem_t	*p1 = *(const zbx_event_problem_t **)d1;
+	const zbx_event_problem_t	*p2 = *(const zbx_event_problem_t **)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(p1->triggerid, p2->triggerid);
+	ZBX_RETURN_IF_NOT_EQUAL(p1->eventid, p2->eventid);
+
+	return 0;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: get_open_problems                                                *
@@ -2141,7 +2339,8 @@ out:
  * Purpose: gets open problems created by the specified triggers              *
  *                                                                            *
  * Parameters: triggerids - [IN] the trigger identifiers (sorted)             *
- *             problems   - [OUT] the problems                                *
+ *             problems   - [OUT] the problems, sorted by trigger and event   *
+ *                                identifiers                                 *
  *                                                                            *
  ******************************************************************************/
 static void	get_open_problems(const zbx_vector_uint64_t *triggerids, zbx_vector_ptr_t *problems)
@@ -2208,6 +2407,8 @@ static void	get_open_problems(const zbx_vector_uint64_t *triggerids, zbx_vector_
 			zbx_vector_ptr_append(&problem->tags, tag);
 		}
 		DBfree_result(result);
+
+		zbx_vector_ptr_sort(problems, event_problem_compare_by_trigger);
 	}
 
 	zbx_free(sql);
@@ -2333,6 +2534,30 @@ static int	match_tag(const char *name, const zbx_vector_ptr_t *tags1, const zbx_
 	return FAIL;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: event_problems_first                                             *
+ *                                                                            *
+ * Purpose: finds the first open problem of the specified trigger             *
+ *                                                                            *
+ * Parameters: problems      - [IN] the problems, sorted by trigger and event *
+ *                                  identifiers                               *
+ *             triggerid     - [IN] the trigger identifier                    *
+ *             problem_local - [IN] the problem used as search key            *
+ *                                                                            *
+ * Return value: the index of the first problem of the trigger or of the      *
+ *               first problem of the next trigger if there are none          *
+ *                                                                            *
+ ******************************************************************************/
+static int	event_problems_first(const zbx_vector_ptr_t *problems, zbx_uint64_t triggerid,
+		zbx_event_problem_t *problem_local)
+{
+	problem_local->triggerid = triggerid;
+	problem_local->eventid = 0;
+
+	return zbx_vector_ptr_nearestindex(problems, problem_local, event_problem_compare_by_trigger);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: process_trigger_events                                           *
@@ -2349,7 +2574,7 @@ static void	process_trigger_events(zbx_vector_ptr_t *trigger_events, zbx_vector_
 	zbx_vector_uint64_t	triggerids;
 	zbx_vector_ptr_t	problems, deps;
 	DB_EVENT		*event;
-	zbx_event_problem_t	*problem;
+	zbx_event_problem_t	*problem, problem_local;
 	zbx_trigger_diff_t	*diff;
 	unsigned char		value;
 
@@ -2434,15 +2659,16 @@ static void	process_trigger_events(zbx_vector_ptr_t *trigger_events, zbx_vector_
 			/* with trigger correlation disabled the recovery event recovers */
 			/* all problem events generated by the same trigger and sets     */
 			/* trigger value to OK                                           */
-			for (j = 0; j < problems.values_num; j++)
+			for (j = event_problems_first(&problems, event->objectid, &problem_local);
+					j < problems.values_num; j++)
 			{
 				problem = (zbx_event_problem_t *)problems.values[j];
 
-				if (problem->triggerid == event->objectid)
-				{
-					recover_event(problem->eventid, EVENT_SOURCE_TRIGGERS, EVENT_OBJECT_TRIGGER,
-							event->objectid);
-				}
+				if (problem->triggerid != event->objectid)
+					break;
+
+				recover_event(problem->eventid, EVENT_SOURCE_TRIGGERS, EVENT_OBJECT_TRIGGER,
+						event->objectid);
 			}
 
 			diff->value = TRIGGER_VALUE_OK;
@@ -2458,23 +2684,22 @@ static void	process_trigger_events(zbx_vector_ptr_t *trigger_events, zbx_vector_
 			value = TRIGGER_VALUE_OK;
 			event->flags = ZBX_FLAGS_DB_EVENT_UNSET;
 
-			for (j = 0; j < problems.values_num; j++)
+			for (j = event_problems_first(&problems, event->objectid, &problem_local);
+					j < problems.values_num; j++)
 			{
 				problem = (zbx_event_problem_t *)problems.values[j];
 
-				if (problem->triggerid == event->objectid)
-				{
-					if (SUCCEED == match_tag(event->trigger.correlation_tag,
-							&problem->tags, &event->tags))
-					{
-						recover_event(problem->eventid, EVENT_SOURCE_TRIGGERS,
-								EVENT_OBJECT_TRIGGER, event->objectid);
-						event->flags = ZBX_FLAGS_DB_EVENT_CREATE;
-					}
-					else
-						value = TRIGGER_VALUE_PROBLEM;
+				if (problem->triggerid != event->objectid)
+					break;
 
+				if (SUCCEED == match_tag(event->trigger.correlation_tag, &problem->tags, &event->tags))
+				{
+					recover_event(problem->eventid, EVENT_SOURCE_TRIGGERS, EVENT_OBJECT_TRIGGER,
+							event->objectid);
+					event->flags = ZBX_FLAGS_DB_EVENT_CREATE;
 				}
+				else
+					value = TRIGGER_VALUE_PROBLEM;
 			}
 
 			diff->value = value;
@@ -564,6 +564,466 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: lld_checksum_append                                              *
+ *                                                                            *
+ * Purpose: appends string, including its terminating zero, to checksum       *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_checksum_append(md5_state_t *md5state, const char *value)
+{
+	if (NULL == value)
+		value = "";
+
+	zbx_md5_append(md5state, (const md5_byte_t *)value, (int)strlen(value) + 1);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: lld_prototypes_checksum                                          *
+ *                                                                            *
+ * Purpose: appends item, application, trigger, graph and host prototypes of  *
+ *          LLD rule to checksum                                              *
+ *                                                                            *
+ * Parameters: lld_ruleid - [IN] the LLD rule identifier                      *
+ *             md5state   - [IN/OUT] the checksum state                       *
+ *                                                                            *
+ * Comments: Prototypes are not kept in configuration cache and frontend does *
+ *           not maintain any revision of them, so the prototype rows are     *
+ *           read from database. This is still much cheaper than the full     *
+ *           processing, which reads the same rows and the discovered         *
+ *           entities.                                                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_prototypes_checksum(zbx_uint64_t lld_ruleid, md5_state_t *md5state)
+{
+	typedef struct
+	{
+		const char	*sql;
+		const char	*sql_order;
+		int		fields_num;
+	}
+	zbx_lld_prototype_query_t;
+
+	static const zbx_lld_prototype_query_t	queries[] = {
+		{
+			"select i.itemid,i.name,i.key_,i.type,i.value_type,i.delay,"
+				"i.history,i.trends,i.status,i.trapper_hosts,i.units,i.formula,"
+				"i.logtimefmt,i.valuemapid,i.params,i.ipmi_sensor,i.snmp_community,i.snmp_oid,"
+				"i.port,i.snmpv3_securityname,i.snmpv3_securitylevel,i.snmpv3_authprotocol,"
+				"i.snmpv3_authpassphrase,i.snmpv3_privprotocol,i.snmpv3_privpassphrase,i.authtype,"
+				"i.username,i.password,i.publickey,i.privatekey,i.description,i.interfaceid,"
+				"i.snmpv3_contextname,i.jmx_endpoint,i.master_itemid,i.timeout,i.url,i.query_fields,"
+				"i.posts,i.status_codes,i.follow_redirects,i.post_type,i.http_proxy,i.headers,"
+				"i.retrieve_mode,i.request_method,i.output_format,i.ssl_cert_file,i.ssl_key_file,"
+				"i.ssl_key_password,i.verify_peer,i.verify_host,i.allow_traps"
+			" from items i,item_discovery id"
+			" where i.itemid=id.itemid"
+				" and id.parent_itemid=",
+			" order by i.itemid",
+			53
+		},
+		{
+			"select ip.item_preprocid,ip.itemid,ip.step,ip.type,ip.params,ip.error_handler,"
+				"ip.error_handler_params"
+			" from item_preproc ip,item_discovery id"
+			" where ip.itemid=id.itemid"
+				" and id.parent_itemid=",
+			" order by ip.item_preprocid",
+			7
+		},
+		{
+			"select ia.itemappid,ia.itemid,ia.applicationid"
+			" from items_applications ia,item_discovery id"
+			" where ia.itemid=id.itemid"
+				" and id.parent_itemid=",
+			" order by ia.itemappid",
+			3
+		},
+		{
+			"select iap.item_application_prototypeid,iap.itemid,ap.application_prototypeid,ap.name"
+			" from item_application_prototype iap,application_prototype ap"
+			" where iap.application_prototypeid=ap.application_prototypeid"
+				" and ap.itemid=",
+			" order by iap.item_application_prototypeid",
+			4
+		},
+		{
+			"select distinct t.triggerid,t.description,t.expression,t.status,t.type,t.priority,t.comments,"
+				"t.url,t.recovery_expression,t.recovery_mode,t.correlation_mode,t.correlation_tag,"
+				"t.manual_close"
+			" from triggers t,functions f,item_discovery id"
+			" where t.triggerid=f.triggerid"
+				" and f.itemid=id.itemid"
+				" and id.parent_itemid=",
+			" order by t.triggerid",
+			13
+		},
+		{
+			"select f.functionid,f.triggerid,f.itemid,f.name,f.parameter"
+			" from functions f"
+			" where f.triggerid in ("
+				"select fp.triggerid"
+				" from functions fp,item_discovery id"
+				" where fp.itemid=id.itemid"
+					" and id.parent_itemid=",
+			")"
+			" order by f.functionid",
+			5
+		},
+		{
+			"select tt.triggertagid,tt.triggerid,tt.tag,tt.value"
+			" from trigger_tag tt"
+			" where tt.triggerid in ("
+				"select fp.triggerid"
+				" from functions fp,item_discovery id"
+				" where fp.itemid=id.itemid"
+					" and id.parent_itemid=",
+			")"
+			" order by tt.triggertagid",
+			4
+		},
+		{
+			"select td.triggerdepid,td.triggerid_down,td.triggerid_up"
+			" from trigger_depends td"
+			" where td.triggerid_down in ("
+				"select fp.triggerid"
+				" from functions fp,item_discovery id"
+				" where fp.itemid=id.itemid"
+					" and id.parent_itemid=",
+			")"
+			" order by td.triggerdepid",
+			3
+		},
+		{
+			"select distinct g.graphid,g.name,g.width,g.height,g.yaxismin,g.yaxismax,g.show_work_period,"
+				"g.show_triggers,g.graphtype,g.show_legend,g.show_3d,g.percent_left,g.percent_right,"
+				"g.ymin_type,g.ymin_itemid,g.ymax_type,g.ymax_itemid"
+			" from graphs g,graphs_items gi,item_discovery id"
+			" where g.graphid=gi.graphid"
+				" and gi.itemid=id.itemid"
+				" and id.parent_itemid=",
+			" order by g.graphid",
+			17
+		},
+		{
+			"select gi.gitemid,gi.graphid,gi.itemid,gi.drawtype,gi.sortorder,gi.color,gi.yaxisside,"
+				"gi.calc_fnc,gi.type"
+			" from graphs_items gi"
+			" where gi.graphid in ("
+				"select gip.graphid"
+				" from graphs_items gip,item_discovery id"
+				" where gip.itemid=id.itemid"
+					" and id.parent_itemid=",
+			")"
+			" order by gi.gitemid",
+			9
+		},
+		{
+			"select h.hostid,h.host,h.name,h.status,hi.inventory_mode"
+			" from hosts h,host_discovery hd"
+				" left join host_inventory hi"
+					" on hd.hostid=hi.hostid"
+			" where h.hostid=hd.hostid"
+				" and hd.parent_itemid=",
+			" order by h.hostid",
+			5
+		},
+		{
+			"select gp.group_prototypeid,gp.hostid,gp.name,gp.groupid"
+			" from group_prototype gp,host_discovery hd"
+			" where gp.hostid=hd.hostid"
+				" and hd.parent_itemid=",
+			" order by gp.group_prototypeid",
+			4
+		},
+		{
+			"select ht.hosttemplateid,ht.hostid,ht.templateid"
+			" from hosts_templates ht,host_discovery hd"
+			" where ht.hostid=hd.hostid"
+				" and hd.parent_itemid=",
+			" order by ht.hosttemplateid",
+			3
+		},
+		{
+			"select hm.hostmacroid,hm.hostid,hm.macro,hm.value"
+			" from hostmacro hm,host_discovery hd"
+			" where hm.hostid=hd.hostid"
+				" and hd.parent_itemid=",
+			" order by hm.hostmacroid",
+			4
+		}
+	};
+
+	DB_RESULT	result;
+	DB_ROW		row;
+	size_t		i;
+	int		j;
+
+	for (i = 0; i < ARRSIZE(queries); i++)
+	{
+		/* separate rows of different queries */
+		lld_checksum_append(md5state, queries[i].sql_order);
+
+		result = DBselect("%s" ZBX_FS_UI64 "%s", queries[i].sql, lld_ruleid, queries[i].sql_order);
+
+		while (NULL != (row = DBfetch(result)))
+		{
+			for (j = 0; j < queries[i].fields_num; j++)
+				lld_checksum_append(md5state, row[j]);
+		}
+		DBfree_result(result);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: lld_rule_checksum                                                *
+ *                                                                            *
+ * Purpose: calculates checksum of everything discovery results depend on     *
+ *                                                                            *
+ * Parameters: lld_ruleid      - [IN] the LLD rule identifier                 *
+ *             hostid          - [IN] the LLD rule host                       *
+ *             value           - [IN] the discovery data                      *
+ *             lifetime        - [IN] the lost resources lifetime             *
+ *             filter          - [IN] the lld filter                          *
+ *             lld_macro_paths - [IN] the lld macro json paths                *
+ *             checksum        - [OUT] the checksum                           *
+ *                                                                            *
+ * Return value: SUCCEED - the checksum was calculated                        *
+ *               FAIL    - host configuration revision is not available       *
+ *                                                                            *
+ * Comments: Host configuration revision changes with host, item, template    *
+ *           link, user macro and global regular expression changes.          *
+ *                                                                            *
+ ******************************************************************************/
+static int	lld_rule_checksum(zbx_uint64_t lld_ruleid, zbx_uint64_t hostid, const char *value, int lifetime,
+		const lld_filter_t *filter, const zbx_vector_ptr_t *lld_macro_paths, md5_byte_t *checksum)
+{
+	md5_state_t	md5state;
+	zbx_uint64_t	revision;
+	int		i;
+	char		buffer[MAX_ID_LEN * 2 + 2];
+
+	if (SUCCEED != DCconfig_get_host_revision(hostid, &revision))
+		return FAIL;
+
+	zbx_md5_init(&md5state);
+
+	zbx_snprintf(buffer, sizeof(buffer), ZBX_FS_UI64 " %d %d", revision, lifetime, filter->evaltype);
+	lld_checksum_append(&md5state, buffer);
+	lld_checksum_append(&md5state, filter->expression);
+
+	for (i = 0; i < filter->conditions.values_num; i++)
+	{
+		const lld_condition_t	*condition = (const lld_condition_t *)filter->conditions.values[i];
+
+		zbx_snprintf(buffer, sizeof(buffer), ZBX_FS_UI64 " %d", condition->id, (int)condition->op);
+		lld_checksum_append(&md5state, buffer);
+		lld_checksum_append(&md5state, condition->macro);
+		lld_checksum_append(&md5state, condition->regexp);
+	}
+
+	for (i = 0; i < lld_macro_paths->values_num; i++)
+	{
+		const zbx_lld_macro_path_t	*lld_macro_path = (const zbx_lld_macro_path_t *)lld_macro_paths->values[i];
+
+		lld_checksum_append(&md5state, lld_macro_path->lld_macro);
+		lld_checksum_append(&md5state, lld_macro_path->path);
+	}
+
+	lld_prototypes_checksum(lld_ruleid, &md5state);
+
+	lld_checksum_append(&md5state, value);
+
+	zbx_md5_finish(&md5state, checksum);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: lld_update_lastcheck                                             *
+ *                                                                            *
+ * Purpose: updates last discovery time of the resources discovered by LLD    *
+ *          rule without processing the unchanged discovery data again        *
+ *                                                                            *
+ * Parameters: lld_ruleid - [IN] the LLD rule identifier                      *
+ *             lastcheck  - [IN] the discovery time                           *
+ *                                                                            *
+ * Comments: Resources that were discovered by the last full processing are   *
+ *           the ones not scheduled for deletion.                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_update_lastcheck(zbx_uint64_t lld_ruleid, int lastcheck)
+{
+	DB_RESULT		result;
+	DB_ROW			row;
+	zbx_vector_uint64_t	itemids, hostids;
+	zbx_uint64_t		id;
+	char			*sql = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid:" ZBX_FS_UI64, __func__, lld_ruleid);
+
+	zbx_vector_uint64_create(&itemids);
+	zbx_vector_uint64_create(&hostids);
+
+	result = DBselect("select itemid from item_discovery where parent_itemid=" ZBX_FS_UI64, lld_ruleid);
+
+	while (NULL != (row = DBfetch(result)))
+	{
+		ZBX_STR2UINT64(id, row[0]);
+		zbx_vector_uint64_append(&itemids, id);
+	}
+	DBfree_result(result);
+
+	result = DBselect("select hostid from host_discovery where parent_itemid=" ZBX_FS_UI64, lld_ruleid);
+
+	while (NULL != (row = DBfetch(result)))
+	{
+		ZBX_STR2UINT64(id, row[0]);
+		zbx_vector_uint64_append(&hostids, id);
+	}
+	DBfree_result(result);
+
+	DBbegin();
+
+	DBbegin_multiple_update(&sql, &sql_alloc, &sql_offset);
+
+	if (0 != itemids.values_num)
+	{
+		zbx_vector_uint64_sort(&itemids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
+				"update item_discovery set lastcheck=%d where ts_delete=0 and", lastcheck);
+		DBadd_condition_alloc(&sql, &sql_alloc, &sql_offset, "parent_itemid", itemids.values,
+				itemids.values_num);
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, ";\n");
+
+		DBexecute_overflowed_sql(&sql, &sql_alloc, &sql_offset);
+	}
+
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
+			"update application_discovery set lastcheck=%d"
+			" where ts_delete=0"
+				" and application_prototypeid in ("
+					"select application_prototypeid"
+					" from application_prototype"
+					" where itemid=" ZBX_FS_UI64
+				");\n",
+			lastcheck, lld_ruleid);
+
+	DBexecute_overflowed_sql(&sql, &sql_alloc, &sql_offset);
+
+	if (0 != hostids.values_num)
+	{
+		zbx_vector_uint64_sort(&hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
+				"update host_discovery set lastcheck=%d where ts_delete=0 and", lastcheck);
+		DBadd_condition_alloc(&sql, &sql_alloc, &sql_offset, "parent_hostid", hostids.values,
+				hostids.values_num);
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, ";\n");
+
+		DBexecute_overflowed_sql(&sql, &sql_alloc, &sql_offset);
+
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
+				"update group_discovery set lastcheck=%d"
+				" where ts_delete=0"
+					" and parent_group_prototypeid in ("
+						"select group_prototypeid"
+						" from group_prototype"
+						" where", lastcheck);
+		DBadd_condition_alloc(&sql, &sql_alloc, &sql_offset, "hostid", hostids.values,
+				hostids.values_num);
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, ");\n");
+
+		DBexecute_overflowed_sql(&sql, &sql_alloc, &sql_offset);
+	}
+
+	DBend_multiple_update(&sql, &sql_alloc, &sql_offset);
+
+	if (16 < sql_offset)	/* in ORACLE always present begin..end; */
+		DBexecute("%s", sql);
+
+	DBcommit();
+
+	zbx_free(sql);
+	zbx_vector_uint64_destroy(&hostids);
+	zbx_vector_uint64_destroy(&itemids);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: lld_lost_resources_expired                                       *
+ *                                                                            *
+ * Purpose: checks if any lost resource discovered by LLD rule must be        *
+ *          deleted                                                           *
+ *                                                                            *
+ * Parameters: lld_ruleid - [IN] the LLD rule identifier                      *
+ *             now        - [IN] the discovery time                           *
+ *                                                                            *
+ * Return value: SUCCEED - lifetime of a lost resource has expired            *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	lld_lost_resources_expired(zbx_uint64_t lld_ruleid, int now)
+{
+	static const char	*queries[] = {
+		"select null"
+		" from item_discovery id,item_discovery idp"
+		" where id.parent_itemid=idp.itemid"
+			" and id.ts_delete<>0"
+			" and id.ts_delete<%d"
+			" and idp.parent_itemid=" ZBX_FS_UI64,
+		"select null"
+		" from application_discovery ad,application_prototype ap"
+		" where ad.application_prototypeid=ap.application_prototypeid"
+			" and ad.ts_delete<>0"
+			" and ad.ts_delete<%d"
+			" and ap.itemid=" ZBX_FS_UI64,
+		"select null"
+		" from host_discovery hd,host_discovery hdp"
+		" where hd.parent_hostid=hdp.hostid"
+			" and hd.ts_delete<>0"
+			" and hd.ts_delete<%d"
+			" and hdp.parent_itemid=" ZBX_FS_UI64,
+		"select null"
+		" from group_discovery gd,group_prototype gp,host_discovery hd"
+		" where gd.parent_group_prototypeid=gp.group_prototypeid"
+			" and gp.hostid=hd.hostid"
+			" and gd.ts_delete<>0"
+			" and gd.ts_delete<%d"
+			" and hd.parent_itemid=" ZBX_FS_UI64
+	};
+
+	DB_RESULT	result;
+	char		*sql = NULL;
+	size_t		i, sql_alloc = 0, sql_offset;
+	int		ret = FAIL;
+
+	for (i = 0; i < ARRSIZE(queries) && FAIL == ret; i++)
+	{
+		sql_offset = 0;
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, queries[i], now, lld_ruleid);
+
+		result = DBselectN(sql, 1);
+
+		if (NULL != DBfetch(result))
+			ret = SUCCEED;
+
+		DBfree_result(result);
+	}
+
+	zbx_free(sql);
+
+	return ret;
+}
+
 static void	lld_item_link_free(zbx_lld_item_link_t *item_link)
 {
 	zbx_free(item_link);
@@ -584,21 +1044,31 @@ static void	lld_row_free(zbx_lld_row_t *lld_row)
  *                                                                            *
  * Parameters: lld_ruleid - [IN] discovery item identifier from database      *
  *             value      - [IN] received value from agent                    *
+ *             state      - [IN/OUT] the last full processing of the rule     *
  *             error      - [OUT] error or informational message. Will be set *
  *                               to empty string on successful discovery      *
  *                               without additional information.              *
  *                                                                            *
+ * Comments: When the discovery data, rule settings, prototypes and host      *
+ *           configuration did not change since the last full processing,     *
+ *           which happened less than ZBX_LLD_FULL_PROCESSING_PERIOD ago, and *
+ *           no lost resource is due for deletion, only the last discovery    *
+ *           time of discovered resources is updated. The error is not set in *
+ *           this case as it stays the same.                                  *
+ *                                                                            *
  ******************************************************************************/
-int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, char **error)
+int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, zbx_lld_rule_state_t *state,
+		char **error)
 {
 	DB_RESULT		result;
 	DB_ROW			row;
 	zbx_uint64_t		hostid;
 	char			*discovery_key = NULL, *info = NULL;
-	int			lifetime, ret = SUCCEED;
+	int			lifetime, ret = SUCCEED, checksum_ret, processed;
 	zbx_vector_ptr_t	lld_rows, lld_macro_paths;
 	lld_filter_t		filter;
 	time_t			now;
+	md5_byte_t		checksum[MD5_DIGEST_SIZE];
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid:" ZBX_FS_UI64, __func__, lld_ruleid);
 
@@ -637,6 +1107,11 @@ int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, char
 	}
 	DBfree_result(result);
 
+	/* the rule state is reset unless processing succeeds */
+	checksum_ret = FAIL;
+	processed = state->processed;
+	state->processed = 0;
+
 	if (NULL == row)
 	{
 		zabbix_log(LOG_LEVEL_WARNING, "invalid discovery rule ID [" ZBX_FS_UI64 "]", lld_ruleid);
@@ -655,6 +1130,20 @@ int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, char
 		goto out;
 	}
 
+	now = time(NULL);
+
+	if (SUCCEED == (checksum_ret = lld_rule_checksum(lld_ruleid, hostid, value, lifetime, &filter,
+			&lld_macro_paths, checksum)) && 0 != processed && now - processed < ZBX_LLD_FULL_PROCESSING_PERIOD &&
+			0 == memcmp(checksum, state->checksum, sizeof(checksum)) &&
+			SUCCEED != lld_lost_resources_expired(lld_ruleid, (int)now))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "discovery data did not change, skipping full processing");
+
+		lld_update_lastcheck(lld_ruleid, (int)now);
+		state->processed = processed;
+		goto out;
+	}
+
 	if (SUCCEED != lld_rows_get(value, &filter, &lld_rows, &lld_macro_paths, &info, error))
 	{
 		ret = FAIL;
@@ -663,8 +1152,6 @@ int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, char
 
 	*error = zbx_strdup(*error, "");
 
-	now = time(NULL);
-
 	if (SUCCEED != lld_update_items(hostid, lld_ruleid, &lld_rows, &lld_macro_paths, error, lifetime, now))
 	{
 		zabbix_log(LOG_LEVEL_DEBUG, "cannot update/add items because parent host was removed while"
@@ -693,6 +1180,12 @@ int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, char
 	/* add informative warning to the error message about lack of data for macros used in filter */
 	if (NULL != info)
 		*error = zbx_strdcat(*error, info);
+
+	if (SUCCEED == checksum_ret)
+	{
+		memcpy(state->checksum, checksum, sizeof(checksum));
+		state->processed = (int)now;
+	}
 out:
 	zbx_free(info);
 	zbx_free(discovery_key);
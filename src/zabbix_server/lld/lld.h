@@ -23,6 +23,7 @@
 #include "common.h"
 #include "zbxjson.h"
 #include "zbxalgo.h"
+#include "lld_protocol.h"
 
 typedef struct
 {
@@ -57,4 +58,7 @@ void	lld_update_hosts(zbx_uint64_t lld_ruleid, const zbx_vector_ptr_t *lld_rows,
 
 int	lld_end_of_life(int lastcheck, int lifetime);
 
+int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, zbx_lld_rule_state_t *state,
+		char **error);
+
 #endif
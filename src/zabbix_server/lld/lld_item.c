@@ -80,7 +80,6 @@ typedef struct
 	unsigned char		snmpv3_privprotocol;
 	unsigned char		authtype;
 	unsigned char		allow_traps;
-	zbx_vector_ptr_t	lld_rows;
 	zbx_vector_ptr_t	applications;
 	zbx_vector_ptr_t	preproc_ops;
 }
@@ -322,6 +321,27 @@ typedef struct
 }
 zbx_lld_application_index_t;
 
+/* lld rows expanding prototype field to the same value */
+typedef struct
+{
+	char			*value;
+	zbx_vector_ptr_t	lld_rows;
+}
+zbx_lld_row_value_t;
+
+/* prototype field expanded for all lld rows, indexed by prototype id and unexpanded field */
+typedef struct
+{
+	zbx_uint64_t	prototypeid;
+	const char	*proto;
+	zbx_hashset_t	values;
+}
+zbx_lld_row_values_t;
+
+/* expands lld macros in prototype field, returns SUCCEED or FAIL if the field cannot be expanded */
+typedef int	(*zbx_lld_expand_func_t)(char **data, const zbx_lld_row_t *lld_row,
+		const zbx_vector_ptr_t *lld_macro_paths);
+
 /* items index hashset support functions */
 static zbx_hash_t	lld_item_index_hash_func(const void *data)
 {
@@ -407,6 +427,27 @@ static int	lld_items_keys_compare_func(const void *d1, const void *d2)
 	return ZBX_DEFAULT_STR_COMPARE_FUNC(d1, d2);
 }
 
+/* expanded prototype field index hashset support functions */
+static zbx_hash_t	lld_row_values_hash_func(const void *data)
+{
+	const zbx_lld_row_values_t	*row_values = (const zbx_lld_row_values_t *)data;
+	zbx_hash_t			hash;
+
+	hash = ZBX_DEFAULT_UINT64_HASH_ALGO(&row_values->prototypeid, sizeof(row_values->prototypeid),
+			ZBX_DEFAULT_HASH_SEED);
+	return ZBX_DEFAULT_STRING_HASH_ALGO(row_values->proto, strlen(row_values->proto), hash);
+}
+
+static int	lld_row_values_compare_func(const void *d1, const void *d2)
+{
+	const zbx_lld_row_values_t	*rv1 = (const zbx_lld_row_values_t *)d1;
+	const zbx_lld_row_values_t	*rv2 = (const zbx_lld_row_values_t *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(rv1->prototypeid, rv2->prototypeid);
+
+	return strcmp(rv1->proto, rv2->proto);
+}
+
 /* items - applications hashset support */
 static zbx_hash_t	lld_item_application_hash_func(const void *data)
 {
@@ -499,8 +540,6 @@ static void	lld_item_prototype_free(zbx_lld_item_prototype_t *item_prototype)
 	zbx_free(item_prototype->ssl_key_file);
 	zbx_free(item_prototype->ssl_key_password);
 
-	zbx_vector_ptr_destroy(&item_prototype->lld_rows);
-
 	zbx_vector_ptr_clear_ext(&item_prototype->applications, zbx_default_mem_free_func);
 	zbx_vector_ptr_destroy(&item_prototype->applications);
 
@@ -2378,6 +2417,118 @@ static void	lld_item_update(const zbx_lld_item_prototype_t *item_prototype, cons
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: lld_row_values_clean                                             *
+ *                                                                            *
+ * Purpose: frees expanded prototype field index                              *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_row_values_clean(zbx_hashset_t *row_values_index)
+{
+	zbx_hashset_iter_t	iter, iter_values;
+	zbx_lld_row_values_t	*row_values;
+	zbx_lld_row_value_t	*row_value;
+
+	zbx_hashset_iter_reset(row_values_index, &iter);
+	while (NULL != (row_values = (zbx_lld_row_values_t *)zbx_hashset_iter_next(&iter)))
+	{
+		zbx_hashset_iter_reset(&row_values->values, &iter_values);
+		while (NULL != (row_value = (zbx_lld_row_value_t *)zbx_hashset_iter_next(&iter_values)))
+		{
+			zbx_free(row_value->value);
+			zbx_vector_ptr_destroy(&row_value->lld_rows);
+		}
+
+		zbx_hashset_destroy(&row_values->values);
+	}
+
+	zbx_hashset_destroy(row_values_index);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: lld_row_values_get                                               *
+ *                                                                            *
+ * Purpose: gets lld rows indexed by the value prototype field expands to     *
+ *                                                                            *
+ * Parameters: row_values_index - [IN/OUT] the expanded prototype field index *
+ *             prototypeid      - [IN] the prototype identifier               *
+ *             proto            - [IN] the unexpanded prototype field         *
+ *             lld_rows         - [IN] the lld data rows                      *
+ *             lld_macro_paths  - [IN] use json path to extract from jp_row   *
+ *             expand_func      - [IN] the prototype field expand function    *
+ *                                                                            *
+ * Return value: the lld rows (zbx_lld_row_value_t) indexed by expanded value *
+ *                                                                            *
+ * Comments: The field is expanded for every lld row only once, when it is    *
+ *           requested for the first time. This allows discovered entities to *
+ *           be matched to lld rows with a lookup instead of expanding the    *
+ *           field for every entity and lld row pair.                         *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_hashset_t	*lld_row_values_get(zbx_hashset_t *row_values_index, zbx_uint64_t prototypeid,
+		const char *proto, const zbx_vector_ptr_t *lld_rows, const zbx_vector_ptr_t *lld_macro_paths,
+		zbx_lld_expand_func_t expand_func)
+{
+	int			i;
+	zbx_lld_row_values_t	*row_values, row_values_local;
+	zbx_lld_row_value_t	*row_value, row_value_local;
+	zbx_lld_row_t		*lld_row;
+	char			*buffer = NULL;
+
+	row_values_local.prototypeid = prototypeid;
+	row_values_local.proto = proto;
+
+	if (NULL != (row_values = (zbx_lld_row_values_t *)zbx_hashset_search(row_values_index, &row_values_local)))
+		return &row_values->values;
+
+	row_values = (zbx_lld_row_values_t *)zbx_hashset_insert(row_values_index, &row_values_local,
+			sizeof(row_values_local));
+	zbx_hashset_create(&row_values->values, lld_rows->values_num, lld_items_keys_hash_func,
+			lld_items_keys_compare_func);
+
+	for (i = 0; i < lld_rows->values_num; i++)
+	{
+		lld_row = (zbx_lld_row_t *)lld_rows->values[i];
+
+		buffer = zbx_strdup(buffer, proto);
+
+		if (SUCCEED != expand_func(&buffer, lld_row, lld_macro_paths))
+			continue;
+
+		row_value_local.value = buffer;
+
+		if (NULL == (row_value = (zbx_lld_row_value_t *)zbx_hashset_search(&row_values->values,
+				&row_value_local)))
+		{
+			row_value = (zbx_lld_row_value_t *)zbx_hashset_insert(&row_values->values, &row_value_local,
+					sizeof(row_value_local));
+			zbx_vector_ptr_create(&row_value->lld_rows);
+			buffer = NULL;
+		}
+
+		zbx_vector_ptr_append(&row_value->lld_rows, lld_row);
+	}
+
+	zbx_free(buffer);
+
+	return &row_values->values;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: lld_item_key_expand                                              *
+ *                                                                            *
+ * Purpose: expands lld macros in item prototype key                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	lld_item_key_expand(char **data, const zbx_lld_row_t *lld_row, const zbx_vector_ptr_t *lld_macro_paths)
+{
+	return substitute_key_macros(data, NULL, NULL, &lld_row->jp_row, lld_macro_paths, MACRO_TYPE_ITEM_KEY,
+			NULL, 0);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: lld_items_make                                                   *
@@ -2399,65 +2550,53 @@ static void	lld_items_make(const zbx_vector_ptr_t *item_prototypes, const zbx_ve
 		const zbx_vector_ptr_t *lld_macro_paths, zbx_vector_ptr_t *items, zbx_hashset_t *items_index,
 		char **error)
 {
-	int				i, j, index;
+	int				i, j;
 	zbx_lld_item_prototype_t	*item_prototype;
 	zbx_lld_item_t			*item;
-	zbx_lld_row_t			*lld_row;
 	zbx_lld_item_index_t		*item_index, item_index_local;
-	char				*buffer = NULL;
+	zbx_hashset_t			row_values_index, *row_values;
+	zbx_lld_row_value_t		*row_value, row_value_local;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	/* create the items index */
-	for (i = 0; i < item_prototypes->values_num; i++)
-	{
-		item_prototype = (zbx_lld_item_prototype_t *)item_prototypes->values[i];
-
-		for (j = 0; j < lld_rows->values_num; j++)
-			zbx_vector_ptr_append(&item_prototype->lld_rows, lld_rows->values[j]);
-	}
+	zbx_hashset_create(&row_values_index, item_prototypes->values_num, lld_row_values_hash_func,
+			lld_row_values_compare_func);
 
-	/* Iterate in reverse order because usually the items are created in the same order as     */
-	/* incoming lld rows. Iterating in reverse optimizes lld_row removal from item prototypes. */
-	for (i = items->values_num - 1; i >= 0; i--)
+	/* match existing items to lld rows by their keys */
+	for (i = 0; i < items->values_num; i++)
 	{
 		item = (zbx_lld_item_t *)items->values[i];
 
-		if (FAIL == (index = zbx_vector_ptr_bsearch(item_prototypes, &item->parent_itemid,
-				ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC)))
+		if (FAIL == zbx_vector_ptr_bsearch(item_prototypes, &item->parent_itemid,
+				ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC))
 		{
 			THIS_SHOULD_NEVER_HAPPEN;
 			continue;
 		}
 
-		item_prototype = (zbx_lld_item_prototype_t *)item_prototypes->values[index];
+		row_values = lld_row_values_get(&row_values_index, item->parent_itemid, item->key_proto, lld_rows,
+				lld_macro_paths, lld_item_key_expand);
 
-		for (j = item_prototype->lld_rows.values_num - 1; j >= 0; j--)
+		row_value_local.value = item->key;
+
+		if (NULL == (row_value = (zbx_lld_row_value_t *)zbx_hashset_search(row_values, &row_value_local)) ||
+				0 == row_value->lld_rows.values_num)
 		{
-			lld_row = (zbx_lld_row_t *)item_prototype->lld_rows.values[j];
+			continue;
+		}
 
-			buffer = zbx_strdup(buffer, item->key_proto);
+		/* each lld row can be matched to one item of the prototype */
+		j = row_value->lld_rows.values_num - 1;
 
-			if (SUCCEED != substitute_key_macros(&buffer, NULL, NULL, &lld_row->jp_row, lld_macro_paths,
-					MACRO_TYPE_ITEM_KEY, NULL, 0))
-			{
-				continue;
-			}
-
-			if (0 == strcmp(item->key, buffer))
-			{
-				item_index_local.parent_itemid = item->parent_itemid;
-				item_index_local.lld_row = lld_row;
-				item_index_local.item = item;
-				zbx_hashset_insert(items_index, &item_index_local, sizeof(item_index_local));
+		item_index_local.parent_itemid = item->parent_itemid;
+		item_index_local.lld_row = (zbx_lld_row_t *)row_value->lld_rows.values[j];
+		item_index_local.item = item;
+		zbx_hashset_insert(items_index, &item_index_local, sizeof(item_index_local));
 
-				zbx_vector_ptr_remove_noorder(&item_prototype->lld_rows, j);
-				break;
-			}
-		}
+		zbx_vector_ptr_remove(&row_value->lld_rows, j);
 	}
 
-	zbx_free(buffer);
+	lld_row_values_clean(&row_values_index);
 
 	/* update/create discovered items */
 	for (i = 0; i < item_prototypes->values_num; i++)
@@ -4504,6 +4643,22 @@ static void	lld_application_make(const zbx_lld_application_prototype_t *applicat
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: lld_application_name_expand                                      *
+ *                                                                            *
+ * Purpose: expands lld macros in application prototype name                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	lld_application_name_expand(char **data, const zbx_lld_row_t *lld_row,
+		const zbx_vector_ptr_t *lld_macro_paths)
+{
+	substitute_lld_macros(data, &lld_row->jp_row, lld_macro_paths, ZBX_MACRO_ANY, NULL, 0);
+	zbx_lrtrim(*data, ZBX_WHITESPACE);
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: lld_applications_make                                            *
@@ -4526,38 +4681,43 @@ static void	lld_applications_make(const zbx_vector_ptr_t *application_prototypes
 	zbx_lld_application_t		*application;
 	zbx_lld_row_t			*lld_row;
 	zbx_lld_application_index_t	application_index_local;
-	char				*buffer = NULL;
+	zbx_hashset_t			row_values_index, *row_values;
+	zbx_lld_row_value_t		*row_value, row_value_local;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	/* index existing applications */
 
+	zbx_hashset_create(&row_values_index, application_prototypes->values_num, lld_row_values_hash_func,
+			lld_row_values_compare_func);
+
 	for (i = 0; i < applications->values_num; i++)
 	{
 		application = (zbx_lld_application_t *)applications->values[i];
 
-		for (j = 0; j < lld_rows->values_num; j++)
-		{
-			lld_row = (zbx_lld_row_t *)lld_rows->values[j];
+		row_values = lld_row_values_get(&row_values_index, application->application_prototypeid,
+				application->name_proto, lld_rows, lld_macro_paths, lld_application_name_expand);
 
-			buffer = zbx_strdup(buffer, application->name_proto);
-			substitute_lld_macros(&buffer, &lld_row->jp_row, lld_macro_paths, ZBX_MACRO_ANY, NULL, 0);
-			zbx_lrtrim(buffer, ZBX_WHITESPACE);
+		row_value_local.value = application->name;
 
-			if (0 == strcmp(application->name, buffer))
-			{
-				application_index_local.application_prototypeid = application->application_prototypeid;
-				application_index_local.lld_row = lld_row;
-				application_index_local.application = application;
-				zbx_hashset_insert(applications_index, &application_index_local,
-						sizeof(application_index_local));
+		if (NULL == (row_value = (zbx_lld_row_value_t *)zbx_hashset_search(row_values, &row_value_local)))
+			continue;
 
-				application->lld_row = lld_row;
-			}
+		for (j = 0; j < row_value->lld_rows.values_num; j++)
+		{
+			lld_row = (zbx_lld_row_t *)row_value->lld_rows.values[j];
+
+			application_index_local.application_prototypeid = application->application_prototypeid;
+			application_index_local.lld_row = lld_row;
+			application_index_local.application = application;
+			zbx_hashset_insert(applications_index, &application_index_local,
+					sizeof(application_index_local));
+
+			application->lld_row = lld_row;
 		}
 	}
 
-	zbx_free(buffer);
+	lld_row_values_clean(&row_values_index);
 
 	/* make the applications */
 	for (i = 0; i < application_prototypes->values_num; i++)
@@ -5065,7 +5225,6 @@ static void	lld_item_prototypes_get(zbx_uint64_t lld_ruleid, zbx_vector_ptr_t *i
 		ZBX_STR2UCHAR(item_prototype->verify_host, row[51]);
 		ZBX_STR2UCHAR(item_prototype->allow_traps, row[52]);
 
-		zbx_vector_ptr_create(&item_prototype->lld_rows);
 		zbx_vector_ptr_create(&item_prototype->applications);
 		zbx_vector_ptr_create(&item_prototype->preproc_ops);
 
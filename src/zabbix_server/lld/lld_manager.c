@@ -43,6 +43,14 @@ extern int	CONFIG_LLDWORKER_FORKS;
  * values in the list the rule is removed from the index (rule_index hashset),
  * otherwise the rule is enqueued back in LLD queue.
  *
+ * Only the newest discovery data matters, so a rule keeps at most two values -
+ * the oldest one, which might be already sent to a worker, and the newest one
+ * replacing any other values received meanwhile.
+ *
+ * The state of the last full processing of each rule (rule_states hashset) is
+ * sent to workers with the rule value and updated from their done responses,
+ * allowing workers to skip the rules with unchanged discovery data.
+ *
  */
 
 typedef struct zbx_lld_value
@@ -59,6 +67,14 @@ typedef struct zbx_lld_value
 }
 zbx_lld_data_t;
 
+/* the last full processing of LLD rule */
+typedef struct
+{
+	zbx_uint64_t		itemid;
+	zbx_lld_rule_state_t	state;
+}
+zbx_lld_rule_state_ref_t;
+
 /* queue of values for one LLD rule */
 typedef struct
 {
@@ -96,6 +112,8 @@ typedef struct
 	/* the number of queued LLD rules */
 	zbx_uint64_t		queued_num;
 
+	/* the last full processing of LLD rules, indexed by rule id */
+	zbx_hashset_t		rule_states;
 }
 zbx_lld_manager_t;
 
@@ -209,6 +227,8 @@ static void	lld_manager_init(zbx_lld_manager_t *manager)
 
 	zbx_binary_heap_create(&manager->rule_queue, rule_elem_compare_func, ZBX_BINARY_HEAP_OPTION_EMPTY);
 
+	zbx_hashset_create(&manager->rule_states, 0, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
 	manager->next_worker_index = 0;
 
 	for (i = 0; i < CONFIG_LLDWORKER_FORKS; i++)
@@ -238,6 +258,7 @@ static void	lld_manager_destroy(zbx_lld_manager_t *manager)
 {
 	zbx_binary_heap_destroy(&manager->rule_queue);
 	zbx_hashset_destroy(&manager->rule_index);
+	zbx_hashset_destroy(&manager->rule_states);
 	zbx_queue_ptr_destroy(&manager->free_workers);
 	zbx_hashset_destroy(&manager->workers_client);
 	zbx_vector_ptr_clear_ext(&manager->workers, (zbx_clean_func_t)lld_worker_free);
@@ -365,6 +386,17 @@ static void	lld_queue_request(zbx_lld_manager_t *manager, const zbx_ipc_message_
 		rule = zbx_hashset_insert(&manager->rule_index, &rule_local, sizeof(rule_local));
 		lld_queue_rule(manager, rule);
 	}
+	else if (rule->head != rule->tail)
+	{
+		/* the oldest value might be processed already, replace the waiting value with the newest one */
+		zabbix_log(LOG_LEVEL_DEBUG, "replacing queued value of discovery rule:" ZBX_FS_UI64, itemid);
+
+		lld_data_free(rule->tail);
+		rule->head->next = data;
+		rule->tail = data;
+
+		goto out;
+	}
 	else
 	{
 		rule->tail->next = data;
@@ -372,7 +404,7 @@ static void	lld_queue_request(zbx_lld_manager_t *manager, const zbx_ipc_message_
 	}
 
 	manager->queued_num++;
-
+out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
@@ -388,17 +420,27 @@ static void	lld_queue_request(zbx_lld_manager_t *manager, const zbx_ipc_message_
  ******************************************************************************/
 static void	lld_process_next_request(zbx_lld_manager_t *manager, zbx_lld_worker_t *worker)
 {
-	zbx_binary_heap_elem_t	*elem;
-	unsigned char		*buf;
-	zbx_uint32_t		buf_len;
-	zbx_lld_data_t		*data;
+	zbx_binary_heap_elem_t		*elem;
+	unsigned char			*buf;
+	zbx_uint32_t			buf_len;
+	zbx_lld_data_t			*data;
+	zbx_lld_rule_state_ref_t	*rule_state;
+	zbx_lld_rule_state_t		state;
 
 	elem = zbx_binary_heap_find_min(&manager->rule_queue);
 	worker->rule = (zbx_lld_rule_t *)elem->data;
 	zbx_binary_heap_remove_min(&manager->rule_queue);
 
+	if (NULL != (rule_state = (zbx_lld_rule_state_ref_t *)zbx_hashset_search(&manager->rule_states,
+			&worker->rule->itemid)))
+	{
+		state = rule_state->state;
+	}
+	else
+		memset(&state, 0, sizeof(state));
+
 	data = worker->rule->head;
-	buf_len = zbx_lld_serialize_item_value(&buf, worker->rule->itemid, data->value, &data->ts, data->meta,
+	buf_len = zbx_lld_serialize_task(&buf, &state, worker->rule->itemid, data->value, &data->ts, data->meta,
 			data->lastlogsize, data->mtime, data->error);
 	zbx_ipc_client_send(worker->client, ZBX_IPC_LLD_TASK, buf, buf_len);
 	zbx_free(buf);
@@ -433,14 +475,18 @@ static void	lld_process_queue(zbx_lld_manager_t *manager)
  * Purpose: processes LLD worker 'done' response                              *
  *                                                                            *
  * Parameters: manager - [IN] the LLD manager                                 *
- * Parameters: client  - [IN] the worker's IPC client connection              *
+ *             client  - [IN] the worker's IPC client connection              *
+ *             message - [IN] the message with the rule state                 *
  *                                                                            *
  ******************************************************************************/
-static void	lld_process_result(zbx_lld_manager_t *manager, zbx_ipc_client_t *client)
+static void	lld_process_result(zbx_lld_manager_t *manager, zbx_ipc_client_t *client,
+		const zbx_ipc_message_t *message)
 {
-	zbx_lld_worker_t	*worker;
-	zbx_lld_rule_t		*rule;
-	zbx_lld_data_t		*data;
+	zbx_lld_worker_t		*worker;
+	zbx_lld_rule_t			*rule;
+	zbx_lld_data_t			*data;
+	zbx_lld_rule_state_ref_t	*rule_state;
+	zbx_lld_rule_state_t		state;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -451,6 +497,25 @@ static void	lld_process_result(zbx_lld_manager_t *manager, zbx_ipc_client_t *cli
 	rule = worker->rule;
 	worker->rule = NULL;
 
+	memcpy(&state, message->data, sizeof(state));
+
+	if (NULL == (rule_state = (zbx_lld_rule_state_ref_t *)zbx_hashset_search(&manager->rule_states,
+			&rule->itemid)))
+	{
+		if (0 != state.processed)
+		{
+			zbx_lld_rule_state_ref_t	rule_state_local;
+
+			rule_state_local.itemid = rule->itemid;
+			rule_state_local.state = state;
+			zbx_hashset_insert(&manager->rule_states, &rule_state_local, sizeof(rule_state_local));
+		}
+	}
+	else if (0 != state.processed)
+		rule_state->state = state;
+	else
+		zbx_hashset_remove_direct(&manager->rule_states, rule_state);
+
 	data = rule->head;
 	rule->head = rule->head->next;
 
@@ -469,6 +534,30 @@ static void	lld_process_result(zbx_lld_manager_t *manager, zbx_ipc_client_t *cli
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: lld_remove_expired_rule_states                                   *
+ *                                                                            *
+ * Purpose: removes states of LLD rules that were not fully processed for     *
+ *          too long to allow skipping their data                             *
+ *                                                                            *
+ * Parameters: manager - [IN] the LLD manager                                 *
+ *             now     - [IN] the current time                                *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_remove_expired_rule_states(zbx_lld_manager_t *manager, int now)
+{
+	zbx_hashset_iter_t		iter;
+	zbx_lld_rule_state_ref_t	*rule_state;
+
+	zbx_hashset_iter_reset(&manager->rule_states, &iter);
+	while (NULL != (rule_state = (zbx_lld_rule_state_ref_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (now - rule_state->state.processed >= ZBX_LLD_FULL_PROCESSING_PERIOD)
+			zbx_hashset_iter_remove(&iter);
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: lld_manager_thread                                               *
@@ -485,7 +574,7 @@ ZBX_THREAD_ENTRY(lld_manager_thread, args)
 	char			*error = NULL;
 	zbx_ipc_client_t	*client;
 	zbx_ipc_message_t	*message;
-	double			time_stat, time_now, sec;
+	double			time_stat, time_now, sec, time_cleanup;
 	zbx_lld_manager_t	manager;
 	zbx_uint64_t		processed_num = 0;
 
@@ -509,6 +598,7 @@ ZBX_THREAD_ENTRY(lld_manager_thread, args)
 
 	/* initialize statistics */
 	time_stat = zbx_time();
+	time_cleanup = time_stat;
 
 	zbx_setproctitle("%s #%d started", get_process_type_string(process_type), process_num);
 
@@ -528,6 +618,12 @@ ZBX_THREAD_ENTRY(lld_manager_thread, args)
 			processed_num = 0;
 		}
 
+		if (ZBX_LLD_FULL_PROCESSING_PERIOD < time_now - time_cleanup)
+		{
+			lld_remove_expired_rule_states(&manager, (int)time_now);
+			time_cleanup = time_now;
+		}
+
 		update_selfmon_counter(ZBX_PROCESS_STATE_IDLE);
 		zbx_ipc_service_recv(&lld_service, 1, &client, &message);
 		update_selfmon_counter(ZBX_PROCESS_STATE_BUSY);
@@ -547,7 +643,7 @@ ZBX_THREAD_ENTRY(lld_manager_thread, args)
 					lld_process_queue(&manager);
 					break;
 				case ZBX_IPC_LLD_DONE:
-					lld_process_result(&manager, client);
+					lld_process_result(&manager, client, message);
 					processed_num++;
 					manager.queued_num--;
 					break;
@@ -27,15 +27,21 @@
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_lld_serialize_item_value                                     *
+ * Function: lld_serialize_item_value                                         *
+ *                                                                            *
+ * Purpose: serializes item value, optionally preceded by LLD rule state      *
  *                                                                            *
  ******************************************************************************/
-zbx_uint32_t	zbx_lld_serialize_item_value(unsigned char **data, zbx_uint64_t itemid, const char *value,
-		const zbx_timespec_t *ts, unsigned char meta, zbx_uint64_t lastlogsize, int mtime, const char *error)
+static zbx_uint32_t	lld_serialize_item_value(unsigned char **data, const zbx_lld_rule_state_t *state,
+		zbx_uint64_t itemid, const char *value, const zbx_timespec_t *ts, unsigned char meta,
+		zbx_uint64_t lastlogsize, int mtime, const char *error)
 {
 	unsigned char	*ptr;
 	zbx_uint32_t	data_len = 0, value_len, error_len;
 
+	if (NULL != state)
+		zbx_serialize_prepare_value(data_len, *state);
+
 	zbx_serialize_prepare_value(data_len, itemid);
 	zbx_serialize_prepare_str(data_len, value);
 	zbx_serialize_prepare_value(data_len, *ts);
@@ -51,6 +57,10 @@ zbx_uint32_t	zbx_lld_serialize_item_value(unsigned char **data, zbx_uint64_t ite
 	*data = (unsigned char *)zbx_malloc(NULL, data_len);
 
 	ptr = *data;
+
+	if (NULL != state)
+		ptr += zbx_serialize_value(ptr, *state);
+
 	ptr += zbx_serialize_value(ptr, itemid);
 	ptr += zbx_serialize_str(ptr, value, value_len);
 	ptr += zbx_serialize_value(ptr, *ts);
@@ -65,6 +75,17 @@ zbx_uint32_t	zbx_lld_serialize_item_value(unsigned char **data, zbx_uint64_t ite
 	return data_len;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_lld_serialize_item_value                                     *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint32_t	zbx_lld_serialize_item_value(unsigned char **data, zbx_uint64_t itemid, const char *value,
+		const zbx_timespec_t *ts, unsigned char meta, zbx_uint64_t lastlogsize, int mtime, const char *error)
+{
+	return lld_serialize_item_value(data, NULL, itemid, value, ts, meta, lastlogsize, mtime, error);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_lld_deserialize_item_value                                   *
@@ -87,6 +108,33 @@ void	zbx_lld_deserialize_item_value(const unsigned char *data, zbx_uint64_t *ite
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_lld_serialize_task                                           *
+ *                                                                            *
+ * Purpose: serializes LLD rule value together with the rule state for worker *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint32_t	zbx_lld_serialize_task(unsigned char **data, const zbx_lld_rule_state_t *state, zbx_uint64_t itemid,
+		const char *value, const zbx_timespec_t *ts, unsigned char meta, zbx_uint64_t lastlogsize, int mtime,
+		const char *error)
+{
+	return lld_serialize_item_value(data, state, itemid, value, ts, meta, lastlogsize, mtime, error);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_lld_deserialize_task                                         *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_lld_deserialize_task(const unsigned char *data, zbx_lld_rule_state_t *state, zbx_uint64_t *itemid,
+		char **value, zbx_timespec_t *ts, unsigned char *meta, zbx_uint64_t *lastlogsize, int *mtime,
+		char **error)
+{
+	data += zbx_deserialize_value(data, state);
+	zbx_lld_deserialize_item_value(data, itemid, value, ts, meta, lastlogsize, mtime, error);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_lld_process_value                                            *
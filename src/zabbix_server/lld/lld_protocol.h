@@ -21,9 +21,24 @@
 #define ZABBIX_LLD_PROTOCOL_H
 
 #include "common.h"
+#include "md5.h"
 
 #define ZBX_IPC_SERVICE_LLD	"lld"
 
+/* how long unchanged discovery data can be skipped after full processing of LLD rule */
+#define ZBX_LLD_FULL_PROCESSING_PERIOD	(10 * SEC_PER_MIN)
+
+/* the last full processing of LLD rule, kept by manager and passed with tasks to workers */
+typedef struct
+{
+	/* checksum of the discovery data, rule settings, prototypes and host configuration revision */
+	md5_byte_t	checksum[MD5_DIGEST_SIZE];
+
+	/* the time of the last full processing, 0 if rule must be fully processed */
+	int		processed;
+}
+zbx_lld_rule_state_t;
+
 /* LLD -> manager */
 #define ZBX_IPC_LLD_REGISTER		1000
 #define ZBX_IPC_LLD_DONE		1001
@@ -43,4 +58,12 @@ zbx_uint32_t	zbx_lld_serialize_item_value(unsigned char **data, zbx_uint64_t ite
 void	zbx_lld_deserialize_item_value(const unsigned char *data, zbx_uint64_t *itemid, char **value,
 		zbx_timespec_t *ts, unsigned char *meta, zbx_uint64_t *lastlogsize, int *mtime, char **error);
 
+zbx_uint32_t	zbx_lld_serialize_task(unsigned char **data, const zbx_lld_rule_state_t *state, zbx_uint64_t itemid,
+		const char *value, const zbx_timespec_t *ts, unsigned char meta, zbx_uint64_t lastlogsize, int mtime,
+		const char *error);
+
+void	zbx_lld_deserialize_task(const unsigned char *data, zbx_lld_rule_state_t *state, zbx_uint64_t *itemid,
+		char **value, zbx_timespec_t *ts, unsigned char *meta, zbx_uint64_t *lastlogsize, int *mtime,
+		char **error);
+
 #endif
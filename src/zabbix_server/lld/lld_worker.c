@@ -26,6 +26,7 @@
 #include "proxy.h"
 #include "../events.h"
 
+#include "lld.h"
 #include "lld_worker.h"
 #include "lld_protocol.h"
 
@@ -58,9 +59,11 @@ static void	lld_register_worker(zbx_ipc_socket_t *socket)
  *          cache and database                                                *
  *                                                                            *
  * Parameters: message - [IN] the message with LLD request                    *
+ *             state   - [OUT] the state of the last full processing of the   *
+ *                             rule                                           *
  *                                                                            *
  ******************************************************************************/
-static void	lld_process_task(zbx_ipc_message_t *message)
+static void	lld_process_task(zbx_ipc_message_t *message, zbx_lld_rule_state_t *state)
 {
 	zbx_uint64_t		itemid, lastlogsize;
 	char			*value, *error;
@@ -68,15 +71,18 @@ static void	lld_process_task(zbx_ipc_message_t *message)
 	zbx_item_diff_t		diff;
 	DC_ITEM			item;
 	int			errcode, mtime;
-	unsigned char		state, meta;
+	unsigned char		item_state, meta;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_lld_deserialize_item_value(message->data, &itemid, &value, &ts, &meta, &lastlogsize, &mtime, &error);
+	zbx_lld_deserialize_task(message->data, state, &itemid, &value, &ts, &meta, &lastlogsize, &mtime, &error);
 
 	DCconfig_get_items_by_itemids(&item, &itemid, &errcode, 1);
 	if (SUCCEED != errcode)
+	{
+		memset(state, 0, sizeof(*state));
 		goto out;
+	}
 
 	zabbix_log(LOG_LEVEL_DEBUG, "processing discovery rule:" ZBX_FS_UI64, itemid);
 
@@ -84,17 +90,22 @@ static void	lld_process_task(zbx_ipc_message_t *message)
 
 	if (NULL != error || NULL != value)
 	{
-		if (NULL == error && SUCCEED == lld_process_discovery_rule(itemid, value, &error))
-			state = ITEM_STATE_NORMAL;
+		if (NULL == error && SUCCEED == lld_process_discovery_rule(itemid, value, state, &error))
+		{
+			item_state = ITEM_STATE_NORMAL;
+		}
 		else
-			state = ITEM_STATE_NOTSUPPORTED;
+		{
+			item_state = ITEM_STATE_NOTSUPPORTED;
+			memset(state, 0, sizeof(*state));
+		}
 
-		if (state != item.state)
+		if (item_state != item.state)
 		{
-			diff.state = state;
+			diff.state = item_state;
 			diff.flags |= ZBX_FLAGS_ITEM_DIFF_UPDATE_STATE;
 
-			if (ITEM_STATE_NORMAL == state)
+			if (ITEM_STATE_NORMAL == item_state)
 			{
 				zabbix_log(LOG_LEVEL_WARNING, "discovery rule \"%s:%s\" became supported",
 						item.host.host, item.key_orig);
@@ -176,6 +187,7 @@ ZBX_THREAD_ENTRY(lld_worker_thread, args)
 	char			*error = NULL;
 	zbx_ipc_socket_t	lld_socket;
 	zbx_ipc_message_t	message;
+	zbx_lld_rule_state_t	state;
 	double			time_stat, time_idle = 0, time_now, time_read;
 	zbx_uint64_t		processed_num = 0;
 
@@ -238,8 +250,9 @@ ZBX_THREAD_ENTRY(lld_worker_thread, args)
 		switch (message.code)
 		{
 			case ZBX_IPC_LLD_TASK:
-				lld_process_task(&message);
-				zbx_ipc_socket_write(&lld_socket, ZBX_IPC_LLD_DONE, NULL, 0);
+				lld_process_task(&message, &state);
+				zbx_ipc_socket_write(&lld_socket, ZBX_IPC_LLD_DONE, (unsigned char *)&state,
+						sizeof(state));
 				processed_num++;
 				break;
 		}
@@ -20,6 +20,7 @@
 #include "common.h"
 #include "comms.h"
 #include "log.h"
+#include "zbxjson.h"
 #include "../../libs/zbxcrypto/tls_tcp_active.h"
 
 #include "checks_agent.h"
@@ -28,6 +29,118 @@
 extern unsigned char	program_type;
 #endif
 
+/* retry bulk requests to the agents that did not support them after this period */
+#define ZBX_AGENT_BULK_RETRY_PERIOD	SEC_PER_HOUR
+
+typedef struct
+{
+	zbx_uint64_t	interfaceid;
+	time_t		retry_time;
+}
+zbx_agent_interface_t;
+
+/* interfaces of the agents that do not support bulk requests */
+static zbx_hashset_t	bulk_unsupported;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_get_tls_args                                               *
+ *                                                                            *
+ * Purpose: get TLS connection arguments of the item host                     *
+ *                                                                            *
+ * Parameters: item     - [IN] the item                                       *
+ *             tls_arg1 - [OUT] the first TLS argument                        *
+ *             tls_arg2 - [OUT] the second TLS argument                       *
+ *             error    - [OUT] the error message                             *
+ *                                                                            *
+ * Return value: SUCCEED - the arguments were retrieved                       *
+ *               CONFIG_ERROR - invalid TLS configuration                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	agent_get_tls_args(const DC_ITEM *item, const char **tls_arg1, const char **tls_arg2, char **error)
+{
+	switch (item->host.tls_connect)
+	{
+		case ZBX_TCP_SEC_UNENCRYPTED:
+			*tls_arg1 = NULL;
+			*tls_arg2 = NULL;
+			break;
+#if defined(HAVE_POLARSSL) || defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
+		case ZBX_TCP_SEC_TLS_CERT:
+			*tls_arg1 = item->host.tls_issuer;
+			*tls_arg2 = item->host.tls_subject;
+			break;
+		case ZBX_TCP_SEC_TLS_PSK:
+			*tls_arg1 = item->host.tls_psk_identity;
+			*tls_arg2 = item->host.tls_psk;
+			break;
+#else
+		case ZBX_TCP_SEC_TLS_CERT:
+		case ZBX_TCP_SEC_TLS_PSK:
+			*error = zbx_dsprintf(NULL, "A TLS connection is configured to be used with agent"
+					" but support for TLS was not compiled into %s.",
+					get_program_type_string(program_type));
+			return CONFIG_ERROR;
+#endif
+		default:
+			THIS_SHOULD_NEVER_HAPPEN;
+			*error = zbx_strdup(NULL, "Invalid TLS connection parameters.");
+			return CONFIG_ERROR;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_set_result                                                 *
+ *                                                                            *
+ * Purpose: set item result from the agent reply to a single item key         *
+ *                                                                            *
+ * Parameters: item   - [IN] the item                                         *
+ *             reply  - [IN] the agent reply                                  *
+ *             len    - [IN] the reply length, including the error message    *
+ *                           following ZBX_NOTSUPPORTED                       *
+ *             result - [OUT] the item value or error message                 *
+ *                                                                            *
+ * Return value: SUCCEED - the value was received                             *
+ *               NETWORK_ERROR - the agent replied with empty response        *
+ *               NOTSUPPORTED - item not supported by the agent               *
+ *               AGENT_ERROR - uncritical error on agent side occurred        *
+ *                                                                            *
+ ******************************************************************************/
+static int	agent_set_result(const DC_ITEM *item, char *reply, size_t len, AGENT_RESULT *result)
+{
+	if (0 == strcmp(reply, ZBX_NOTSUPPORTED))
+	{
+		/* 'ZBX_NOTSUPPORTED\0<error message>' */
+		if (sizeof(ZBX_NOTSUPPORTED) < len)
+			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "%s", reply + sizeof(ZBX_NOTSUPPORTED)));
+		else
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Not supported by Zabbix Agent"));
+
+		return NOTSUPPORTED;
+	}
+
+	if (0 == strcmp(reply, ZBX_ERROR))
+	{
+		SET_MSG_RESULT(result, zbx_strdup(NULL, "Zabbix Agent non-critical error"));
+		return AGENT_ERROR;
+	}
+
+	if (0 == len)
+	{
+		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Received empty response from Zabbix Agent at [%s]."
+				" Assuming that agent dropped connection because of access permissions.",
+				item->interface.addr));
+		return NETWORK_ERROR;
+	}
+
+	set_result_type(result, ITEM_VALUE_TYPE_TEXT, reply);
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: get_value_agent                                                  *
@@ -51,42 +164,18 @@ extern unsigned char	program_type;
 int	get_value_agent(DC_ITEM *item, AGENT_RESULT *result)
 {
 	zbx_socket_t	s;
-	char		*tls_arg1, *tls_arg2;
+	const char	*tls_arg1, *tls_arg2;
+	char		*error = NULL;
 	int		ret = SUCCEED;
 	ssize_t		received_len;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() host:'%s' addr:'%s' key:'%s' conn:'%s'", __func__, item->host.host,
 			item->interface.addr, item->key, zbx_tcp_connection_type_name(item->host.tls_connect));
 
-	switch (item->host.tls_connect)
+	if (SUCCEED != (ret = agent_get_tls_args(item, &tls_arg1, &tls_arg2, &error)))
 	{
-		case ZBX_TCP_SEC_UNENCRYPTED:
-			tls_arg1 = NULL;
-			tls_arg2 = NULL;
-			break;
-#if defined(HAVE_POLARSSL) || defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
-		case ZBX_TCP_SEC_TLS_CERT:
-			tls_arg1 = item->host.tls_issuer;
-			tls_arg2 = item->host.tls_subject;
-			break;
-		case ZBX_TCP_SEC_TLS_PSK:
-			tls_arg1 = item->host.tls_psk_identity;
-			tls_arg2 = item->host.tls_psk;
-			break;
-#else
-		case ZBX_TCP_SEC_TLS_CERT:
-		case ZBX_TCP_SEC_TLS_PSK:
-			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "A TLS connection is configured to be used with agent"
-					" but support for TLS was not compiled into %s.",
-					get_program_type_string(program_type)));
-			ret = CONFIG_ERROR;
-			goto out;
-#endif
-		default:
-			THIS_SHOULD_NEVER_HAPPEN;
-			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid TLS connection parameters."));
-			ret = CONFIG_ERROR;
-			goto out;
+		SET_MSG_RESULT(result, error);
+		goto out;
 	}
 
 	if (SUCCEED == (ret = zbx_tcp_connect(&s, CONFIG_SOURCE_IP, item->interface.addr, item->interface.port, 0,
@@ -109,38 +198,304 @@ int	get_value_agent(DC_ITEM *item, AGENT_RESULT *result)
 	if (SUCCEED == ret)
 	{
 		zabbix_log(LOG_LEVEL_DEBUG, "get value from agent result: '%s'", s.buffer);
+		ret = agent_set_result(item, s.buffer, (size_t)received_len, result);
+	}
+	else
+		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Get value from agent failed: %s", zbx_socket_strerror()));
+
+	zbx_tcp_close(&s);
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_bulk_is_supported                                          *
+ *                                                                            *
+ * Purpose: check if bulk requests can be sent to the agent interface         *
+ *                                                                            *
+ ******************************************************************************/
+static int	agent_bulk_is_supported(zbx_uint64_t interfaceid)
+{
+	zbx_agent_interface_t	*interface;
+
+	if (NULL == bulk_unsupported.slots)
+		return SUCCEED;
+
+	if (NULL == (interface = (zbx_agent_interface_t *)zbx_hashset_search(&bulk_unsupported, &interfaceid)))
+		return SUCCEED;
+
+	if (interface->retry_time > time(NULL))
+		return FAIL;
+
+	zbx_hashset_remove_direct(&bulk_unsupported, interface);
 
-		if (0 == strcmp(s.buffer, ZBX_NOTSUPPORTED))
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_bulk_set_unsupported                                       *
+ *                                                                            *
+ * Purpose: remember that the agent interface does not support bulk requests  *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_bulk_set_unsupported(zbx_uint64_t interfaceid)
+{
+	zbx_agent_interface_t	interface_local;
+
+	if (NULL == bulk_unsupported.slots)
+	{
+		zbx_hashset_create(&bulk_unsupported, 100, ZBX_DEFAULT_UINT64_HASH_FUNC,
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	}
+
+	interface_local.interfaceid = interfaceid;
+	interface_local.retry_time = time(NULL) + ZBX_AGENT_BULK_RETRY_PERIOD;
+
+	zbx_hashset_insert(&bulk_unsupported, &interface_local, sizeof(interface_local));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: get_values_agent_bulk                                            *
+ *                                                                            *
+ * Purpose: retrieve values of multiple items from Zabbix agent over a single *
+ *          connection                                                        *
+ *                                                                            *
+ * Parameters: items    - [IN] the items of the same agent interface          *
+ *             results  - [OUT] the item values                               *
+ *             errcodes - [IN/OUT] the item error codes, only items with      *
+ *                                 SUCCEED error code are requested           *
+ *             done     - [OUT] set for items having result                   *
+ *             num      - [IN] the number of items                            *
+ *                                                                            *
+ * Return value: SUCCEED - the request was sent, items without results must   *
+ *                         be requested separately                            *
+ *               FAIL    - the agent does not support bulk requests           *
+ *                                                                            *
+ ******************************************************************************/
+static int	get_values_agent_bulk(const DC_ITEM *items, AGENT_RESULT *results, int *errcodes, unsigned char *done,
+		int num)
+{
+	zbx_socket_t		s;
+	struct zbx_json		j;
+	struct zbx_json_parse	jp, jp_data, jp_row;
+	const char		*tls_arg1, *tls_arg2, *p = NULL;
+	char			*error = NULL, *value = NULL, response[MAX_STRING_LEN];
+	size_t			value_alloc = 0;
+	int			i, ret, requested[MAX_POLLER_ITEMS], requested_num = 0;
+	ssize_t			received_len = 0;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() host:'%s' addr:'%s' num:%d conn:'%s'", __func__, items[0].host.host,
+			items[0].interface.addr, num, zbx_tcp_connection_type_name(items[0].host.tls_connect));
+
+	if (SUCCEED != (ret = agent_get_tls_args(&items[0], &tls_arg1, &tls_arg2, &error)))
+	{
+		for (i = 0; i < num; i++)
 		{
-			/* 'ZBX_NOTSUPPORTED\0<error message>' */
-			if (sizeof(ZBX_NOTSUPPORTED) < s.read_bytes)
-				SET_MSG_RESULT(result, zbx_dsprintf(NULL, "%s", s.buffer + sizeof(ZBX_NOTSUPPORTED)));
-			else
-				SET_MSG_RESULT(result, zbx_strdup(NULL, "Not supported by Zabbix Agent"));
+			if (SUCCEED != errcodes[i])
+				continue;
 
-			ret = NOTSUPPORTED;
+			SET_MSG_RESULT(&results[i], zbx_strdup(NULL, error));
+			errcodes[i] = ret;
+			done[i] = 1;
 		}
-		else if (0 == strcmp(s.buffer, ZBX_ERROR))
+
+		zbx_free(error);
+		ret = SUCCEED;
+		goto out;
+	}
+
+	zbx_json_init(&j, ZBX_JSON_STAT_BUF_LEN);
+	zbx_json_addstring(&j, ZBX_PROTO_TAG_REQUEST, ZBX_PROTO_VALUE_PASSIVE_CHECKS, ZBX_JSON_TYPE_STRING);
+	zbx_json_adduint64(&j, ZBX_PROTO_TAG_TIMEOUT, CONFIG_TIMEOUT);
+	zbx_json_addarray(&j, ZBX_PROTO_TAG_DATA);
+
+	for (i = 0; i < num; i++)
+	{
+		if (SUCCEED != errcodes[i])
+			continue;
+
+		zbx_json_addobject(&j, NULL);
+		zbx_json_addstring(&j, ZBX_PROTO_TAG_KEY, items[i].key, ZBX_JSON_TYPE_STRING);
+		zbx_json_close(&j);
+
+		requested[requested_num++] = i;
+	}
+
+	zbx_json_close(&j);
+
+	zbx_alarm_on(CONFIG_TIMEOUT);
+
+	if (SUCCEED != zbx_tcp_connect(&s, CONFIG_SOURCE_IP, items[0].interface.addr, items[0].interface.port, 0,
+			items[0].host.tls_connect, tls_arg1, tls_arg2))
+	{
+		zbx_alarm_off();
+		zbx_json_free(&j);
+
+		/* the agent is not reachable, requesting the items one by one would only delay the poller */
+		error = zbx_dsprintf(NULL, "Get value from agent failed: %s", zbx_socket_strerror());
+
+		for (i = 0; i < requested_num; i++)
 		{
-			SET_MSG_RESULT(result, zbx_strdup(NULL, "Zabbix Agent non-critical error"));
-			ret = AGENT_ERROR;
+			SET_MSG_RESULT(&results[requested[i]], zbx_strdup(NULL, error));
+			errcodes[requested[i]] = NETWORK_ERROR;
+			done[requested[i]] = 1;
 		}
-		else if (0 == received_len)
+
+		zbx_free(error);
+		ret = SUCCEED;
+		goto out;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "Sending [%s]", j.buffer);
+
+	if (SUCCEED != zbx_tcp_send(&s, j.buffer) || FAIL == (received_len = zbx_tcp_recv_ext(&s, 0)))
+	{
+		/* A slow item key must not fail the other items of the request. The items are requested one */
+		/* by one with their own timeouts and only the items that do not answer in time fail.         */
+		zabbix_log(LOG_LEVEL_DEBUG, "bulk request to agent at [%s] failed%s: %s", items[0].interface.addr,
+				SUCCEED == zbx_alarm_timed_out() ? " (timeout)" : "", zbx_socket_strerror());
+		received_len = FAIL;
+	}
+
+	zbx_alarm_off();
+	zbx_json_free(&j);
+
+	/* the empty reply is checked by the single item requests */
+	if (FAIL == received_len || 0 == received_len)
+	{
+		zbx_tcp_close(&s);
+		ret = SUCCEED;
+		goto out;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "get values from agent result: '%s'", s.buffer);
+
+	/* agents without bulk request support respond with ZBX_NOTSUPPORTED as for an unknown item key */
+	if (SUCCEED != zbx_json_open(s.buffer, &jp) ||
+			SUCCEED != zbx_json_value_by_name(&jp, ZBX_PROTO_TAG_RESPONSE, response, sizeof(response)) ||
+			0 != strcmp(response, ZBX_PROTO_VALUE_SUCCESS) ||
+			SUCCEED != zbx_json_brackets_by_name(&jp, ZBX_PROTO_TAG_DATA, &jp_data))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "agent at [%s] does not support bulk requests", items[0].interface.addr);
+		agent_bulk_set_unsupported(items[0].interface.interfaceid);
+		zbx_tcp_close(&s);
+		ret = FAIL;
+		goto out;
+	}
+
+	for (i = 0; i < requested_num && NULL != (p = zbx_json_next(&jp_data, p)); i++)
+	{
+		int	index = requested[i];
+
+		if (SUCCEED != zbx_json_brackets_open(p, &jp_row))
+			break;
+
+		/* the value is the same as the agent reply to the single item key, */
+		/* the row without value and error stands for an empty reply         */
+		if (SUCCEED == zbx_json_value_by_name_dyn(&jp_row, ZBX_PROTO_TAG_VALUE, &value, &value_alloc))
 		{
-			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Received empty response from Zabbix Agent at [%s]."
-					" Assuming that agent dropped connection because of access permissions.",
-					item->interface.addr));
-			ret = NETWORK_ERROR;
+			errcodes[index] = agent_set_result(&items[index], value, strlen(value), &results[index]);
+		}
+		else if (SUCCEED == zbx_json_value_by_name_dyn(&jp_row, ZBX_PROTO_TAG_ERROR, &value, &value_alloc))
+		{
+			SET_MSG_RESULT(&results[index], zbx_strdup(NULL, '\0' != *value ? value :
+					"Not supported by Zabbix Agent"));
+			errcodes[index] = NOTSUPPORTED;
 		}
 		else
-			set_result_type(result, ITEM_VALUE_TYPE_TEXT, s.buffer);
+			errcodes[index] = agent_set_result(&items[index], "", 0, &results[index]);
+
+		done[index] = 1;
 	}
-	else
-		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Get value from agent failed: %s", zbx_socket_strerror()));
 
+	zbx_free(value);
 	zbx_tcp_close(&s);
 out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
 }
+
+/******************************************************************************
+ *                                                                            *
+ * Function: get_values_agent                                                 *
+ *                                                                            *
+ * Purpose: retrieve values of multiple items of the same Zabbix agent        *
+ *          interface                                                         *
+ *                                                                            *
+ * Parameters: items    - [IN] the items                                      *
+ *             results  - [OUT] the item values                               *
+ *             errcodes - [IN/OUT] the item error codes, only items with      *
+ *                                 SUCCEED error code are requested           *
+ *             num      - [IN] the number of items                            *
+ *                                                                            *
+ * Comments: The items are requested with a single bulk request if the agent  *
+ *           supports it. Items the agent did not return values for (because  *
+ *           of its time limit for bulk requests or because the bulk request  *
+ *           timed out) and items of the agents without bulk request support  *
+ *           are requested one by one, each with its own timeout. Once the    *
+ *           agent cannot be reached or two items in a row time out the       *
+ *           remaining items fail without being requested.                    *
+ *                                                                            *
+ ******************************************************************************/
+void	get_values_agent(DC_ITEM *items, AGENT_RESULT *results, int *errcodes, int num)
+{
+	unsigned char	done[MAX_POLLER_ITEMS];
+	char		*error = NULL;
+	int		i, requested_num = 0, timeouts = 0, errcode = SUCCEED;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() num:%d", __func__, num);
+
+	memset(done, 0, sizeof(unsigned char) * num);
+
+	for (i = 0; i < num; i++)
+	{
+		if (SUCCEED == errcodes[i])
+			requested_num++;
+	}
+
+	if (1 < requested_num && SUCCEED == agent_bulk_is_supported(items[0].interface.interfaceid))
+		get_values_agent_bulk(items, results, errcodes, done, num);
+
+	for (i = 0; i < num; i++)
+	{
+		if (SUCCEED != errcodes[i] || 0 != done[i])
+			continue;
+
+		if (NULL != error)
+		{
+			/* the agent stopped responding, do not wait for the timeout of each remaining item */
+			SET_MSG_RESULT(&results[i], zbx_strdup(NULL, error));
+			errcodes[i] = errcode;
+			continue;
+		}
+
+		zbx_alarm_on(CONFIG_TIMEOUT);
+		errcodes[i] = get_value_agent(&items[i], &results[i]);
+		zbx_alarm_off();
+
+		switch (errcodes[i])
+		{
+			case TIMEOUT_ERROR:
+				/* a single slow item key does not fail the remaining items */
+				if (0 == timeouts++)
+					break;
+				ZBX_FALLTHROUGH;
+			case NETWORK_ERROR:
+				errcode = errcodes[i];
+				error = zbx_dsprintf(NULL, "Get value from agent skipped: %s", results[i].msg);
+				break;
+			default:
+				timeouts = 0;
+		}
+	}
+
+	zbx_free(error);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
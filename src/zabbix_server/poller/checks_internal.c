@@ -794,6 +794,60 @@ int	get_value_internal(DC_ITEM *item, AGENT_RESULT *result)
 			}
 		}
 	}
+	else if (0 == strcmp(tmp, "tls"))			/* zabbix[tls,<mode>] */
+	{
+		zbx_uint64_t	handshakes, resumed;
+
+		if (2 != nparams)
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid number of parameters."));
+			goto out;
+		}
+
+		get_selfmon_tls_stats(&handshakes, &resumed);
+
+		tmp = get_rparam(&request, 1);
+
+		if (0 == strcmp(tmp, "handshakes"))
+			SET_UI64_RESULT(result, handshakes);
+		else if (0 == strcmp(tmp, "resumed"))
+			SET_UI64_RESULT(result, resumed);
+		else if (0 == strcmp(tmp, "presumed"))
+			SET_DBL_RESULT(result, 0 == handshakes ? 0 : 100.0 * (double)resumed / (double)handshakes);
+		else
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid second parameter."));
+			goto out;
+		}
+	}
+	else if (0 == strcmp(tmp, "ssh"))			/* zabbix[ssh,<mode>] */
+	{
+		zbx_uint64_t	requests, reused, sessions;
+
+		if (2 != nparams)
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid number of parameters."));
+			goto out;
+		}
+
+		get_selfmon_ssh_stats(&requests, &reused, &sessions);
+
+		tmp = get_rparam(&request, 1);
+
+		if (0 == strcmp(tmp, "requests"))
+			SET_UI64_RESULT(result, requests);
+		else if (0 == strcmp(tmp, "reused"))
+			SET_UI64_RESULT(result, reused);
+		else if (0 == strcmp(tmp, "preused"))
+			SET_DBL_RESULT(result, 0 == requests ? 0 : 100.0 * (double)reused / (double)requests);
+		else if (0 == strcmp(tmp, "sessions"))
+			SET_UI64_RESULT(result, sessions);
+		else
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid second parameter."));
+			goto out;
+		}
+	}
 	else if (0 == strcmp(tmp, "preprocessing_queue"))
 	{
 		if (1 != nparams)
@@ -84,8 +84,7 @@ int	zbx_get_value_internal_ext(const char *param1, const AGENT_REQUEST *request,
 		SET_UI64_RESULT(result, DBget_row_count(param1));
 	}
 	else if (0 == strcmp(param1, "proxy"))			/* zabbix["proxy",<hostname>,"lastaccess"] */
-	{
-		int	lastaccess;
+	{							/* zabbix["proxy",<hostname>,"latency"] */
 		char	*error = NULL;
 
 		/* this item is always processed by server */
@@ -97,19 +96,36 @@ int	zbx_get_value_internal_ext(const char *param1, const AGENT_REQUEST *request,
 		}
 
 		param2 = get_rparam(request, 2);
-		if ('\0' == *param2 || 0 != strcmp(param2, "lastaccess"))
+
+		if (0 == strcmp(param2, "lastaccess"))
 		{
-			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid third parameter."));
-			goto out;
+			int	lastaccess;
+
+			if (FAIL == DBget_proxy_lastaccess(get_rparam(request, 1), &lastaccess, &error))
+			{
+				SET_MSG_RESULT(result, error);
+				goto out;
+			}
+
+			SET_UI64_RESULT(result, lastaccess);
 		}
+		else if (0 == strcmp(param2, "latency"))
+		{
+			double	latency;
 
-		if (FAIL == DBget_proxy_lastaccess(get_rparam(request, 1), &lastaccess, &error))
+			if (FAIL == zbx_dc_get_proxy_latency(get_rparam(request, 1), &latency, &error))
+			{
+				SET_MSG_RESULT(result, error);
+				goto out;
+			}
+
+			SET_DBL_RESULT(result, latency);
+		}
+		else
 		{
-			SET_MSG_RESULT(result, error);
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid third parameter."));
 			goto out;
 		}
-
-		SET_UI64_RESULT(result, lastaccess);
 	}
 	else if (0 == strcmp(param1, "vcache"))
 	{
@@ -25,14 +25,55 @@
 
 #include "checks_java.h"
 
-static int	parse_response(AGENT_RESULT *results, int *errcodes, int num, char *response,
+
+#define ZBX_JAVA_GATEWAY_MAX_CONNECTIONS	32
+
+/* Java gateway uses Zabbix protocol header with 8 byte data length */
+#define ZBX_JAVA_HEADER_DATA	"ZBXD\1"
+#define ZBX_JAVA_HEADER_LEN	ZBX_CONST_STRLEN(ZBX_JAVA_HEADER_DATA)
+
+#define ZBX_JAVA_REQUEST_PENDING	0
+#define ZBX_JAVA_REQUEST_DONE		1
+
+/* persistent connection to Java gateway, carries pipelined requests */
+typedef struct
+{
+	zbx_socket_t	s;
+	int		connected;
+	/* the connection was kept open from the previous requests */
+	int		reused;
+	/* the number of responses received during the current request batch */
+	int		received;
+	/* the time by which Java gateway must answer the first pending request */
+	double		deadline;
+	/* data received from Java gateway that is not parsed into responses yet */
+	char		*buffer;
+	size_t		buffer_alloc;
+	size_t		buffer_offset;
+}
+zbx_java_conn_t;
+
+/* request to Java gateway for the items with the same connection parameters */
+typedef struct
+{
+	int	index[MAX_JAVA_ITEMS];
+	int	num;
+	int	conn;
+	int	state;
+	char	*data;
+}
+zbx_java_request_t;
+
+static zbx_java_conn_t	java_conns[ZBX_JAVA_GATEWAY_MAX_CONNECTIONS];
+
+static int	parse_response(AGENT_RESULT *results, int *errcodes, const int *index, int num, char *response,
 		char *error, int max_error_len)
 {
 	const char		*p;
 	struct zbx_json_parse	jp, jp_data, jp_row;
 	char			*value = NULL;
 	size_t			value_alloc = 0;
-	int			i, ret = GATEWAY_ERROR;
+	int			i, k, ret = GATEWAY_ERROR;
 
 	if (SUCCEED == zbx_json_open(response, &jp))
 	{
@@ -52,8 +93,10 @@ static int	parse_response(AGENT_RESULT *results, int *errcodes, int num, char *r
 
 			p = NULL;
 
-			for (i = 0; i < num; i++)
+			for (k = 0; k < num; k++)
 			{
+				i = index[k];
+
 				if (SUCCEED != errcodes[i])
 					continue;
 
@@ -115,42 +158,25 @@ exit:
 	return ret;
 }
 
-int	get_value_java(unsigned char request, const DC_ITEM *item, AGENT_RESULT *result)
-{
-	int	errcode = SUCCEED;
-
-	get_values_java(request, item, result, &errcode, 1);
-
-	return errcode;
-}
-
-void	get_values_java(unsigned char request, const DC_ITEM *items, AGENT_RESULT *results, int *errcodes, int num)
+/******************************************************************************
+ *                                                                            *
+ * Function: java_request_prepare                                             *
+ *                                                                            *
+ * Purpose: prepare Java gateway request for the items of a request           *
+ *                                                                            *
+ * Parameters: request     - [IN] the request type                            *
+ *             items       - [IN] the items                                   *
+ *             java_request - [IN/OUT] the request, its data is set           *
+ *                                                                            *
+ ******************************************************************************/
+static void	java_request_prepare(unsigned char request, const DC_ITEM *items, zbx_java_request_t *java_request)
 {
-	zbx_socket_t	s;
 	struct zbx_json	json;
-	char		error[MAX_STRING_LEN];
-	int		i, j, err = SUCCEED;
-
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() jmx_endpoint:'%s' num:%d", __func__, items[0].jmx_endpoint, num);
-
-	for (j = 0; j < num; j++)	/* locate first supported item to use as a reference */
-	{
-		if (SUCCEED == errcodes[j])
-			break;
-	}
-
-	if (j == num)	/* all items already NOTSUPPORTED (with invalid key or port) */
-		goto out;
+	const DC_ITEM	*item = &items[java_request->index[0]];
+	int		k;
 
 	zbx_json_init(&json, ZBX_JSON_STAT_BUF_LEN);
 
-	if (NULL == CONFIG_JAVA_GATEWAY || '\0' == *CONFIG_JAVA_GATEWAY)
-	{
-		err = GATEWAY_ERROR;
-		strscpy(error, "JavaGateway configuration parameter not set or empty");
-		goto exit;
-	}
-
 	if (ZBX_JAVA_GATEWAY_REQUEST_INTERNAL == request)
 	{
 		zbx_json_addstring(&json, ZBX_PROTO_TAG_REQUEST, ZBX_PROTO_VALUE_JAVA_GATEWAY_INTERNAL,
@@ -158,34 +184,19 @@ void	get_values_java(unsigned char request, const DC_ITEM *items, AGENT_RESULT *
 	}
 	else if (ZBX_JAVA_GATEWAY_REQUEST_JMX == request)
 	{
-		for (i = j + 1; i < num; i++)
-		{
-			if (SUCCEED != errcodes[i])
-				continue;
-
-			if (0 != strcmp(items[j].username, items[i].username) ||
-					0 != strcmp(items[j].password, items[i].password) ||
-					0 != strcmp(items[j].jmx_endpoint, items[i].jmx_endpoint))
-			{
-				err = GATEWAY_ERROR;
-				strscpy(error, "Java poller received items with different connection parameters");
-				goto exit;
-			}
-		}
-
 		zbx_json_addstring(&json, ZBX_PROTO_TAG_REQUEST, ZBX_PROTO_VALUE_JAVA_GATEWAY_JMX, ZBX_JSON_TYPE_STRING);
 
-		if ('\0' != *items[j].username)
+		if ('\0' != *item->username)
 		{
-			zbx_json_addstring(&json, ZBX_PROTO_TAG_USERNAME, items[j].username, ZBX_JSON_TYPE_STRING);
+			zbx_json_addstring(&json, ZBX_PROTO_TAG_USERNAME, item->username, ZBX_JSON_TYPE_STRING);
 		}
-		if ('\0' != *items[j].password)
+		if ('\0' != *item->password)
 		{
-			zbx_json_addstring(&json, ZBX_PROTO_TAG_PASSWORD, items[j].password, ZBX_JSON_TYPE_STRING);
+			zbx_json_addstring(&json, ZBX_PROTO_TAG_PASSWORD, item->password, ZBX_JSON_TYPE_STRING);
 		}
-		if ('\0' != *items[j].jmx_endpoint)
+		if ('\0' != *item->jmx_endpoint)
 		{
-			zbx_json_addstring(&json, ZBX_PROTO_TAG_JMX_ENDPOINT, items[j].jmx_endpoint,
+			zbx_json_addstring(&json, ZBX_PROTO_TAG_JMX_ENDPOINT, item->jmx_endpoint,
 					ZBX_JSON_TYPE_STRING);
 		}
 	}
@@ -193,54 +204,553 @@ void	get_values_java(unsigned char request, const DC_ITEM *items, AGENT_RESULT *
 		assert(0);
 
 	zbx_json_addarray(&json, ZBX_PROTO_TAG_KEYS);
-	for (i = j; i < num; i++)
+	for (k = 0; k < java_request->num; k++)
+		zbx_json_addstring(&json, NULL, items[java_request->index[k]].key, ZBX_JSON_TYPE_STRING);
+	zbx_json_close(&json);
+
+	java_request->data = zbx_strdup(NULL, json.buffer);
+
+	zbx_json_free(&json);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: java_request_fail                                                *
+ *                                                                            *
+ * Purpose: set error for all items of a request                              *
+ *                                                                            *
+ ******************************************************************************/
+static void	java_request_fail(zbx_java_request_t *java_request, AGENT_RESULT *results, int *errcodes, int err,
+		const char *error)
+{
+	int	i, k;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "getting Java values failed: %s", error);
+
+	for (k = 0; k < java_request->num; k++)
 	{
+		i = java_request->index[k];
+
 		if (SUCCEED != errcodes[i])
 			continue;
 
-		zbx_json_addstring(&json, NULL, items[i].key, ZBX_JSON_TYPE_STRING);
+		SET_MSG_RESULT(&results[i], zbx_strdup(NULL, error));
+		errcodes[i] = err;
 	}
-	zbx_json_close(&json);
 
-	if (SUCCEED == (err = zbx_tcp_connect(&s, CONFIG_SOURCE_IP, CONFIG_JAVA_GATEWAY, CONFIG_JAVA_GATEWAY_PORT,
-			CONFIG_TIMEOUT, ZBX_TCP_SEC_UNENCRYPTED, NULL, NULL)))
+	java_request->state = ZBX_JAVA_REQUEST_DONE;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: java_conn_close                                                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	java_conn_close(zbx_java_conn_t *conn)
+{
+	if (0 == conn->connected)
+		return;
+
+	zbx_tcp_close(&conn->s);
+	conn->connected = 0;
+	conn->reused = 0;
+	conn->buffer_offset = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: java_conn_is_alive                                               *
+ *                                                                            *
+ * Purpose: check if kept open connection was not closed by Java gateway      *
+ *                                                                            *
+ * Comments: There are no outstanding requests on a kept open connection, so  *
+ *           any readable data means that it was closed or is out of sync.    *
+ *                                                                            *
+ ******************************************************************************/
+static int	java_conn_is_alive(zbx_java_conn_t *conn)
+{
+	fd_set		fdr;
+	struct timeval	tv = {0, 0};
+
+	FD_ZERO(&fdr);
+	FD_SET(conn->s.socket, &fdr);
+
+	if (0 != select(ZBX_SOCKET_TO_INT(conn->s.socket) + 1, &fdr, NULL, NULL, &tv))
+		return FAIL;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: java_conn_send                                                   *
+ *                                                                            *
+ * Purpose: send all pending requests of a connection to Java gateway,        *
+ *          connecting first if necessary                                     *
+ *                                                                            *
+ * Parameters: conn         - [IN] the connection index                       *
+ *             requests     - [IN] the requests                               *
+ *             requests_num - [IN] the number of requests                     *
+ *             error        - [OUT] the error message                         *
+ *             max_error_len - [IN] the error message buffer size             *
+ *                                                                            *
+ * Return value: SUCCEED - the requests were sent without waiting for         *
+ *                         responses                                          *
+ *               FAIL    - connection or network error                        *
+ *                                                                            *
+ * Comments: Connecting and sending is limited by Timeout. The deadline of    *
+ *           the first request is set after the requests have been sent.      *
+ *                                                                            *
+ ******************************************************************************/
+static int	java_conn_send(int conn, const zbx_java_request_t *requests, int requests_num, char *error,
+		size_t max_error_len)
+{
+	zbx_java_conn_t	*java_conn = &java_conns[conn];
+	int		i, ret = FAIL;
+
+	if (0 != java_conn->connected && (0 != java_conn->buffer_offset || SUCCEED != java_conn_is_alive(java_conn)))
+		java_conn_close(java_conn);
+
+	/* the alarm is not passed to socket, as socket would keep it while the connection is kept open */
+	zbx_alarm_on(CONFIG_TIMEOUT);
+
+	if (0 == java_conn->connected)
+	{
+		if (SUCCEED != zbx_tcp_connect(&java_conn->s, CONFIG_SOURCE_IP, CONFIG_JAVA_GATEWAY,
+				CONFIG_JAVA_GATEWAY_PORT, 0, ZBX_TCP_SEC_UNENCRYPTED, NULL, NULL))
+		{
+			zbx_strlcpy(error, zbx_socket_strerror(), max_error_len);
+			goto out;
+		}
+
+		java_conn->connected = 1;
+		java_conn->reused = 0;
+		java_conn->buffer_offset = 0;
+	}
+
+	java_conn->received = 0;
+
+	for (i = 0; i < requests_num; i++)
 	{
-		zabbix_log(LOG_LEVEL_DEBUG, "JSON before sending [%s]", json.buffer);
+		if (conn != requests[i].conn || ZBX_JAVA_REQUEST_PENDING != requests[i].state)
+			continue;
+
+		zabbix_log(LOG_LEVEL_DEBUG, "JSON before sending [%s]", requests[i].data);
 
-		if (SUCCEED == (err = zbx_tcp_send(&s, json.buffer)))
+		if (SUCCEED != zbx_tcp_send(&java_conn->s, requests[i].data))
 		{
-			if (SUCCEED == (err = zbx_tcp_recv(&s)))
-			{
-				zabbix_log(LOG_LEVEL_DEBUG, "JSON back [%s]", s.buffer);
+			zbx_strlcpy(error, zbx_socket_strerror(), max_error_len);
+			java_conn_close(java_conn);
+			goto out;
+		}
+	}
+
+	java_conn->deadline = zbx_time() + CONFIG_TIMEOUT;
+	ret = SUCCEED;
+out:
+	zbx_alarm_off();
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: java_conn_recv                                                   *
+ *                                                                            *
+ * Purpose: read available data from Java gateway connection                  *
+ *                                                                            *
+ * Return value: SUCCEED - data was read                                      *
+ *               FAIL    - the connection was closed or an error occurred     *
+ *                                                                            *
+ ******************************************************************************/
+static int	java_conn_recv(zbx_java_conn_t *conn, char *error, size_t max_error_len)
+{
+	char	buffer[ZBX_STAT_BUF_LEN];
+	ssize_t	nbytes;
+
+	if (ZBX_PROTO_ERROR == (nbytes = ZBX_TCP_READ(conn->s.socket, buffer, sizeof(buffer))))
+	{
+		if (EINTR == zbx_socket_last_error())
+			return SUCCEED;
+
+		zbx_snprintf(error, max_error_len, "Cannot read response from Java gateway: %s",
+				strerror_from_system(zbx_socket_last_error()));
+		return FAIL;
+	}
+
+	if (0 == nbytes)
+	{
+		zbx_strlcpy(error, "Connection closed by Java gateway", max_error_len);
+		return FAIL;
+	}
+
+	if (conn->buffer_alloc < conn->buffer_offset + (size_t)nbytes + 1)
+	{
+		while (conn->buffer_alloc < conn->buffer_offset + (size_t)nbytes + 1)
+			conn->buffer_alloc = (0 == conn->buffer_alloc ? ZBX_STAT_BUF_LEN : conn->buffer_alloc * 2);
+
+		conn->buffer = (char *)zbx_realloc(conn->buffer, conn->buffer_alloc);
+	}
+
+	memcpy(conn->buffer + conn->buffer_offset, buffer, (size_t)nbytes);
+	conn->buffer_offset += (size_t)nbytes;
+
+	return SUCCEED;
+}
 
-				err = parse_response(results, errcodes, num, s.buffer, error, sizeof(error));
+/******************************************************************************
+ *                                                                            *
+ * Function: java_conn_get_response                                           *
+ *                                                                            *
+ * Purpose: extract the next complete response from received data             *
+ *                                                                            *
+ * Parameters: conn          - [IN] the connection                            *
+ *             response      - [OUT] the response, NULL if it is not fully    *
+ *                                   received yet                             *
+ *             error         - [OUT] the error message                        *
+ *             max_error_len - [IN] the error message buffer size             *
+ *                                                                            *
+ * Return value: SUCCEED - the response was extracted or more data is needed  *
+ *               FAIL    - invalid response header                            *
+ *                                                                            *
+ * Comments: Java gateway response consists of the header, 8 bytes of data    *
+ *           length in little endian byte order and the data.                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	java_conn_get_response(zbx_java_conn_t *conn, char **response, char *error, size_t max_error_len)
+{
+	zbx_uint64_t	len;
+	size_t		offset = ZBX_JAVA_HEADER_LEN + sizeof(zbx_uint64_t);
+
+	*response = NULL;
+
+	if (0 != memcmp(conn->buffer, ZBX_JAVA_HEADER_DATA, MIN(ZBX_JAVA_HEADER_LEN, conn->buffer_offset)))
+	{
+		zbx_strlcpy(error, "Invalid response header from Java gateway", max_error_len);
+		return FAIL;
+	}
+
+	if (offset > conn->buffer_offset)
+		return SUCCEED;
+
+	memcpy(&len, conn->buffer + ZBX_JAVA_HEADER_LEN, sizeof(zbx_uint64_t));
+	len = zbx_letoh_uint64(len);
+
+	if (ZBX_MAX_RECV_DATA_SIZE < len)
+	{
+		zbx_snprintf(error, max_error_len, "Response size " ZBX_FS_UI64 " from Java gateway exceeds the"
+				" maximum size " ZBX_FS_UI64 " bytes", len, (zbx_uint64_t)ZBX_MAX_RECV_DATA_SIZE);
+		return FAIL;
+	}
+
+	if (offset + len > conn->buffer_offset)
+		return SUCCEED;
+
+	*response = (char *)zbx_malloc(NULL, len + 1);
+	memcpy(*response, conn->buffer + offset, len);
+	(*response)[len] = '\0';
+
+	conn->buffer_offset -= offset + len;
+	memmove(conn->buffer, conn->buffer + offset + len, conn->buffer_offset);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: java_conn_first_pending                                          *
+ *                                                                            *
+ * Purpose: find the first pending request of a connection                    *
+ *                                                                            *
+ * Return value: the index of the request Java gateway is working on or FAIL  *
+ *               if the connection has no pending requests                    *
+ *                                                                            *
+ * Comments: Java gateway answers requests of a connection in the order they  *
+ *           were sent.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+static int	java_conn_first_pending(int conn, const zbx_java_request_t *requests, int requests_num)
+{
+	int	i;
+
+	for (i = 0; i < requests_num; i++)
+	{
+		if (conn == requests[i].conn && ZBX_JAVA_REQUEST_PENDING == requests[i].state)
+			return i;
+	}
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: java_conn_fail                                                   *
+ *                                                                            *
+ * Purpose: fail pending requests of a connection and close it                *
+ *                                                                            *
+ ******************************************************************************/
+static void	java_conn_fail(int conn, zbx_java_request_t *requests, int requests_num, AGENT_RESULT *results,
+		int *errcodes, const char *error)
+{
+	int	i;
+
+	for (i = 0; i < requests_num; i++)
+	{
+		if (conn == requests[i].conn && ZBX_JAVA_REQUEST_PENDING == requests[i].state)
+			java_request_fail(&requests[i], results, errcodes, GATEWAY_ERROR, error);
+	}
+
+	java_conn_close(&java_conns[conn]);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: java_items_compare                                               *
+ *                                                                            *
+ * Purpose: check if JMX items can be requested with the same request         *
+ *                                                                            *
+ ******************************************************************************/
+static int	java_items_compare(const DC_ITEM *item1, const DC_ITEM *item2)
+{
+	if (0 != strcmp(item1->username, item2->username) || 0 != strcmp(item1->password, item2->password) ||
+			0 != strcmp(item1->jmx_endpoint, item2->jmx_endpoint))
+	{
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+int	get_value_java(unsigned char request, const DC_ITEM *item, AGENT_RESULT *result)
+{
+	int	errcode = SUCCEED;
+
+	get_values_java(request, item, result, &errcode, 1);
+
+	return errcode;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: get_values_java                                                  *
+ *                                                                            *
+ * Purpose: retrieve values of multiple items from Java gateway               *
+ *                                                                            *
+ * Parameters: request  - [IN] the request type                               *
+ *             items    - [IN] the items                                      *
+ *             results  - [OUT] the item values                               *
+ *             errcodes - [IN/OUT] the item error codes, only items with      *
+ *                                 SUCCEED error code are requested           *
+ *             num      - [IN] the number of items                            *
+ *                                                                            *
+ * Comments: Items are grouped into requests by their connection parameters.  *
+ *           The requests are spread over up to JavaGatewayConnections        *
+ *           connections and sent without waiting for responses. Responses    *
+ *           are read from the connections as they become ready, so a slow    *
+ *           JVM delays only the requests queued behind it on the same        *
+ *           connection.                                                      *
+ *           Each request has its own Timeout counted from when Java gateway  *
+ *           starts working on it. When it expires only that request fails,   *
+ *           the requests queued behind it are resent over a new connection.  *
+ *           Connections used for JMX requests are kept open for the next     *
+ *           call.                                                            *
+ *                                                                            *
+ ******************************************************************************/
+void	get_values_java(unsigned char request, const DC_ITEM *items, AGENT_RESULT *results, int *errcodes, int num)
+{
+	zbx_java_request_t	requests[MAX_POLLER_ITEMS];
+	char			error[MAX_STRING_LEN], *response;
+	int			i, j, requests_num = 0, conns_num, rc, ret;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() jmx_endpoint:'%s' num:%d", __func__, items[0].jmx_endpoint, num);
+
+	for (i = 0; i < num; i++)
+	{
+		if (SUCCEED != errcodes[i])
+			continue;
+
+		for (j = 0; j < requests_num; j++)
+		{
+			if (MAX_JAVA_ITEMS > requests[j].num && (ZBX_JAVA_GATEWAY_REQUEST_INTERNAL == request ||
+					SUCCEED == java_items_compare(&items[requests[j].index[0]], &items[i])))
+			{
+				break;
 			}
 		}
 
-		zbx_tcp_close(&s);
+		if (j == requests_num)
+		{
+			requests[requests_num].num = 0;
+			requests[requests_num].state = ZBX_JAVA_REQUEST_PENDING;
+			requests[requests_num].data = NULL;
+			requests_num++;
+		}
+
+		requests[j].index[requests[j].num++] = i;
 	}
 
-	zbx_json_free(&json);
+	if (0 == requests_num)	/* all items already NOTSUPPORTED (with invalid key or port) */
+		goto out;
 
-	if (FAIL == err)
+	if (NULL == CONFIG_JAVA_GATEWAY || '\0' == *CONFIG_JAVA_GATEWAY)
 	{
-		strscpy(error, zbx_socket_strerror());
-		err = GATEWAY_ERROR;
+		for (j = 0; j < requests_num; j++)
+		{
+			java_request_fail(&requests[j], results, errcodes, GATEWAY_ERROR,
+					"JavaGateway configuration parameter not set or empty");
+		}
+
+		goto out;
 	}
-exit:
-	if (NETWORK_ERROR == err || GATEWAY_ERROR == err)
+
+	conns_num = MIN(MIN(CONFIG_JAVA_GATEWAY_CONNECTIONS, ZBX_JAVA_GATEWAY_MAX_CONNECTIONS), requests_num);
+
+	for (j = 0; j < requests_num; j++)
+	{
+		java_request_prepare(request, items, &requests[j]);
+		requests[j].conn = j % conns_num;
+	}
+
+	for (i = 0; i < conns_num; i++)
+	{
+		if (SUCCEED != java_conn_send(i, requests, requests_num, error, sizeof(error)))
+			java_conn_fail(i, requests, requests_num, results, errcodes, error);
+	}
+
+	for (;;)
 	{
-		zabbix_log(LOG_LEVEL_DEBUG, "getting Java values failed: %s", error);
+		fd_set		fdr;
+		ZBX_SOCKET	max_fd = 0;
+		struct timeval	tv;
+		double		now, wait = -1;
 
-		for (i = j; i < num; i++)
+		FD_ZERO(&fdr);
+
+		now = zbx_time();
+
+		for (i = 0; i < conns_num; i++)
+		{
+			zbx_java_conn_t	*conn = &java_conns[i];
+
+			if (FAIL == (j = java_conn_first_pending(i, requests, requests_num)))
+				continue;
+
+			if (conn->deadline <= now)
+			{
+				/* only the request Java gateway is working on timed out, resend the rest */
+				java_request_fail(&requests[j], results, errcodes, GATEWAY_ERROR,
+						"Timeout while waiting for Java gateway response");
+				java_conn_close(conn);
+
+				if (FAIL == java_conn_first_pending(i, requests, requests_num))
+					continue;
+
+				if (SUCCEED != java_conn_send(i, requests, requests_num, error, sizeof(error)))
+				{
+					java_conn_fail(i, requests, requests_num, results, errcodes, error);
+					continue;
+				}
+
+				now = zbx_time();
+			}
+
+			FD_SET(conn->s.socket, &fdr);
+
+			if (max_fd < conn->s.socket)
+				max_fd = conn->s.socket;
+
+			if (0 > wait || conn->deadline - now < wait)
+				wait = conn->deadline - now;
+		}
+
+		if (0 > wait)	/* no pending requests */
+			break;
+
+		tv.tv_sec = (time_t)wait;
+		tv.tv_usec = (suseconds_t)((wait - tv.tv_sec) * 1000000);
+
+		if (-1 == (rc = select(ZBX_SOCKET_TO_INT(max_fd) + 1, &fdr, NULL, NULL, &tv)))
 		{
-			if (SUCCEED != errcodes[i])
+			if (EINTR == errno)
 				continue;
 
-			SET_MSG_RESULT(&results[i], zbx_strdup(NULL, error));
-			errcodes[i] = err;
+			zbx_snprintf(error, sizeof(error), "Cannot wait for Java gateway response: %s",
+					zbx_strerror(errno));
+
+			for (i = 0; i < conns_num; i++)
+				java_conn_fail(i, requests, requests_num, results, errcodes, error);
+
+			break;
+		}
+
+		if (0 == rc)
+			continue;
+
+		for (i = 0; i < conns_num; i++)
+		{
+			zbx_java_conn_t	*conn = &java_conns[i];
+
+			if (0 == conn->connected || !FD_ISSET(conn->s.socket, &fdr))
+				continue;
+
+			if (SUCCEED != java_conn_recv(conn, error, sizeof(error)))
+			{
+				/* Java gateway might have closed idle connection just before the requests were sent */
+				if (0 != conn->reused && 0 == conn->received && 0 == conn->buffer_offset)
+				{
+					java_conn_close(conn);
+
+					if (SUCCEED == java_conn_send(i, requests, requests_num, error, sizeof(error)))
+						continue;
+				}
+
+				java_conn_fail(i, requests, requests_num, results, errcodes, error);
+				continue;
+			}
+
+			while (SUCCEED == (ret = java_conn_get_response(conn, &response, error, sizeof(error))) &&
+					NULL != response)
+			{
+				zabbix_log(LOG_LEVEL_DEBUG, "JSON back [%s]", response);
+
+				if (FAIL == (j = java_conn_first_pending(i, requests, requests_num)))
+				{
+					zbx_strlcpy(error, "Unexpected response from Java gateway", sizeof(error));
+					zbx_free(response);
+					ret = FAIL;
+					break;
+				}
+
+				conn->received++;
+				requests[j].state = ZBX_JAVA_REQUEST_DONE;
+
+				/* Java gateway starts working on the next request of the connection */
+				conn->deadline = zbx_time() + CONFIG_TIMEOUT;
+
+				if (SUCCEED != (ret = parse_response(results, errcodes, requests[j].index, requests[j].num,
+						response, error, sizeof(error))))
+				{
+					java_request_fail(&requests[j], results, errcodes, ret, error);
+				}
+
+				zbx_free(response);
+			}
+
+			if (FAIL == ret)
+				java_conn_fail(i, requests, requests_num, results, errcodes, error);
 		}
 	}
+
+	for (i = 0; i < conns_num; i++)
+	{
+		if (ZBX_JAVA_GATEWAY_REQUEST_JMX == request)
+			java_conns[i].reused = 1;
+		else
+			java_conn_close(&java_conns[i]);
+	}
+
+	for (j = 0; j < requests_num; j++)
+		zbx_free(requests[j].data);
 out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
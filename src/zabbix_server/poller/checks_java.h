@@ -29,6 +29,7 @@
 extern char	*CONFIG_SOURCE_IP;
 extern char	*CONFIG_JAVA_GATEWAY;
 extern int	CONFIG_JAVA_GATEWAY_PORT;
+extern int	CONFIG_JAVA_GATEWAY_CONNECTIONS;
 
 int	get_value_java(unsigned char request, const DC_ITEM *item, AGENT_RESULT *result);
 void	get_values_java(unsigned char request, const DC_ITEM *items, AGENT_RESULT *results, int *errcodes, int num);
@@ -25,6 +25,7 @@
 
 #include "comms.h"
 #include "log.h"
+#include "zbxself.h"
 
 #define SSH_RUN_KEY	"ssh.run"
 
@@ -76,48 +77,79 @@ static int	waitsocket(int socket_fd, LIBSSH2_SESSION *session)
 	return rc;
 }
 
-/* example ssh.run["ls /"] */
-static int	ssh_run(DC_ITEM *item, AGENT_RESULT *result, const char *encoding)
+/* authenticated SSH session kept open for the next checks on the same host */
+typedef struct
 {
+	char		*addr;
+	unsigned short	port;
+	unsigned char	authtype;
+	char		*username;
+	char		*password;
+	char		*publickey;
+	char		*privatekey;
 	zbx_socket_t	s;
 	LIBSSH2_SESSION	*session;
-	LIBSSH2_CHANNEL	*channel;
-	int		auth_pw = 0, rc, ret = NOTSUPPORTED,
-			exitcode, bytecount = 0;
-	char		buffer[MAX_BUFFER_LEN], buf[16], *userauthlist,
-			*publickey = NULL, *privatekey = NULL, *ssherr, *output;
-	size_t		sz;
-
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+	time_t		lastaccess;
+}
+zbx_ssh_session_t;
+
+/* idle sessions are closed after this many seconds, the maximum number of */
+/* idle sessions kept by a poller is set by SSHSessionCacheSize            */
+#define ZBX_SSH_SESSION_IDLE_MAX	300
+
+static zbx_vector_ptr_t	ssh_sessions;
+static int		ssh_sessions_init = 0;
+
+/* number of checks and number of checks done over an already authenticated session */
+static zbx_uint64_t	ssh_requests = 0, ssh_reused = 0;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ssh_session_open                                                 *
+ *                                                                            *
+ * Purpose: connect to SSH server and authenticate                            *
+ *                                                                            *
+ * Parameters: item  - [IN] the item                                          *
+ *             ssh   - [OUT] the session                                      *
+ *             error - [OUT] the error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - authenticated session was established              *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	ssh_session_open(const DC_ITEM *item, zbx_ssh_session_t *ssh, char **error)
+{
+	int	auth_pw = 0, rc, ret = FAIL;
+	char	*userauthlist, *publickey = NULL, *privatekey = NULL, *ssherr;
 
-	if (FAIL == zbx_tcp_connect(&s, CONFIG_SOURCE_IP, item->interface.addr, item->interface.port, 0,
+	if (FAIL == zbx_tcp_connect(&ssh->s, CONFIG_SOURCE_IP, item->interface.addr, item->interface.port, 0,
 			ZBX_TCP_SEC_UNENCRYPTED, NULL, NULL))
 	{
-		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot connect to SSH server: %s", zbx_socket_strerror()));
+		*error = zbx_dsprintf(NULL, "Cannot connect to SSH server: %s", zbx_socket_strerror());
 		goto close;
 	}
 
 	/* initializes an SSH session object */
-	if (NULL == (session = libssh2_session_init()))
+	if (NULL == (ssh->session = libssh2_session_init()))
 	{
-		SET_MSG_RESULT(result, zbx_strdup(NULL, "Cannot initialize SSH session"));
+		*error = zbx_strdup(NULL, "Cannot initialize SSH session");
 		goto tcp_close;
 	}
 
 	/* set blocking mode on session */
-	libssh2_session_set_blocking(session, 1);
+	libssh2_session_set_blocking(ssh->session, 1);
 
 	/* Create a session instance and start it up. This will trade welcome */
 	/* banners, exchange keys, and setup crypto, compression, and MAC layers */
-	if (0 != libssh2_session_startup(session, s.socket))
+	if (0 != libssh2_session_startup(ssh->session, ssh->s.socket))
 	{
-		libssh2_session_last_error(session, &ssherr, NULL, 0);
-		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot establish SSH session: %s", ssherr));
+		libssh2_session_last_error(ssh->session, &ssherr, NULL, 0);
+		*error = zbx_dsprintf(NULL, "Cannot establish SSH session: %s", ssherr);
 		goto session_free;
 	}
 
 	/* check what authentication methods are available */
-	if (NULL != (userauthlist = libssh2_userauth_list(session, item->username, strlen(item->username))))
+	if (NULL != (userauthlist = libssh2_userauth_list(ssh->session, item->username, strlen(item->username))))
 	{
 		if (NULL != strstr(userauthlist, "password"))
 			auth_pw |= 1;
@@ -128,8 +160,8 @@ static int	ssh_run(DC_ITEM *item, AGENT_RESULT *result, const char *encoding)
 	}
 	else
 	{
-		libssh2_session_last_error(session, &ssherr, NULL, 0);
-		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot obtain authentication methods: %s", ssherr));
+		libssh2_session_last_error(ssh->session, &ssherr, NULL, 0);
+		*error = zbx_dsprintf(NULL, "Cannot obtain authentication methods: %s", ssherr);
 		goto session_close;
 	}
 
@@ -141,11 +173,10 @@ static int	ssh_run(DC_ITEM *item, AGENT_RESULT *result, const char *encoding)
 			if (auth_pw & 1)
 			{
 				/* we could authenticate via password */
-				if (0 != libssh2_userauth_password(session, item->username, item->password))
+				if (0 != libssh2_userauth_password(ssh->session, item->username, item->password))
 				{
-					libssh2_session_last_error(session, &ssherr, NULL, 0);
-					SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Password authentication failed: %s",
-							ssherr));
+					libssh2_session_last_error(ssh->session, &ssherr, NULL, 0);
+					*error = zbx_dsprintf(NULL, "Password authentication failed: %s", ssherr);
 					goto session_close;
 				}
 				else
@@ -155,11 +186,11 @@ static int	ssh_run(DC_ITEM *item, AGENT_RESULT *result, const char *encoding)
 			{
 				/* or via keyboard-interactive */
 				password = item->password;
-				if (0 != libssh2_userauth_keyboard_interactive(session, item->username, &kbd_callback))
+				if (0 != libssh2_userauth_keyboard_interactive(ssh->session, item->username, &kbd_callback))
 				{
-					libssh2_session_last_error(session, &ssherr, NULL, 0);
-					SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Keyboard-interactive authentication"
-							" failed: %s", ssherr));
+					libssh2_session_last_error(ssh->session, &ssherr, NULL, 0);
+					*error = zbx_dsprintf(NULL, "Keyboard-interactive authentication failed: %s",
+							ssherr);
 					goto session_close;
 				}
 				else
@@ -168,8 +199,8 @@ static int	ssh_run(DC_ITEM *item, AGENT_RESULT *result, const char *encoding)
 			}
 			else
 			{
-				SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Unsupported authentication method."
-						" Supported methods: %s", userauthlist));
+				*error = zbx_dsprintf(NULL, "Unsupported authentication method. Supported methods: %s",
+						userauthlist);
 				goto session_close;
 			}
 			break;
@@ -178,8 +209,8 @@ static int	ssh_run(DC_ITEM *item, AGENT_RESULT *result, const char *encoding)
 			{
 				if (NULL == CONFIG_SSH_KEY_LOCATION)
 				{
-					SET_MSG_RESULT(result, zbx_strdup(NULL, "Authentication by public key failed."
-							" SSHKeyLocation option is not set"));
+					*error = zbx_strdup(NULL, "Authentication by public key failed."
+							" SSHKeyLocation option is not set");
 					goto session_close;
 				}
 
@@ -190,26 +221,23 @@ static int	ssh_run(DC_ITEM *item, AGENT_RESULT *result, const char *encoding)
 
 				if (SUCCEED != zbx_is_regular_file(publickey))
 				{
-					SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot access public key file %s",
-							publickey));
+					*error = zbx_dsprintf(NULL, "Cannot access public key file %s", publickey);
 					goto session_close;
 				}
 
 				if (SUCCEED != zbx_is_regular_file(privatekey))
 				{
-					SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot access private key file %s",
-							privatekey));
+					*error = zbx_dsprintf(NULL, "Cannot access private key file %s", privatekey);
 					goto session_close;
 				}
 
-				rc = libssh2_userauth_publickey_fromfile(session, item->username, publickey,
+				rc = libssh2_userauth_publickey_fromfile(ssh->session, item->username, publickey,
 						privatekey, item->password);
 
 				if (0 != rc)
 				{
-					libssh2_session_last_error(session, &ssherr, NULL, 0);
-					SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Public key authentication failed:"
-							" %s", ssherr));
+					libssh2_session_last_error(ssh->session, &ssherr, NULL, 0);
+					*error = zbx_dsprintf(NULL, "Public key authentication failed: %s", ssherr);
 					goto session_close;
 				}
 				else
@@ -218,39 +246,274 @@ static int	ssh_run(DC_ITEM *item, AGENT_RESULT *result, const char *encoding)
 			}
 			else
 			{
-				SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Unsupported authentication method."
-						" Supported methods: %s", userauthlist));
+				*error = zbx_dsprintf(NULL, "Unsupported authentication method. Supported methods: %s",
+						userauthlist);
 				goto session_close;
 			}
 			break;
 	}
 
+	ssh->addr = zbx_strdup(NULL, item->interface.addr);
+	ssh->port = item->interface.port;
+	ssh->authtype = item->authtype;
+	ssh->username = zbx_strdup(NULL, item->username);
+	ssh->password = zbx_strdup(NULL, item->password);
+	ssh->publickey = zbx_strdup(NULL, ZBX_NULL2EMPTY_STR(item->publickey));
+	ssh->privatekey = zbx_strdup(NULL, ZBX_NULL2EMPTY_STR(item->privatekey));
+
+	ret = SUCCEED;
+	goto close;
+
+session_close:
+	libssh2_session_disconnect(ssh->session, "Normal Shutdown");
+
+session_free:
+	libssh2_session_free(ssh->session);
+
+tcp_close:
+	zbx_tcp_close(&ssh->s);
+
+close:
+	zbx_free(publickey);
+	zbx_free(privatekey);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ssh_session_free                                                 *
+ *                                                                            *
+ * Purpose: disconnect SSH session and free its resources                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	ssh_session_free(zbx_ssh_session_t *ssh)
+{
+	libssh2_session_disconnect(ssh->session, "Normal Shutdown");
+	libssh2_session_free(ssh->session);
+	zbx_tcp_close(&ssh->s);
+
+	zbx_free(ssh->addr);
+	zbx_free(ssh->username);
+	zbx_free(ssh->password);
+	zbx_free(ssh->publickey);
+	zbx_free(ssh->privatekey);
+	zbx_free(ssh);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ssh_session_is_alive                                             *
+ *                                                                            *
+ * Purpose: check if idle session was not closed by SSH server                *
+ *                                                                            *
+ * Comments: Nothing is expected from the server on an idle session, so any   *
+ *           readable data (disconnect or keep-alive message) makes the       *
+ *           session unsuitable for reuse.                                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	ssh_session_is_alive(const zbx_ssh_session_t *ssh)
+{
+	fd_set		fdr;
+	struct timeval	tv = {0, 0};
+
+	FD_ZERO(&fdr);
+	FD_SET(ssh->s.socket, &fdr);
+
+	if (0 != select(ssh->s.socket + 1, &fdr, NULL, NULL, &tv))
+		return FAIL;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ssh_sessions_expire                                              *
+ *                                                                            *
+ * Purpose: close idle sessions that have expired or were closed by SSH       *
+ *          server                                                            *
+ *                                                                            *
+ * Comments: Called by pollers after each batch of checks, so that sessions   *
+ *           of the hosts that are no longer checked are closed as well.      *
+ *                                                                            *
+ ******************************************************************************/
+void	ssh_sessions_expire(void)
+{
+	zbx_ssh_session_t	*ssh;
+	time_t			now;
+	int			i;
+
+	if (0 == ssh_sessions_init)
+		return;
+
+	now = time(NULL);
+
+	for (i = 0; i < ssh_sessions.values_num; i++)
+	{
+		ssh = (zbx_ssh_session_t *)ssh_sessions.values[i];
+
+		if (ZBX_SSH_SESSION_IDLE_MAX < now - ssh->lastaccess || SUCCEED != ssh_session_is_alive(ssh))
+		{
+			ssh_session_free(ssh);
+			zbx_vector_ptr_remove_noorder(&ssh_sessions, i--);
+		}
+	}
+
+	update_selfmon_ssh_stats(ssh_requests, ssh_reused, ssh_sessions.values_num);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ssh_session_get                                                  *
+ *                                                                            *
+ * Purpose: take idle session authenticated with the item credentials from    *
+ *          the pool                                                          *
+ *                                                                            *
+ * Return value: the session or NULL if there is no suitable session          *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_ssh_session_t	*ssh_session_get(const DC_ITEM *item)
+{
+	zbx_ssh_session_t	*ssh;
+	int			i;
+
+	if (0 == ssh_sessions_init)
+	{
+		zbx_vector_ptr_create(&ssh_sessions);
+		ssh_sessions_init = 1;
+	}
+
+	ssh_sessions_expire();
+
+	for (i = 0; i < ssh_sessions.values_num; i++)
+	{
+		ssh = (zbx_ssh_session_t *)ssh_sessions.values[i];
+
+		if (ssh->port != item->interface.port || ssh->authtype != item->authtype ||
+				0 != strcmp(ssh->addr, item->interface.addr) ||
+				0 != strcmp(ssh->username, item->username) ||
+				0 != strcmp(ssh->password, item->password) ||
+				0 != strcmp(ssh->publickey, ZBX_NULL2EMPTY_STR(item->publickey)) ||
+				0 != strcmp(ssh->privatekey, ZBX_NULL2EMPTY_STR(item->privatekey)))
+		{
+			continue;
+		}
+
+		zbx_vector_ptr_remove_noorder(&ssh_sessions, i);
+
+		return ssh;
+	}
+
+	return NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ssh_session_release                                              *
+ *                                                                            *
+ * Purpose: return session to the pool, closing the least recently used       *
+ *          session if the pool is full                                       *
+ *                                                                            *
+ * Comments: the session is closed if the pool is disabled                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	ssh_session_release(zbx_ssh_session_t *ssh)
+{
+	int	i, oldest = 0;
+
+	if (0 == CONFIG_SSH_SESSION_CACHE_SIZE)
+	{
+		ssh_session_free(ssh);
+		return;
+	}
+
+	if (CONFIG_SSH_SESSION_CACHE_SIZE <= ssh_sessions.values_num)
+	{
+		for (i = 1; i < ssh_sessions.values_num; i++)
+		{
+			if (((zbx_ssh_session_t *)ssh_sessions.values[i])->lastaccess <
+					((zbx_ssh_session_t *)ssh_sessions.values[oldest])->lastaccess)
+			{
+				oldest = i;
+			}
+		}
+
+		ssh_session_free((zbx_ssh_session_t *)ssh_sessions.values[oldest]);
+		zbx_vector_ptr_remove_noorder(&ssh_sessions, oldest);
+	}
+
+	ssh->lastaccess = time(NULL);
+	zbx_vector_ptr_append(&ssh_sessions, ssh);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ssh_channel_open                                                 *
+ *                                                                            *
+ * Purpose: open a new channel of authenticated session                       *
+ *                                                                            *
+ * Return value: the channel or NULL if the session cannot be used            *
+ *                                                                            *
+ ******************************************************************************/
+static LIBSSH2_CHANNEL	*ssh_channel_open(zbx_ssh_session_t *ssh)
+{
+	LIBSSH2_CHANNEL	*channel;
+
 	/* exec non-blocking on the remove host */
-	while (NULL == (channel = libssh2_channel_open_session(session)))
+	while (NULL == (channel = libssh2_channel_open_session(ssh->session)))
 	{
-		switch (libssh2_session_last_error(session, NULL, NULL, 0))
+		switch (libssh2_session_last_error(ssh->session, NULL, NULL, 0))
 		{
 			/* marked for non-blocking I/O but the call would block. */
 			case LIBSSH2_ERROR_EAGAIN:
-				waitsocket(s.socket, session);
+				waitsocket(ssh->s.socket, ssh->session);
 				continue;
 			default:
-				SET_MSG_RESULT(result, zbx_strdup(NULL, "Cannot establish generic session channel"));
-				goto session_close;
+				return NULL;
 		}
 	}
 
-	dos2unix(item->params);	/* CR+LF (Windows) => LF (Unix) */
+	return channel;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ssh_exec                                                         *
+ *                                                                            *
+ * Purpose: execute command over a channel and close the channel              *
+ *                                                                            *
+ * Parameters: ssh        - [IN] the session                                  *
+ *             channel    - [IN] the channel                                  *
+ *             command    - [IN] the command                                  *
+ *             encoding   - [IN] the output encoding                          *
+ *             result     - [OUT] the command output                          *
+ *             error      - [OUT] the error message                           *
+ *             session_ok - [OUT] 1 if the session can be used for further    *
+ *                                commands, 0 otherwise                       *
+ *                                                                            *
+ * Return value: SUCCEED - the command was executed                           *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	ssh_exec(zbx_ssh_session_t *ssh, LIBSSH2_CHANNEL *channel, const char *command, const char *encoding,
+		AGENT_RESULT *result, char **error, int *session_ok)
+{
+	int	rc, ret = FAIL, exitcode, bytecount = 0, read_error = 0;
+	char	buffer[MAX_BUFFER_LEN], buf[16], *ssherr, *output;
+	size_t	sz;
+
+	*session_ok = 0;
+
 	/* request a shell on a channel and execute command */
-	while (0 != (rc = libssh2_channel_exec(channel, item->params)))
+	while (0 != (rc = libssh2_channel_exec(channel, command)))
 	{
 		switch (rc)
 		{
 			case LIBSSH2_ERROR_EAGAIN:
-				waitsocket(s.socket, session);
+				waitsocket(ssh->s.socket, ssh->session);
 				continue;
 			default:
-				SET_MSG_RESULT(result, zbx_strdup(NULL, "Cannot request a shell"));
+				*error = zbx_strdup(NULL, "Cannot request a shell");
 				goto channel_close;
 		}
 	}
@@ -278,10 +541,11 @@ static int	ssh_run(DC_ITEM *item, AGENT_RESULT *result, const char *encoding)
 		 * this condition
 		 */
 		if (LIBSSH2_ERROR_EAGAIN == rc)
-			waitsocket(s.socket, session);
+			waitsocket(ssh->s.socket, ssh->session);
 		else if (rc < 0)
 		{
-			SET_MSG_RESULT(result, zbx_strdup(NULL, "Cannot read data from SSH server"));
+			*error = zbx_strdup(NULL, "Cannot read data from SSH server");
+			read_error = 1;
 			goto channel_close;
 		}
 		else
@@ -294,40 +558,106 @@ static int	ssh_run(DC_ITEM *item, AGENT_RESULT *result, const char *encoding)
 	zbx_rtrim(output, ZBX_WHITESPACE);
 
 	if (SUCCEED == set_result_type(result, ITEM_VALUE_TYPE_TEXT, output))
-		ret = SYSINFO_RET_OK;
+		ret = SUCCEED;
 
 	zbx_free(output);
 channel_close:
 	/* close an active data channel */
 	exitcode = 127;
 	while (LIBSSH2_ERROR_EAGAIN == (rc = libssh2_channel_close(channel)))
-		waitsocket(s.socket, session);
+		waitsocket(ssh->s.socket, ssh->session);
 
 	if (0 != rc)
 	{
-		libssh2_session_last_error(session, &ssherr, NULL, 0);
+		libssh2_session_last_error(ssh->session, &ssherr, NULL, 0);
 		zabbix_log(LOG_LEVEL_WARNING, "%s() cannot close generic session channel: %s", __func__, ssherr);
 	}
 	else
+	{
 		exitcode = libssh2_channel_get_exit_status(channel);
 
+		/* channel errors do not affect the session, transport errors do */
+		if (0 == read_error)
+			*session_ok = 1;
+	}
+
 	zabbix_log(LOG_LEVEL_DEBUG, "%s() exitcode:%d bytecount:%d", __func__, exitcode, bytecount);
 
 	libssh2_channel_free(channel);
-	channel = NULL;
 
-session_close:
-	libssh2_session_disconnect(session, "Normal Shutdown");
+	return ret;
+}
 
-session_free:
-	libssh2_session_free(session);
+/******************************************************************************
+ *                                                                            *
+ * Function: ssh_run                                                          *
+ *                                                                            *
+ * Purpose: execute command on SSH server, e.g. ssh.run["ls /"]               *
+ *                                                                            *
+ * Comments: Authenticated sessions are kept open in a per process pool and   *
+ *           reused by the checks with the same host, port and credentials,   *
+ *           each check opening a new channel. A kept session that cannot     *
+ *           open a channel is replaced with a new one; the command is never  *
+ *           sent twice.                                                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	ssh_run(DC_ITEM *item, AGENT_RESULT *result, const char *encoding)
+{
+	zbx_ssh_session_t	*ssh;
+	LIBSSH2_CHANNEL		*channel = NULL;
+	int			ret = NOTSUPPORTED, session_ok;
+	char			*error = NULL;
 
-tcp_close:
-	zbx_tcp_close(&s);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	ssh_requests++;
+
+	if (0 != CONFIG_SSH_SESSION_CACHE_SIZE && NULL != (ssh = ssh_session_get(item)))
+	{
+		if (NULL != (channel = ssh_channel_open(ssh)))
+		{
+			ssh_reused++;
+		}
+		else
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "%s() cannot open channel of existing session", __func__);
+			ssh_session_free(ssh);
+		}
+	}
+
+	if (NULL == channel)
+	{
+		ssh = (zbx_ssh_session_t *)zbx_malloc(NULL, sizeof(zbx_ssh_session_t));
+
+		if (SUCCEED != ssh_session_open(item, ssh, &error))
+		{
+			zbx_free(ssh);
+			goto out;
+		}
+
+		if (NULL == (channel = ssh_channel_open(ssh)))
+		{
+			error = zbx_strdup(NULL, "Cannot establish generic session channel");
+			ssh_session_free(ssh);
+			goto out;
+		}
+	}
+
+	dos2unix(item->params);	/* CR+LF (Windows) => LF (Unix) */
+
+	if (SUCCEED == ssh_exec(ssh, channel, item->params, encoding, result, &error, &session_ok))
+		ret = SYSINFO_RET_OK;
+
+	if (0 != session_ok)
+		ssh_session_release(ssh);
+	else
+		ssh_session_free(ssh);
+out:
+	if (NULL != error)
+		SET_MSG_RESULT(result, error);
+
+	update_selfmon_ssh_stats(ssh_requests, ssh_reused, 0 != ssh_sessions_init ? ssh_sessions.values_num : 0);
 
-close:
-	zbx_free(publickey);
-	zbx_free(privatekey);
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
@@ -28,8 +28,10 @@
 
 extern char	*CONFIG_SOURCE_IP;
 extern char	*CONFIG_SSH_KEY_LOCATION;
+extern int	CONFIG_SSH_SESSION_CACHE_SIZE;
 
 int	get_value_ssh(DC_ITEM *item, AGENT_RESULT *result);
+void	ssh_sessions_expire(void);
 #endif	/* HAVE_SSH2 */
 
 #endif
@@ -492,8 +492,8 @@ static int	parse_query_fields(const DC_ITEM *item, char **query_fields)
  *                                                                            *
  * Author: Alexei Vladishev                                                   *
  *                                                                            *
- * Comments: processes single item at a time except for Java, SNMP items,     *
- *           see DCconfig_get_poller_items()                                  *
+ * Comments: processes single item at a time except for Java, SNMP and agent  *
+ *           items, see DCconfig_get_poller_items()                           *
  *                                                                            *
  ******************************************************************************/
 static int	get_values(unsigned char poller_type, int *nextcheck)
@@ -718,9 +718,13 @@ static int	get_values(unsigned char poller_type, int *nextcheck)
 	}
 	else if (ITEM_TYPE_JMX == items[0].type)
 	{
-		zbx_alarm_on(CONFIG_TIMEOUT);
+		/* Java checks use their own timeouts */
 		get_values_java(ZBX_JAVA_GATEWAY_REQUEST_JMX, items, results, errcodes, num);
-		zbx_alarm_off();
+	}
+	else if (ITEM_TYPE_ZABBIX == items[0].type && 1 < num)
+	{
+		/* agent checks use their own timeouts */
+		get_values_agent(items, results, errcodes, num);
 	}
 	else if (1 == num)
 	{
@@ -735,6 +739,10 @@ static int	get_values(unsigned char poller_type, int *nextcheck)
 	/* process item values */
 	for (i = 0; i < num; i++)
 	{
+		/* Java poller batches can contain items of different hosts */
+		if (0 != i && items[i].host.hostid != items[i - 1].host.hostid)
+			last_available = HOST_AVAILABLE_UNKNOWN;
+
 		switch (errcodes[i])
 		{
 			case SUCCEED:
@@ -918,6 +926,9 @@ ZBX_THREAD_ENTRY(poller_thread, args)
 		}
 
 		processed += get_values(poller_type, &nextcheck);
+#ifdef HAVE_SSH2
+		ssh_sessions_expire();
+#endif
 		total_sec += zbx_time() - sec;
 
 		sleeptime = calculate_sleeptime(nextcheck, POLLER_DELAY);
@@ -35,6 +35,27 @@
 extern unsigned char	process_type, program_type;
 extern int		server_num, process_num;
 
+#define ZBX_PROXY_STEP_CONFIG	0
+#define ZBX_PROXY_STEP_DATA	1
+#define ZBX_PROXY_STEP_TASKS	2
+#define ZBX_PROXY_STEP_DONE	3
+
+/* passive proxy taken from queue by proxy poller */
+typedef struct
+{
+	DC_PROXY	proxy;
+	DC_PROXY	proxy_old;
+	zbx_socket_t	sock;
+	zbx_timespec_t	ts;		/* the time the proxy connection was established */
+	double		sent;		/* the time the current request was sent */
+	double		latency;	/* time the proxy took to respond, negative if there was no response */
+	time_t		now;		/* the time the proxy was taken from queue */
+	int		ret;
+	unsigned char	update_nextcheck;
+	unsigned char	step;
+}
+zbx_proxy_conn_t;
+
 static int	connect_to_proxy(const DC_PROXY *proxy, zbx_socket_t *sock, int timeout)
 {
 	int		ret = FAIL;
@@ -93,7 +114,8 @@ static int	send_data_to_proxy(const DC_PROXY *proxy, zbx_socket_t *sock, const c
 	if (0 != proxy->auto_compress)
 		flags |= ZBX_TCP_COMPRESS;
 
-	if (FAIL == (ret = zbx_tcp_send_ext(sock, data, size, flags, 0)))
+	/* explicit timeout also clears the alarm left by connect, the response is waited for with select() */
+	if (FAIL == (ret = zbx_tcp_send_ext(sock, data, size, flags, CONFIG_TRAPPER_TIMEOUT)))
 	{
 		zabbix_log(LOG_LEVEL_ERR, "cannot send data to proxy \"%s\": %s", proxy->host, zbx_socket_strerror());
 
@@ -111,7 +133,7 @@ static int	recv_data_from_proxy(const DC_PROXY *proxy, zbx_socket_t *sock)
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	if (FAIL == (ret = zbx_tcp_recv(sock)))
+	if (FAIL == (ret = zbx_tcp_recv_to(sock, CONFIG_TRAPPER_TIMEOUT)))
 	{
 		zabbix_log(LOG_LEVEL_ERR, "cannot obtain data from proxy \"%s\": %s", proxy->host,
 				zbx_socket_strerror());
@@ -135,27 +157,24 @@ static void	disconnect_proxy(zbx_socket_t *sock)
 
 /******************************************************************************
  *                                                                            *
- * Function: get_data_from_proxy                                              *
+ * Function: send_request_to_proxy                                            *
  *                                                                            *
- * Purpose: get historical data from proxy                                    *
+ * Purpose: connect to proxy and send data request                            *
  *                                                                            *
- * Parameters: proxy   - [IN/OUT] proxy data                                  *
+ * Parameters: proxy   - [IN] proxy data                                      *
  *             request - [IN] requested data type                             *
- *             data    - [OUT] data received from proxy                       *
+ *             sock    - [OUT] the connection to proxy                        *
  *             ts      - [OUT] timestamp when the proxy connection was        *
  *                             established                                    *
- *             tasks   - [IN] proxy task response flag                        *
  *                                                                            *
- * Return value: SUCCESS - processed successfully                             *
+ * Return value: SUCCESS - request was sent, the connection is left open for  *
+ *                         receiving the response with get_data_from_proxy()  *
  *               other code - an error occurred                               *
  *                                                                            *
- * Comments: The proxy->compress property is updated depending on the         *
- *           protocol flags sent by proxy.                                    *
- *                                                                            *
  ******************************************************************************/
-static int	get_data_from_proxy(DC_PROXY *proxy, const char *request, char **data, zbx_timespec_t *ts)
+static int	send_request_to_proxy(const DC_PROXY *proxy, const char *request, zbx_socket_t *sock,
+		zbx_timespec_t *ts)
 {
-	zbx_socket_t	s;
 	struct zbx_json	j;
 	int		ret;
 
@@ -164,31 +183,61 @@ static int	get_data_from_proxy(DC_PROXY *proxy, const char *request, char **data
 	zbx_json_init(&j, ZBX_JSON_STAT_BUF_LEN);
 
 	zbx_json_addstring(&j, "request", request, ZBX_JSON_TYPE_STRING);
+	zbx_json_adduint64(&j, ZBX_PROTO_TAG_HISTORY_BINARY_FORMAT, ZBX_PROXY_HISTORY_BINARY_FORMAT);
 
-	if (SUCCEED == (ret = connect_to_proxy(proxy, &s, CONFIG_TRAPPER_TIMEOUT)))
+	if (SUCCEED == (ret = connect_to_proxy(proxy, sock, CONFIG_TRAPPER_TIMEOUT)))
 	{
-		/* get connection timestamp if required */
-		if (NULL != ts)
-			zbx_timespec(ts);
+		zbx_timespec(ts);
 
-		if (SUCCEED == (ret = send_data_to_proxy(proxy, &s, j.buffer, j.buffer_size)))
-		{
-			if (SUCCEED == (ret = recv_data_from_proxy(proxy, &s)))
-			{
-				if (0 != (s.protocol & ZBX_TCP_COMPRESS))
-					proxy->auto_compress = 1;
+		if (SUCCEED != (ret = send_data_to_proxy(proxy, sock, j.buffer, j.buffer_size)))
+			disconnect_proxy(sock);
+	}
 
-				ret = zbx_send_proxy_data_response(proxy, &s, NULL);
+	zbx_json_free(&j);
 
-				if (SUCCEED == ret)
-					*data = zbx_strdup(*data, s.buffer);
-			}
-		}
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
 
-		disconnect_proxy(&s);
+/******************************************************************************
+ *                                                                            *
+ * Function: get_data_from_proxy                                              *
+ *                                                                            *
+ * Purpose: get historical data from proxy                                    *
+ *                                                                            *
+ * Parameters: proxy - [IN/OUT] proxy data                                    *
+ *             sock  - [IN] the connection the request was sent over,         *
+ *                          closed by this function                           *
+ *             data  - [OUT] data received from proxy                         *
+ *                                                                            *
+ * Return value: SUCCESS - processed successfully                             *
+ *               other code - an error occurred                               *
+ *                                                                            *
+ * Comments: The proxy->compress property is updated depending on the         *
+ *           protocol flags sent by proxy.                                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	get_data_from_proxy(DC_PROXY *proxy, zbx_socket_t *sock, char **data)
+{
+	int			ret;
+	struct zbx_json_parse	jp;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	if (SUCCEED == (ret = recv_data_from_proxy(proxy, sock)))
+	{
+		if (0 != (sock->protocol & ZBX_TCP_COMPRESS))
+			proxy->auto_compress = 1;
+
+		ret = zbx_send_proxy_data_response(proxy, sock,
+				SUCCEED == zbx_json_open(sock->buffer, &jp) ? &jp : NULL, NULL, 0);
+
+		if (SUCCEED == ret)
+			*data = zbx_strdup(*data, sock->buffer);
 	}
 
-	zbx_json_free(&j);
+	disconnect_proxy(sock);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
@@ -201,20 +250,19 @@ static int	get_data_from_proxy(DC_PROXY *proxy, const char *request, char **data
  *                                                                            *
  * Purpose: sends configuration data to proxy                                 *
  *                                                                            *
- * Parameters: proxy - [IN/OUT] proxy data                                    *
+ * Parameters: proxy - [IN] proxy data                                        *
+ *             sock  - [OUT] the connection to proxy                          *
  *                                                                            *
- * Return value: SUCCEED - processed successfully                             *
+ * Return value: SUCCEED - configuration was sent, the connection is left     *
+ *                         open for receiving the response with               *
+ *                         proxy_recv_configuration()                         *
  *               other code - an error occurred                               *
  *                                                                            *
- * Comments: This function updates proxy version, compress and lastaccess     *
- *           properties.                                                      *
- *                                                                            *
  ******************************************************************************/
-static int	proxy_send_configuration(DC_PROXY *proxy)
+static int	proxy_send_configuration(const DC_PROXY *proxy, zbx_socket_t *sock)
 {
 	char		*error = NULL;
 	int		ret;
-	zbx_socket_t	s;
 	struct zbx_json	j;
 
 	zbx_json_init(&j, 512 * ZBX_KIBIBYTE);
@@ -222,48 +270,74 @@ static int	proxy_send_configuration(DC_PROXY *proxy)
 	zbx_json_addstring(&j, ZBX_PROTO_TAG_REQUEST, ZBX_PROTO_VALUE_PROXY_CONFIG, ZBX_JSON_TYPE_STRING);
 	zbx_json_addobject(&j, ZBX_PROTO_TAG_DATA);
 
-	if (SUCCEED != (ret = get_proxyconfig_data(proxy->hostid, &j, &error)))
+	if (SUCCEED != (ret = get_proxyconfig_data(proxy->hostid, &j, NULL, &error)))
 	{
 		zabbix_log(LOG_LEVEL_ERR, "cannot collect configuration data for proxy \"%s\": %s",
 				proxy->host, error);
 		goto out;
 	}
 
-	if (SUCCEED != (ret = connect_to_proxy(proxy, &s, CONFIG_TRAPPER_TIMEOUT)))
+	if (SUCCEED != (ret = connect_to_proxy(proxy, sock, CONFIG_TRAPPER_TIMEOUT)))
 		goto out;
 
 	zabbix_log(LOG_LEVEL_WARNING, "sending configuration data to proxy \"%s\" at \"%s\", datalen " ZBX_FS_SIZE_T,
-			proxy->host, s.peer, (zbx_fs_size_t)j.buffer_size);
+			proxy->host, sock->peer, (zbx_fs_size_t)j.buffer_size);
+
+	if (SUCCEED != (ret = send_data_to_proxy(proxy, sock, j.buffer, j.buffer_size)))
+		disconnect_proxy(sock);
+out:
+	zbx_free(error);
+	zbx_json_free(&j);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: proxy_recv_configuration                                         *
+ *                                                                            *
+ * Purpose: receives proxy response to the sent configuration data            *
+ *                                                                            *
+ * Parameters: proxy - [IN/OUT] proxy data                                    *
+ *             sock  - [IN] the connection configuration was sent over,       *
+ *                          closed by this function                           *
+ *                                                                            *
+ * Return value: SUCCEED - processed successfully                             *
+ *               other code - an error occurred                               *
+ *                                                                            *
+ * Comments: This function updates proxy version, compress and lastaccess     *
+ *           properties.                                                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	proxy_recv_configuration(DC_PROXY *proxy, zbx_socket_t *sock)
+{
+	char	*error = NULL;
+	int	ret;
 
-	if (SUCCEED == (ret = send_data_to_proxy(proxy, &s, j.buffer, j.buffer_size)))
+	if (SUCCEED != (ret = zbx_recv_response(sock, CONFIG_TRAPPER_TIMEOUT, &error)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot send configuration data to proxy"
+				" \"%s\" at \"%s\": %s", proxy->host, sock->peer, error);
+	}
+	else
 	{
-		if (SUCCEED != (ret = zbx_recv_response(&s, 0, &error)))
+		struct zbx_json_parse	jp;
+
+		if (SUCCEED != zbx_json_open(sock->buffer, &jp))
 		{
-			zabbix_log(LOG_LEVEL_WARNING, "cannot send configuration data to proxy"
-					" \"%s\" at \"%s\": %s", proxy->host, s.peer, error);
+			zabbix_log(LOG_LEVEL_WARNING, "invalid configuration data response received from proxy"
+					" \"%s\" at \"%s\": %s", proxy->host, sock->peer, zbx_json_strerror());
 		}
 		else
 		{
-			struct zbx_json_parse	jp;
-
-			if (SUCCEED != zbx_json_open(s.buffer, &jp))
-			{
-				zabbix_log(LOG_LEVEL_WARNING, "invalid configuration data response received from proxy"
-						" \"%s\" at \"%s\": %s", proxy->host, s.peer, zbx_json_strerror());
-			}
-			else
-			{
-				proxy->version = zbx_get_protocol_version(&jp);
-				proxy->auto_compress = (0 != (s.protocol & ZBX_TCP_COMPRESS) ? 1 : 0);
-				proxy->lastaccess = time(NULL);
-			}
+			proxy->version = zbx_get_protocol_version(&jp);
+			proxy->auto_compress = (0 != (sock->protocol & ZBX_TCP_COMPRESS) ? 1 : 0);
+			proxy->lastaccess = time(NULL);
 		}
 	}
 
-	disconnect_proxy(&s);
-out:
+	disconnect_proxy(sock);
 	zbx_free(error);
-	zbx_json_free(&j);
 
 	return ret;
 }
@@ -345,6 +419,9 @@ out:
  * Purpose: gets data from proxy ('proxy data' request)                       *
  *                                                                            *
  * Parameters: proxy  - [IN] proxy data                                       *
+ *             sock   - [IN] the connection the request was sent over         *
+ *             ts     - [IN] timestamp when the proxy connection was          *
+ *                           established                                      *
  *             more   - [OUT] available data flag                             *
  *                                                                            *
  * Return value: SUCCEED - data were received and processed successfully      *
@@ -354,15 +431,14 @@ out:
  *           properties.                                                      *
  *                                                                            *
  ******************************************************************************/
-static int	proxy_get_data(DC_PROXY *proxy, int *more)
+static int	proxy_get_data(DC_PROXY *proxy, zbx_socket_t *sock, zbx_timespec_t *ts, int *more)
 {
-	char		*answer = NULL;
-	int		ret;
-	zbx_timespec_t	ts;
+	char	*answer = NULL;
+	int	ret;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	if (SUCCEED != (ret = get_data_from_proxy(proxy, ZBX_PROTO_VALUE_PROXY_DATA, &answer, &ts)))
+	if (SUCCEED != (ret = get_data_from_proxy(proxy, sock, &answer)))
 		goto out;
 
 	/* handle pre 3.4 proxies that did not support proxy data request */
@@ -375,7 +451,7 @@ static int	proxy_get_data(DC_PROXY *proxy, int *more)
 	}
 
 	proxy->lastaccess = time(NULL);
-	ret = proxy_process_proxy_data(proxy, answer, &ts, more);
+	ret = proxy_process_proxy_data(proxy, answer, ts, more);
 	zbx_free(answer);
 out:
 	if (SUCCEED == ret)
@@ -393,6 +469,9 @@ out:
  * Purpose: gets data from proxy ('proxy data' request)                       *
  *                                                                            *
  * Parameters: proxy - [IN/OUT] the proxy data                                *
+ *             sock  - [IN] the connection the request was sent over          *
+ *             ts    - [IN] timestamp when the proxy connection was           *
+ *                          established                                       *
  *                                                                            *
  * Return value: SUCCEED - data were received and processed successfully      *
  *               other code - an error occurred                               *
@@ -401,23 +480,19 @@ out:
  *           properties.                                                      *
  *                                                                            *
  ******************************************************************************/
-static int	proxy_get_tasks(DC_PROXY *proxy)
+static int	proxy_get_tasks(DC_PROXY *proxy, zbx_socket_t *sock, zbx_timespec_t *ts)
 {
-	char		*answer = NULL;
-	int		ret = FAIL, more;
-	zbx_timespec_t	ts;
+	char	*answer = NULL;
+	int	ret, more;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	if (ZBX_COMPONENT_VERSION(3, 2) >= proxy->version)
-		goto out;
-
-	if (SUCCEED != (ret = get_data_from_proxy(proxy, ZBX_PROTO_VALUE_PROXY_TASKS, &answer, &ts)))
+	if (SUCCEED != (ret = get_data_from_proxy(proxy, sock, &answer)))
 		goto out;
 
 	proxy->lastaccess = time(NULL);
 
-	ret = proxy_process_proxy_data(proxy, answer, &ts, &more);
+	ret = proxy_process_proxy_data(proxy, answer, ts, &more);
 
 	zbx_free(answer);
 out:
@@ -426,112 +501,319 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: proxy_get_step                                                   *
+ *                                                                            *
+ * Purpose: get the next exchange to be performed with passive proxy          *
+ *                                                                            *
+ * Parameters: proxy - [IN] the proxy data                                    *
+ *             now   - [IN] the time proxy was taken from queue               *
+ *             step  - [IN] the first exchange that can still be performed    *
+ *                                                                            *
+ * Return value: the next exchange or ZBX_PROXY_STEP_DONE                     *
+ *                                                                            *
+ ******************************************************************************/
+static unsigned char	proxy_get_step(const DC_PROXY *proxy, time_t now, unsigned char step)
+{
+	if (ZBX_PROXY_STEP_CONFIG >= step && proxy->proxy_config_nextcheck <= now)
+		return ZBX_PROXY_STEP_CONFIG;
+
+	if (ZBX_PROXY_STEP_DATA >= step)
+	{
+		if (proxy->proxy_data_nextcheck <= now)
+			return ZBX_PROXY_STEP_DATA;
+
+		if (proxy->proxy_tasks_nextcheck <= now)
+			return ZBX_PROXY_STEP_TASKS;
+	}
+
+	return ZBX_PROXY_STEP_DONE;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: proxy_conn_send                                                  *
+ *                                                                            *
+ * Purpose: send request of the current exchange step to passive proxy        *
+ *                                                                            *
+ * Parameters: conn - [IN/OUT] the proxy connection                           *
+ *                                                                            *
+ * Comments: On failure the connection step is set to ZBX_PROXY_STEP_DONE.    *
+ *                                                                            *
+ ******************************************************************************/
+static void	proxy_conn_send(zbx_proxy_conn_t *conn)
+{
+	switch (conn->step)
+	{
+		case ZBX_PROXY_STEP_CONFIG:
+			conn->ret = proxy_send_configuration(&conn->proxy, &conn->sock);
+			break;
+		case ZBX_PROXY_STEP_DATA:
+			conn->ret = send_request_to_proxy(&conn->proxy, ZBX_PROTO_VALUE_PROXY_DATA, &conn->sock,
+					&conn->ts);
+			break;
+		case ZBX_PROXY_STEP_TASKS:
+			if (ZBX_COMPONENT_VERSION(3, 2) >= conn->proxy.version)
+			{
+				conn->ret = FAIL;
+				break;
+			}
+
+			conn->ret = send_request_to_proxy(&conn->proxy, ZBX_PROTO_VALUE_PROXY_TASKS, &conn->sock,
+					&conn->ts);
+			break;
+		default:
+			return;
+	}
+
+	if (SUCCEED != conn->ret)
+		conn->step = ZBX_PROXY_STEP_DONE;
+	else
+		conn->sent = zbx_time();
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: proxy_conn_recv                                                  *
+ *                                                                            *
+ * Purpose: receive and process passive proxy response to the current         *
+ *          exchange step and send request of the next step                   *
+ *                                                                            *
+ * Parameters: conn     - [IN/OUT] the proxy connection                       *
+ *             readable - [IN] the time the response became readable          *
+ *                                                                            *
+ ******************************************************************************/
+static void	proxy_conn_recv(zbx_proxy_conn_t *conn, double readable)
+{
+	int	more = ZBX_PROXY_DATA_DONE;
+
+	conn->latency = readable - conn->sent;
+
+	switch (conn->step)
+	{
+		case ZBX_PROXY_STEP_CONFIG:
+			if (SUCCEED == (conn->ret = proxy_recv_configuration(&conn->proxy, &conn->sock)))
+				conn->step = proxy_get_step(&conn->proxy, conn->now, ZBX_PROXY_STEP_DATA);
+			else
+				conn->step = ZBX_PROXY_STEP_DONE;
+			break;
+		case ZBX_PROXY_STEP_DATA:
+			conn->ret = proxy_get_data(&conn->proxy, &conn->sock, &conn->ts, &more);
+
+			if (SUCCEED != conn->ret || ZBX_PROXY_DATA_MORE != more)
+				conn->step = ZBX_PROXY_STEP_DONE;
+			break;
+		default:
+			conn->ret = proxy_get_tasks(&conn->proxy, &conn->sock, &conn->ts);
+			conn->step = ZBX_PROXY_STEP_DONE;
+	}
+
+	proxy_conn_send(conn);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: proxy_conn_start                                                 *
+ *                                                                            *
+ * Purpose: prepare passive proxy taken from queue and send its first request *
+ *                                                                            *
+ * Parameters: conn - [IN/OUT] the proxy connection                           *
+ *             now  - [IN] the current time                                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	proxy_conn_start(zbx_proxy_conn_t *conn, time_t now)
+{
+	DC_PROXY	*proxy = &conn->proxy;
+
+	memcpy(&conn->proxy_old, proxy, sizeof(DC_PROXY));
+
+	conn->now = now;
+	conn->ret = FAIL;
+	conn->latency = -1;
+	conn->update_nextcheck = 0;
+	conn->step = ZBX_PROXY_STEP_DONE;
+
+	if (proxy->proxy_config_nextcheck <= now)
+		conn->update_nextcheck |= ZBX_PROXY_CONFIG_NEXTCHECK;
+	if (proxy->proxy_data_nextcheck <= now)
+		conn->update_nextcheck |= ZBX_PROXY_DATA_NEXTCHECK;
+	if (proxy->proxy_tasks_nextcheck <= now)
+		conn->update_nextcheck |= ZBX_PROXY_TASKS_NEXTCHECK;
+
+	/* Check if passive proxy has been misconfigured on the server side. If it has happened more */
+	/* recently than last synchronisation of cache then there is no point to retry connecting to */
+	/* proxy again. The next reconnection attempt will happen after cache synchronisation. */
+	if (proxy->last_cfg_error_time < DCconfig_get_last_sync_time())
+	{
+		char	*port = NULL;
+
+		proxy->addr = proxy->addr_orig;
+
+		port = zbx_strdup(port, proxy->port_orig);
+		substitute_simple_macros(NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+				&port, MACRO_TYPE_COMMON, NULL, 0);
+		if (FAIL == is_ushort(port, &proxy->port))
+		{
+			zabbix_log(LOG_LEVEL_ERR, "invalid proxy \"%s\" port: \"%s\"", proxy->host, port);
+			conn->ret = CONFIG_ERROR;
+		}
+		else
+			conn->step = proxy_get_step(proxy, now, ZBX_PROXY_STEP_CONFIG);
+
+		zbx_free(port);
+	}
+
+	proxy_conn_send(conn);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: proxy_conn_finish                                                *
+ *                                                                            *
+ * Purpose: store changed proxy properties and return proxy to the queue      *
+ *                                                                            *
+ * Parameters: conn - [IN] the proxy connection                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	proxy_conn_finish(zbx_proxy_conn_t *conn)
+{
+	const DC_PROXY	*proxy = &conn->proxy;
+
+	if (conn->proxy_old.version != proxy->version || conn->proxy_old.auto_compress != proxy->auto_compress ||
+			conn->proxy_old.lastaccess != proxy->lastaccess)
+	{
+		zbx_update_proxy_data(&conn->proxy_old, proxy->version, proxy->lastaccess, proxy->auto_compress);
+	}
+
+	DCrequeue_proxy(proxy->hostid, conn->update_nextcheck, conn->ret, conn->latency);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: process_proxy                                                    *
  *                                                                            *
  * Purpose: retrieve values of metrics from monitored hosts                   *
  *                                                                            *
- * Parameters:                                                                *
+ * Parameters: conns - [IN/OUT] the proxies waited for response               *
  *                                                                            *
- * Return value:                                                              *
+ * Return value: number of proxies exchange was finished with                 *
  *                                                                            *
  * Author: Alexei Vladishev                                                   *
  *                                                                            *
- * Comments:                                                                  *
+ * Comments: Up to ProxyPollerMaxConnections proxies are taken from queue and *
+ *           sent requests, then responses are processed as they arrive so    *
+ *           that slow proxies do not delay the others. Proxies still waited  *
+ *           for are kept in conns until the next call.                       *
  *                                                                            *
  ******************************************************************************/
-static int	process_proxy(void)
+static int	process_proxy(zbx_vector_ptr_t *conns)
 {
-	DC_PROXY	proxy, proxy_old;
-	int		num, i;
-	time_t		now;
-
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+	zbx_proxy_conn_t	*conn;
+	int			i, rc, processed = 0;
+	time_t			now;
+	double			time_now;
+	fd_set			fdr;
+	ZBX_SOCKET		max_fd = 0;
+	struct timeval		tv;
 
-	if (0 == (num = DCconfig_get_proxypoller_hosts(&proxy, 1)))
-		goto exit;
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() waiting:%d", __func__, conns->values_num);
 
 	now = time(NULL);
 
-	for (i = 0; i < num; i++)
+	while (conns->values_num < CONFIG_PROXYPOLLER_MAX_CONNECTIONS)
 	{
-		int		ret = FAIL;
-		unsigned char	update_nextcheck = 0;
-
-		memcpy(&proxy_old, &proxy, sizeof(DC_PROXY));
-
-		if (proxy.proxy_config_nextcheck <= now)
-			update_nextcheck |= ZBX_PROXY_CONFIG_NEXTCHECK;
-		if (proxy.proxy_data_nextcheck <= now)
-			update_nextcheck |= ZBX_PROXY_DATA_NEXTCHECK;
-		if (proxy.proxy_tasks_nextcheck <= now)
-			update_nextcheck |= ZBX_PROXY_TASKS_NEXTCHECK;
-
-		/* Check if passive proxy has been misconfigured on the server side. If it has happened more */
-		/* recently than last synchronisation of cache then there is no point to retry connecting to */
-		/* proxy again. The next reconnection attempt will happen after cache synchronisation. */
-		if (proxy.last_cfg_error_time < DCconfig_get_last_sync_time())
+		conn = (zbx_proxy_conn_t *)zbx_malloc(NULL, sizeof(zbx_proxy_conn_t));
+
+		if (0 == DCconfig_get_proxypoller_hosts(&conn->proxy, 1))
 		{
-			char	*port = NULL;
+			zbx_free(conn);
+			break;
+		}
 
-			proxy.addr = proxy.addr_orig;
+		proxy_conn_start(conn, now);
 
-			port = zbx_strdup(port, proxy.port_orig);
-			substitute_simple_macros(NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
-					&port, MACRO_TYPE_COMMON, NULL, 0);
-			if (FAIL == is_ushort(port, &proxy.port))
-			{
-				zabbix_log(LOG_LEVEL_ERR, "invalid proxy \"%s\" port: \"%s\"", proxy.host, port);
-				ret = CONFIG_ERROR;
-				zbx_free(port);
-				goto error;
-			}
-			zbx_free(port);
+		if (ZBX_PROXY_STEP_DONE == conn->step)
+		{
+			proxy_conn_finish(conn);
+			zbx_free(conn);
+			processed++;
+			continue;
+		}
 
-			if (proxy.proxy_config_nextcheck <= now)
-			{
-				if (SUCCEED != (ret = proxy_send_configuration(&proxy)))
-					goto error;
-			}
+		zbx_vector_ptr_append(conns, conn);
+	}
 
-			if (proxy.proxy_data_nextcheck <= now)
-			{
-				int	more;
-
-				do
-				{
-					if (SUCCEED != (ret = proxy_get_data(&proxy, &more)))
-						goto error;
-				}
-				while (ZBX_PROXY_DATA_MORE == more);
-			}
-			else if (proxy.proxy_tasks_nextcheck <= now)
-			{
-				if (SUCCEED != (ret = proxy_get_tasks(&proxy)))
-					goto error;
-			}
+	if (0 == conns->values_num)
+		goto out;
+
+	FD_ZERO(&fdr);
+
+	for (i = 0; i < conns->values_num; i++)
+	{
+		conn = (zbx_proxy_conn_t *)conns->values[i];
+
+		FD_SET(conn->sock.socket, &fdr);
+
+		if (max_fd < conn->sock.socket)
+			max_fd = conn->sock.socket;
+	}
+
+	tv.tv_sec = 1;
+	tv.tv_usec = 0;
+
+	update_selfmon_counter(ZBX_PROCESS_STATE_IDLE);
+
+	if (-1 == (rc = select(ZBX_SOCKET_TO_INT(max_fd) + 1, &fdr, NULL, NULL, &tv)))
+	{
+		if (EINTR != errno)
+			zabbix_log(LOG_LEVEL_ERR, "cannot wait for proxy response: %s", zbx_strerror(errno));
+
+		FD_ZERO(&fdr);
+	}
+
+	/* latency of all ready responses is measured here, before any of them is processed */
+	time_now = zbx_time();
+
+	update_selfmon_counter(ZBX_PROCESS_STATE_BUSY);
+
+	for (i = conns->values_num - 1; i >= 0; i--)
+	{
+		conn = (zbx_proxy_conn_t *)conns->values[i];
+
+		if (0 < rc && FD_ISSET(conn->sock.socket, &fdr))
+		{
+			proxy_conn_recv(conn, time_now);
 		}
-error:
-		if (proxy_old.version != proxy.version || proxy_old.auto_compress != proxy.auto_compress ||
-				proxy_old.lastaccess != proxy.lastaccess)
+		else if (time_now - conn->sent >= CONFIG_TRAPPER_TIMEOUT)
 		{
-			zbx_update_proxy_data(&proxy_old, proxy.version, proxy.lastaccess, proxy.auto_compress);
+			zabbix_log(LOG_LEVEL_ERR, "cannot obtain data from proxy \"%s\": timeout while waiting for"
+					" response", conn->proxy.host);
+			disconnect_proxy(&conn->sock);
+			conn->ret = NETWORK_ERROR;
+			conn->step = ZBX_PROXY_STEP_DONE;
 		}
 
-		DCrequeue_proxy(proxy.hostid, update_nextcheck, ret);
+		if (ZBX_PROXY_STEP_DONE == conn->step)
+		{
+			proxy_conn_finish(conn);
+			zbx_free(conn);
+			zbx_vector_ptr_remove(conns, i);
+			processed++;
+		}
 	}
-exit:
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() processed:%d waiting:%d", __func__, processed, conns->values_num);
 
-	return num;
+	return processed;
 }
 
 ZBX_THREAD_ENTRY(proxypoller_thread, args)
 {
-	int	nextcheck, sleeptime = -1, processed = 0, old_processed = 0;
-	double	sec, total_sec = 0.0, old_total_sec = 0.0;
-	time_t	last_stat_time;
+	int			nextcheck, sleeptime = -1, processed = 0, old_processed = 0;
+	double			sec, total_sec = 0.0, old_total_sec = 0.0;
+	time_t			last_stat_time;
+	zbx_vector_ptr_t	conns;
 
 	process_type = ((zbx_thread_args_t *)args)->process_type;
 	server_num = ((zbx_thread_args_t *)args)->server_num;
@@ -551,6 +833,8 @@ ZBX_THREAD_ENTRY(proxypoller_thread, args)
 
 	DBconnect(ZBX_DB_CONNECT_NORMAL);
 
+	zbx_vector_ptr_create(&conns);
+
 	for (;;)
 	{
 		sec = zbx_time();
@@ -563,11 +847,16 @@ ZBX_THREAD_ENTRY(proxypoller_thread, args)
 					old_processed, old_total_sec);
 		}
 
-		processed += process_proxy();
+		processed += process_proxy(&conns);
 		total_sec += zbx_time() - sec;
 
-		nextcheck = DCconfig_get_proxypoller_nextcheck();
-		sleeptime = calculate_sleeptime(nextcheck, POLLER_DELAY);
+		if (0 == conns.values_num)
+		{
+			nextcheck = DCconfig_get_proxypoller_nextcheck();
+			sleeptime = calculate_sleeptime(nextcheck, POLLER_DELAY);
+		}
+		else
+			sleeptime = 0;
 
 		if (0 != sleeptime || STAT_INTERVAL <= time(NULL) - last_stat_time)
 		{
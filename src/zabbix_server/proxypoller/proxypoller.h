@@ -24,6 +24,7 @@
 
 extern char	*CONFIG_SOURCE_IP;
 extern int	CONFIG_TRAPPER_TIMEOUT;
+extern int	CONFIG_PROXYPOLLER_MAX_CONNECTIONS;
 
 ZBX_THREAD_ENTRY(proxypoller_thread, args);
 
@@ -37,13 +37,13 @@ extern unsigned char	process_type, program_type;
 extern int		server_num, process_num;
 extern int		CONFIG_TIMER_FORKS;
 
-/* trigger -> functions cache */
+/* event -> tags cache, problem tags do not change after the problem is created */
 typedef struct
 {
-	zbx_uint64_t		triggerid;
-	zbx_vector_uint64_t	functionids;
+	zbx_uint64_t		eventid;
+	zbx_vector_ptr_t	tags;
 }
-zbx_trigger_functions_t;
+zbx_event_tags_t;
 
 /* addition data for event maintenance calculations to pair with zbx_event_suppress_query_t */
 typedef struct
@@ -53,6 +53,9 @@ typedef struct
 }
 zbx_event_suppress_data_t;
 
+/* tags of the events processed by the previous event suppress data update */
+static zbx_hashset_t	event_tags;
+
 /******************************************************************************
  *                                                                            *
  * Function: log_host_maintenance_update                                      *
@@ -316,90 +319,64 @@ static void	db_get_query_events(zbx_vector_ptr_t *event_queries, zbx_vector_ptr_
 
 /******************************************************************************
  *                                                                            *
- * Function: db_get_query_functions                                           *
+ * Function: event_tags_free                                                  *
  *                                                                            *
- * Purpose: get event query functionids from database                         *
+ * Purpose: free cached event tags                                            *
  *                                                                            *
  ******************************************************************************/
-static void	db_get_query_functions(zbx_vector_ptr_t *event_queries)
+static void	event_tags_free(zbx_event_tags_t *tags)
 {
-	DB_ROW				row;
-	DB_RESULT			result;
-	int				i;
-	zbx_vector_uint64_t		triggerids;
-	zbx_hashset_t			triggers;
-	zbx_hashset_iter_t		iter;
-	char				*sql = NULL;
-	size_t				sql_alloc = 0, sql_offset = 0;
-	zbx_trigger_functions_t		*trigger = NULL, trigger_local;
-	zbx_uint64_t			triggerid, functionid;
-	zbx_event_suppress_query_t	*query;
-
-	/* cache functionids by triggerids */
-
-	zbx_hashset_create(&triggers, 100, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-
-	zbx_vector_uint64_create(&triggerids);
-
-	for (i = 0; i < event_queries->values_num; i++)
-	{
-		query = (zbx_event_suppress_query_t *)event_queries->values[i];
-		zbx_vector_uint64_append(&triggerids, query->triggerid);
-	}
-
-	zbx_vector_uint64_sort(&triggerids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-	zbx_vector_uint64_uniq(&triggerids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_ptr_clear_ext(&tags->tags, (zbx_clean_func_t)zbx_free_tag);
+	zbx_vector_ptr_destroy(&tags->tags);
+}
 
-	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, "select functionid,triggerid from functions where");
-	DBadd_condition_alloc(&sql, &sql_alloc, &sql_offset, "triggerid", triggerids.values,
-			triggerids.values_num);
-	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " order by triggerid");
+/******************************************************************************
+ *                                                                            *
+ * Function: event_query_free                                                 *
+ *                                                                            *
+ * Purpose: free event query structure without the tags it shares with the    *
+ *          event tags cache                                                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	event_query_free(zbx_event_suppress_query_t *query)
+{
+	zbx_vector_ptr_clear(&query->tags);
+	zbx_event_suppress_query_free(query);
+}
 
-	result = DBselect("%s", sql);
-	zbx_free(sql);
+/******************************************************************************
+ *                                                                            *
+ * Function: event_tags_remove_unused                                         *
+ *                                                                            *
+ * Purpose: remove cached tags of events that are no longer processed         *
+ *                                                                            *
+ * Parameters: event_queries - [IN] the event queries sorted by eventid       *
+ *                                                                            *
+ ******************************************************************************/
+static void	event_tags_remove_unused(const zbx_vector_ptr_t *event_queries)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_event_tags_t	*tags;
 
-	while (NULL != (row = DBfetch(result)))
+	zbx_hashset_iter_reset(&event_tags, &iter);
+	while (NULL != (tags = (zbx_event_tags_t *)zbx_hashset_iter_next(&iter)))
 	{
-		ZBX_STR2UINT64(functionid, row[0]);
-		ZBX_STR2UINT64(triggerid, row[1]);
-
-		if (NULL == trigger || trigger->triggerid != triggerid)
+		if (FAIL == zbx_vector_ptr_bsearch(event_queries, &tags->eventid, ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC))
 		{
-			trigger_local.triggerid = triggerid;
-			trigger = (zbx_trigger_functions_t *)zbx_hashset_insert(&triggers, &trigger_local,
-					sizeof(trigger_local));
-			zbx_vector_uint64_create(&trigger->functionids);
+			event_tags_free(tags);
+			zbx_hashset_iter_remove(&iter);
 		}
-		zbx_vector_uint64_append(&trigger->functionids, functionid);
 	}
-	DBfree_result(result);
-
-	/*  copy functionids to event queries */
-
-	for (i = 0; i < event_queries->values_num; i++)
-	{
-		query = (zbx_event_suppress_query_t *)event_queries->values[i];
-
-		if (NULL == (trigger = (zbx_trigger_functions_t *)zbx_hashset_search(&triggers, &query->triggerid)))
-			continue;
-
-		zbx_vector_uint64_append_array(&query->functionids, trigger->functionids.values,
-				trigger->functionids.values_num);
-	}
-
-	zbx_hashset_iter_reset(&triggers, &iter);
-	while (NULL != (trigger = (zbx_trigger_functions_t *)zbx_hashset_iter_next(&iter)))
-		zbx_vector_uint64_destroy(&trigger->functionids);
-	zbx_hashset_destroy(&triggers);
-
-	zbx_vector_uint64_destroy(&triggerids);
 }
 
 /******************************************************************************
  *                                                                            *
  * Function: db_get_query_tags                                                *
  *                                                                            *
- * Purpose: get event query tags from database                                *
+ * Purpose: get event query tags from cache or database                       *
+ *                                                                            *
+ * Comments: Only tags of events that were not processed by the previous      *
+ *           update are read from database.                                   *
  *                                                                            *
  ******************************************************************************/
 static void	db_get_query_tags(zbx_vector_ptr_t *event_queries)
@@ -407,46 +384,70 @@ static void	db_get_query_tags(zbx_vector_ptr_t *event_queries)
 	DB_ROW				row;
 	DB_RESULT			result;
 	int				i;
-	char				*sql = NULL;
-	size_t				sql_alloc = 0, sql_offset = 0;
 	zbx_event_suppress_query_t	*query;
 	zbx_vector_uint64_t		eventids;
 	zbx_uint64_t			eventid;
 	zbx_tag_t			*tag;
+	zbx_event_tags_t		*tags = NULL, tags_local;
 
 	zbx_vector_uint64_create(&eventids);
 
 	for (i = 0; i < event_queries->values_num; i++)
 	{
 		query = (zbx_event_suppress_query_t *)event_queries->values[i];
+
+		if (NULL != zbx_hashset_search(&event_tags, &query->eventid))
+			continue;
+
+		tags_local.eventid = query->eventid;
+		tags = (zbx_event_tags_t *)zbx_hashset_insert(&event_tags, &tags_local, sizeof(tags_local));
+		zbx_vector_ptr_create(&tags->tags);
+
 		zbx_vector_uint64_append(&eventids, query->eventid);
 	}
 
-	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, "select eventid,tag,value from problem_tag where");
-	DBadd_condition_alloc(&sql, &sql_alloc, &sql_offset, "eventid", eventids.values, eventids.values_num);
-	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " order by eventid");
+	if (0 != eventids.values_num)
+	{
+		char	*sql = NULL;
+		size_t	sql_alloc = 0, sql_offset = 0;
 
-	result = DBselect("%s", sql);
-	zbx_free(sql);
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, "select eventid,tag,value from problem_tag where");
+		DBadd_condition_alloc(&sql, &sql_alloc, &sql_offset, "eventid", eventids.values, eventids.values_num);
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " order by eventid");
 
-	i = 0;
-	query = (zbx_event_suppress_query_t *)event_queries->values[0];
+		result = DBselect("%s", sql);
+		zbx_free(sql);
 
-	while (NULL != (row = DBfetch(result)))
-	{
-		ZBX_STR2UINT64(eventid, row[0]);
+		tags = NULL;
+
+		while (NULL != (row = DBfetch(result)))
+		{
+			ZBX_STR2UINT64(eventid, row[0]);
 
-		while (query->eventid != eventid)
-			query = (zbx_event_suppress_query_t *)event_queries->values[++i];
+			if (NULL == tags || tags->eventid != eventid)
+				tags = (zbx_event_tags_t *)zbx_hashset_search(&event_tags, &eventid);
 
-		tag = (zbx_tag_t *)zbx_malloc(NULL, sizeof(zbx_tag_t));
-		tag->tag = zbx_strdup(NULL, row[1]);
-		tag->value = zbx_strdup(NULL, row[2]);
-		zbx_vector_ptr_append(&query->tags, tag);
+			tag = (zbx_tag_t *)zbx_malloc(NULL, sizeof(zbx_tag_t));
+			tag->tag = zbx_strdup(NULL, row[1]);
+			tag->value = zbx_strdup(NULL, row[2]);
+			zbx_vector_ptr_append(&tags->tags, tag);
+		}
+		DBfree_result(result);
 	}
-	DBfree_result(result);
 
 	zbx_vector_uint64_destroy(&eventids);
+
+	/* event queries share tags with cache, see event_query_free() */
+
+	for (i = 0; i < event_queries->values_num; i++)
+	{
+		query = (zbx_event_suppress_query_t *)event_queries->values[i];
+
+		if (NULL == (tags = (zbx_event_tags_t *)zbx_hashset_search(&event_tags, &query->eventid)))
+			continue;
+
+		zbx_vector_ptr_append_array(&query->tags, tags->tags.values, tags->tags.values_num);
+	}
 }
 
 /******************************************************************************
@@ -469,6 +470,7 @@ static void	db_update_event_suppress_data(int *suppressed_num)
 	zbx_vector_ptr_create(&event_data);
 
 	db_get_query_events(&event_queries, &event_data);
+	event_tags_remove_unused(&event_queries);
 
 	if (0 != event_queries.values_num)
 	{
@@ -485,7 +487,7 @@ static void	db_update_event_suppress_data(int *suppressed_num)
 		zbx_vector_uint64_create(&maintenanceids);
 		zbx_vector_uint64_pair_create(&del_event_maintenances);
 
-		db_get_query_functions(&event_queries);
+		zbx_dc_get_event_query_functionids(&event_queries);
 		db_get_query_tags(&event_queries);
 
 		zbx_dc_get_running_maintenanceids(&maintenanceids);
@@ -617,7 +619,7 @@ cleanup:
 	zbx_vector_ptr_clear_ext(&event_data, (zbx_clean_func_t)event_suppress_data_free);
 	zbx_vector_ptr_destroy(&event_data);
 
-	zbx_vector_ptr_clear_ext(&event_queries, (zbx_clean_func_t)zbx_event_suppress_query_free);
+	zbx_vector_ptr_clear_ext(&event_queries, (zbx_clean_func_t)event_query_free);
 	zbx_vector_ptr_destroy(&event_queries);
 }
 
@@ -693,6 +695,8 @@ ZBX_THREAD_ENTRY(timer_thread, args)
 
 	DBconnect(ZBX_DB_CONNECT_NORMAL);
 
+	zbx_hashset_create(&event_tags, 100, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
 	for (;;)
 	{
 		sec = zbx_time();
@@ -23,12 +23,28 @@
 #include "log.h"
 #include "zbxserver.h"
 #include "zbxregexp.h"
+#include "md5.h"
 
 #include "active.h"
 #include "../../libs/zbxcrypto/tls_tcp_active.h"
 
 extern unsigned char	program_type;
 
+#define ZBX_ACTIVE_CHECKS_CHECKSUM_LEN	(MD5_DIGEST_SIZE * 2)
+
+/* checksum of the last active check list sent to each host by this process */
+typedef struct
+{
+	zbx_uint64_t	hostid;
+	zbx_uint64_t	revision;	/* host configuration revision the list was built for */
+	int		lastaccess;
+	char		checksum[ZBX_ACTIVE_CHECKS_CHECKSUM_LEN + 1];
+}
+zbx_active_checks_cache_t;
+
+static zbx_hashset_t	active_checks_cache;
+static int		active_checks_cache_init = 0, active_checks_cache_cleanup = 0;
+
 /******************************************************************************
  *                                                                            *
  * Function: db_register_host                                                 *
@@ -438,6 +454,104 @@ out:
 	free_request(&request);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: active_checks_cache_get                                          *
+ *                                                                            *
+ * Purpose: get cached checksum of host active check list                     *
+ *                                                                            *
+ * Parameters: hostid   - [IN] the host identifier                            *
+ *             revision - [IN] the current host configuration revision        *
+ *                                                                            *
+ * Return value: the checksum or NULL if the list must be rebuilt             *
+ *                                                                            *
+ ******************************************************************************/
+static const char	*active_checks_cache_get(zbx_uint64_t hostid, zbx_uint64_t revision)
+{
+	zbx_active_checks_cache_t	*entry;
+
+	if (0 == active_checks_cache_init)
+		return NULL;
+
+	if (NULL == (entry = (zbx_active_checks_cache_t *)zbx_hashset_search(&active_checks_cache, &hostid)) ||
+			entry->revision != revision)
+	{
+		return NULL;
+	}
+
+	entry->lastaccess = (int)time(NULL);
+
+	return entry->checksum;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: active_checks_cache_set                                          *
+ *                                                                            *
+ * Purpose: remember checksum of host active check list                       *
+ *                                                                            *
+ * Parameters: hostid   - [IN] the host identifier                            *
+ *             revision - [IN] the host configuration revision the list was   *
+ *                             built for                                      *
+ *             checksum - [IN] the list checksum, NULL to forget the host     *
+ *                                                                            *
+ * Comments: Entries of hosts that did not request active checks for a day    *
+ *           are removed once per hour.                                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	active_checks_cache_set(zbx_uint64_t hostid, zbx_uint64_t revision, const char *checksum)
+{
+	zbx_active_checks_cache_t	*entry, entry_local;
+	zbx_hashset_iter_t		iter;
+	int				now;
+
+	now = (int)time(NULL);
+
+	if (0 == active_checks_cache_init)
+	{
+		zbx_hashset_create(&active_checks_cache, 100, ZBX_DEFAULT_UINT64_HASH_FUNC,
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		active_checks_cache_init = 1;
+		active_checks_cache_cleanup = now;
+	}
+
+	if (NULL == checksum)
+	{
+		zbx_hashset_remove(&active_checks_cache, &hostid);
+	}
+	else
+	{
+		if (NULL == (entry = (zbx_active_checks_cache_t *)zbx_hashset_search(&active_checks_cache, &hostid)))
+		{
+			entry_local.hostid = hostid;
+			entry = (zbx_active_checks_cache_t *)zbx_hashset_insert(&active_checks_cache, &entry_local,
+					sizeof(entry_local));
+		}
+
+		entry->revision = revision;
+		entry->lastaccess = now;
+		zbx_strlcpy(entry->checksum, checksum, sizeof(entry->checksum));
+	}
+
+	if (SEC_PER_HOUR > now - active_checks_cache_cleanup)
+		return;
+
+	zbx_hashset_iter_reset(&active_checks_cache, &iter);
+	while (NULL != (entry = (zbx_active_checks_cache_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (SEC_PER_DAY <= now - entry->lastaccess)
+			zbx_hashset_iter_remove(&iter);
+	}
+
+	active_checks_cache_cleanup = now;
+}
+
+static void	active_checks_checksum_append(md5_state_t *state, const char *value)
+{
+	/* include terminating zero to separate values */
+	zbx_md5_append(state, (const md5_byte_t *)value, (int)strlen(value) + 1);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: send_list_of_active_checks_json                                  *
@@ -452,19 +566,27 @@ out:
  *                                                                            *
  * Author: Alexander Vladishev                                                *
  *                                                                            *
- * Comments:                                                                  *
+ * Comments: Agent can send checksum of the list it received last time as     *
+ *           configuration revision. If the list did not change since, only   *
+ *           the revision is sent back without data. Lists of hosts with      *
+ *           unsupported items are not cached, as they depend on the time of  *
+ *           the last item check.                                             *
  *                                                                            *
  ******************************************************************************/
 int	send_list_of_active_checks_json(zbx_socket_t *sock, struct zbx_json_parse *jp)
 {
 	char			host[HOST_HOST_LEN_MAX], tmp[MAX_STRING_LEN], ip[INTERFACE_IP_LEN_MAX],
-				error[MAX_STRING_LEN], *host_metadata = NULL;
+				error[MAX_STRING_LEN], *host_metadata = NULL,
+				checksum[ZBX_ACTIVE_CHECKS_CHECKSUM_LEN + 1];
+	const char		*hex = "0123456789abcdef", *checksum_cached;
 	struct zbx_json		json;
-	int			ret = FAIL, i;
-	zbx_uint64_t		hostid;
+	int			ret = FAIL, i, cacheable;
+	zbx_uint64_t		hostid, revision;
 	size_t			host_metadata_alloc = 1;	/* for at least NUL-termination char */
 	unsigned short		port;
 	zbx_vector_uint64_t	itemids;
+	md5_state_t		state;
+	md5_byte_t		hash[MD5_DIGEST_SIZE];
 
 	zbx_vector_ptr_t	regexps;
 	zbx_vector_str_t	names;
@@ -510,10 +632,29 @@ int	send_list_of_active_checks_json(zbx_socket_t *sock, struct zbx_json_parse *j
 	if (FAIL == get_hostid_by_host(sock, host, ip, port, host_metadata, &hostid, error))
 		goto error;
 
+	/* revision must be taken before building the list so that changes made meanwhile invalidate it */
+	cacheable = DCconfig_get_host_revision(hostid, &revision);
+
+	if (SUCCEED == cacheable && NULL != (checksum_cached = active_checks_cache_get(hostid, revision)) &&
+			SUCCEED == zbx_json_value_by_name(jp, ZBX_PROTO_TAG_CONFIG_REVISION, tmp, sizeof(tmp)) &&
+			0 == strcmp(tmp, checksum_cached))
+	{
+		zbx_json_init(&json, ZBX_JSON_STAT_BUF_LEN);
+		zbx_json_addstring(&json, ZBX_PROTO_TAG_RESPONSE, ZBX_PROTO_VALUE_SUCCESS, ZBX_JSON_TYPE_STRING);
+		zbx_json_addstring(&json, ZBX_PROTO_TAG_CONFIG_REVISION, checksum_cached, ZBX_JSON_TYPE_STRING);
+
+		goto send;
+	}
+
 	zbx_vector_uint64_create(&itemids);
 
 	get_list_of_active_checks(hostid, &itemids);
 
+	/* keep the same order of items for the same list checksum */
+	zbx_vector_uint64_sort(&itemids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	zbx_md5_init(&state);
+
 	zbx_json_init(&json, ZBX_JSON_STAT_BUF_LEN);
 	zbx_json_addstring(&json, ZBX_PROTO_TAG_RESPONSE, ZBX_PROTO_VALUE_SUCCESS, ZBX_JSON_TYPE_STRING);
 	zbx_json_addarray(&json, ZBX_PROTO_TAG_DATA);
@@ -549,6 +690,8 @@ int	send_list_of_active_checks_json(zbx_socket_t *sock, struct zbx_json_parse *j
 
 			if (ITEM_STATE_NOTSUPPORTED == dc_items[i].state)
 			{
+				cacheable = FAIL;
+
 				if (0 == cfg.refresh_unsupported)
 					continue;
 
@@ -562,6 +705,12 @@ int	send_list_of_active_checks_json(zbx_socket_t *sock, struct zbx_json_parse *j
 			dc_items[i].key = zbx_strdup(dc_items[i].key, dc_items[i].key_orig);
 			substitute_key_macros(&dc_items[i].key, NULL, &dc_items[i], NULL, NULL, MACRO_TYPE_ITEM_KEY, NULL, 0);
 
+			/* lastlogsize and mtime are used by agent only for new items, checksum ignores them */
+			active_checks_checksum_append(&state, dc_items[i].key);
+			active_checks_checksum_append(&state, dc_items[i].key_orig);
+			zbx_snprintf(tmp, sizeof(tmp), "%d", delay);
+			active_checks_checksum_append(&state, tmp);
+
 			zbx_json_addobject(&json, NULL);
 			zbx_json_addstring(&json, ZBX_PROTO_TAG_KEY, dc_items[i].key, ZBX_JSON_TYPE_STRING);
 			if (0 != strcmp(dc_items[i].key, dc_items[i].key_orig))
@@ -619,11 +768,45 @@ int	send_list_of_active_checks_json(zbx_socket_t *sock, struct zbx_json_parse *j
 			zbx_json_addstring(&json, "case_sensitive", buffer, ZBX_JSON_TYPE_INT);
 
 			zbx_json_close(&json);
+
+			active_checks_checksum_append(&state, regexp->name);
+			active_checks_checksum_append(&state, regexp->expression);
+			zbx_snprintf(buffer, sizeof(buffer), "%d %c %d", regexp->expression_type,
+					regexp->exp_delimiter, regexp->case_sensitive);
+			active_checks_checksum_append(&state, buffer);
 		}
 
 		zbx_json_close(&json);
 	}
 
+	zbx_md5_finish(&state, hash);
+
+	if (SUCCEED == cacheable)
+	{
+		for (i = 0; i < MD5_DIGEST_SIZE; i++)
+		{
+			checksum[i * 2] = hex[hash[i] >> 4];
+			checksum[i * 2 + 1] = hex[hash[i] & 15];
+		}
+
+		checksum[ZBX_ACTIVE_CHECKS_CHECKSUM_LEN] = '\0';
+
+		active_checks_cache_set(hostid, revision, checksum);
+
+		/* the list could have been rebuilt after unrelated host changes */
+		if (SUCCEED == zbx_json_value_by_name(jp, ZBX_PROTO_TAG_CONFIG_REVISION, tmp, sizeof(tmp)) &&
+				0 == strcmp(tmp, checksum))
+		{
+			zbx_json_clean(&json);
+			zbx_json_addstring(&json, ZBX_PROTO_TAG_RESPONSE, ZBX_PROTO_VALUE_SUCCESS,
+					ZBX_JSON_TYPE_STRING);
+		}
+
+		zbx_json_addstring(&json, ZBX_PROTO_TAG_CONFIG_REVISION, checksum, ZBX_JSON_TYPE_STRING);
+	}
+	else if (0 != active_checks_cache_init)
+		active_checks_cache_set(hostid, 0, NULL);
+send:
 	zabbix_log(LOG_LEVEL_DEBUG, "%s() sending [%s]", __func__, json.buffer);
 
 	zbx_alarm_on(CONFIG_TIMEOUT);
@@ -37,10 +37,11 @@
  ******************************************************************************/
 void	send_proxyconfig(zbx_socket_t *sock, struct zbx_json_parse *jp)
 {
-	char		*error = NULL;
-	struct zbx_json	j;
-	DC_PROXY	proxy;
-	int		flags = ZBX_TCP_PROTOCOL;
+	char			*error = NULL;
+	struct zbx_json		j;
+	struct zbx_json_parse	jp_digest, *pjp_digest = NULL;
+	DC_PROXY		proxy;
+	int			flags = ZBX_TCP_PROTOCOL;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -64,9 +65,13 @@ void	send_proxyconfig(zbx_socket_t *sock, struct zbx_json_parse *jp)
 	if (0 != proxy.auto_compress)
 		flags |= ZBX_TCP_COMPRESS;
 
+	/* proxy reports the digest of its configuration copy to receive only the changed rows */
+	if (SUCCEED == zbx_json_brackets_by_name(jp, ZBX_PROTO_TAG_CONFIG_DIGEST, &jp_digest))
+		pjp_digest = &jp_digest;
+
 	zbx_json_init(&j, ZBX_JSON_STAT_BUF_LEN);
 
-	if (SUCCEED != get_proxyconfig_data(proxy.hostid, &j, &error))
+	if (SUCCEED != get_proxyconfig_data(proxy.hostid, &j, pjp_digest, &error))
 	{
 		zbx_send_response_ext(sock, FAIL, error, NULL, flags, CONFIG_TIMEOUT);
 		zabbix_log(LOG_LEVEL_WARNING, "cannot collect configuration data for proxy \"%s\" at \"%s\": %s",
@@ -33,11 +33,27 @@ static zbx_mutex_t	proxy_lock = ZBX_MUTEX_NULL;
 #define	LOCK_PROXY_HISTORY	if (0 != (program_type & ZBX_PROGRAM_TYPE_PROXY_PASSIVE)) zbx_mutex_lock(proxy_lock)
 #define	UNLOCK_PROXY_HISTORY	if (0 != (program_type & ZBX_PROGRAM_TYPE_PROXY_PASSIVE)) zbx_mutex_unlock(proxy_lock)
 
-int	zbx_send_proxy_data_response(const DC_PROXY *proxy, zbx_socket_t *sock, const char *info)
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_send_proxy_data_response                                     *
+ *                                                                            *
+ * Purpose: send 'proxy data' response to proxy                               *
+ *                                                                            *
+ * Parameters: proxy     - [IN] the proxy                                     *
+ *             sock      - [IN] the connection socket                         *
+ *             jp        - [IN] the received proxy data (optional)            *
+ *             info      - [IN] the response information (optional)           *
+ *             keepalive - [IN] 1 - the next proxy data request can be sent   *
+ *                                  over the same connection                  *
+ *                              0 - otherwise                                 *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_send_proxy_data_response(const DC_PROXY *proxy, zbx_socket_t *sock, const struct zbx_json_parse *jp,
+		const char *info, int keepalive)
 {
 	struct zbx_json		json;
 	zbx_vector_ptr_t	tasks;
-	int			ret, flags = ZBX_TCP_PROTOCOL;
+	int			ret, flags = ZBX_TCP_PROTOCOL, records_num;
 
 	zbx_vector_ptr_create(&tasks);
 
@@ -53,6 +69,15 @@ int	zbx_send_proxy_data_response(const DC_PROXY *proxy, zbx_socket_t *sock, cons
 	if (0 != tasks.values_num)
 		zbx_tm_json_serialize_tasks(&json, &tasks);
 
+	if (0 != keepalive)
+		zbx_json_adduint64(&json, ZBX_PROTO_TAG_KEEPALIVE, 1);
+
+	/* proxy discards sent binary history data only when server confirms it was decoded */
+	if (NULL != jp && SUCCEED == zbx_proxy_hist_bin_records(jp, &records_num))
+		zbx_json_adduint64(&json, ZBX_PROTO_TAG_HISTORY_BINARY_RECORDS, records_num);
+
+	zbx_json_adduint64(&json, ZBX_PROTO_TAG_HISTORY_BINARY_FORMAT, ZBX_PROXY_HISTORY_BINARY_FORMAT);
+
 	if (0 != proxy->auto_compress)
 		flags |= ZBX_TCP_COMPRESS;
 
@@ -72,19 +97,23 @@ int	zbx_send_proxy_data_response(const DC_PROXY *proxy, zbx_socket_t *sock, cons
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_recv_proxy_data                                              *
+ * Function: recv_proxy_data_request                                          *
  *                                                                            *
- * Purpose: receive 'proxy data' request from proxy                           *
+ * Purpose: process one 'proxy data' request from proxy                       *
  *                                                                            *
  * Parameters: sock - [IN] the connection socket                              *
  *             jp   - [IN] the received JSON data                             *
- *             ts   - [IN] the connection timestamp                           *
+ *             ts   - [IN] the request timestamp                              *
+ *                                                                            *
+ * Return value: SUCCEED - the proxy has more data and was invited to send    *
+ *                         the next request over the same connection          *
+ *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-void	zbx_recv_proxy_data(zbx_socket_t *sock, struct zbx_json_parse *jp, zbx_timespec_t *ts)
+static int	recv_proxy_data_request(zbx_socket_t *sock, struct zbx_json_parse *jp, zbx_timespec_t *ts)
 {
-	int		ret = FAIL, status;
-	char		*error = NULL;
+	int		ret = FAIL, status, keepalive = 0;
+	char		*error = NULL, value[MAX_ID_LEN + 1];
 	DC_PROXY	proxy;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
@@ -119,7 +148,15 @@ void	zbx_recv_proxy_data(zbx_socket_t *sock, struct zbx_json_parse *jp, zbx_time
 		goto out;
 	}
 
-	zbx_send_proxy_data_response(&proxy, sock, error);
+	/* let proxy send the rest of its backlog without reconnecting */
+	if (SUCCEED == zbx_json_value_by_name(jp, ZBX_PROTO_TAG_MORE, value, sizeof(value)) &&
+			ZBX_PROXY_DATA_MORE == atoi(value))
+	{
+		keepalive = 1;
+	}
+
+	if (SUCCEED != zbx_send_proxy_data_response(&proxy, sock, jp, error, keepalive))
+		keepalive = 0;
 out:
 	if (FAIL == ret)
 	{
@@ -133,7 +170,51 @@ out:
 
 	zbx_free(error);
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s keepalive:%d", __func__, zbx_result_string(ret), keepalive);
+
+	return 0 != keepalive ? SUCCEED : FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_recv_proxy_data                                              *
+ *                                                                            *
+ * Purpose: receive 'proxy data' request from proxy                           *
+ *                                                                            *
+ * Parameters: sock - [IN] the connection socket                              *
+ *             jp   - [IN] the received JSON data                             *
+ *             ts   - [IN] the connection timestamp                           *
+ *                                                                            *
+ * Comments: When proxy has more data to send it can send the following       *
+ *           'proxy data' requests over the same connection. Each request is  *
+ *           a complete message processed in the same way as over a new       *
+ *           connection, only the connection setup is saved.                  *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_recv_proxy_data(zbx_socket_t *sock, struct zbx_json_parse *jp, zbx_timespec_t *ts)
+{
+	struct zbx_json_parse	jp_request;
+	zbx_timespec_t		ts_request;
+	char			value[MAX_STRING_LEN];
+
+	if (SUCCEED != recv_proxy_data_request(sock, jp, ts))
+		return;
+
+	while (SUCCEED == zbx_tcp_recv_to(sock, CONFIG_TRAPPER_TIMEOUT))
+	{
+		zbx_timespec(&ts_request);
+
+		if (SUCCEED != zbx_json_open(sock->buffer, &jp_request) ||
+				SUCCEED != zbx_json_value_by_name(&jp_request, ZBX_PROTO_TAG_REQUEST, value,
+				sizeof(value)) || 0 != strcmp(value, ZBX_PROTO_VALUE_PROXY_DATA))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "received invalid proxy data request from \"%s\"", sock->peer);
+			break;
+		}
+
+		if (SUCCEED != recv_proxy_data_request(sock, &jp_request, &ts_request))
+			break;
+	}
 }
 
 /******************************************************************************
@@ -167,16 +248,18 @@ static int	send_data_to_server(zbx_socket_t *sock, const char *data, char **erro
  *                                                                            *
  * Purpose: sends 'proxy data' request to server                              *
  *                                                                            *
- * Parameters: sock - [IN] the connection socket                              *
- *             ts   - [IN] the connection timestamp                           *
+ * Parameters: sock       - [IN] the connection socket                        *
+ *             jp_request - [IN] the received request                         *
+ *             ts         - [IN] the connection timestamp                     *
  *                                                                            *
  ******************************************************************************/
-void	zbx_send_proxy_data(zbx_socket_t *sock, zbx_timespec_t *ts)
+void	zbx_send_proxy_data(zbx_socket_t *sock, struct zbx_json_parse *jp_request, zbx_timespec_t *ts)
 {
 	struct zbx_json		j;
 	zbx_uint64_t		areg_lastid = 0, history_lastid = 0, discovery_lastid = 0;
 	char			*error = NULL;
-	int			availability_ts, more_history, more_discovery, more_areg;
+	int			availability_ts, more_history, more_discovery, more_areg, history_bin,
+				history_records;
 	zbx_vector_ptr_t	tasks;
 	struct zbx_json_parse	jp, jp_tasks;
 
@@ -193,7 +276,8 @@ void	zbx_send_proxy_data(zbx_socket_t *sock, zbx_timespec_t *ts)
 
 	zbx_json_addstring(&j, ZBX_PROTO_TAG_SESSION, zbx_dc_get_session_token(), ZBX_JSON_TYPE_STRING);
 	get_host_availability_data(&j, &availability_ts);
-	proxy_get_hist_data(&j, &history_lastid, &more_history);
+	history_bin = (SUCCEED == zbx_proxy_hist_bin_supported(jp_request) ? 1 : 0);
+	history_records = proxy_get_hist_data(&j, history_bin, &history_lastid, &more_history);
 	proxy_get_dhis_data(&j, &discovery_lastid, &more_discovery);
 	proxy_get_areg_data(&j, &areg_lastid, &more_areg);
 
@@ -217,6 +301,15 @@ void	zbx_send_proxy_data(zbx_socket_t *sock, zbx_timespec_t *ts)
 	{
 		zbx_set_availability_diff_ts(availability_ts);
 
+		/* keep binary history data until server confirms it was decoded */
+		if (0 != history_bin && 0 != history_records && (SUCCEED != zbx_json_open(sock->buffer, &jp) ||
+				SUCCEED != zbx_proxy_hist_bin_confirmed(&jp, history_records)))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "server at \"%s\" did not confirm binary history data, the data"
+					" will be sent again", sock->peer);
+			history_lastid = 0;
+		}
+
 		DBbegin();
 
 		if (0 != history_lastid)
@@ -43,10 +43,21 @@
 #define ZBX_MAX_SECTION_ENTRIES		4
 #define ZBX_MAX_ENTRY_ATTRIBUTES	3
 
+#define ZBX_TRAPPER_KEEPALIVE_TIMEOUT	SEC_PER_MIN
+
 extern unsigned char	process_type, program_type;
 extern int		server_num, process_num;
 extern size_t		(*find_psk_in_cache)(const unsigned char *, unsigned char *, size_t);
 
+typedef struct
+{
+	zbx_socket_t	sock;
+	int		lastaccess;
+	unsigned char	checked;	/* connection type is checked and TLS handshake is done */
+	unsigned char	keepalive;	/* client asked to keep connection open for further requests */
+}
+zbx_trapper_conn_t;
+
 typedef struct
 {
 	zbx_counter_value_t	online;
@@ -1042,7 +1053,39 @@ static void	active_passive_misconfig(zbx_socket_t *sock)
 	zbx_free(msg);
 }
 
-static int	process_trap(zbx_socket_t *sock, char *s, zbx_timespec_t *ts)
+/******************************************************************************
+ *                                                                            *
+ * Function: trapper_keepalive_requested                                      *
+ *                                                                            *
+ * Purpose: checks if client asked to keep connection open after the request  *
+ *                                                                            *
+ * Parameters: jp    - [IN] the request                                       *
+ *             value - [IN] the request type                                  *
+ *                                                                            *
+ * Return value: SUCCEED - connection can be reused for further requests      *
+ *               FAIL    - connection must be closed                          *
+ *                                                                            *
+ * Comments: Only requests sent periodically by active agents and senders can *
+ *           keep connection open.                                            *
+ *                                                                            *
+ ******************************************************************************/
+static int	trapper_keepalive_requested(const struct zbx_json_parse *jp, const char *value)
+{
+	char	buffer[MAX_ID_LEN + 1];
+
+	if (0 != strcmp(value, ZBX_PROTO_VALUE_AGENT_DATA) && 0 != strcmp(value, ZBX_PROTO_VALUE_SENDER_DATA) &&
+			0 != strcmp(value, ZBX_PROTO_VALUE_GET_ACTIVE_CHECKS))
+	{
+		return FAIL;
+	}
+
+	if (SUCCEED != zbx_json_value_by_name(jp, ZBX_PROTO_TAG_KEEPALIVE, buffer, sizeof(buffer)))
+		return FAIL;
+
+	return 0 == strcmp(buffer, "1") ? SUCCEED : FAIL;
+}
+
+static int	process_trap(zbx_socket_t *sock, char *s, zbx_timespec_t *ts, int *keepalive)
 {
 	int	ret = SUCCEED;
 
@@ -1106,7 +1149,7 @@ static int	process_trap(zbx_socket_t *sock, char *s, zbx_timespec_t *ts)
 				if (0 != (program_type & ZBX_PROGRAM_TYPE_SERVER))
 					zbx_recv_proxy_data(sock, &jp, ts);
 				else if (0 != (program_type & ZBX_PROGRAM_TYPE_PROXY_PASSIVE))
-					zbx_send_proxy_data(sock, ts);
+					zbx_send_proxy_data(sock, &jp, ts);
 			}
 			else if (0 == strcmp(value, ZBX_PROTO_VALUE_PROXY_HEARTBEAT))
 			{
@@ -1148,6 +1191,9 @@ static int	process_trap(zbx_socket_t *sock, char *s, zbx_timespec_t *ts)
 			}
 			else
 				zabbix_log(LOG_LEVEL_WARNING, "unknown request received [%s]", value);
+
+			if (SUCCEED == ret && SUCCEED == trapper_keepalive_requested(&jp, value))
+				*keepalive = 1;
 		}
 	}
 	else if (0 == strncmp(s, "ZBX_GET_ACTIVE_CHECKS", 21))	/* request for list of active checks */
@@ -1222,19 +1268,319 @@ static int	process_trap(zbx_socket_t *sock, char *s, zbx_timespec_t *ts)
 	return ret;
 }
 
-static void	process_trapper_child(zbx_socket_t *sock, zbx_timespec_t *ts)
+/******************************************************************************
+ *                                                                            *
+ * Function: process_trapper_child                                            *
+ *                                                                            *
+ * Purpose: receives and processes one request                                *
+ *                                                                            *
+ * Parameters: sock      - [IN] the connection                                *
+ *             ts        - [IN] the request timestamp                         *
+ *             keepalive - [OUT] 1 if the connection can be used for further  *
+ *                                requests, 0 otherwise                       *
+ *                                                                            *
+ * Return value: SUCCEED - a request was received                             *
+ *               FAIL    - the connection was closed by peer or an error      *
+ *                         occurred                                           *
+ *                                                                            *
+ ******************************************************************************/
+static int	process_trapper_child(zbx_socket_t *sock, zbx_timespec_t *ts, int *keepalive)
+{
+	*keepalive = 0;
+
+	if (SUCCEED != zbx_tcp_recv_to(sock, CONFIG_TRAPPER_TIMEOUT) || 0 == sock->read_bytes)
+		return FAIL;
+
+	process_trap(sock, sock->buffer, ts, keepalive);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trapper_process_connection                                       *
+ *                                                                            *
+ * Purpose: processes request received over a multiplexed connection         *
+ *                                                                            *
+ * Parameters: conn - [IN] the connection with pending data                   *
+ *             sec  - [OUT] the time spent processing request                 *
+ *                                                                            *
+ * Return value: SUCCEED - the connection is kept open                        *
+ *               FAIL    - the connection must be closed                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	trapper_process_connection(zbx_trapper_conn_t *conn, double *sec)
+{
+	zbx_timespec_t	ts;
+	int		keepalive, ret;
+
+	update_selfmon_counter(ZBX_PROCESS_STATE_BUSY);
+
+	zbx_setproctitle("%s #%d [processing data]", get_process_type_string(process_type), process_num);
+
+	if (0 == conn->checked)
+	{
+		if (SUCCEED != zbx_tcp_accept_check(&conn->sock, ZBX_TCP_SEC_TLS_CERT | ZBX_TCP_SEC_TLS_PSK |
+				ZBX_TCP_SEC_UNENCRYPTED))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "failed to accept an incoming connection: %s",
+					zbx_socket_strerror());
+			return FAIL;
+		}
+
+		conn->checked = 1;
+	}
+
+	/* get request timestamp */
+	zbx_timespec(&ts);
+
+	*sec = zbx_time();
+	ret = process_trapper_child(&conn->sock, &ts, &keepalive);
+	*sec = zbx_time() - *sec;
+
+	if (SUCCEED != ret || 0 == keepalive)
+		return FAIL;
+
+	conn->keepalive = 1;
+	conn->lastaccess = (int)time(NULL);
+
+	return SUCCEED;
+}
+
+static void	trapper_conn_free(zbx_trapper_conn_t *conn)
+{
+	zbx_tcp_close(&conn->sock);
+	zbx_free(conn);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trapper_conn_evict                                               *
+ *                                                                            *
+ * Purpose: closes the least recently used idle keep-alive connection to make *
+ *          room for a new one                                                *
+ *                                                                            *
+ * Return value: SUCCEED - a connection was closed                            *
+ *               FAIL    - there are no idle keep-alive connections           *
+ *                                                                            *
+ ******************************************************************************/
+static int	trapper_conn_evict(zbx_vector_ptr_t *conns)
+{
+	int			i, index = -1;
+	zbx_trapper_conn_t	*conn;
+
+	for (i = 0; i < conns->values_num; i++)
+	{
+		conn = (zbx_trapper_conn_t *)conns->values[i];
+
+		if (0 == conn->keepalive)
+			continue;
+
+		if (-1 == index || conn->lastaccess < ((zbx_trapper_conn_t *)conns->values[index])->lastaccess)
+			index = i;
+	}
+
+	if (-1 == index)
+		return FAIL;
+
+	trapper_conn_free((zbx_trapper_conn_t *)conns->values[index]);
+	zbx_vector_ptr_remove_noorder(conns, index);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trapper_process_multiplexed                                      *
+ *                                                                            *
+ * Purpose: serves up to CONFIG_TRAPPER_MAX_CONNECTIONS connections at once   *
+ *                                                                            *
+ * Parameters: s - [IN] the listening socket                                  *
+ *                                                                            *
+ * Comments: Connections are waited for data with select(), so idle keep-alive*
+ *           connections and slow clients do not hold the trapper. Requests   *
+ *           themselves are received and processed one at a time.             *
+ *                                                                            *
+ ******************************************************************************/
+static void	trapper_process_multiplexed(zbx_socket_t *s)
 {
-	if (SUCCEED != zbx_tcp_recv_to(sock, CONFIG_TRAPPER_TIMEOUT))
-		return;
+	zbx_vector_ptr_t	conns;
+	zbx_trapper_conn_t	*conn;
+	fd_set			fdset;
+	struct timeval		tv;
+	double			sec = 0.0;
+	int			i, n, ret, now, accept_new, processed = 1;
+
+	zbx_vector_ptr_create(&conns);
+
+	for (;;)
+	{
+		if (0 != processed)
+		{
+			zbx_setproctitle("%s #%d [processed data in " ZBX_FS_DBL " sec, waiting for connection]",
+					get_process_type_string(process_type), process_num, sec);
+			processed = 0;
+		}
+
+		now = (int)time(NULL);
+
+		/* close connections that did not send data in time */
+		for (i = conns.values_num - 1; i >= 0; i--)
+		{
+			conn = (zbx_trapper_conn_t *)conns.values[i];
+
+			if (now - conn->lastaccess < (0 == conn->keepalive ? CONFIG_TIMEOUT :
+					ZBX_TRAPPER_KEEPALIVE_TIMEOUT))
+			{
+				continue;
+			}
+
+			if (0 == conn->keepalive)
+			{
+				zabbix_log(LOG_LEVEL_DEBUG, "connection from %s timed out before sending data",
+						conn->sock.peer);
+			}
+
+			trapper_conn_free(conn);
+			zbx_vector_ptr_remove_noorder(&conns, i);
+		}
+
+		FD_ZERO(&fdset);
+		n = 0;
+
+		/* when all connection slots are busy new connections are left to other trappers, */
+		/* unless there is an idle keep-alive connection that can be closed               */
+		accept_new = 0;
+
+		if (conns.values_num < CONFIG_TRAPPER_MAX_CONNECTIONS)
+		{
+			accept_new = 1;
+		}
+		else
+		{
+			for (i = 0; i < conns.values_num; i++)
+			{
+				if (0 != ((zbx_trapper_conn_t *)conns.values[i])->keepalive)
+				{
+					accept_new = 1;
+					break;
+				}
+			}
+		}
+
+		if (0 != accept_new)
+		{
+			for (i = 0; i < s->num_socks; i++)
+			{
+				FD_SET(s->sockets[i], &fdset);
+				if (s->sockets[i] > n)
+					n = s->sockets[i];
+			}
+		}
+
+		for (i = 0; i < conns.values_num; i++)
+		{
+			conn = (zbx_trapper_conn_t *)conns.values[i];
+
+			FD_SET(conn->sock.socket, &fdset);
+			if (conn->sock.socket > n)
+				n = conn->sock.socket;
+		}
+
+		/* wake up every second to expire connections */
+		tv.tv_sec = 1;
+		tv.tv_usec = 0;
+
+		update_selfmon_counter(ZBX_PROCESS_STATE_IDLE);
 
-	process_trap(sock, sock->buffer, ts);
+		ret = select(n + 1, &fdset, NULL, NULL, 0 != conns.values_num ? &tv : NULL);
+		zbx_update_env(zbx_time());
+
+		if (ZBX_PROTO_ERROR == ret)
+		{
+			if (EINTR != zbx_socket_last_error())
+			{
+				zabbix_log(LOG_LEVEL_WARNING, "failed to wait for incoming data: %s",
+						strerror_from_system(zbx_socket_last_error()));
+			}
+
+			continue;
+		}
+
+		if (0 == ret)
+			continue;
+
+		for (i = conns.values_num - 1; i >= 0; i--)
+		{
+			conn = (zbx_trapper_conn_t *)conns.values[i];
+
+			if (0 == FD_ISSET(conn->sock.socket, &fdset))
+				continue;
+
+			processed = 1;
+
+			if (SUCCEED != trapper_process_connection(conn, &sec))
+			{
+				trapper_conn_free(conn);
+				zbx_vector_ptr_remove_noorder(&conns, i);
+			}
+		}
+
+		if (0 == accept_new)
+			continue;
+
+		for (i = 0; i < s->num_socks; i++)
+		{
+			if (0 != FD_ISSET(s->sockets[i], &fdset))
+				break;
+		}
+
+		if (i == s->num_socks)
+			continue;
+
+		/* accept all pending connections while there are free slots */
+		for (;;)
+		{
+			if (conns.values_num >= CONFIG_TRAPPER_MAX_CONNECTIONS && SUCCEED != trapper_conn_evict(&conns))
+				break;
+
+			conn = (zbx_trapper_conn_t *)zbx_malloc(NULL, sizeof(zbx_trapper_conn_t));
+
+			if (SUCCEED != zbx_tcp_accept_nowait(s, &conn->sock))
+			{
+				zbx_free(conn);
+
+				if (EAGAIN != zbx_socket_last_error())
+				{
+					zabbix_log(LOG_LEVEL_WARNING, "failed to accept an incoming connection: %s",
+							zbx_socket_strerror());
+				}
+
+				break;
+			}
+
+			if (FD_SETSIZE <= conn->sock.socket)
+			{
+				zabbix_log(LOG_LEVEL_WARNING, "cannot accept connection from %s: too many open files",
+						conn->sock.peer);
+				trapper_conn_free(conn);
+				break;
+			}
+
+			conn->lastaccess = (int)time(NULL);
+			conn->checked = 0;
+			conn->keepalive = 0;
+
+			zbx_vector_ptr_append(&conns, conn);
+		}
+	}
 }
 
 ZBX_THREAD_ENTRY(trapper_thread, args)
 {
 	double		sec = 0.0;
 	zbx_socket_t	s;
-	int		ret;
+	int		ret, keepalive;
 
 	process_type = ((zbx_thread_args_t *)args)->process_type;
 	server_num = ((zbx_thread_args_t *)args)->server_num;
@@ -1253,6 +1599,9 @@ ZBX_THREAD_ENTRY(trapper_thread, args)
 
 	DBconnect(ZBX_DB_CONNECT_NORMAL);
 
+	if (1 < CONFIG_TRAPPER_MAX_CONNECTIONS)
+		trapper_process_multiplexed(&s);
+
 	for (;;)
 	{
 		zbx_setproctitle("%s #%d [processed data in " ZBX_FS_DBL " sec, waiting for connection]",
@@ -1279,7 +1628,7 @@ ZBX_THREAD_ENTRY(trapper_thread, args)
 					process_num);
 
 			sec = zbx_time();
-			process_trapper_child(&s, &ts);
+			process_trapper_child(&s, &ts, &keepalive);
 			sec = zbx_time() - sec;
 
 			zbx_tcp_unaccept(&s);
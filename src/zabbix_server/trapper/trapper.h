@@ -25,6 +25,7 @@
 
 extern int	CONFIG_TIMEOUT;
 extern int	CONFIG_TRAPPER_TIMEOUT;
+extern int	CONFIG_TRAPPER_MAX_CONNECTIONS;
 extern char	*CONFIG_STATS_ALLOWED_IP;
 
 ZBX_THREAD_ENTRY(trapper_thread, args);
@@ -0,0 +1,109 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2019 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "zbxjson.h"
+#include "dbcache.h"
+#include "proxy.h"
+
+#include "proxy_test.h"
+
+void	zbx_mock_test_entry(void **state)
+{
+	struct zbx_json		j;
+	struct zbx_json_parse	jp, jp_digest, jp_obj;
+	zbx_mock_handle_t	htables, htable, hbuckets, hbucket;
+	zbx_mock_error_t	error;
+	zbx_uint64_t		*buckets, bucket;
+	const char		*table;
+	char			*digest = NULL, *error_msg = NULL;
+	size_t			digest_alloc = 0;
+	int			buckets_num, i;
+	char			prefix[MAX_STRING_LEN];
+
+	ZBX_UNUSED(state);
+
+	/* store the configuration received from server */
+
+	htables = zbx_mock_get_parameter_handle("in.tables");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(htables, &htable))
+	{
+		table = zbx_mock_get_object_member_string(htable, "table");
+
+		if (SUCCEED != zbx_json_open(zbx_mock_get_object_member_string(htable, "data"), &jp_obj))
+			fail_msg("invalid data of table \"%s\": %s", table, zbx_json_strerror());
+
+		if (SUCCEED != proxyconfig_table_update_test(table, &jp_obj, &error_msg))
+			fail_msg("cannot update table \"%s\": %s", table, error_msg);
+	}
+
+	/* encode the digest the way proxy sends it and decode it the way server reads it */
+
+	zbx_json_init(&j, ZBX_JSON_STAT_BUF_LEN);
+	get_proxyconfig_digest(&j);
+
+	if (SUCCEED != zbx_json_open(j.buffer, &jp) ||
+			SUCCEED != zbx_json_brackets_by_name(&jp, ZBX_PROTO_TAG_CONFIG_DIGEST, &jp_digest))
+	{
+		fail_msg("invalid configuration digest: %s", j.buffer);
+	}
+
+	htables = zbx_mock_get_parameter_handle("out.tables");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(htables, &htable))
+	{
+		table = zbx_mock_get_object_member_string(htable, "table");
+
+		if (SUCCEED != zbx_json_value_by_name_dyn(&jp_digest, table, &digest, &digest_alloc))
+			fail_msg("cannot find digest of table \"%s\" in: %s", table, j.buffer);
+
+		if (SUCCEED != proxyconfig_digest_decode_test(digest, &buckets, &buckets_num))
+			fail_msg("cannot decode digest of table \"%s\": %s", table, digest);
+
+		hbuckets = zbx_mock_get_object_member_handle(htable, "buckets");
+
+		for (i = 0; ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hbuckets, &hbucket); i++)
+		{
+			if (ZBX_MOCK_SUCCESS != (error = zbx_mock_uint64(hbucket, &bucket)))
+				fail_msg("Cannot read bucket #%d: %s", i, zbx_mock_error_string(error));
+
+			if (i >= buckets_num)
+				fail_msg("Expected more than %d buckets of table \"%s\"", buckets_num, table);
+
+			zbx_snprintf(prefix, sizeof(prefix), "table \"%s\" bucket #%d", table, i);
+			zbx_mock_assert_uint64_eq(prefix, bucket, buckets[i]);
+		}
+
+		zbx_snprintf(prefix, sizeof(prefix), "table \"%s\" number of buckets", table);
+		zbx_mock_assert_int_eq(prefix, i, buckets_num);
+
+		zbx_free(buckets);
+	}
+
+	zbx_free(digest);
+	zbx_free(error_msg);
+	zbx_json_free(&j);
+}
@@ -0,0 +1,90 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2019 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "zbxjson.h"
+#include "dbcache.h"
+
+#include "proxy_test.h"
+
+static int	get_out_int(const char *name)
+{
+	char	path[MAX_STRING_LEN];
+
+	zbx_snprintf(path, sizeof(path), "out.%s", name);
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_parameter_exists(path))
+		return 0;
+
+	return atoi(zbx_mock_get_parameter_string(path));
+}
+
+static void	check_out_str(const char *name, const char *returned_value)
+{
+	char	path[MAX_STRING_LEN];
+
+	zbx_snprintf(path, sizeof(path), "out.%s", name);
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_parameter_exists(path))
+		zbx_mock_assert_ptr_eq(name, NULL, returned_value);
+	else
+		zbx_mock_assert_str_eq(name, zbx_mock_get_parameter_string(path), returned_value);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	struct zbx_json_parse	jp_row;
+	zbx_timespec_t		unique_shift = {0, 0};
+	zbx_agent_value_t	av;
+	int			ret, expected_ret;
+
+	ZBX_UNUSED(state);
+
+	if (SUCCEED != zbx_json_open(zbx_mock_get_parameter_string("in.row"), &jp_row))
+		fail_msg("invalid history data row: %s", zbx_json_strerror());
+
+	ret = parse_history_data_row_value_test(&jp_row, &unique_shift, &av);
+
+	expected_ret = zbx_mock_str_to_return_code(zbx_mock_get_parameter_string("out.return"));
+	zbx_mock_assert_result_eq("parse_history_data_row_value() return", expected_ret, ret);
+
+	if (SUCCEED == ret)
+	{
+		zbx_mock_assert_int_eq("clock", get_out_int("clock"), av.ts.sec);
+		zbx_mock_assert_int_eq("ns", get_out_int("ns"), av.ts.ns);
+		zbx_mock_assert_uint64_eq("id", zbx_mock_get_parameter_uint64("out.id"), av.id);
+		zbx_mock_assert_int_eq("state", get_out_int("state"), av.state);
+		zbx_mock_assert_int_eq("meta", get_out_int("meta"), av.meta);
+		zbx_mock_assert_uint64_eq("lastlogsize", (zbx_uint64_t)get_out_int("lastlogsize"), av.lastlogsize);
+		zbx_mock_assert_int_eq("mtime", get_out_int("mtime"), av.mtime);
+		zbx_mock_assert_int_eq("timestamp", get_out_int("timestamp"), av.timestamp);
+		zbx_mock_assert_int_eq("severity", get_out_int("severity"), av.severity);
+		zbx_mock_assert_int_eq("logeventid", get_out_int("logeventid"), av.logeventid);
+		check_out_str("value", av.value);
+		check_out_str("source", av.source);
+	}
+
+	zbx_free(av.value);
+	zbx_free(av.source);
+}
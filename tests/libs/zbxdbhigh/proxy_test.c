@@ -0,0 +1,93 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2019 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "proxy_test.h"
+
+int	parse_history_data_row_value_test(const struct zbx_json_parse *jp_row, zbx_timespec_t *unique_shift,
+		zbx_agent_value_t *av)
+{
+	return parse_history_data_row_value(jp_row, unique_shift, av);
+}
+
+int	proxyconfig_digest_decode_test(const char *base64, zbx_uint64_t **buckets, int *buckets_num)
+{
+	return proxyconfig_digest_decode(base64, buckets, buckets_num);
+}
+
+void	proxyconfig_add_buckets_condition_test(char **sql, size_t *sql_alloc, size_t *sql_offset,
+		const char *table_name, const zbx_vector_uint64_t *buckets, int buckets_num)
+{
+	proxyconfig_add_buckets_condition(sql, sql_alloc, sql_offset, DBget_table(table_name), buckets, buckets_num);
+}
+
+/* applies configuration table data received from server to the synced row hashes, without database */
+int	proxyconfig_table_update_test(const char *table_name, const struct zbx_json_parse *jp_obj, char **error)
+{
+	zbx_proxyconfig_update_t	update;
+	zbx_vector_ptr_t		updates;
+	int				ret;
+
+	if (0 == proxyconfig_tables_init)
+	{
+		zbx_vector_ptr_create(&proxyconfig_tables);
+		proxyconfig_tables_init = 1;
+	}
+
+	update.table = DBget_table(table_name);
+	update.delta = 0;
+	update.buckets_num = 0;
+	update.digest = 0;
+	zbx_vector_uint64_create(&update.ids);
+	zbx_vector_uint64_create(&update.buckets);
+	zbx_vector_uint64_pair_create(&update.rows);
+
+	if (SUCCEED == (ret = proxyconfig_parse_delta(jp_obj, &update, error)) &&
+			SUCCEED == (ret = proxyconfig_hash_rows(update.table, jp_obj, &update.rows, error)))
+	{
+		zbx_vector_ptr_create(&updates);
+		zbx_vector_ptr_append(&updates, &update);
+		proxyconfig_tables_update(&updates);
+		zbx_vector_ptr_destroy(&updates);
+	}
+
+	zbx_vector_uint64_pair_destroy(&update.rows);
+	zbx_vector_uint64_destroy(&update.buckets);
+	zbx_vector_uint64_destroy(&update.ids);
+
+	return ret;
+}
+
+/* gets identifiers of the synced rows, fails if the table is not synced */
+int	proxyconfig_table_rows_test(const char *table_name, zbx_vector_uint64_t *recids)
+{
+	zbx_proxyconfig_table_t	*pt;
+	zbx_proxyconfig_row_t	*prow;
+	zbx_hashset_iter_t	iter;
+
+	if (0 == proxyconfig_tables_init || NULL == (pt = proxyconfig_table_get(DBget_table(table_name))))
+		return FAIL;
+
+	zbx_hashset_iter_reset(&pt->rows, &iter);
+	while (NULL != (prow = (zbx_proxyconfig_row_t *)zbx_hashset_iter_next(&iter)))
+		zbx_vector_uint64_append(recids, prow->recid);
+
+	zbx_vector_uint64_sort(recids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	return SUCCEED;
+}
@@ -0,0 +1,32 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2019 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#ifndef PROXY_TEST_H
+#define PROXY_TEST_H
+
+int	parse_history_data_row_value_test(const struct zbx_json_parse *jp_row, zbx_timespec_t *unique_shift,
+		zbx_agent_value_t *av);
+
+int	proxyconfig_digest_decode_test(const char *base64, zbx_uint64_t **buckets, int *buckets_num);
+void	proxyconfig_add_buckets_condition_test(char **sql, size_t *sql_alloc, size_t *sql_offset,
+		const char *table_name, const zbx_vector_uint64_t *buckets, int buckets_num);
+int	proxyconfig_table_update_test(const char *table_name, const struct zbx_json_parse *jp_obj, char **error);
+int	proxyconfig_table_rows_test(const char *table_name, zbx_vector_uint64_t *recids);
+
+#endif
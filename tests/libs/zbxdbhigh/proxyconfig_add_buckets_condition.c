@@ -0,0 +1,67 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2019 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "zbxjson.h"
+#include "dbcache.h"
+
+#include "proxy_test.h"
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_vector_uint64_t	buckets;
+	zbx_mock_handle_t	hbuckets, hbucket;
+	zbx_mock_error_t	error;
+	zbx_uint64_t		bucket;
+	char			*sql = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0;
+
+	ZBX_UNUSED(state);
+
+	zbx_vector_uint64_create(&buckets);
+
+	hbuckets = zbx_mock_get_parameter_handle("in.buckets");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hbuckets, &hbucket))
+	{
+		if (ZBX_MOCK_SUCCESS != (error = zbx_mock_uint64(hbucket, &bucket)))
+			fail_msg("Cannot read bucket: %s", zbx_mock_error_string(error));
+
+		zbx_vector_uint64_append(&buckets, bucket);
+	}
+
+	proxyconfig_add_buckets_condition_test(&sql, &sql_alloc, &sql_offset,
+			zbx_mock_get_parameter_string("in.table"), &buckets,
+			atoi(zbx_mock_get_parameter_string("in.buckets_num")));
+
+#ifdef HAVE_SQLITE3
+	zbx_mock_assert_str_eq("buckets condition", zbx_mock_get_parameter_string("out.sql_sqlite"), sql);
+#else
+	zbx_mock_assert_str_eq("buckets condition", zbx_mock_get_parameter_string("out.sql"), sql);
+#endif
+
+	zbx_free(sql);
+	zbx_vector_uint64_destroy(&buckets);
+}
@@ -0,0 +1,67 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2019 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "zbxjson.h"
+#include "dbcache.h"
+
+#include "proxy_test.h"
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_uint64_t		*buckets = NULL, bucket;
+	int			buckets_num = 0, ret, expected_ret, i = 0;
+	zbx_mock_handle_t	hbuckets, hbucket;
+	zbx_mock_error_t	error;
+	char			prefix[MAX_STRING_LEN];
+
+	ZBX_UNUSED(state);
+
+	ret = proxyconfig_digest_decode_test(zbx_mock_get_parameter_string("in.digest"), &buckets, &buckets_num);
+
+	expected_ret = zbx_mock_str_to_return_code(zbx_mock_get_parameter_string("out.return"));
+	zbx_mock_assert_result_eq("proxyconfig_digest_decode() return", expected_ret, ret);
+
+	if (SUCCEED == ret)
+	{
+		hbuckets = zbx_mock_get_parameter_handle("out.buckets");
+
+		while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hbuckets, &hbucket))
+		{
+			if (ZBX_MOCK_SUCCESS != (error = zbx_mock_uint64(hbucket, &bucket)))
+				fail_msg("Cannot read bucket #%d: %s", i, zbx_mock_error_string(error));
+
+			if (i >= buckets_num)
+				fail_msg("Expected more than %d buckets", buckets_num);
+
+			zbx_snprintf(prefix, sizeof(prefix), "bucket #%d", i);
+			zbx_mock_assert_uint64_eq(prefix, bucket, buckets[i++]);
+		}
+
+		zbx_mock_assert_int_eq("number of buckets", i, buckets_num);
+
+		zbx_free(buckets);
+	}
+}
@@ -0,0 +1,102 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2019 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "zbxjson.h"
+#include "dbcache.h"
+
+#include "proxy_test.h"
+
+void	zbx_mock_test_entry(void **state)
+{
+	struct zbx_json_parse	jp_obj;
+	zbx_mock_handle_t	hupdates, hupdate, hrows, hrow;
+	zbx_mock_error_t	error;
+	zbx_vector_uint64_t	recids;
+	zbx_uint64_t		recid;
+	const char		*table;
+	char			*error_msg = NULL, prefix[MAX_STRING_LEN];
+	int			i = 0, ret, expected_ret;
+
+	ZBX_UNUSED(state);
+
+	table = zbx_mock_get_parameter_string("in.table");
+
+	/* apply the full table data followed by partial updates as received from server */
+
+	hupdates = zbx_mock_get_parameter_handle("in.updates");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hupdates, &hupdate))
+	{
+		if (SUCCEED != zbx_json_open(zbx_mock_get_object_member_string(hupdate, "data"), &jp_obj))
+			fail_msg("invalid update #%d data: %s", i, zbx_json_strerror());
+
+		ret = proxyconfig_table_update_test(table, &jp_obj, &error_msg);
+
+		expected_ret = zbx_mock_str_to_return_code(zbx_mock_get_object_member_string(hupdate, "return"));
+		zbx_snprintf(prefix, sizeof(prefix), "update #%d return", i);
+		zbx_mock_assert_result_eq(prefix, expected_ret, ret);
+
+		if (SUCCEED != ret && NULL == error_msg)
+			fail_msg("no error message for failed update #%d", i);
+
+		zbx_free(error_msg);
+		i++;
+	}
+
+	/* check the rows that will be reported in the digest of the next configuration request */
+
+	zbx_vector_uint64_create(&recids);
+
+	ret = proxyconfig_table_rows_test(table, &recids);
+
+	/* table that is not synced has all its rows requested during the next configuration sync */
+	if (0 == strcmp(zbx_mock_get_parameter_string("out.synced"), "no"))
+	{
+		zbx_mock_assert_result_eq("table is synced", FAIL, ret);
+	}
+	else
+	{
+		zbx_mock_assert_result_eq("table is synced", SUCCEED, ret);
+
+		hrows = zbx_mock_get_parameter_handle("out.rows");
+
+		for (i = 0; ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hrows, &hrow); i++)
+		{
+			if (ZBX_MOCK_SUCCESS != (error = zbx_mock_uint64(hrow, &recid)))
+				fail_msg("Cannot read row #%d: %s", i, zbx_mock_error_string(error));
+
+			if (i >= recids.values_num)
+				fail_msg("Expected more than %d rows", recids.values_num);
+
+			zbx_snprintf(prefix, sizeof(prefix), "row #%d", i);
+			zbx_mock_assert_uint64_eq(prefix, recid, recids.values[i]);
+		}
+
+		zbx_mock_assert_int_eq("number of rows", i, recids.values_num);
+	}
+
+	zbx_vector_uint64_destroy(&recids);
+}
@@ -0,0 +1,222 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2019 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "base64.h"
+
+#include "../../../src/libs/zbxdbhigh/hist_bin.h"
+
+static const char	*record_get_string(zbx_mock_handle_t record, const char *name)
+{
+	zbx_mock_handle_t	handle;
+	zbx_mock_error_t	error;
+	const char		*value;
+
+	if (ZBX_MOCK_NO_SUCH_MEMBER == (error = zbx_mock_object_member(record, name, &handle)))
+		return NULL;
+
+	if (ZBX_MOCK_SUCCESS != error || ZBX_MOCK_SUCCESS != (error = zbx_mock_string(handle, &value)))
+		fail_msg("Cannot read record field \"%s\": %s", name, zbx_mock_error_string(error));
+
+	return value;
+}
+
+static int	record_get_int(zbx_mock_handle_t record, const char *name)
+{
+	const char	*value;
+
+	if (NULL == (value = record_get_string(record, name)))
+		return 0;
+
+	return atoi(value);
+}
+
+static zbx_uint64_t	record_get_uint64(zbx_mock_handle_t record, const char *name)
+{
+	const char	*value;
+	zbx_uint64_t	value_ui64;
+
+	if (NULL == (value = record_get_string(record, name)))
+		return 0;
+
+	if (SUCCEED != is_uint64(value, &value_ui64))
+		fail_msg("Invalid record field \"%s\" value \"%s\"", name, value);
+
+	return value_ui64;
+}
+
+static void	hist_bin_encode(zbx_hist_bin_t *bin)
+{
+	zbx_mock_handle_t	records, record;
+	zbx_history_data_t	hd;
+	char			*string_buffer = NULL;
+	size_t			string_buffer_alloc = 0, string_buffer_offset = 0;
+	const char		*value;
+
+	zbx_hist_bin_init(bin);
+	records = zbx_mock_get_parameter_handle("in.records");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(records, &record))
+	{
+		memset(&hd, 0, sizeof(hd));
+
+		hd.id = record_get_uint64(record, "id");
+		hd.itemid = record_get_uint64(record, "itemid");
+		hd.clock = record_get_int(record, "clock");
+		hd.ns = record_get_int(record, "ns");
+		hd.state = (unsigned char)record_get_int(record, "state");
+		hd.timestamp = record_get_int(record, "timestamp");
+		hd.severity = record_get_int(record, "severity");
+		hd.logeventid = record_get_int(record, "logeventid");
+
+		/* the string buffer holds source and value of the current record, missing ones are empty */
+		string_buffer_offset = 0;
+
+		if (NULL == (value = record_get_string(record, "source")))
+			value = "";
+
+		zbx_strcpy_alloc(&string_buffer, &string_buffer_alloc, &string_buffer_offset, value);
+		string_buffer_offset++;
+		hd.value_offset = string_buffer_offset;
+
+		if (NULL != (value = record_get_string(record, "value")))
+			zbx_strcpy_alloc(&string_buffer, &string_buffer_alloc, &string_buffer_offset, value);
+		else
+			hd.flags |= PROXY_HISTORY_FLAG_NOVALUE;
+
+		if (NULL != record_get_string(record, "lastlogsize"))
+		{
+			hd.flags |= PROXY_HISTORY_FLAG_META;
+			hd.lastlogsize = record_get_uint64(record, "lastlogsize");
+			hd.mtime = record_get_int(record, "mtime");
+		}
+
+		zbx_hist_bin_add_record(bin, &hd, hd.id, string_buffer);
+	}
+
+	zbx_free(string_buffer);
+}
+
+static void	hist_bin_check_record(int index, zbx_mock_handle_t record, zbx_uint64_t itemid,
+		const zbx_agent_value_t *av)
+{
+	char		prefix[MAX_STRING_LEN];
+	const char	*value;
+
+	zbx_snprintf(prefix, sizeof(prefix), "record #%d id", index);
+	zbx_mock_assert_uint64_eq(prefix, record_get_uint64(record, "id"), av->id);
+
+	zbx_snprintf(prefix, sizeof(prefix), "record #%d itemid", index);
+	zbx_mock_assert_uint64_eq(prefix, record_get_uint64(record, "itemid"), itemid);
+
+	zbx_snprintf(prefix, sizeof(prefix), "record #%d clock", index);
+	zbx_mock_assert_int_eq(prefix, record_get_int(record, "clock"), av->ts.sec);
+
+	zbx_snprintf(prefix, sizeof(prefix), "record #%d ns", index);
+	zbx_mock_assert_int_eq(prefix, record_get_int(record, "ns"), av->ts.ns);
+
+	zbx_snprintf(prefix, sizeof(prefix), "record #%d state", index);
+	zbx_mock_assert_int_eq(prefix, record_get_int(record, "state"), av->state);
+
+	zbx_snprintf(prefix, sizeof(prefix), "record #%d value", index);
+	if (NULL != (value = record_get_string(record, "value")))
+		zbx_mock_assert_str_eq(prefix, value, av->value);
+	else
+		zbx_mock_assert_ptr_eq(prefix, NULL, av->value);
+
+	zbx_snprintf(prefix, sizeof(prefix), "record #%d source", index);
+	if (NULL != (value = record_get_string(record, "source")))
+		zbx_mock_assert_str_eq(prefix, value, av->source);
+	else
+		zbx_mock_assert_ptr_eq(prefix, NULL, av->source);
+
+	zbx_snprintf(prefix, sizeof(prefix), "record #%d timestamp", index);
+	zbx_mock_assert_int_eq(prefix, record_get_int(record, "timestamp"), av->timestamp);
+
+	zbx_snprintf(prefix, sizeof(prefix), "record #%d severity", index);
+	zbx_mock_assert_int_eq(prefix, record_get_int(record, "severity"), av->severity);
+
+	zbx_snprintf(prefix, sizeof(prefix), "record #%d logeventid", index);
+	zbx_mock_assert_int_eq(prefix, record_get_int(record, "logeventid"), av->logeventid);
+
+	zbx_snprintf(prefix, sizeof(prefix), "record #%d meta", index);
+	zbx_mock_assert_int_eq(prefix, NULL != record_get_string(record, "lastlogsize") ? 1 : 0, av->meta);
+
+	zbx_snprintf(prefix, sizeof(prefix), "record #%d lastlogsize", index);
+	zbx_mock_assert_uint64_eq(prefix, record_get_uint64(record, "lastlogsize"), av->lastlogsize);
+
+	zbx_snprintf(prefix, sizeof(prefix), "record #%d mtime", index);
+	zbx_mock_assert_int_eq(prefix, record_get_int(record, "mtime"), av->mtime);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_hist_bin_t		bin;
+	zbx_mock_handle_t	records, record;
+	zbx_agent_value_t	av;
+	zbx_uint64_t		itemid;
+	char			*base64 = NULL;
+	int			index = 0, truncated_bytes = 0, ret = SUCCEED;
+
+	ZBX_UNUSED(state);
+
+	hist_bin_encode(&bin);
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.truncate"))
+		truncated_bytes = atoi(zbx_mock_get_parameter_string("in.truncate"));
+
+	str_base64_encode_dyn((const char *)bin.data, &base64, (int)bin.data_offset - truncated_bytes);
+	zbx_hist_bin_clear(&bin);
+
+	zbx_mock_assert_result_eq("zbx_hist_bin_open() return", SUCCEED, zbx_hist_bin_open(&bin, base64));
+
+	records = zbx_mock_get_parameter_handle("out.records");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(records, &record))
+	{
+		index++;
+
+		ret = zbx_hist_bin_read_record(&bin, &itemid, &av);
+		zbx_mock_assert_result_eq("zbx_hist_bin_read_record() return", SUCCEED, ret);
+
+		hist_bin_check_record(index, record, itemid, &av);
+
+		zbx_free(av.value);
+		zbx_free(av.source);
+	}
+
+	/* the truncated record must be rejected, otherwise all data must be consumed */
+	if (bin.data_offset < bin.data_size)
+	{
+		ret = zbx_hist_bin_read_record(&bin, &itemid, &av);
+		zbx_free(av.value);
+		zbx_free(av.source);
+	}
+
+	zbx_mock_assert_result_eq("decoding result", zbx_mock_str_to_return_code(
+			zbx_mock_get_parameter_string("out.return")), ret);
+
+	zbx_hist_bin_clear(&bin);
+	zbx_free(base64);
+}